@@ -160,3 +160,69 @@ class RegressionDetector:
         # Write baseline
         with open(self.baseline_path, 'w') as f:
             json.dump(baseline_data, f, indent=2)
+
+
+class MicroHistory:
+    """History of microbenchmark runs (bench/micro.py), one JSON object per line
+
+    Each run records ns/tuple and MB/s per case. A case regresses when its
+    ns/tuple (scan) or total_ms (build) is more than the threshold above the
+    median of the last `window` runs that measured it at the same row count.
+    """
+
+    def __init__(self, history_path: str = 'bench/results/micro_history.jsonl',
+                 threshold: float = 15.0, window: int = 5):
+        self.history_path = history_path
+        self.threshold = threshold
+        self.window = window
+        self.runs: List[Dict] = []
+        self._load()
+
+    def _load(self):
+        """Load earlier runs, skipping lines that do not parse"""
+        if not os.path.exists(self.history_path):
+            return
+        with open(self.history_path, 'r') as f:
+            for line in f:
+                line = line.strip()
+                if not line:
+                    continue
+                try:
+                    self.runs.append(json.loads(line))
+                except json.JSONDecodeError:
+                    print(f"Warning: skipping bad line in {self.history_path}")
+
+    def _median(self, case: str, metric: str, rows: Optional[int]) -> Optional[float]:
+        values = [r['cases'][case][metric] for r in self.runs
+                  if case in r.get('cases', {}) and r['cases'][case].get(metric)
+                  and (rows is None or r.get('rows') == rows)]
+        values = sorted(values[-self.window:])
+        if not values:
+            return None
+        mid = len(values) // 2
+        return values[mid] if len(values) % 2 else (values[mid - 1] + values[mid]) / 2
+
+    def check(self, cases: Dict[str, Dict], rows: Optional[int] = None) -> List[Dict]:
+        """Compare a run's cases against history; same report shape as RegressionDetector"""
+        regressions = []
+        for case, m in cases.items():
+            for metric in ('ns_per_tuple', 'build_total_ms'):
+                if not m.get(metric):
+                    continue
+                baseline = self._median(case, metric, rows)
+                if baseline and m[metric] > baseline * (1 + self.threshold / 100):
+                    regressions.append({
+                        'workload': case,
+                        'metric': metric,
+                        'baseline': baseline,
+                        'current': m[metric],
+                        'regression_pct': (m[metric] - baseline) / baseline * 100
+                    })
+        return regressions
+
+    def append(self, run: Dict):
+        """Add a run to the history file"""
+        os.makedirs(os.path.dirname(self.history_path), exist_ok=True)
+        with open(self.history_path, 'a') as f:
+            f.write(json.dumps(run) + '\n')
+        self.runs.append(run)
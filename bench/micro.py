@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+SMOL Microbenchmarks - scan and build hot paths without the executor
+
+Each case builds one SMOL index in a given page format and key width, then
+reads the build phase timings from smol_bench_build_profile() and times full
+scans through smol_bench_scan(), which drives smol_rescan/smol_gettuple in a
+C loop.  Results are ns/tuple and MB/s per case; runs are appended to
+bench/results/micro_history.jsonl and compared to the median of recent runs.
+"""
+
+import argparse
+import os
+import sys
+from datetime import datetime
+
+# Add bench directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from bench.lib.db import DatabaseConnection
+from bench.lib.regression import MicroHistory
+
+
+# name: (columns, INCLUDE columns, row expression, build GUCs)
+CASES = {
+    'plain_int2':     ('k int2', None, '(i % 30000)::int2', {}),
+    'plain_int4':     ('k int4', None, 'i', {}),
+    'plain_int8':     ('k int8', None, 'i::int8 * 3', {}),
+    'for_int4':       ('k int4', None, 'i', {'smol.key_bitpack': 'on'}),
+    'rle_int4':       ('k int4', None, 'i / 100', {}),
+    'plain_uuid':     ('k uuid', None, "md5(i::text)::uuid", {}),
+    'plain_text16':   ('k text COLLATE "C"', None, "lpad(i::text, 12, '0')", {}),
+    'prefix_text16':  ('k text COLLATE "C"', None, "'sku-' || lpad(i::text, 10, '0')", {'smol.text_prefix': 'on'}),
+    'inc_int4':       ('k int4, v int4', 'v', 'i, i % 1000', {}),
+    'inc_rle_int4':   ('k int4, v int4', 'v', 'i / 50, i / 500', {}),
+    'inc_dict_int4':  ('k int4, v int4', 'v', 'i, i % 16', {'smol.include_dict': 'on'}),
+    'twocol_int4':    ('k int4, k2 int4', None, 'i / 8, i % 8', {}),
+    'groups_int4':    ('k int4, k2 int4', None, 'i / 8, i % 8', {'smol.two_col_groups': 'on'}),
+}
+
+
+def run_case(db: DatabaseConnection, name: str, rows: int, loops: int) -> dict:
+    cols, inc, expr, gucs = CASES[name]
+    keys = ', '.join(c.split()[0] for c in cols.split(', ') if inc is None or c.split()[0] != inc)
+    include = f' INCLUDE ({inc})' if inc else ''
+    sets = ''.join(f"SET {g} = {v};\n" for g, v in gucs.items())
+
+    db.execute(f"""
+        DROP TABLE IF EXISTS micro_{name} CASCADE;
+        CREATE UNLOGGED TABLE micro_{name} ({cols});
+        INSERT INTO micro_{name} SELECT {expr} FROM generate_series(1, {rows}) i;
+        ANALYZE micro_{name};
+    """)
+
+    # Build and profile in one session: the profile is backend-local
+    build = db.execute(f"""
+        {sets}
+        CREATE INDEX micro_{name}_idx ON micro_{name} USING smol({keys}){include};
+        SELECT tuples, collect_ms, sort_ms, write_ms, total_ms, index_mb, mb_per_sec
+        FROM smol_bench_build_profile();
+    """).split('|')
+
+    # One warm-up pass, so every loop reads from shared buffers
+    db.execute(f"SELECT smol_prewarm('micro_{name}_idx');")
+    fwd = db.execute(f"SELECT tuples, ns_per_tuple, mb_per_sec FROM smol_bench_scan('micro_{name}_idx', {loops});").split('|')
+    bwd = db.execute(f"SELECT ns_per_tuple FROM smol_bench_scan('micro_{name}_idx', {loops}, true);")
+
+    db.execute(f"DROP TABLE micro_{name} CASCADE;")
+    return {
+        'tuples': int(fwd[0]),
+        'ns_per_tuple': float(fwd[1]),
+        'mb_per_sec': float(fwd[2]),
+        'ns_per_tuple_backward': float(bwd),
+        'build_collect_ms': float(build[1]),
+        'build_sort_ms': float(build[2]),
+        'build_write_ms': float(build[3]),
+        'build_total_ms': float(build[4]),
+        'index_mb': float(build[5]),
+        'build_mb_per_sec': float(build[6]),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description='SMOL scan/build microbenchmarks')
+    parser.add_argument('--rows', type=int, default=1_000_000, help='Rows per case (default 1M)')
+    parser.add_argument('--loops', type=int, default=10, help='Scan loops per measurement (default 10)')
+    parser.add_argument('--cases', default=','.join(CASES), help='Comma-separated case names')
+    parser.add_argument('--no-history', action='store_true', help='Do not append this run to the history')
+    args = parser.parse_args()
+
+    db = DatabaseConnection()
+    db.execute("CREATE EXTENSION IF NOT EXISTS smol;")
+    history = MicroHistory()
+    results = {}
+
+    print(f"{'case':<16} {'ns/tup':>8} {'bwd ns':>8} {'MB/s':>8} {'build ms':>9} "
+          f"{'collect':>8} {'sort':>8} {'write':>8} {'idx MB':>7}")
+    for name in args.cases.split(','):
+        if name not in CASES:
+            print(f"Unknown case {name}; known: {', '.join(CASES)}")
+            sys.exit(2)
+        r = run_case(db, name, args.rows, args.loops)
+        results[name] = r
+        print(f"{name:<16} {r['ns_per_tuple']:>8.2f} {r['ns_per_tuple_backward']:>8.2f} {r['mb_per_sec']:>8.1f} "
+              f"{r['build_total_ms']:>9.1f} {r['build_collect_ms']:>8.1f} {r['build_sort_ms']:>8.1f} "
+              f"{r['build_write_ms']:>8.1f} {r['index_mb']:>7.1f}", flush=True)
+
+    regressions = history.check(results, rows=args.rows)
+    if not args.no_history:
+        history.append({
+            'timestamp': datetime.now().strftime('%Y%m%d-%H%M%S'),
+            'rows': args.rows,
+            'loops': args.loops,
+            'cases': results,
+        })
+
+    if regressions:
+        for reg in regressions:
+            print(f"REGRESSION {reg['workload']} {reg['metric']}: {reg['baseline']:.2f} -> "
+                  f"{reg['current']:.2f} (+{reg['regression_pct']:.1f}%)")
+        sys.exit(1)
+    print(f"\n✓ No regressions against the last {history.window} runs")
+
+
+if __name__ == '__main__':
+    main()
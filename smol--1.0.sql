@@ -18,6 +18,160 @@ LANGUAGE C STRICT;
 COMMENT ON FUNCTION smol_inspect(regclass) IS
 'Inspect SMOL index structure: returns page counts and RLE compression percentage';
 
+-- Load an index into shared buffers: upper levels first, then leaf chunks in parallel
+CREATE FUNCTION smol_prewarm(idx regclass, workers int4 DEFAULT 0)
+RETURNS int8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+COMMENT ON FUNCTION smol_prewarm(regclass, int4) IS
+'Prewarm a SMOL index: reads the metapage, leaf directory and internal levels, then splits the leaves across the caller and up to workers parallel workers; returns blocks read';
+
+-- Index heap rows added since the last build as a new segment on the right of the tree
+CREATE FUNCTION smol_append(idx regclass)
+RETURNS int8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+COMMENT ON FUNCTION smol_append(regclass) IS
+'Append heap rows inserted since the last build or append to a SMOL index; the new rows must not sort below its last key. Returns rows added';
+
+-- Rebuild the upper levels, directory and statistics after appends
+CREATE FUNCTION smol_compact(idx regclass)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+COMMENT ON FUNCTION smol_compact(regclass) IS
+'Rebuild the internal levels, leaf directory and statistics of a SMOL index grown by smol_append; returns the tree height';
+
+-- Rebuild several SMOL indexes of one table from a single heap scan
+CREATE FUNCTION smol_build_many(tbl regclass, indexes regclass[] DEFAULT '{}')
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+COMMENT ON FUNCTION smol_build_many(regclass, regclass[]) IS
+'Rebuild the given SMOL indexes of a table (all of them for an empty array) as by REINDEX, reading the heap once; returns the number of indexes rebuilt';
+
+-- Per-key aggregates computed directly from leaf pages (RLE runs fold as count * value)
+CREATE FUNCTION smol_group_agg(idx regclass,
+    include_col int4 DEFAULT NULL,
+    lower_key int8 DEFAULT NULL,
+    upper_key int8 DEFAULT NULL,
+    filter_col int4 DEFAULT NULL,
+    filter_lower int8 DEFAULT NULL,
+    filter_upper int8 DEFAULT NULL,
+    OUT k int8,
+    OUT count int8,
+    OUT sum numeric,
+    OUT min int8,
+    OUT max int8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STABLE;
+
+COMMENT ON FUNCTION smol_group_agg(regclass, int4, int8, int8, int4, int8, int8) IS
+'GROUP BY key with count/sum/min/max of an INCLUDE column over a single-column integer SMOL index; include_col defaults to the first INCLUDE column (0 counts only), lower_key/upper_key are inclusive; only rows whose INCLUDE column filter_col lies in [filter_lower, filter_upper] are counted';
+
+-- Distinct leading keys, skipping from key to key (RLE runs, binary search, descents)
+CREATE FUNCTION smol_distinct(idx regclass,
+    lower_key int8 DEFAULT NULL,
+    upper_key int8 DEFAULT NULL,
+    OUT k int8,
+    OUT first_k2 int8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STABLE;
+
+COMMENT ON FUNCTION smol_distinct(regclass, int8, int8) IS
+'Each distinct leading key of an integer SMOL index once, with the smallest second key of its group for two-column indexes (NULL otherwise); lower_key/upper_key are inclusive';
+
+-- Per-index scan counters accumulated in shared memory (see pg_stat_smol)
+CREATE FUNCTION smol_stat_indexes(
+    OUT indexrelid oid,
+    OUT scans int8,
+    OUT leaves_read int8,
+    OUT subtrees_pruned int8,
+    OUT bloom_checks int8,
+    OUT bloom_pruned int8,
+    OUT runs int8,
+    OUT prefetches int8,
+    OUT parallel_scans int8,
+    OUT dir_claims int8,
+    OUT dir_steals int8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C VOLATILE;
+
+COMMENT ON FUNCTION smol_stat_indexes() IS
+'Scan counters of the SMOL indexes of the current database scanned since the last smol_stat_reset()';
+
+CREATE FUNCTION smol_stat_reset()
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C VOLATILE;
+
+COMMENT ON FUNCTION smol_stat_reset() IS
+'Zero the scan counters behind pg_stat_smol for all databases';
+
+-- Like pg_stat_reset(), clearing shared counters is for superusers unless granted
+REVOKE ALL ON FUNCTION smol_stat_reset() FROM PUBLIC;
+
+CREATE VIEW pg_stat_smol AS
+    SELECT x.indrelid AS relid,
+           s.indexrelid,
+           n.nspname AS schemaname,
+           t.relname,
+           i.relname AS indexrelname,
+           s.scans,
+           s.leaves_read,
+           s.subtrees_pruned,
+           s.bloom_checks,
+           s.bloom_pruned,
+           s.runs,
+           s.prefetches,
+           s.parallel_scans,
+           s.dir_claims,
+           s.dir_steals,
+           round(s.dir_claims::numeric / NULLIF(s.parallel_scans, 0), 1) AS claims_per_worker
+    FROM smol_stat_indexes() s
+         JOIN pg_class i ON i.oid = s.indexrelid
+         JOIN pg_index x ON x.indexrelid = s.indexrelid
+         JOIN pg_class t ON t.oid = x.indrelid
+         JOIN pg_namespace n ON n.oid = i.relnamespace;
+
+COMMENT ON VIEW pg_stat_smol IS
+'Per-index SMOL scan counters: leaves read, subtrees pruned by zone maps, bloom checks and prunes, runs emitted, prefetches and parallel directory claims';
+
+-- Microbenchmarks (bench/micro.py): AM scan loop and build phases without the executor
+CREATE FUNCTION smol_bench_scan(idx regclass, loops int4 DEFAULT 10, backward bool DEFAULT false,
+    OUT tuples int8,
+    OUT ns_per_tuple float8,
+    OUT mb_per_sec float8)
+RETURNS record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT;
+
+COMMENT ON FUNCTION smol_bench_scan(regclass, int4, bool) IS
+'Time loops full index-only scans of a SMOL index through the AM scan functions; returns tuples per loop, ns per tuple and key + INCLUDE MB/s';
+
+CREATE FUNCTION smol_bench_build_profile(
+    OUT indexrelid oid,
+    OUT tuples int8,
+    OUT collect_ms float8,
+    OUT sort_ms float8,
+    OUT write_ms float8,
+    OUT total_ms float8,
+    OUT index_mb float8,
+    OUT mb_per_sec float8)
+RETURNS record
+AS 'MODULE_PATHNAME'
+LANGUAGE C VOLATILE;
+
+COMMENT ON FUNCTION smol_bench_build_profile() IS
+'Collect, sort and write timings of the last SMOL index built by this session, with the index size and build MB/s';
+
 -- Test functions for coverage (call AM functions directly to bypass planner)
 CREATE FUNCTION smol_test_backward_scan(regclass)
 RETURNS integer
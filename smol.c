@@ -6,14 +6,24 @@ PG_MODULE_MAGIC;
 /* GUC variable definitions (not extern declarations - those are in smol.h) */
 bool smol_debug_log = false;
 bool smol_profile_log = false;
+bool smol_track_scan_stats = true;
 double smol_cost_page = 1.0;
 double smol_cost_tup = 0.01;
 int smol_parallel_claim_batch = 16;
 int smol_prefetch_depth = 0;
+bool smol_read_stream = true;
 double smol_rle_uniqueness_threshold = 0.95;
 int smol_key_rle_version = KEY_RLE_AUTO;
+bool smol_key_bitpack = false;
+bool smol_two_col_groups = false;
+bool smol_text_prefix = false;
+bool smol_include_dict = false;
 bool smol_use_position_scan = true;
 bool smol_use_tuple_buffering = true;
+bool smol_scan_kernels = true;
+bool smol_skip_scan = true;
+int smol_tree_cache_pages = 1024;
+bool smol_rescan_reposition = true;
 int smol_tuple_buffer_size = 64;
 
 /* Zone maps + bloom filters GUCs */
@@ -22,6 +32,13 @@ bool smol_bloom_filters = true;
 bool smol_build_zone_maps = true;
 bool smol_build_bloom_filters = true;
 int smol_bloom_nhash = 2;
+int smol_bloom_leaf_bits = 0;
+bool smol_build_bulk_write = true;
+bool smol_build_include_zones = false;
+bool smol_build_radix_sort = true;
+
+/* Reloption kind registered in _PG_init */
+relopt_kind smol_relopt_kind;
 
 #ifdef SMOL_TEST_COVERAGE
 int smol_test_keylen_inflate = 0;
@@ -55,6 +72,13 @@ Oid smol_sort_typoid1 = InvalidOid, smol_sort_typoid2 = InvalidOid;
 static void smol_run_synthetic_tests(void);
 #endif
 
+/* EXPLAIN (ANALYZE, SMOL) option */
+static int smol_explain_id = -1;
+static explain_per_node_hook_type prev_explain_per_node_hook = NULL;
+static void smol_explain_option(ExplainState *es, DefElem *opt, ParseState *pstate);
+static void smol_explain_per_node(PlanState *planstate, List *ancestors, const char *relationship,
+                                  const char *plan_name, ExplainState *es);
+
 void
 _PG_init(void)
 {
@@ -67,6 +91,15 @@ _PG_init(void)
                              0,
                              NULL, NULL, NULL);
 
+    DefineCustomBoolVariable("smol.track_scan_stats",
+                             "Accumulate per-index scan counters for pg_stat_smol",
+                             "Each scan adds its leaf, pruning, run and prefetch counts to shared memory when it ends.",
+                             &smol_track_scan_stats,
+                             true,
+                             PGC_SUSET,
+                             0,
+                             NULL, NULL, NULL);
+
     DefineCustomBoolVariable("smol.profile",
                              "Log per-scan microprofile counters",
                              "When on, SMOL logs counters for amgettuple hot path (pages, rows, copies).",
@@ -94,6 +127,44 @@ _PG_init(void)
                              0,
                             NULL, NULL, NULL);
 
+    DefineCustomBoolVariable("smol.scan_kernels",
+                             "Use scan loops specialized on key width and INCLUDE shape",
+                             "When on, buffered scans of plain leaves with int-ordered 4- or 8-byte keys and up to four INCLUDE columns of one fixed width use a refill loop generated for that shape.",
+                             &smol_scan_kernels,
+                             true,
+                             PGC_USERSET,
+                             0,
+                            NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("smol.skip_scan",
+                             "Skip between leading-key groups on second-key bounds",
+                             "When on, forward scans of two-column indexes with integer-ordered keys and a second-key bound but no leading-key equality binary-search each group to the bound and jump past the rest of the group, re-descending when it spans leaves.",
+                             &smol_skip_scan,
+                             true,
+                             PGC_USERSET,
+                             0,
+                            NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("smol.rescan_reposition",
+                             "Start rescans from the previous start leaf when the new bound falls on it",
+                             "When on, serial bounded scans keep their start leaf pinned, and a rescan whose lower bound falls on that leaf or its right sibling starts there instead of descending from the root.",
+                             &smol_rescan_reposition,
+                             true,
+                             PGC_USERSET,
+                             0,
+                            NULL, NULL, NULL);
+
+    DefineCustomIntVariable("smol.tree_cache_pages",
+                            "Internal pages per index kept decoded in backend memory",
+                            "Descents read the metapage and internal pages of each index from a backend-local cache of up to this many pages per index instead of shared buffers (0 disables the cache).",
+                            &smol_tree_cache_pages,
+                            1024, /* default */
+                            0, /* min */
+                            1048576, /* max */
+                            PGC_USERSET,
+                            0,
+                            NULL, NULL, NULL);
+
     DefineCustomIntVariable("smol.tuple_buffer_size",
                             "Number of tuples to buffer",
                             "Buffer size for tuple buffering optimization (tuples per batch).",
@@ -267,6 +338,14 @@ _PG_init(void)
                             PGC_USERSET, 0,
                             NULL, NULL, NULL);
 
+    DefineCustomBoolVariable("smol.read_stream",
+                             "Read leaves through a read stream",
+                             "When on, leaf walks read predicted sibling blocks through a read stream (combined and asynchronous I/O); when off, they prefetch with smol.prefetch_depth.",
+                             &smol_read_stream,
+                             true,
+                             PGC_USERSET, 0,
+                             NULL, NULL, NULL);
+
     DefineCustomIntVariable("smol.parallel_claim_batch",
                             "Number of leaves to claim per atomic operation in parallel scans",
                             NULL,
@@ -292,6 +371,38 @@ _PG_init(void)
                             PGC_USERSET, 0,
                             NULL, NULL, NULL);
 
+    DefineCustomBoolVariable("smol.key_bitpack",
+                            "Allow frame-of-reference bit-packed leaves for integer keys",
+                            "When on, builds of single-column integer indexes without INCLUDE columns store a leaf as per-block base plus bit-packed deltas whenever that is smaller than the plain and RLE layouts.",
+                            &smol_key_bitpack,
+                            false,
+                            PGC_USERSET, 0,
+                            NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("smol.two_col_groups",
+                            "Allow k1-grouped leaves for two-column indexes",
+                            "When on, two-column builds store each distinct leading key once per leaf with a row directory and a packed second-key array whenever that fits more rows than the row-major layout.",
+                            &smol_two_col_groups,
+                            false,
+                            PGC_USERSET, 0,
+                            NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("smol.text_prefix",
+                            "Allow prefix-truncated leaves for text keys",
+                            "When on, builds of single-column text indexes without INCLUDE columns store a leaf as one shared prefix plus per-key suffixes with an offset array whenever that fits more rows than the padded layout, and accept keys up to 256 bytes.",
+                            &smol_text_prefix,
+                            false,
+                            PGC_USERSET, 0,
+                            NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("smol.include_dict",
+                            "Allow dictionary-coded INCLUDE columns on leaves",
+                            "When on, single-key builds with INCLUDE columns code each low-cardinality INCLUDE column of a leaf against a per-leaf dictionary of up to 256 values whenever that fits more rows than the plain or Include-RLE layout.",
+                            &smol_include_dict,
+                            false,
+                            PGC_USERSET, 0,
+                            NULL, NULL, NULL);
+
     DefineCustomRealVariable("smol.rle_uniqueness_threshold",
                             "Uniqueness threshold for RLE format (nruns/nitems)",
                             "If nruns/nitems >= this threshold, keys are considered unique",
@@ -338,19 +449,134 @@ _PG_init(void)
                             NULL, NULL, NULL);
 
     DefineCustomIntVariable("smol.bloom_nhash",
-                            "Number of hash functions for bloom filters (1-4)",
-                            "Higher values reduce false positives but increase computation cost.",
+                            "Number of hash functions for bloom filters (1-8)",
+                            "Higher values reduce false positives but increase computation cost; "
+                            "values above 4 pay off only with smol.bloom_leaf_bits.",
                             &smol_bloom_nhash,
-                            2, 1, 4,
+                            2, 1, SMOL_BLOOM_MAX_NHASH,
                             PGC_USERSET, 0,
                             NULL, NULL, NULL);
 
+    DefineCustomIntVariable("smol.bloom_leaf_bits",
+                            "Bits per leaf in per-leaf bloom pages written at build time (0 = none)",
+                            "Rounded up to a multiple of 64. Equality probes test the leaf's bloom "
+                            "before reading it; 512-4096 suits uuid and text point lookups.",
+                            &smol_bloom_leaf_bits,
+                            0, 0, SMOL_LEAF_BLOOM_MAX_BITS,
+                            PGC_USERSET, 0,
+                            NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("smol.build_include_zones",
+                            "Write per-leaf min/max pages for integer INCLUDE columns during index build",
+                            "When on, single-key builds record each leaf's range of every int2, int4 and "
+                            "int8 INCLUDE column, so smol_group_agg filters can skip leaves unread.",
+                            &smol_build_include_zones,
+                            false,
+                            PGC_USERSET,
+                            0,
+                            NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("smol.build_radix_sort",
+                            "Radix-sort order-normalized keys in memory during index build",
+                            "When on, builds whose key types have an order-preserving image (every "
+                            "fixed-width opclass except interval, timetz and name) sort it with an "
+                            "LSD radix sort instead of comparator calls or tuplesort.",
+                            &smol_build_radix_sort,
+                            true,
+                            PGC_USERSET,
+                            0,
+                            NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("smol.build_bulk_write",
+                            "Write leaf pages through smgr bulk writes during index build",
+                            "When on, CREATE INDEX fills leaves in private memory and writes them in "
+                            "batches, bypassing shared buffers, with one fsync at the end.",
+                            &smol_build_bulk_write,
+                            true,
+                            PGC_USERSET,
+                            0,
+                            NULL, NULL, NULL);
+
+    smol_relopt_kind = add_reloption_kind();
+    add_int_reloption(smol_relopt_kind, "fillfactor",
+                      "Accepted for btree compatibility; SMOL always packs leaves full",
+                      100, 10, 100, ShareUpdateExclusiveLock);
+    add_bool_reloption(smol_relopt_kind, "resident",
+                       "Read the metapage, directory and internal levels on first use in each backend",
+                       false, AccessExclusiveLock);
+    add_bool_reloption(smol_relopt_kind, "append",
+                       "Accept inserts into the table; the new rows are indexed by smol_append",
+                       false, AccessExclusiveLock);
+
+    /* Drop cached trees when their index is invalidated */
+    smol_tree_cache_register();
+
+    smol_explain_id = GetExplainExtensionId("smol");
+    RegisterExtensionExplainOption("smol", smol_explain_option);
+    prev_explain_per_node_hook = explain_per_node_hook;
+    explain_per_node_hook = smol_explain_per_node;
+
 #ifdef SMOL_TEST_COVERAGE
     /* Run synthetic tests on first load */
     smol_run_synthetic_tests();
 #endif
 }
 
+/* EXPLAIN (SMOL [boolean]) */
+static void
+smol_explain_option(ExplainState *es, DefElem *opt, ParseState *pstate)
+{
+    bool *on = (bool *) GetExplainExtensionState(es, smol_explain_id);
+
+    (void) pstate;
+    if (on == NULL)
+    {
+        on = (bool *) palloc0(sizeof(bool));
+        SetExplainExtensionState(es, smol_explain_id, on);
+    }
+    *on = defGetBoolean(opt);
+}
+
+/*
+ * With EXPLAIN (ANALYZE, SMOL), print the counters of each SMOL scan node
+ * (all loops; in a parallel plan, the leader's share; pg_stat_smol has the
+ * workers' too).
+ */
+static void
+smol_explain_per_node(PlanState *planstate, List *ancestors, const char *relationship,
+                      const char *plan_name, ExplainState *es)
+{
+    bool *on;
+    IndexScanDesc desc = NULL;
+    SmolScanOpaque so;
+
+    if (prev_explain_per_node_hook)
+        prev_explain_per_node_hook(planstate, ancestors, relationship, plan_name, es);
+    on = (bool *) GetExplainExtensionState(es, smol_explain_id);
+    if (on == NULL || !*on || !es->analyze)
+        return;
+    if (IsA(planstate, IndexOnlyScanState))
+        desc = ((IndexOnlyScanState *) planstate)->ioss_ScanDesc;
+    else if (IsA(planstate, IndexScanState))
+        desc = ((IndexScanState *) planstate)->iss_ScanDesc;
+    else if (IsA(planstate, BitmapIndexScanState))
+        desc = ((BitmapIndexScanState *) planstate)->biss_ScanDesc;
+    if (desc == NULL || desc->opaque == NULL || desc->indexRelation->rd_indam->ambeginscan != smol_beginscan)
+        return;
+
+    so = (SmolScanOpaque) desc->opaque;
+    ExplainPropertyUInteger("SMOL Leaves Read", NULL, so->stat_leaves, es);
+    ExplainPropertyUInteger("SMOL Subtrees Pruned", NULL, so->prof_subtrees_skipped, es);
+    ExplainPropertyUInteger("SMOL Bloom Pruned", NULL, so->prof_bloom_skips, es);
+    ExplainPropertyUInteger("SMOL Runs", NULL, so->stat_runs, es);
+    ExplainPropertyUInteger("SMOL Prefetches", NULL, so->stat_prefetches, es);
+    if (desc->parallel_scan)
+    {
+        ExplainPropertyUInteger("SMOL Directory Claims", NULL, so->prof_dir_claims, es);
+        ExplainPropertyUInteger("SMOL Directory Steals", NULL, so->prof_dir_steals, es);
+    }
+}
+
 /* --- Handler: wire a minimal IndexAmRoutine --- */
 PG_FUNCTION_INFO_V1(smol_handler);
 Datum
@@ -371,7 +597,7 @@ smol_handler(PG_FUNCTION_ARGS)
     am->amcanunique = false;
     am->amcanmulticol = true;
     am->amoptionalkey = true;
-    am->amsearcharray = false;
+    am->amsearcharray = true;
     am->amsearchnulls = false;
     am->amstorage = false;
     am->amclusterable = false;
@@ -401,7 +627,7 @@ smol_handler(PG_FUNCTION_ARGS)
     am->ambeginscan = smol_beginscan;
     am->amrescan = smol_rescan;
     am->amgettuple = smol_gettuple;
-    am->amgetbitmap = NULL;
+    am->amgetbitmap = smol_getbitmap;
     am->amendscan = smol_endscan;
     am->ammarkpos = NULL;
     am->amrestrpos = NULL;
@@ -422,16 +648,53 @@ smol_insert(Relation index, Datum *values, bool *isnull, ItemPointer heap_tid,
             Relation heapRel, IndexUniqueCheck checkUnique, bool indexUnchanged,
             struct IndexInfo *indexInfo)
 {
-    ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-                    errmsg("smol is read-only: aminsert is not supported")));
+    Buffer      buf;
+    SmolMeta   *m;
+    bool        below;
+
+    /*
+     * WITH (append = true) lets the row into the heap and leaves it out of
+     * the index until smol_append collects the rows past the high-water mark.
+     */
+    if (!SmolIndexIsAppend(index))
+        ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                        errmsg("smol is read-only: aminsert is not supported")));
+
+    /*
+     * A row at or below the mark (free space reuse, an UPDATE's new version
+     * on its old page) would never be collected: flag the metapage so that
+     * smol_append refuses instead of leaving the index short of it.
+     */
+    buf = ReadBuffer(index, 0);
+    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    m = smol_meta_ptr(BufferGetPage(buf));
+    below = !m->append_stale &&
+        (ItemPointerGetBlockNumber(heap_tid) < m->append_heap_blk ||
+         (ItemPointerGetBlockNumber(heap_tid) == m->append_heap_blk &&
+          ItemPointerGetOffsetNumber(heap_tid) <= m->append_heap_off));
+    LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    if (below)
+    {
+        LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+        smol_meta_ptr(BufferGetPage(buf))->append_stale = true;
+        MarkBufferDirty(buf);
+        LockBuffer(buf, BUFFER_LOCK_UNLOCK);
+    }
+    ReleaseBuffer(buf);
     return false;
 }
 
 bytea *
 smol_options(Datum reloptions, bool validate)
 {
-    (void) reloptions; (void) validate;
-    return NULL;
+    static const relopt_parse_elt tab[] = {
+        {"fillfactor", RELOPT_TYPE_INT, offsetof(SmolOptions, fillfactor)},
+        {"resident", RELOPT_TYPE_BOOL, offsetof(SmolOptions, resident)},
+        {"append", RELOPT_TYPE_BOOL, offsetof(SmolOptions, append)}
+    };
+
+    return (bytea *) build_reloptions(reloptions, validate, smol_relopt_kind,
+                                      sizeof(SmolOptions), tab, lengthof(tab));
 }
 
 bool
@@ -595,32 +858,205 @@ smol_test_validate(PG_FUNCTION_ARGS)
     PG_RETURN_BOOL(result);
 }
 
+/*
+ * smol_cost_leading_bounds - fold the path's leading-key quals into 'so' the
+ * way smol_rescan does, so the root zone maps can be probed at plan time.
+ * Collects the leading-key clauses into *leading.  Returns true when at least
+ * one bound could be used for the probe.
+ */
+static bool
+smol_cost_leading_bounds(IndexPath *path, Relation irel, const SmolMeta *meta,
+                         SmolScanOpaque so, List **leading, bool *leading_eq)
+{
+    IndexOptInfo *index = path->indexinfo;
+    ListCell   *lc;
+    bool        usable = false;
+
+    so->atttypid = TupleDescAttr(RelationGetDescr(irel), 0)->atttypid;
+    so->key_len = meta->key_len1;
+    so->collation = index->indexcollations[0];
+    get_typlenbyvalalign(so->atttypid, &so->key_typlen, &so->key_byval, &so->align1);
+    if (so->atttypid == TEXTOID)
+    {
+        pg_locale_t locale = pg_newlocale_from_collation(so->collation);
+
+        so->use_generic_cmp = (locale && !locale->collate_is_c);
+    }
+    *leading = NIL;
+    *leading_eq = false;
+
+    foreach(lc, path->indexclauses)
+    {
+        IndexClause *iclause = lfirst_node(IndexClause, lc);
+        ListCell   *lc2;
+
+        if (iclause->indexcol != 0)
+            continue;
+        foreach(lc2, iclause->indexquals)
+        {
+            RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc2);
+            OpExpr     *op = (OpExpr *) rinfo->clause;
+            Node       *arg;
+            int         strat;
+
+            *leading = lappend(*leading, rinfo);
+            if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+                continue;
+            arg = (Node *) lsecond(op->args);
+            if (!IsA(arg, Const) || ((Const *) arg)->constisnull ||
+                ((Const *) arg)->consttype != so->atttypid)
+                continue;
+            strat = get_op_opfamily_strategy(op->opno, index->opfamily[0]);
+            if (strat == BTGreaterEqualStrategyNumber || strat == BTGreaterStrategyNumber ||
+                strat == BTEqualStrategyNumber)
+            {
+                so->have_bound = true;
+                so->bound_strict = (strat == BTGreaterStrategyNumber);
+                so->have_k1_eq = (strat == BTEqualStrategyNumber);
+                so->bound_datum = ((Const *) arg)->constvalue;
+                *leading_eq = so->have_k1_eq;
+                usable = true;
+            }
+            else if (strat == BTLessEqualStrategyNumber || strat == BTLessStrategyNumber)
+            {
+                so->have_upper_bound = true;
+                so->upper_bound_strict = (strat == BTLessStrategyNumber);
+                so->upper_bound_datum = ((Const *) arg)->constvalue;
+                usable = true;
+            }
+        }
+    }
+    return usable;
+}
+
+/*
+ * True when the leftmost leaf carries no heap block range, so that
+ * amgetbitmap falls back to the whole heap (the writers record a range for
+ * every leaf of the index or for none)
+ */
+static bool
+smol_cost_heap_ranges_unknown(Relation irel)
+{
+    BlockNumber leaf = smol_find_first_leaf(irel, PG_INT64_MIN,
+                                            TupleDescAttr(RelationGetDescr(irel), 0)->atttypid, 0);
+    Buffer      buf;
+    bool        unknown;
+
+    if (!BlockNumberIsValid(leaf))
+        return false; /* GCOV_EXCL_LINE - built indexes always have a leaf */
+    buf = ReadBuffer(irel, leaf);
+    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    unknown = smol_page_opaque(BufferGetPage(buf))->heap_nblocks == 0;
+    UnlockReleaseBuffer(buf);
+    return unknown;
+}
+
+/*
+ * smol_costestimate - cost a SMOL scan from the statistics the build stored
+ * in the metapage.
+ *
+ * A scan reads every row in its leading-key range and tests the remaining
+ * quals per row, so the leaves it touches follow the selectivity of the
+ * leading-key quals alone (an equality uses the build's distinct count),
+ * capped by the share of rows the root zone maps leave.  Leaves are read
+ * along the rightlinks with prefetch: one random read, then sequential ones.
+ * genericcostestimate still supplies the overall selectivity and
+ * correlation, and indexes built without statistics keep its estimate.
+ * A scan that visits the heap through an index without heap block ranges
+ * reads all of it, so its selectivity is charged as 1.
+ */
 void
 smol_costestimate(PlannerInfo *root, IndexPath *path, double loop_count,
                   Cost *indexStartupCost, Cost *indexTotalCost,
                   Selectivity *indexSelectivity, double *indexCorrelation,
                   double *indexPages)
 {
+    IndexOptInfo *index = path->indexinfo;
     GenericCosts costs;
+    Relation    irel;
+    SmolMeta    meta;
 
     /* Use genericcostestimate for standard index cost calculation with parallel support */
     MemSet(&costs, 0, sizeof(costs));
     genericcostestimate(root, path, loop_count, &costs);
 
-    /* Apply SMOL-specific cost multipliers */
-    if (smol_cost_page != 1.0 && costs.spc_random_page_cost > 0.0)
-    {
-        Cost io_cost = costs.numIndexPages * costs.spc_random_page_cost;
-        Cost cpu_cost = costs.indexTotalCost - io_cost;
-        costs.indexTotalCost = (io_cost * smol_cost_page) + cpu_cost;
-    }
+    irel = index_open(index->indexoid, NoLock);
+    MemSet(&meta, 0, sizeof(meta));
+    if (RelationGetNumberOfBlocks(irel) > 0)
+        smol_meta_read(irel, &meta);
 
-    if (smol_cost_tup != 1.0)
+    if (meta.magic == SMOL_META_MAGIC && meta.stat_leaves > 0 && meta.stat_rows > 0)
     {
-        Cost io_cost = costs.numIndexPages * costs.spc_random_page_cost;
-        Cost cpu_cost = costs.indexTotalCost - io_cost;
-        costs.indexTotalCost = io_cost + (cpu_cost * smol_cost_tup);
+        SmolScanOpaque so = (SmolScanOpaque) palloc0(sizeof(SmolScanOpaqueData));
+        List       *leading;
+        bool        leading_eq;
+        Selectivity lead_sel = 1.0;
+        double      scans = Max(costs.num_sa_scans, 1.0);
+        double      leaves;
+        double      visited;
+        double      spc_seq;
+        Cost        descent;
+        Cost        io_cost;
+        Cost        cpu_cost;
+
+        if (smol_cost_leading_bounds(path, irel, &meta, so, &leading, &leading_eq) &&
+            !(so->atttypid == TEXTOID && so->use_generic_cmp))
+            lead_sel = smol_root_zone_fraction(irel, so, &meta);
+        if (leading_eq && meta.stat_distinct > 0)
+            lead_sel = Min(lead_sel, scans / meta.stat_distinct);
+        else if (leading != NIL)
+            lead_sel = Min(lead_sel, clauselist_selectivity(root, leading, index->rel->relid,
+                                                            JOIN_INNER, NULL));
+        lead_sel = Max(lead_sel, costs.indexSelectivity);
+        pfree(so);
+
+        visited = clamp_row_est(lead_sel * meta.stat_rows);
+        leaves = Min(ceil(lead_sel * meta.stat_leaves) + scans - 1.0, (double) meta.stat_leaves);
+        leaves = Max(leaves, 1.0);
+
+        /* Like btree: the descent is CPU only, internal pages stay cached */
+        descent = scans * (ceil(log(meta.stat_rows) / log(2.0)) + (meta.height + 1) * 50.0) * cpu_operator_cost;
+
+        get_tablespace_page_costs(index->reltablespace, NULL, &spc_seq);
+        if (loop_count > 1)
+        {
+            double fetched = index_pages_fetched(leaves * loop_count, meta.stat_leaves,
+                                                 (double) index->pages, root);
+
+            io_cost = fetched * costs.spc_random_page_cost / loop_count;
+        }
+        else
+            io_cost = costs.spc_random_page_cost * scans + (leaves - scans) * spc_seq;
+
+        cpu_cost = visited * (cpu_index_tuple_cost +
+                              list_length(path->indexclauses) * cpu_operator_cost);
+
+        costs.indexStartupCost = descent;
+        costs.indexTotalCost = descent + io_cost * smol_cost_page + cpu_cost * smol_cost_tup;
+        costs.numIndexPages = leaves + Max((double) meta.height - 1, 0.0);
+        if (path->path.pathtype != T_IndexOnlyScan && smol_cost_heap_ranges_unknown(irel))
+            costs.indexSelectivity = 1.0;
+        index_close(irel, NoLock);
     }
+    else
+    { /* GCOV_EXCL_START - indexes built before the v7 statistics */
+        index_close(irel, NoLock);
+
+        /* Apply SMOL-specific cost multipliers */
+        if (smol_cost_page != 1.0 && costs.spc_random_page_cost > 0.0)
+        {
+            Cost io_cost = costs.numIndexPages * costs.spc_random_page_cost;
+            Cost cpu_cost = costs.indexTotalCost - io_cost;
+            costs.indexTotalCost = (io_cost * smol_cost_page) + cpu_cost;
+        }
+
+        if (smol_cost_tup != 1.0)
+        {
+            Cost io_cost = costs.numIndexPages * costs.spc_random_page_cost;
+            Cost cpu_cost = costs.indexTotalCost - io_cost;
+            costs.indexTotalCost = io_cost + (cpu_cost * smol_cost_tup);
+        }
+    } /* GCOV_EXCL_STOP */
 
     *indexStartupCost = costs.indexStartupCost;
     *indexTotalCost = costs.indexTotalCost;
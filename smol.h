@@ -21,6 +21,7 @@
 #include "access/nbtree.h"
 #include "catalog/index.h"
 #include "access/xlogdefs.h"
+#include "access/xact.h"
 #include "fmgr.h"
 #include "funcapi.h"
 #include "storage/bufmgr.h"
@@ -37,21 +38,42 @@
 #include "utils/syscache.h"
 #include "utils/regproc.h"
 #include "catalog/pg_collation_d.h"
+#include "commands/defrem.h"
+#include "common/int.h"
 #include <string.h>
 #include <stdint.h>
+#include <math.h>
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "nodes/pathnodes.h"
 #include "utils/lsyscache.h"
 #include "access/tupmacs.h"
+#include "nodes/tidbitmap.h"
+#include "port/pg_bitutils.h"
+#include "port/pg_bswap.h"
+#include "port/simd.h"
+#include "utils/array.h"
 #include "utils/tuplesort.h"
+#include "utils/tuplestore.h"
+#include "executor/tuptable.h"
+#include "catalog/pg_type.h"
 #include "utils/typcache.h"
+#include "utils/uuid.h"
 #include "utils/pg_locale.h"
 #include "utils/numeric.h"
 #include "portability/instr_time.h"
 #include "pgstat.h"
 #include "utils/selfuncs.h"
 #include "optimizer/cost.h"
+#include "optimizer/optimizer.h"
+#include "utils/spccache.h"
+#include "access/reloptions.h"
+#include "storage/read_stream.h"
+#include "storage/bulk_write.h"
+#include "utils/acl.h"
+#include "utils/rls.h"
+#include "utils/datum.h"
+#include "catalog/pg_class.h"
 #include "access/parallel.h"
 #include "postmaster/bgworker.h"
 #include "postmaster/interrupt.h"
@@ -64,6 +86,13 @@
 #include "tcop/tcopprot.h"
 #include "utils/queryenvironment.h"
 #include "utils/wait_event.h"
+#include "storage/dsm_registry.h"
+#include "common/hashfn.h"
+#include "commands/explain.h"
+#include "commands/explain_format.h"
+#include "commands/explain_state.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
 
 
 /* ---- Constants and Enums ---- */
@@ -86,19 +115,85 @@ typedef enum
 #define SMOL_TAG_KEY_RLE     0x8001u
 #define SMOL_TAG_KEY_RLE_V2  0x8002u
 #define SMOL_TAG_INC_RLE     0x8003u
+#define SMOL_TAG_KEY_FOR     0x8004u   /* frame-of-reference bit-packed integer keys */
+#define SMOL_TAG_K1_GROUPS   0x8005u   /* two-column leaf grouped by k1 */
+#define SMOL_TAG_TEXT_PREFIX 0x8006u   /* text keys sharing a page-wide prefix */
+#define SMOL_TAG_INC_DICT    0x8007u   /* INCLUDE columns coded against per-page dictionaries */
+
+/*
+ * Frame-of-reference leaf layout (SMOL_TAG_KEY_FOR), single integer key
+ * without INCLUDE columns:
+ *   [u16 tag][u16 nitems][u16 nblocks][u16 reserved]
+ *   [int64 base * nblocks][u16 byte offset * nblocks][u8 width * nblocks]
+ *   [packed deltas][SMOL_FOR_SLACK zero bytes]
+ * Each block of SMOL_FOR_BLOCK keys stores (key - base) in `width` bits,
+ * LSB-first; base is the block minimum.  The slack lets every extraction be
+ * one unaligned 8-byte load.
+ */
+#define SMOL_FOR_BLOCK       128
+#define SMOL_FOR_HEADER      (sizeof(uint16) * 4)
+#define SMOL_FOR_SLACK       8
+#define SMOL_FOR_KEYRING     8         /* decoded keys smol_leaf_keyptr_ex keeps live */
+
+/*
+ * Grouped two-column leaf layout (SMOL_TAG_K1_GROUPS):
+ *   [u16 tag][u16 nrows][u16 ngroups][u16 reserved]
+ *   [k1 | u16 first row (0-based) | u16 count] * ngroups
+ *   [k2 * nrows][INCLUDE row (inc_total bytes) * nrows]
+ * Each distinct k1 is stored once.  Rows keep (k1,k2) order, so a group's k2
+ * slice is sorted and its first/last entries are the group's k2 min/max.
+ * Row-major leaves start with nrows (< 0x8000) and carry no tag.
+ */
+#define SMOL12_GROUP_HEADER  (sizeof(uint16) * 4)
+
+/*
+ * Prefix-truncated text leaf layout (SMOL_TAG_TEXT_PREFIX), single text key
+ * without INCLUDE columns:
+ *   [u16 tag][u16 nitems][u16 plen][u16 reserved]
+ *   [u16 suffix offset * (nitems + 1)][prefix (plen bytes)][suffix bytes]
+ * Key i is the page's common prefix followed by suffix bytes offs[i] up to
+ * offs[i+1].  The offset array keeps binary search possible; readers rebuild
+ * the usual NUL-padded key_len form.  Only these leaves let the padded width
+ * grow past 32 bytes, up to SMOL_TEXT_KEY_MAX.
+ */
+#define SMOL_TP_HEADER       (sizeof(uint16) * 4)
+#define SMOL_TEXT_KEY_MAX    256
+
+/*
+ * Dictionary-coded INCLUDE leaf layout (SMOL_TAG_INC_DICT), single key with
+ * INCLUDE columns:
+ *   [u16 tag][u16 nitems][u16 ninc][u16 reserved][u16 column offset * ninc]
+ *   [keys * nitems]
+ *   column: [u16 ndict][u16 reserved] then nitems raw values (ndict = 0), or
+ *           ndict values, nitems codes of smol_for_width(ndict - 1) bits
+ *           (LSB-first) and SMOL_FOR_SLACK zero bytes
+ * Column offsets count from the payload start.  Each column keeps whichever
+ * form is smaller, so only low-cardinality columns are coded.
+ */
+#define SMOL_INC_DICT_HEADER (sizeof(uint16) * 4)
+#define SMOL_INC_DICT_COL    (sizeof(uint16) * 2)
+#define SMOL_INC_DICT_MAX    256       /* distinct values one column may code */
 
 /* Metapage constants */
 #define SMOL_META_MAGIC   0x534D4F4CUL /* 'SMOL' */
-#define SMOL_META_VERSION 2  /* v2: zone maps + bloom filters */
+#define SMOL_META_VERSION 12  /* v12: append_stale flag */
+#define SMOL_META_VERSION_APPEND 12  /* first version smol_append can extend */
+#define SMOL_META_VERSION_TYPED_BLOOM 9  /* first version whose blooms hash every key type */
+#define SMOL_META_VERSION_WIDE_KEYS 6  /* first version using SmolInternalItemV6 */
+#define SMOL_META_VERSION_INC_ZONES 10  /* first version that may carry INCLUDE zone pages */
+#define SMOL_META_VERSION_NORM_KEYS 11  /* first version whose zone keys use smol_norm_key() for every type */
+#define SMOL_STAT_LEVELS  8  /* internal levels with a recorded fanout */
 
 /* Parallel build shared memory keys */
 #define PARALLEL_KEY_SMOL_SHARED  1
 #define PARALLEL_KEY_TUPLESORT    2
 #define PARALLEL_KEY_QUERY_TEXT   3
+#define PARALLEL_KEY_SMOL_PREWARM 4
 
 /* ---- GUC Variables (extern) ---- */
 extern bool smol_debug_log;
 extern bool smol_profile_log;
+extern bool smol_track_scan_stats;
 extern double smol_cost_page;
 extern double smol_cost_tup;
 extern int smol_parallel_claim_batch;
@@ -106,14 +201,27 @@ extern int smol_prefetch_depth;
 extern double smol_rle_uniqueness_threshold;
 extern int smol_key_rle_version;
 extern bool smol_use_position_scan;
+extern bool smol_key_bitpack;
+extern bool smol_two_col_groups;
+extern bool smol_text_prefix;
+extern bool smol_include_dict;
+extern bool smol_read_stream;
 extern bool smol_use_tuple_buffering;
+extern bool smol_scan_kernels;
+extern bool smol_skip_scan;
+extern int smol_tree_cache_pages;
+extern bool smol_rescan_reposition;
 extern int smol_tuple_buffer_size;
 /* Zone maps + bloom filters GUCs */
 extern bool smol_zone_maps;              /* Enable zone map filtering during scan (default: on) */
 extern bool smol_bloom_filters;          /* Enable bloom filter checks during scan (default: on) */
 extern bool smol_build_zone_maps;        /* Collect zone maps during build (default: on) */
 extern bool smol_build_bloom_filters;    /* Build bloom filters during build (default: on) */
-extern int smol_bloom_nhash;             /* Number of hash functions for bloom (1-4, default: 2) */
+extern int smol_bloom_nhash;             /* Number of hash functions for bloom (1-8, default: 2) */
+extern int smol_bloom_leaf_bits;         /* Per-leaf bloom bits in the bloom pages (0 = none) */
+extern bool smol_build_bulk_write;       /* Write build leaves through smgr bulk writes (default: on) */
+extern bool smol_build_include_zones;    /* Write per-leaf INCLUDE zone pages during build (default: off) */
+extern bool smol_build_radix_sort;       /* Radix-sort normalized keys in memory during build (default: on) */
 
 #ifdef SMOL_TEST_COVERAGE
 extern int smol_test_keylen_inflate;
@@ -201,6 +309,69 @@ extern Oid smol_sort_typoid1, smol_sort_typoid2;
 
 /* ---- Structure Definitions ---- */
 
+/* Reloptions: WITH (...) on CREATE INDEX */
+typedef struct SmolOptions
+{
+    int32       vl_len_;        /* varlena header (do not touch directly!) */
+    int         fillfactor;     /* accepted for btree compatibility; leaves are always packed */
+    bool        resident;       /* warm the upper levels on first use in each backend */
+    bool        append;         /* accept inserts; smol_append indexes them later */
+} SmolOptions;
+
+#define SmolIndexIsResident(rel) \
+    ((rel)->rd_options ? ((SmolOptions *) (rel)->rd_options)->resident : false)
+#define SmolIndexIsAppend(rel) \
+    ((rel)->rd_options ? ((SmolOptions *) (rel)->rd_options)->append : false)
+
+extern relopt_kind smol_relopt_kind;
+
+/* smol_prewarm: block ranges claimed by the leader and parallel workers */
+typedef struct SmolPrewarmRange
+{
+    BlockNumber start;
+    BlockNumber end;            /* exclusive */
+} SmolPrewarmRange;
+
+typedef struct SmolPrewarmShared
+{
+    Oid         indexrelid;
+    uint32      nranges;
+    pg_atomic_uint32 next_range;
+    pg_atomic_uint64 blocks_read;
+    SmolPrewarmRange ranges[FLEXIBLE_ARRAY_MEMBER];
+} SmolPrewarmShared;
+
+/*
+ * smol_append: while a segment is collected, heap scans of the build see only
+ * rows past the recorded high-water mark, and every row is checked against
+ * the last key already in the index so the segment can extend the leaf chain
+ */
+typedef struct SmolAppendScan
+{
+    BlockNumber hwm_blk;        /* rows at or before (hwm_blk, hwm_off) are indexed */
+    OffsetNumber hwm_off;
+    int         nkeys;          /* key columns compared */
+    bool        have_last;      /* index holds rows */
+    Datum       last[2];        /* last key of the index */
+    FmgrInfo    cmp[2];         /* btree comparison support */
+    Oid         coll[2];
+    double      nrows;          /* rows passed to the build */
+    IndexBuildCallback cb;      /* build callback of the current heap scan */
+    void       *cb_state;
+} SmolAppendScan;
+
+/* One index of smol_build_many: its columns from the shared heap scan, spooled with the heap TID */
+typedef struct SmolManySpool
+{
+    Oid         indexoid;
+    int         natts;          /* index columns; the TID follows as int8 */
+    int         map[INDEX_MAX_KEYS];    /* column position in the shared scan */
+    TupleDesc   desc;
+    Tuplestorestate *ts;
+} SmolManySpool;
+
+#define SMOL_PREWARM_DISTANCE 32   /* blocks prefetched ahead of the reader */
+
 /* Page opaque flags */
 #define SMOL_F_LEAF     0x0001
 #define SMOL_F_INTERNAL 0x0002
@@ -220,8 +391,8 @@ typedef struct SmolMeta
     /* v2 fields: zone maps + bloom filters */
     bool        zone_maps_enabled;    /* zone maps present in internal nodes */
     bool        bloom_enabled;        /* bloom filters present */
-    uint8       bloom_nhash;          /* number of hash functions (1-4) */
-    uint8       padding;              /* alignment padding */
+    uint8       bloom_nhash;          /* number of hash functions (1-8) */
+    uint8       zkey_len;             /* v6: zone key bytes per internal item (8 or 16) */
     /* v3 field: collation for text keys */
     Oid         collation_oid;        /* collation for first text key (InvalidOid if not text or C collation) */
     /* v4 field: leaf directory for parallel scan */
@@ -230,42 +401,68 @@ typedef struct SmolMeta
     bool        inc_is_numeric[16];   /* true if INCLUDE column is NUMERIC */
     int16       inc_numeric_precision[16];  /* precision for INCLUDE NUMERIC columns */
     int16       inc_numeric_scale[16];      /* scale for INCLUDE NUMERIC columns */
+    /* v7 fields: build statistics for smol_costestimate (zero when absent) */
+    double      stat_rows;            /* rows stored in the leaves */
+    double      stat_distinct;        /* distinct leading-key values */
+    BlockNumber stat_leaves;          /* leaf pages */
+    BlockNumber stat_packed_leaves;   /* leaves in an RLE or FOR layout */
+    float4      stat_fanout[SMOL_STAT_LEVELS]; /* avg children per node, leaf parents first */
+    /* v8 fields: heap rows already indexed, for smol_append */
+    BlockNumber append_heap_blk;      /* last heap block covered */
+    OffsetNumber append_heap_off;     /* last line pointer covered on append_heap_blk (0 = none) */
+    uint16      nsegments;            /* segments appended since the last build or compaction */
+    /* v9 fields: per-leaf bloom pages (see SmolLeafBloomPageHeader) */
+    uint16      leaf_bloom_words;     /* uint64 words per leaf bloom */
+    BlockNumber leaf_bloom_blkno;     /* first bloom page (InvalidBlockNumber or 0 if none) */
+    BlockNumber leaf_bloom_first;     /* leaf block of bloom slot 0 */
+    uint32      leaf_bloom_nslots;    /* slots cover leaf blocks leaf_bloom_first onwards */
+    /* v10 fields: per-leaf INCLUDE zone pages (see SmolIncZonePageHeader) */
+    uint16      inc_zone_mask;        /* INCLUDE columns summarized (bit c = column c, 0-based) */
+    uint16      inc_zone_ncols;       /* bits set in inc_zone_mask */
+    BlockNumber inc_zone_blkno;       /* first zone page (InvalidBlockNumber or 0 if none) */
+    BlockNumber inc_zone_first;       /* leaf block of zone slot 0 */
+    uint32      inc_zone_nslots;      /* slots cover leaf blocks inc_zone_first onwards */
+    /* v12 field: set by smol_insert when a row lands at or below the append mark */
+    bool        append_stale;
 } SmolMeta;
 
 /*
- * Leaf Directory - Fixed-size directory for parallel scan partitioning
+ * Page opaque data
  *
- * Stored in a single regular page (no special opaque area).
- * Samples leaves to create ~100-500 partition points.
- * Workers divide entries and scan their assigned leaf ranges.
+ * heap_lo/heap_nblocks record the range of heap blocks referenced by a leaf,
+ * which is all amgetbitmap can report since SMOL stores no TIDs.  They reuse
+ * bytes that were alignment padding before, so the special space size is
+ * unchanged and leaves of older indexes read as heap_nblocks == 0 (unknown).
  */
-#define SMOL_DIR_MAGIC 0x534D4452  /* 'SMDR' */
-#define SMOL_DIR_MAX_ENTRIES 1000   /* Conservative: fits in 8KB page */
-
-typedef struct SmolDirEntry
-{
-    int32       key_prefix;    /* First key in partition (for debugging) */
-    BlockNumber leaf_blkno;    /* Leaf page block number */
-} SmolDirEntry;
-
-typedef struct SmolDirectory
-{
-    uint32      magic;          /* SMOL_DIR_MAGIC */
-    uint32      num_entries;    /* Number of valid entries */
-    SmolDirEntry entries[SMOL_DIR_MAX_ENTRIES];
-} SmolDirectory;
-
-/* Page opaque data */
 typedef struct SmolPageOpaqueData
 {
     uint16      flags;
+    uint16      heap_nblocks;   /* heap blocks spanned (0 = unknown) */
     BlockNumber rightlink;
     BlockNumber leftlink;
+    BlockNumber heap_lo;        /* first heap block referenced by this leaf */
 } SmolPageOpaqueData;
 
+/* heap_nblocks value meaning "from heap_lo to the end of the heap" */
+#define SMOL_HEAP_NBLOCKS_OPEN  PG_UINT16_MAX
+
 typedef SmolPageOpaqueData *SmolOpaque;
 
-/* Internal node item */
+/*
+ * Internal node items
+ *
+ * Indexes older than SMOL_META_VERSION_WIDE_KEYS store SmolInternalItem, whose
+ * int32 highkey/minkey truncate anything wider than int4.  Newer indexes store
+ * SmolInternalItemV6: the fixed header below followed by highkey and minkey as
+ * order-preserving "zone keys" of smol_meta_zkey_len() bytes each (8 for keys
+ * up to 8 bytes, 16 otherwise).  Zone keys compare with memcmp: they hold the
+ * smol_norm_key() words in big-endian order (integer-like types have held
+ * smol_norm64() that way all along), C-collation text holds its leading bytes.
+ * Before SMOL_META_VERSION_NORM_KEYS only integer-like types, uuid and text
+ * had comparable zone keys.  Readers decode either layout into SmolZoneItem.
+ */
+#define SMOL_ZKEY_MAX 16
+
 typedef struct SmolInternalItem
 {
     int32       highkey;           /* maximum key in subtree (existing) */
@@ -278,24 +475,205 @@ typedef struct SmolInternalItem
     uint64      bloom_filter;      /* 64-bit bloom filter (0 = disabled) */
 } SmolInternalItem;
 
+typedef struct SmolInternalItemV6
+{
+    BlockNumber child;             /* child block pointer */
+    uint32      row_count;         /* total rows in subtree */
+    uint16      distinct_count;    /* distinct values (saturates at 65535) */
+    uint16      padding;           /* alignment */
+    uint32      padding2;          /* alignment */
+    uint64      bloom_filter;      /* 64-bit bloom filter (0 = disabled) */
+    /* followed by highkey[zkey_len] and minkey[zkey_len] */
+} SmolInternalItemV6;
+
+/* Decoded internal item, independent of the on-disk layout */
+typedef struct SmolZoneItem
+{
+    BlockNumber child;
+    uint32      row_count;
+    uint16      distinct_count;
+    uint64      bloom_filter;
+    uint8       highkey[SMOL_ZKEY_MAX];  /* zone key of the subtree maximum */
+    uint8       minkey[SMOL_ZKEY_MAX];   /* zone key of the subtree minimum */
+} SmolZoneItem;
+
 /* Leaf reference during build */
 typedef struct SmolLeafRef
 {
     BlockNumber blk;
 } SmolLeafRef;
 
+/*
+ * Leaf Directory - row-weighted partition points for parallel scans
+ *
+ * Stored in consecutive regular pages (no special opaque area) starting at
+ * meta->directory_blkno.  Each entry starts at a leaf and covers roughly the
+ * same number of rows; its zone key (same encoding as internal items) lets a
+ * bounded scan find the entries inside the query range without descending
+ * the tree.  Only the first page carries num_entries/npages.
+ */
+#define SMOL_DIR_MAGIC_V1 0x534D4452  /* 'SMDR': single-page int32-prefix layout */
+#define SMOL_DIR_MAGIC 0x534D4432     /* 'SMD2' */
+#define SMOL_DIR_MAX_ENTRIES 65536    /* ~190 pages at most */
+#define SMOL_DIR_MIN_LEAVES 256       /* smaller indexes claim leaf-at-a-time */
+
+typedef struct SmolDirEntry
+{
+    BlockNumber leaf_blkno;             /* first leaf of the entry */
+    uint32      row_count;              /* rows from leaf_blkno up to the next entry */
+    uint8       minkey[SMOL_ZKEY_MAX];  /* zone key of the first key on leaf_blkno */
+} SmolDirEntry;
+
+typedef struct SmolDirPageHeader
+{
+    uint32      magic;          /* SMOL_DIR_MAGIC */
+    uint32      num_entries;    /* total entries in the directory */
+    uint16      npages;         /* directory pages */
+    uint16      zkey_len;       /* significant bytes of minkey */
+    uint16      page_entries;   /* entries on this page */
+    uint16      padding;
+} SmolDirPageHeader;
+
+#define SMOL_DIR_ENTRIES_PER_PAGE \
+    ((BLCKSZ - MAXALIGN(SizeOfPageHeaderData) - sizeof(SmolDirPageHeader)) / sizeof(SmolDirEntry))
+
+/* In-memory directory returned by smol_read_directory() */
+typedef struct SmolDirectory
+{
+    uint32      num_entries;
+    uint16      zkey_len;
+    uint64     *row_start;      /* rows before entry i; row_start[num_entries] = total */
+    SmolDirEntry entries[FLEXIBLE_ARRAY_MEMBER];
+} SmolDirectory;
+
+/*
+ * Per-leaf bloom pages
+ *
+ * Internal items carry one 64-bit bloom per subtree, which a leaf of a few
+ * hundred keys already saturates.  With smol.bloom_leaf_bits > 0 a build
+ * also writes one larger bloom per leaf to consecutive pages after the tree.
+ * Slot i describes block leaf_bloom_first + i; slots of blocks that are not
+ * leaves are all ones.  Leaves outside the slot range (appended segments)
+ * have no bloom.
+ */
+#define SMOL_LEAF_BLOOM_MAGIC 0x534D424C  /* 'SMBL' */
+#define SMOL_LEAF_BLOOM_MAX_BITS 32768
+
+typedef struct SmolLeafBloomPageHeader
+{
+    uint32      magic;          /* SMOL_LEAF_BLOOM_MAGIC */
+    uint32      first_slot;     /* slot of the first bloom on this page */
+    uint16      page_slots;     /* blooms on this page */
+    uint16      nwords;         /* uint64 words per bloom */
+    uint32      padding;
+} SmolLeafBloomPageHeader;
+
+#define SMOL_LEAF_BLOOMS_PER_PAGE(nwords) \
+    ((BLCKSZ - MAXALIGN(SizeOfPageHeaderData) - sizeof(SmolLeafBloomPageHeader)) / ((Size) (nwords) * sizeof(uint64)))
+
+#define SMOL_BLOOM_MAX_NHASH 8
+
+/*
+ * Per-leaf INCLUDE zone pages
+ *
+ * With smol.build_include_zones a single-key build also records the min and
+ * max of each integer INCLUDE column per leaf, on consecutive pages after the
+ * tree (and the bloom pages).  Slot i describes block inc_zone_first + i and
+ * carries the leaf's rightlink, so a reader can step over a leaf whose range
+ * misses its filter without reading it.  Slots of blocks that are not leaves
+ * have an invalid next and the full int64 range; so does the last leaf, whose
+ * rightlink smol_append may set later.
+ */
+#define SMOL_INC_ZONE_MAGIC 0x534D495A  /* 'SMIZ' */
+
+typedef struct SmolIncZonePageHeader
+{
+    uint32      magic;          /* SMOL_INC_ZONE_MAGIC */
+    uint32      first_slot;     /* slot of the first zone on this page */
+    uint16      page_slots;     /* zones on this page */
+    uint16      ncols;          /* columns per zone */
+    uint32      padding;
+} SmolIncZonePageHeader;
+
+typedef struct SmolIncZoneSlot
+{
+    BlockNumber next;           /* rightlink of the leaf (InvalidBlockNumber = read it) */
+    uint32      nrows;
+    int64       bounds[FLEXIBLE_ARRAY_MEMBER];  /* min, max per summarized column */
+} SmolIncZoneSlot;
+
+#define SMOL_INC_ZONE_SLOT_BYTES(ncols) \
+    (offsetof(SmolIncZoneSlot, bounds) + (Size) (ncols) * 2 * sizeof(int64))
+#define SMOL_INC_ZONES_PER_PAGE(ncols) \
+    ((BLCKSZ - MAXALIGN(SizeOfPageHeaderData) - sizeof(SmolIncZonePageHeader)) / SMOL_INC_ZONE_SLOT_BYTES(ncols))
+
+/*
+ * Shared scan statistics (pg_stat_smol)
+ *
+ * Scans count into their SmolScanOpaqueData and add the totals to a table of
+ * per-index atomic counters at endscan.  The table lives in a segment of the
+ * DSM registry, so it needs no shared_preload_libraries entry.  Slots are
+ * claimed by compare-and-swap on (database, index).  Once every slot is taken
+ * a new index takes over the slot of a dropped one of its database; when none
+ * is left it goes uncounted (smol_stat_reset() frees all slots).
+ */
+#define SMOL_STATS_SLOTS 1024
+
+typedef enum SmolStatCounter
+{
+    SMOL_STAT_SCANS,
+    SMOL_STAT_LEAVES,
+    SMOL_STAT_ZONE_PRUNED,
+    SMOL_STAT_BLOOM_CHECKS,
+    SMOL_STAT_BLOOM_PRUNED,
+    SMOL_STAT_RUNS,
+    SMOL_STAT_PREFETCHES,
+    SMOL_STAT_PARALLEL_SCANS,
+    SMOL_STAT_DIR_CLAIMS,
+    SMOL_STAT_DIR_STEALS,
+    SMOL_STAT_NCOUNTERS
+} SmolStatCounter;
+
+typedef struct SmolStatsEntry
+{
+    pg_atomic_uint64 key;       /* (dbid << 32) | index oid; 0 = free */
+    pg_atomic_uint64 counters[SMOL_STAT_NCOUNTERS];
+} SmolStatsEntry;
+
+typedef struct SmolStatsShared
+{
+    SmolStatsEntry entries[SMOL_STATS_SLOTS];
+} SmolStatsShared;
+
 /* Leaf statistics for zone map building (v2) */
 typedef struct SmolLeafStats
 {
     BlockNumber blk;            /* leaf block number */
-    int32       minkey;         /* minimum key in leaf */
-    int32       maxkey;         /* maximum key in leaf (highkey) */
     uint32      row_count;      /* number of rows in leaf */
     uint16      distinct_count; /* estimated distinct values (saturates at 65535) */
     uint16      padding;        /* alignment */
     uint64      bloom_filter;   /* 64-bit bloom filter for all keys in leaf */
+    uint8       minkey[SMOL_ZKEY_MAX];  /* zone key of minimum key in leaf */
+    uint8       maxkey[SMOL_ZKEY_MAX];  /* zone key of maximum key in leaf (highkey) */
 } SmolLeafStats;
 
+/*
+ * Sequential leaf writer for builds.  Each leaf is filled in place and held
+ * until the next one starts, so both sibling links are set before the page
+ * is written.  In bulk mode pages live in private memory and go through
+ * smgr bulk writes (batched extension, one fsync at finish), bypassing
+ * shared buffers; otherwise they are extended one at a time via smol_extend.
+ */
+typedef struct SmolLeafWriter
+{
+    Relation    idx;
+    BulkWriteState *bulk;       /* NULL = shared buffers */
+    BulkWriteBuffer page;       /* held leaf in bulk mode */
+    Buffer      buf;            /* held leaf otherwise */
+    BlockNumber blkno;          /* block of the held leaf */
+    BlockNumber next_blkno;     /* next block to assign in bulk mode */
+} SmolLeafWriter;
+
 /*
  * SmolIncludeMetadata - Dynamically allocated INCLUDE column metadata
  *
@@ -324,6 +702,14 @@ typedef struct SmolIncludeMetadata
     char      (*run_inc_vl)[VARHDRSZ + 32];  /* varlena blob storage */
 } SmolIncludeMetadata;
 
+/*
+ * Plain-page refill kernel: copy 'count' rows starting at 1-based row 'start'
+ * of a plain key array into the tuple buffer.  Variants specialized on key
+ * width and INCLUDE shape are generated in smol_scan.c.
+ */
+typedef uint16 (*SmolPlainKernel) (struct SmolScanOpaqueData *so, const char *keys,
+                                   uint16 start, uint16 count);
+
 typedef struct SmolScanOpaqueData
 {
     bool        initialized;    /* positioned to first tuple/group? */
@@ -352,12 +738,36 @@ typedef struct SmolScanOpaqueData
     /* optional equality filter on second key (attno=2) */
     bool        have_k2_eq;
     int64       k2_eq;
+    /* skip scan over k1 groups (two-col, forward, integer-ordered keys) */
+    bool        skip_scan;      /* k2_lo/k2_hi drive group skipping */
+    bool        skip_wide_groups; /* build stats: k1 groups average more than a leaf */
+    int64       k2_lo;          /* inclusive k2 range from the attno 2 quals */
+    int64       k2_hi;
+    BlockNumber skip_next_blk;  /* leaf to continue at instead of the rightlink */
 
     /* Scankeys for runtime filtering (all predicates) */
     ScanKey     runtime_keys;
     int         n_runtime_keys;
     bool        need_runtime_key_test; /* cached: true if runtime key testing needed (opt #4) */
 
+    /*
+     * ScalarArrayOp (= ANY(array)) keys, preprocessed in smol_rescan.  Leading
+     * key probes are sorted and de-duplicated; serial forward scans visit them
+     * one equality descent at a time (probe_mode), other scans treat them as a
+     * [first, last] range with a membership test.
+     */
+    bool        keys_unsatisfiable; /* an array qual has no usable elements */
+    Datum      *probe_vals;     /* leading-key probes (NULL if no array qual) */
+    int         nprobes;
+    int         probe_idx;      /* probe being scanned in probe_mode */
+    bool        probe_mode;     /* true: one equality descent per probe */
+    bool        need_runtime_key_test_base; /* need_runtime_key_test without the probe filter */
+    Buffer      probe_buf;      /* pinned leaf the current probe (or last bounded scan) starts on */
+    BlockNumber probe_start_blk; /* start leaf for the current probe, else InvalidBlockNumber */
+    Datum      *k2_vals;        /* sorted second-key array values (NULL if none) */
+    int         k2_nvals;
+    FmgrInfo   *k2_cmp;         /* comparator for k2_vals */
+
     /* type/width info (leading key always present; second key optional) */
     Oid         atttypid;       /* INT2OID/INT4OID/INT8OID */
     Oid         atttypid2;      /* second column type if 2-col, else InvalidOid */
@@ -402,6 +812,15 @@ typedef struct SmolScanOpaqueData
     uint64      prof_subtrees_skipped;   /* Subtrees skipped by zone maps */
     uint64      prof_bloom_checks;       /* Bloom filter checks performed */
     uint64      prof_bloom_skips;        /* Subtrees skipped by bloom */
+    /* Parallel directory profiling counters (per worker) */
+    uint64      prof_dir_claims;         /* directory entries taken from own range */
+    uint64      prof_dir_steals;         /* ranges stolen from another worker */
+    /* Always-on counters, flushed to pg_stat_smol at endscan */
+    uint64      stat_scans;              /* scans started (one per rescan) */
+    uint64      stat_leaves;             /* leaf pages read */
+    uint64      stat_runs;               /* duplicate-key runs emitted */
+    uint64      stat_prefetches;         /* leaf blocks requested ahead of the scan */
+    BlockNumber stat_last_blk;           /* last leaf counted in stat_leaves */
 
     /* two-col per-leaf cache to simplify correct emission */
     int64      *leaf_k1;
@@ -417,6 +836,8 @@ typedef struct SmolScanOpaqueData
     SmolDirectory *dir_data;         /* cached directory data */
     uint32      dir_current_idx;     /* current directory entry being scanned */
     BlockNumber dir_current_end;     /* end block for current directory entry */
+    int32       pscan_slot;          /* own work-stealing slot in SmolParallelScan (-1 = none) */
+    bool        dir_keyed;           /* directory zone keys bound the claimable entries */
 
     /* Equal-key run optimization (single-key indices): */
     bool        run_active;
@@ -426,6 +847,7 @@ typedef struct SmolScanOpaqueData
     char        run_key[16];    /* store up to 16 bytes of fixed-length key */
     int16       run_text_klen;  /* cached varlena key length for current run (text32) */
     bool        page_is_plain;  /* true when current page is plain (not RLE) - set once per page */
+    uint16      leaf_kernel_len; /* 2/4/8: plain leaves use the integer search kernels; 0 = comparator */
     /* RLE run caching to avoid O(m) scans in smol_leaf_keyptr_ex */
     uint16      rle_cached_run_idx;      /* current cached RLE run index (0-based) */
     uint32      rle_cached_run_acc;      /* accumulated offset before current run */
@@ -438,12 +860,23 @@ typedef struct SmolScanOpaqueData
     /* Cached page metadata (opt #5): nitems and format cached once per page */
     uint16      cur_page_nitems;    /* cached nitems for current page */
     uint8       cur_page_format;    /* cached format: 0=plain, 2=key_rle, 3=inc_rle */
+    /* FOR and prefix-text leaves are decoded once per page into a plain image [u16 n][keys] */
+    char       *for_keys;
+    Size        for_keys_cap;
+    BlockNumber for_blk;            /* leaf decoded into for_keys */
+    bool        for_active;         /* current page is decoded; keys come from for_keys */
+    /* Leaf read stream (smol.read_stream): predicted sibling blocks */
+    ReadStream *leaf_stream;
+    BlockNumber stream_next;        /* next block the callback yields */
+    BlockNumber stream_last;        /* last leaf the stream may yield in its direction */
+    BlockNumber stream_limit;       /* forward: last leaf within the upper bound */
+    bool        stream_backward;    /* stream walks leftlinks */
     bool        plain_inc_cached;   /* true when plain_inc_base[] is valid for current page */
     bool        rle_run_inc_cached;  /* true when rle_run_inc_ptr[] is valid for current run */
     /* Prebuilt varlena blobs reused within run (text) */
     bool        run_key_built;
     int16       run_key_vl_len; /* bytes in run_key_vl (VARHDR+payload) */
-    char        run_key_vl[VARHDRSZ + 32];
+    char        run_key_vl[VARHDRSZ + SMOL_TEXT_KEY_MAX];
 
     /* Adaptive prefetching for bounded scans (slow-start to avoid over-prefetching) */
     uint16      pages_scanned;     /* total pages successfully scanned (not skipped) */
@@ -460,19 +893,37 @@ typedef struct SmolScanOpaqueData
     bool        key_is_text32;  /* true when key type is text/varchar packed to 32B */
     bool        has_varwidth;   /* any varlena field present in tuple (key or includes) */
 
-    /* Tuple buffering for high-selectivity scans (forward direction only) */
+    /* Tuple buffering for high-selectivity scans (both directions, all leaf layouts) */
     bool        tuple_buffering_enabled; /* true when buffering is active for this scan */
     IndexTuple *tuple_buffer;     /* array of pre-built tuples */
-    char       *tuple_buffer_data; /* backing memory for tuple data */
+    bool        tuple_buffer_aliased; /* RLE run rows share a slot: entry i may not be slot i */
+    char       *tuple_buffer_data; /* backing memory: capacity slots of tuple_size bytes */
     uint16      tuple_buffer_capacity; /* buffer size (tuples) */
     uint16      tuple_buffer_count;    /* number of valid tuples in buffer */
     uint16      tuple_buffer_current;  /* current read position in buffer */
-    uint16      tuple_size;       /* size of each tuple (key + includes) */
+    uint16      tuple_size;       /* slot size: the widest tuple, varlena fields at full width */
+    SmolPlainKernel plain_kernel; /* specialized refill for this shape, NULL = generic */
 } SmolScanOpaqueData;
 typedef SmolScanOpaqueData *SmolScanOpaque;
+/*
+ * Parallel scan shared state.  Without a leaf directory workers claim one
+ * leaf at a time through curr.  With a directory each worker owns a slot
+ * holding its unclaimed range of directory entries: the owner takes entries
+ * from the front, and a worker whose range is empty CAS-steals the back half
+ * of the largest remaining range.  Slot 0 starts out holding every entry
+ * (hi = SMOL_PSCAN_RANGE_UNSET until the first worker resolves the lower
+ * bound to a start entry); the other slots start empty and fill by stealing.
+ */
+#define SMOL_PSCAN_MAX_SLOTS    64
+#define SMOL_PSCAN_RANGE_UNSET  PG_UINT32_MAX
+#define SMOL_PSCAN_NO_ENTRY     PG_UINT32_MAX
+
 typedef struct SmolParallelScan
 {
     pg_atomic_uint32 curr;    /* next leaf to claim (0 = init, InvalidBlockNumber = done) */
+    pg_atomic_uint32 nslots;  /* directory mode: work-stealing slots handed out */
+    pg_atomic_uint32 stop_entry; /* directory mode: entries at or past this cannot match */
+    pg_atomic_uint64 range[SMOL_PSCAN_MAX_SLOTS]; /* unclaimed entries [lo, hi) as (hi << 32) | lo */
 } SmolParallelScan;
 typedef struct SmolParallelHdr
 {
@@ -529,6 +980,28 @@ typedef struct SmolTextBuildContext
     int            *pmax;
 } SmolTextBuildContext;
 
+/* Tuplesort collector for INCLUDE builds: tracks the widest text INCLUDE value */
+typedef struct SmolIncSortContext
+{
+    Tuplesortstate *ts;
+    Size           *pnkeys;
+    int             nkeyatts;
+    int             incn;
+    bool            itext[16];
+    int             imax[16];
+} SmolIncSortContext;
+
+
+/* Key-only single-column collector for the in-memory radix build */
+typedef struct SmolKeyArrayContext
+{
+    char       *keys;      /* key_len-byte keys in heap order */
+    BlockNumber *blks;     /* heap block of each key */
+    Size        cap;
+    Size        n;
+    uint16      key_len;
+    bool        byval;
+} SmolKeyArrayContext;
 
 /* Two-column generic builders */
 typedef struct SmolPairContext
@@ -561,6 +1034,24 @@ typedef struct SmolIncludeContext {
     int16 inumeric_scale[16];  /* scale for NUMERIC INCLUDE columns */
     Size *pcap; Size *pcount; int incn;
 } SmolIncludeContext;
+
+/*
+ * Streamed INCLUDE builds: the leaf writers look at most
+ * SMOL_BUILD_LOOKAHEAD_ROWS rows ahead (the Include-RLE candidate window), so
+ * the merged sort output is packed into the collection arrays a window at a
+ * time and slid forward whenever fewer rows than that remain unconsumed.
+ */
+#define SMOL_BUILD_LOOKAHEAD_ROWS 32000
+#define SMOL_BUILD_WINDOW_ROWS    65536
+typedef struct SmolRowWindow
+{
+    Tuplesortstate *ts;          /* merged, sorted row stream */
+    Relation index;
+    TupleDesc tupdesc;
+    SmolIncludeContext *cctx;    /* packs each row into the column arrays */
+    bool done;                   /* stream exhausted */
+    Size nrows;                  /* rows delivered so far */
+} SmolRowWindow;
 typedef struct SMOLShared
 {
     /* Immutable state shared across all workers */
@@ -577,6 +1068,7 @@ typedef struct SMOLShared
     int nparticipantsdone;
     double reltuples;
     int maxlen;  /* Maximum text length seen across all workers (for text types) */
+    int inc_maxlen[16];  /* Widest text INCLUDE value seen (INCLUDE builds) */
 
     /*
      * ParallelTableScanDescData follows. Can't directly embed here, as
@@ -623,6 +1115,79 @@ smol_page_opaque(Page page)
     return (SmolPageOpaqueData *) PageGetSpecialPointer(page);
 }
 
+/* True if the index has per-leaf bloom pages */
+static inline bool
+smol_meta_has_leaf_blooms(const SmolMeta *meta)
+{
+    return meta->version >= SMOL_META_VERSION_TYPED_BLOOM && meta->leaf_bloom_words > 0 &&
+           meta->leaf_bloom_blkno != 0 && BlockNumberIsValid(meta->leaf_bloom_blkno);
+}
+
+/* True if the index has per-leaf INCLUDE zone pages */
+static inline bool
+smol_meta_has_inc_zones(const SmolMeta *meta)
+{
+    return meta->version >= SMOL_META_VERSION_INC_ZONES && meta->inc_zone_ncols > 0 &&
+           meta->inc_zone_blkno != 0 && BlockNumberIsValid(meta->inc_zone_blkno);
+}
+
+/* Position of 0-based INCLUDE column c among the summarized ones, or -1 */
+static inline int
+smol_inc_zone_col(const SmolMeta *meta, int c)
+{
+    if (c < 0 || c >= 16 || (meta->inc_zone_mask & (1u << c)) == 0)
+        return -1;
+    return pg_popcount32(meta->inc_zone_mask & ((1u << c) - 1));
+}
+
+/* True if internal items use the SmolInternalItemV6 layout */
+static inline bool
+smol_meta_wide_keys(const SmolMeta *meta)
+{
+    return meta->version >= SMOL_META_VERSION_WIDE_KEYS;
+}
+
+/* Zone key width of internal items (legacy int32 keys decode to 8 bytes) */
+static inline uint16
+smol_meta_zkey_len(const SmolMeta *meta)
+{
+    return smol_meta_wide_keys(meta) ? meta->zkey_len : 8;
+}
+
+/* Widen a [lo, hi] heap block range (lo == InvalidBlockNumber means empty) */
+static inline void
+smol_heap_range_add(BlockNumber *lo, BlockNumber *hi, BlockNumber blk)
+{
+    if (!BlockNumberIsValid(*lo))
+    {
+        *lo = *hi = blk;
+        return;
+    }
+    if (blk < *lo)
+        *lo = blk;
+    if (blk > *hi)
+        *hi = blk;
+}
+
+/* Store a leaf's heap block range in its opaque data */
+static inline void
+smol_page_set_heap_range(Page page, BlockNumber lo, BlockNumber hi)
+{
+    SmolPageOpaqueData *op = smol_page_opaque(page);
+
+    if (!BlockNumberIsValid(lo))
+    {
+        op->heap_lo = InvalidBlockNumber;
+        op->heap_nblocks = 0;
+        return;
+    }
+    op->heap_lo = lo;
+    if ((uint64) hi - lo + 1 >= SMOL_HEAP_NBLOCKS_OPEN)
+        op->heap_nblocks = SMOL_HEAP_NBLOCKS_OPEN;
+    else
+        op->heap_nblocks = (uint16) (hi - lo + 1);
+}
+
 /*
  * Fast copy helpers and related functions
  *
@@ -716,10 +1281,57 @@ smol_norm64(int64 v)
 #endif /* SMOL_TEST_COVERAGE */
 
 /* Two-column row pointer helpers */
+static inline char *smol12_payload(Page page)
+{
+    return (char *) PageGetItem(page, PageGetItemId(page, FirstOffsetNumber));
+}
+
+static inline bool smol12_is_grouped(const char *payload)
+{
+    uint16 tag; memcpy(&tag, payload, sizeof(uint16)); return tag == SMOL_TAG_K1_GROUPS;
+}
+
+static inline uint16 smol12_ngroups(const char *payload)
+{
+    uint16 g; memcpy(&g, payload + sizeof(uint16) * 2, sizeof(uint16)); return g;
+}
+
+/* Group directory entry g: k1 followed by the group's first row and count */
+static inline char *smol12_group_k1(const char *payload, uint16 g, uint16 key_len1)
+{
+    return (char *) payload + SMOL12_GROUP_HEADER + (size_t) g * ((size_t) key_len1 + sizeof(uint16) * 2);
+}
+
+static inline void smol12_group_range(const char *payload, uint16 g, uint16 key_len1, uint16 *first, uint16 *cnt)
+{
+    char *e = smol12_group_k1(payload, g, key_len1) + key_len1;
+    memcpy(first, e, sizeof(uint16));
+    memcpy(cnt, e + sizeof(uint16), sizeof(uint16));
+}
+
+/* Group holding 0-based row r: last directory entry whose first row <= r */
+static inline uint16 smol12_group_of_row(const char *payload, uint16 r, uint16 key_len1)
+{
+    uint16 lo = 0, hi = smol12_ngroups(payload) - 1;
+    while (lo < hi)
+    {
+        uint16 mid = (uint16) ((lo + hi + 1) >> 1);
+        uint16 first, cnt;
+        smol12_group_range(payload, mid, key_len1, &first, &cnt);
+        if (first <= r) lo = mid; else hi = (uint16) (mid - 1);
+    }
+    return lo;
+}
+
+static inline char *smol12_group_k2_base(const char *payload, uint16 key_len1)
+{
+    return smol12_group_k1(payload, smol12_ngroups(payload), key_len1);
+}
+
+/* Row-major layout only: start of row (1-based) */
 static inline char *smol12_row_ptr(Page page, uint16 row, uint16 key_len1, uint16 key_len2, uint32 inc_total_len)
 {
-    ItemId iid = PageGetItemId(page, FirstOffsetNumber);
-    char *base = (char *) PageGetItem(page, iid);
+    char *base = smol12_payload(page);
     size_t row_size = (size_t) key_len1 + (size_t) key_len2 + (size_t) inc_total_len;
     size_t off = sizeof(uint16) + (size_t)(row - 1) * row_size;
     return base + off;
@@ -727,14 +1339,31 @@ static inline char *smol12_row_ptr(Page page, uint16 row, uint16 key_len1, uint1
 
 static inline char *smol12_row_k1_ptr(Page page, uint16 row, uint16 key_len1, uint16 key_len2, uint32 inc_total_len)
 {
+    char *p = smol12_payload(page);
+    if (smol12_is_grouped(p))
+        return smol12_group_k1(p, smol12_group_of_row(p, (uint16) (row - 1), key_len1), key_len1);
     return smol12_row_ptr(page, row, key_len1, key_len2, inc_total_len) + 0;
 }
 
 static inline char *smol12_row_k2_ptr(Page page, uint16 row, uint16 key_len1, uint16 key_len2, uint32 inc_total_len)
 {
+    char *p = smol12_payload(page);
+    if (smol12_is_grouped(p))
+        return smol12_group_k2_base(p, key_len1) + (size_t) (row - 1) * key_len2;
     return smol12_row_ptr(page, row, key_len1, key_len2, inc_total_len) + key_len1;
 }
 
+static inline char *smol12_row_inc_ptr(Page page, uint16 row, uint16 key_len1, uint16 key_len2, uint32 inc_total_len)
+{
+    char *p = smol12_payload(page);
+    if (smol12_is_grouped(p))
+    {
+        uint16 n; memcpy(&n, p + sizeof(uint16), sizeof(uint16));
+        return smol12_group_k2_base(p, key_len1) + (size_t) n * key_len2 + (size_t) (row - 1) * inc_total_len;
+    }
+    return smol12_row_ptr(page, row, key_len1, key_len2, inc_total_len) + key_len1 + key_len2;
+}
+
 /* Single-column + INCLUDE helpers */
 static inline char *smol1_payload(Page page)
 {
@@ -742,12 +1371,159 @@ static inline char *smol1_payload(Page page)
     return (char *) PageGetItem(page, iid);
 }
 
+/* Frame-of-reference leaf accessors (see SMOL_TAG_KEY_FOR) */
+typedef struct SmolForLeaf
+{
+    uint16      nitems;
+    uint16      nblocks;
+    const char *bases;
+    const char *offs;
+    const uint8 *widths;
+    const char *data;
+} SmolForLeaf;
+
+static inline void smol_for_open(const char *payload, SmolForLeaf *f)
+{
+    memcpy(&f->nitems, payload + sizeof(uint16), sizeof(uint16));
+    memcpy(&f->nblocks, payload + sizeof(uint16) * 2, sizeof(uint16));
+    f->bases = payload + SMOL_FOR_HEADER;
+    f->offs = f->bases + (size_t) f->nblocks * sizeof(int64);
+    f->widths = (const uint8 *) (f->offs + (size_t) f->nblocks * sizeof(uint16));
+    f->data = (const char *) f->widths + f->nblocks;
+}
+
+/* Bits needed for a block whose keys span `range`; 58..63 round up to 64 so
+ * a shifted value always fits the 8-byte load */
+static inline uint8 smol_for_width(uint64 range)
+{
+    int w = (range == 0) ? 0 : pg_leftmost_one_pos64(range) + 1;
+    return (uint8) (w > 57 ? 64 : w);
+}
+
+/* Encoded bytes for one block of cnt keys at the given width */
+static inline Size smol_for_block_bytes(uint32 cnt, uint8 width)
+{
+    return sizeof(int64) + sizeof(uint16) + sizeof(uint8) + ((Size) cnt * width + 7) / 8;
+}
+
+static inline uint64 smol_for_bits(const char *data, uint32 bitpos, uint8 width)
+{
+    uint64 w;
+    memcpy(&w, data + (bitpos >> 3), sizeof(uint64));
+#ifdef WORDS_BIGENDIAN
+    w = pg_bswap64(w);
+#endif
+    w >>= (bitpos & 7);
+    return (width == 64) ? w : (w & ((UINT64CONST(1) << width) - 1));
+}
+
+/* Key at 0-based position i */
+static inline int64 smol_for_value(const SmolForLeaf *f, uint32 i)
+{
+    uint32 b = i / SMOL_FOR_BLOCK;
+    int64 base;
+    uint16 off;
+    uint8 width = f->widths[b];
+
+    memcpy(&base, f->bases + (size_t) b * sizeof(int64), sizeof(int64));
+    memcpy(&off, f->offs + (size_t) b * sizeof(uint16), sizeof(uint16));
+    return (int64) ((uint64) base +
+                    smol_for_bits(f->data + off, (i % SMOL_FOR_BLOCK) * width, width));
+}
+
+/* Load an integer key of its on-disk width */
+static inline int64 smol_for_load_key(const char *k, uint16 key_len)
+{
+    if (key_len == 2) { int16 x; memcpy(&x, k, sizeof(int16)); return x; }
+    if (key_len == 4) { int32 x; memcpy(&x, k, sizeof(int32)); return x; }
+    { int64 x; memcpy(&x, k, sizeof(int64)); return x; }
+}
+
+/* Store an integer key back in its on-disk width */
+static inline void smol_for_store_key(char *dst, int64 v, uint16 key_len)
+{
+    if (key_len == 2) { int16 x = (int16) v; memcpy(dst, &x, sizeof(int16)); }
+    else if (key_len == 4) { int32 x = (int32) v; memcpy(dst, &x, sizeof(int32)); }
+    else memcpy(dst, &v, sizeof(int64));
+}
+
+/* Prefix-truncated text leaf accessors (see SMOL_TAG_TEXT_PREFIX) */
+typedef struct SmolTextPrefixLeaf
+{
+    uint16      nitems;
+    uint16      plen;
+    const char *offs;
+    const char *prefix;
+    const char *sfx;
+} SmolTextPrefixLeaf;
+
+static inline void smol_tp_open(const char *payload, SmolTextPrefixLeaf *t)
+{
+    memcpy(&t->nitems, payload + sizeof(uint16), sizeof(uint16));
+    memcpy(&t->plen, payload + sizeof(uint16) * 2, sizeof(uint16));
+    t->offs = payload + SMOL_TP_HEADER;
+    t->prefix = t->offs + ((size_t) t->nitems + 1) * sizeof(uint16);
+    t->sfx = t->prefix + t->plen;
+}
+
+/* Rebuild key i (0-based) NUL-padded to key_len bytes */
+static inline void smol_tp_key(const SmolTextPrefixLeaf *t, uint32 i, char *dst, uint16 key_len)
+{
+    uint16 o0, o1, len;
+
+    memcpy(&o0, t->offs + (size_t) i * sizeof(uint16), sizeof(uint16));
+    memcpy(&o1, t->offs + ((size_t) i + 1) * sizeof(uint16), sizeof(uint16));
+    len = (uint16) (t->plen + (o1 - o0));
+    memcpy(dst, t->prefix, t->plen);
+    memcpy(dst + t->plen, t->sfx + o0, (size_t) (o1 - o0));
+    if (len < key_len)
+        memset(dst + len, 0, (size_t) (key_len - len));
+}
+
+/* Dictionary-coded INCLUDE leaf accessors (see SMOL_TAG_INC_DICT) */
+typedef struct SmolIncDictCol
+{
+    uint16      ndict;          /* 0 = raw values */
+    uint8       width;          /* code bits */
+    const char *vals;           /* dictionary, or the raw values */
+    const char *codes;
+} SmolIncDictCol;
+
+static inline const char *smol_incdict_keys(const char *payload)
+{
+    uint16 ninc;
+
+    memcpy(&ninc, payload + sizeof(uint16) * 2, sizeof(uint16));
+    return payload + SMOL_INC_DICT_HEADER + (size_t) ninc * sizeof(uint16);
+}
+
+static inline void smol_incdict_col(const char *payload, uint16 col, uint16 len, SmolIncDictCol *c)
+{
+    uint16 off;
+
+    memcpy(&off, payload + SMOL_INC_DICT_HEADER + (size_t) col * sizeof(uint16), sizeof(uint16));
+    memcpy(&c->ndict, payload + off, sizeof(uint16));
+    c->width = (c->ndict > 0) ? smol_for_width((uint64) (c->ndict - 1)) : 0;
+    c->vals = payload + off + SMOL_INC_DICT_COL;
+    c->codes = c->vals + (size_t) c->ndict * len;
+}
+
+/* Value of a column at 0-based row */
+static inline const char *smol_incdict_value(const SmolIncDictCol *c, uint32 row, uint16 len)
+{
+    if (c->ndict == 0)
+        return c->vals + (size_t) row * len;
+    return c->vals + (size_t) smol_for_bits(c->codes, row * c->width, c->width) * len;
+}
+
 /* Get number of rows in two-column leaf page */
 static inline uint16 smol12_leaf_nrows(Page page)
 {
-    ItemId iid = PageGetItemId(page, FirstOffsetNumber);
-    char *p = (char *) PageGetItem(page, iid);
-    uint16 n; memcpy(&n, p, sizeof(uint16)); return n;
+    char *p = smol12_payload(page);
+    uint16 n; memcpy(&n, p, sizeof(uint16));
+    if (n == SMOL_TAG_K1_GROUPS)
+        memcpy(&n, p + sizeof(uint16), sizeof(uint16));
+    return n;
 }
 
 /* Reset scan run state */
@@ -793,11 +1569,13 @@ extern StrategyNumber smol_translatecmptype(CompareType cmptype, Oid opfamily);
 extern IndexScanDesc smol_beginscan(Relation index, int nkeys, int norderbys);
 extern void smol_rescan(IndexScanDesc scan, ScanKey keys, int nkeys, ScanKey orderbys, int norderbys);
 extern bool smol_gettuple(IndexScanDesc scan, ScanDirection dir);
+extern int64 smol_getbitmap(IndexScanDesc scan, TIDBitmap *tbm);
 extern void smol_endscan(IndexScanDesc scan);
 extern bool smol_canreturn(Relation index, int attno);
 extern Size smol_estimateparallelscan(Relation index, int nkeys, int norderbys);
 extern void smol_initparallelscan(void *target);
 extern void smol_parallelrescan(IndexScanDesc scan);
+extern void smol_agg_check_access(Relation idx, const char *fname);
 
 /* Utility functions (smol_utils.c) */
 extern void smol_meta_read(Relation idx, SmolMeta *out);
@@ -805,9 +1583,14 @@ extern void smol_meta_init_zone_maps(SmolMeta *meta);
 extern void smol_mark_heap0_allvisible(Relation heapRel);
 extern Buffer smol_extend(Relation idx);
 extern void smol_init_page(Buffer buf, bool leaf, BlockNumber rightlink);
+extern void smol_init_page_image(Page page, bool leaf, BlockNumber rightlink);
 extern void smol_link_siblings(Relation idx, BlockNumber prev, BlockNumber cur);
+extern void smol_leaf_writer_begin(SmolLeafWriter *w, Relation idx, bool bulk);
+extern Page smol_leaf_writer_next(SmolLeafWriter *w);
+extern void smol_leaf_writer_finish(SmolLeafWriter *w);
 extern BlockNumber smol_find_first_leaf(Relation idx, int64 lower_bound, Oid atttypid, uint16 key_len);
 extern BlockNumber smol_find_first_leaf_generic(Relation idx, SmolScanOpaque so);
+extern BlockNumber smol_find_probe_leaf(Relation idx, SmolScanOpaque so, bool *absent_out);
 extern BlockNumber smol_find_leaf_for_upper_bound(Relation idx, SmolScanOpaque so);
 extern void smol_find_end_position(Relation idx, SmolScanOpaque so, BlockNumber *end_blk_out, OffsetNumber *end_off_out);
 extern int smol_cmp_keyptr_bound_generic(FmgrInfo *cmp, Oid collation, Oid atttypid, const char *keyp, uint16 key_len, bool key_byval, Datum bound);
@@ -815,19 +1598,108 @@ extern int smol_cmp_keyptr_bound(const char *keyp, uint16 key_len, Oid atttypid,
 extern uint16 smol_leaf_nitems(Page page);
 extern char *smol_leaf_keyptr_ex(Page page, uint16 idx, uint16 key_len, const uint16 *inc_lens, uint16 ninc, const uint32 *inc_cumul_offs);
 extern bool smol_key_eq_len(const char *a, const char *b, uint16 len);
+extern char *smol_leaf_plain_keys(Page page, uint16 *nitems_out);
+extern uint16 smol_leaf_search_int(const char *keys, uint16 n, uint16 key_len,
+                                   int64 bound, bool strict, uint64 *bsteps);
+extern Size smol_for_encode(char *dst, const char *keys, uint16 n, uint16 key_len);
+extern void smol_for_decode(const char *payload, char *out, uint16 key_len);
+extern Size smol_tp_fit(const char *keys, Size n, uint16 key_len, Size avail);
+extern Size smol_tp_encode(char *dst, const char *keys, uint16 n, uint16 key_len);
+extern void smol_tp_decode(const char *payload, char *out, uint16 key_len);
+extern Size smol_inc_dict_fit(const char * const *incs, Size start, Size n, uint16 key_len,
+                              int ninc, const uint16 *inc_lens, Size avail);
+extern Size smol_inc_dict_encode(char *dst, const char *keys, const char * const *incs, Size start,
+                                 uint16 n, uint16 key_len, int ninc, const uint16 *inc_lens);
+extern void smol_inc_dict_decode(const char *payload, char *out, uint16 key_len, const uint16 *inc_lens);
+extern uint16 smol_for_search_int(const char *payload, int64 bound, bool strict);
+extern Size smol12_group_fit(const char *k1buf, const uint32 *perm, Size start, Size n,
+                             uint16 key_len1, Size rest, Size avail);
+extern Size smol12_group_encode(char *dst, const char *k1buf, const char *k2buf, const uint32 *perm,
+                                Size start, uint16 nrows, uint16 key_len1, uint16 key_len2,
+                                char * const *incs, int inc_count, const uint16 *inc_lens);
+extern uint16 smol_leaf_run_end_int(const char *keys, uint16 n, uint16 key_len, uint16 start);
 extern BlockNumber smol_rightmost_leaf(Relation idx);
 
 /* Zone map statistics collection (smol_utils.c) */
 extern void smol_collect_leaf_stats(SmolLeafStats *stats, const void *keys, uint32 n,
                                     uint16 key_len, Oid typid, BlockNumber blk);
+extern void smol_leaf_stats_highkey_only(SmolLeafStats *stats, BlockNumber blk, const char *last_key,
+                                         uint16 key_len, Oid typid);
+
+/* Order-preserving key normalization (smol_utils.c) */
+extern int smol_norm_nwords(Oid typid, uint16 key_len);
+extern void smol_norm_key(const char *key, uint16 key_len, Oid typid, uint64 *out);
+extern const char *smol_datum_key_bytes(Datum d, uint16 key_len, bool byval, char *buf);
+
+/* Normalized zone keys and internal items (smol_utils.c) */
+extern void smol_zkey_from_int64(uint8 *out, int64 v);
+extern void smol_zkey_from_keyptr(uint8 *out, uint16 zkey_len, const char *keyp, uint16 key_len, Oid typid);
+extern bool smol_zkey_type_is_int64(Oid typid);
+extern int64 smol_bound_to_int64(Oid typid, Datum bound, int64 dflt);
+extern bool smol_scan_bound_zkey(SmolScanOpaque so, const SmolMeta *meta, bool upper, uint8 *out, bool *exact);
+extern void smol_internal_item_read(Page page, OffsetNumber off, const SmolMeta *meta, SmolZoneItem *out);
+extern Size smol_internal_item_write(char *dst, const SmolZoneItem *item, const SmolMeta *meta);
+
+/* Backend-local cache of the metapage and decoded internal pages (smol_utils.c) */
+typedef struct SmolTreeNode
+{
+    uint16      nitems;
+    SmolZoneItem items[FLEXIBLE_ARRAY_MEMBER];
+} SmolTreeNode;
+
+/* An internal page during a descent: cached items, or a pinned page */
+typedef struct SmolNodeView
+{
+    const SmolTreeNode *node;
+    Buffer      buf;
+    Page        page;
+    const SmolMeta *meta;
+} SmolNodeView;
+
+extern void smol_tree_cache_register(void);
+extern void smol_tree_cache_invalidate(Relation idx);
+extern void smol_meta_get(Relation idx, SmolMeta *out);
+extern OffsetNumber smol_node_open(Relation idx, const SmolMeta *meta, BlockNumber blk, SmolNodeView *v);
+extern void smol_node_close(SmolNodeView *v);
+
+static inline void
+smol_node_item(const SmolNodeView *v, OffsetNumber off, SmolZoneItem *out)
+{
+    if (v->node)
+        *out = v->node->items[off - 1];
+    else
+        smol_internal_item_read(v->page, off, v->meta, out);
+}
 
 /* Bloom filter functions (smol_utils.c) */
-extern void smol_bloom_add(uint64 *bloom, Datum key, Oid typid, int nhash);
-extern bool smol_bloom_test(uint64 bloom, Datum key, Oid typid, int nhash);
-extern uint64 smol_bloom_build_page(Page page, uint16 key_len, Oid typid, int nhash);
+extern uint64 smol_bloom_hash_key(const char *key, uint16 key_len, Oid typid);
+extern uint64 smol_bloom_hash_bound(Datum bound, Oid typid, uint16 key_len, bool byval);
+extern void smol_bloom_add(uint64 *bits, uint32 nbits, uint64 h, int nhash);
+extern bool smol_bloom_test(const uint64 *bits, uint32 nbits, uint64 h, int nhash);
+extern void smol_bloom_fill_page(Page page, uint16 key_len, uint32 inc_total, Oid typid, int nhash,
+                                 uint64 *bits, uint32 nbits);
+extern uint64 smol_bloom_build_page(Page page, uint16 key_len, uint32 inc_total, Oid typid, int nhash);
+extern bool smol_scan_bloom_usable(SmolScanOpaque so, const SmolMeta *meta);
+extern BlockNumber smol_build_and_write_leaf_blooms(Relation idx, SmolMeta *meta);
+extern bool smol_leaf_bloom_test(Relation idx, const SmolMeta *meta, BlockNumber leaf, uint64 h);
+extern BlockNumber smol_build_and_write_inc_zones(Relation idx, SmolMeta *meta);
+extern const SmolIncZoneSlot *smol_inc_zone_slot(Relation idx, const SmolMeta *meta, BlockNumber leaf, Buffer *zbuf);
+
+/* Shared scan statistics (smol_utils.c) */
+extern void smol_stats_flush(IndexScanDesc scan, SmolScanOpaque so);
 
 /* Leaf directory functions (smol_utils.c) */
 extern BlockNumber smol_build_and_write_directory(Relation idx);
+extern void smol_collect_meta_stats(Relation idx);
+extern void smol_heap_append_mark(Relation heap, BlockNumber *blk, OffsetNumber *off);
+extern void smol_heap_new_rows_check(Relation heap, BlockNumber from_blk, OffsetNumber from_off,
+                                     BlockNumber to_blk, OffsetNumber to_off,
+                                     bool *current_xact, bool *updated);
+extern void smol_meta_set_append_mark(Relation idx, Relation heap);
+extern double smol_root_zone_fraction(Relation idx, SmolScanOpaque so, SmolMeta *meta);
+extern uint64 smol_prewarm_upper(Relation idx, const SmolMeta *meta);
+extern uint64 smol_prewarm_blocks(Relation idx, BlockNumber start, BlockNumber end);
+extern void smol_resident_warm(Relation idx, const SmolMeta *meta);
 extern SmolDirectory *smol_read_directory(Relation idx, BlockNumber dir_blk);
 
 /* NUMERIC support functions (smol_utils.c) */
@@ -838,6 +1710,7 @@ extern Datum smol_int64_to_numeric(int64 value, int scale);
 
 /* Parallel build worker entry (must be extern for dynamic loading) */
 extern PGDLLEXPORT void smol_parallel_build_main(dsm_segment *seg, shm_toc *toc);
+extern PGDLLEXPORT void smol_parallel_prewarm_main(dsm_segment *seg, shm_toc *toc);
 
 
 /* Bound comparison helpers (inline for performance in production, extern in coverage builds) */
@@ -859,13 +1732,13 @@ smol_cmp_keyptr_to_bound(SmolScanOpaque so, const char *keyp)
             return smol_cmp_keyptr_bound_generic(&so->cmp_fmgr, so->collation, so->atttypid, keyp, so->key_len, so->key_byval, so->bound_datum);
         }
 
-        /* C collation: compare 32-byte padded keyp with detoasted bound text (binary) */
+        /* C collation: compare NUL-padded keyp with detoasted bound text (binary) */
         text *bt = DatumGetTextPP(so->bound_datum);
         int blen = VARSIZE_ANY_EXHDR(bt);
         const char *b = VARDATA_ANY(bt);
         /* Compute key length up to first zero using memchr */
-        /* In two-column indexes, k2 follows immediately after k1, so we must limit search to so->key_len */
-        int search_len = so->two_col ? so->key_len : 32;
+        /* Keys are NUL-padded to so->key_len; in two-column indexes k2 follows right after */
+        int search_len = so->key_len;
         const char *kend = (const char *) memchr(keyp, '\0', search_len);
         int klen = kend ? (int)(kend - keyp) : search_len;
         int minl = (klen < blen) ? klen : blen;
@@ -902,8 +1775,8 @@ smol_cmp_keyptr_to_upper_bound(SmolScanOpaque so, const char *keyp)
         text *bt = DatumGetTextPP(so->upper_bound_datum);
         int blen = VARSIZE_ANY_EXHDR(bt);
         const char *b = VARDATA_ANY(bt);
-        /* In two-column indexes, k2 follows immediately after k1, so we must limit search to so->key_len */
-        int search_len = so->two_col ? so->key_len : 32;
+        /* Keys are NUL-padded to so->key_len; in two-column indexes k2 follows right after */
+        int search_len = so->key_len;
         const char *kend = (const char *) memchr(keyp, '\0', search_len);
         int klen = kend ? (int)(kend - keyp) : search_len;
         int minl = (klen < blen) ? klen : blen;
@@ -21,36 +21,114 @@ static void smol_sort_pairs_rows64(int64 *k1, int64 *k2, Size n);
 static void smol_build_cb_inc(Relation rel, ItemPointer tid, Datum *values, bool *isnull, bool tupleIsAlive, void *state);
 static void smol_begin_parallel(SMOLBuildState *buildstate, bool isconcurrent, int request);
 static void smol_end_parallel(SMOLLeader *smolleader);
-static void smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * const *incs, Size nkeys, uint16 key_len, int inc_count, const uint16 *inc_lens);
-static void smol_build_text_inc_from_sorted(Relation idx, const char *keys32, const char * const *incs, Size nkeys, uint16 key_len, int inc_count, const uint16 *inc_lens);
+static bool smol_parallel_collect_ok(Relation index);
+static void smol_parallel_wait_workers(SMOLLeader *smolleader, Size *nkeys, int *maxlen);
+static Size smol_parallel_merge_collect(SMOLBuildState *buildstate, IndexBuildCallback cb, void *state);
+static bool smol_inc_build_spills(Relation heap, Relation index);
+static void smol_build_inc_streamed(SMOLBuildState *buildstate, SmolIncludeContext *cctx, uint16 *inc_lens);
+static Size smol_row_window_refill(SmolRowWindow *win, Size consumed);
+static void smol_inc_sort_context_init(SmolIncSortContext *c, Relation index, Tuplesortstate *ts, Size *pnkeys);
+static void ts_build_cb_inc(Relation rel, ItemPointer tid, Datum *values, bool *isnull, bool tupleIsAlive, void *state);
+static void smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * const *incs, Size nkeys, uint16 key_len, int inc_count, const uint16 *inc_lens, SmolRowWindow *win);
+static void smol_build_text_inc_from_sorted(Relation idx, const char *keys32, const char * const *incs, Size nkeys, uint16 key_len, int inc_count, const uint16 *inc_lens, SmolRowWindow *win);
 static void smol_build_internal_levels(Relation idx, BlockNumber *leaf_blks, const int64 *leaf_highkeys, Size nleaves, uint16 key_len, BlockNumber *out_root, uint16 *out_levels);
 static void smol_build_internal_levels_bytes(Relation idx, BlockNumber *leaf_blks, const char *leaf_highkeys, Size nleaves, uint16 key_len, BlockNumber *out_root, uint16 *out_levels);
 static void smol_build_internal_levels_with_stats(Relation idx, SmolLeafStats *leaf_stats, Size nleaves, uint16 key_len, BlockNumber *out_root, uint16 *out_levels);
 static void smol_build_text_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nkeys, uint16 key_len);
-static void smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nkeys, uint16 key_len, bool byval);
+static void smol_build_fixed_stream(Relation idx, Tuplesortstate *ts, Size nkeys, uint16 key_len, bool byval, const char *akeys, const uint32 *aperm, const BlockNumber *ablks);
+static void smol_build_cb_keys(Relation rel, ItemPointer tid, Datum *values, bool *isnull, bool tupleIsAlive, void *state);
 
+/* Phase profile of this backend's most recent build (smol_bench_build_profile) */
+static struct
+{
+    Oid         indexoid;
+    double      tuples;
+    double      collect_ms;
+    double      sort_ms;
+    double      write_ms;
+    double      total_ms;
+    BlockNumber nblocks;
+} smol_last_build;
 
-static void smol_radix_sort_idx_u64(const uint64 *key, uint32 *idx, uint32 *tmp, Size n)
+/*
+ * smol_radix_sort_idx_words - stable LSD radix sort of a row permutation
+ *
+ * norm holds nwords smol_norm_key() words per row, most significant first.
+ * One sequential pass histograms every byte position up front; positions
+ * where all rows share a byte are skipped, so narrow ranges (dates, small
+ * ids, the high bytes of timestamps) pay only for the passes they need.
+ */
+static void
+smol_radix_sort_idx_words(const uint64 *norm, int nwords, uint32 *idx, uint32 *tmp, Size n)
 {
+    int npass = nwords * 8;
+    uint32 *count;
+
     if (n < 2) return;
-    uint32 count[256];
-    for (int pass = 0; pass < 8; pass++)
+    count = (uint32 *) palloc0((Size) npass * 256 * sizeof(uint32));
+    for (Size i = 0; i < n; i++)
     {
-        memset(count, 0, sizeof(count));
-        for (Size i = 0; i < n; i++)
+        for (int w = 0; w < nwords; w++)
         {
-            uint8_t byte = (uint8_t) (key[idx[i]] >> (pass * 8));
-            count[byte]++;
+            uint64 v = norm[i * nwords + w];
+            uint32 *c = count + (Size) (nwords - 1 - w) * 8 * 256;
+
+            for (int b = 0; b < 8; b++)
+                c[b * 256 + (uint8) (v >> (b * 8))]++;
         }
+    }
+    for (int pass = 0; pass < npass; pass++)
+    {
+        uint32 *c = count + (Size) pass * 256;
+        int w = nwords - 1 - pass / 8;
+        int shift = (pass % 8) * 8;
         uint32 sum = 0;
-        for (int b = 0; b < 256; b++) { uint32 c = count[b]; count[b] = sum; sum += c; }
+
+        /* Every row shares this byte: the pass would not move anything */
+        if (c[(uint8) (norm[(Size) idx[0] * nwords + w] >> shift)] == n)
+            continue;
+        for (int b = 0; b < 256; b++) { uint32 t = c[b]; c[b] = sum; sum += t; }
         for (Size i = 0; i < n; i++)
         {
-            uint8_t byte = (uint8_t) (key[idx[i]] >> (pass * 8));
-            tmp[count[byte]++] = idx[i];
+            uint8 byte = (uint8) (norm[(Size) idx[i] * nwords + w] >> shift);
+            tmp[c[byte]++] = idx[i];
         }
         memcpy(idx, tmp, n * sizeof(uint32));
     }
+    pfree(count);
+}
+
+/*
+ * smol_radix_sort_packed - sort a permutation of n packed fixed-width keys
+ * (and optional second keys) by their normalized images
+ *
+ * Returns false, leaving idx alone, when a key type has no normalized image
+ * or smol.build_radix_sort is off; callers then fall back to a comparator.
+ */
+static bool
+smol_radix_sort_packed(uint32 *idx, Size n, const char *k1, uint16 len1, Oid typ1,
+                       const char *k2, uint16 len2, Oid typ2)
+{
+    int nw1 = smol_norm_nwords(typ1, len1);
+    int nw2 = (k2 != NULL) ? smol_norm_nwords(typ2, len2) : 0;
+    int nwords = nw1 + nw2;
+    uint64 *norm;
+    uint32 *tmp;
+
+    if (!smol_build_radix_sort || nw1 == 0 || (k2 != NULL && nw2 == 0))
+        return false;
+    norm = (uint64 *) MemoryContextAllocHuge(CurrentMemoryContext, n * nwords * sizeof(uint64));
+    tmp = (uint32 *) MemoryContextAllocHuge(CurrentMemoryContext, n * sizeof(uint32));
+    for (Size i = 0; i < n; i++)
+    {
+        smol_norm_key(k1 + i * len1, len1, typ1, norm + i * nwords);
+        if (nw2 > 0)
+            smol_norm_key(k2 + i * len2, len2, typ2, norm + i * nwords + nw1);
+    }
+    smol_radix_sort_idx_words(norm, nwords, idx, tmp, n);
+    pfree(norm);
+    pfree(tmp);
+    return true;
 }
 
 static int
@@ -195,6 +273,100 @@ smol_sort_pairs_rows64(int64 *k1, int64 *k2, Size n)
     pfree(count);
 }
 
+/* Set by smol_append while smol_build collects a segment */
+static SmolAppendScan *smol_append_scan = NULL;
+
+/* Set by smol_build_many while the index it names is rebuilt from its spool */
+static SmolManySpool *smol_many_spool = NULL;
+
+/* Leaf writer for a build; appended segments share the relation with readers, so stay buffered */
+static void
+smol_leaf_writer_start(SmolLeafWriter *w, Relation idx)
+{
+    smol_leaf_writer_begin(w, idx, smol_build_bulk_write && smol_append_scan == NULL);
+}
+
+/* Order of a new row's keys against the index's last key */
+static int
+smol_append_cmp_last(SmolAppendScan *as, Datum *values)
+{
+    for (int k = 0; k < as->nkeys; k++)
+    {
+        int c = DatumGetInt32(FunctionCall2Coll(&as->cmp[k], as->coll[k], values[k], as->last[k]));
+
+        if (c != 0)
+            return c;
+    }
+    return 0;
+}
+
+/* Forward rows past the high-water mark to the build callback */
+static void
+smol_append_filter_cb(Relation index, ItemPointer tid, Datum *values, bool *isnull, bool tupleIsAlive, void *state)
+{
+    SmolAppendScan *as = (SmolAppendScan *) state;
+
+    if (ItemPointerGetBlockNumber(tid) == as->hwm_blk &&
+        ItemPointerGetOffsetNumber(tid) <= as->hwm_off)
+        return;
+    if (as->have_last && !isnull[0] && !(as->nkeys == 2 && isnull[1]) &&
+        smol_append_cmp_last(as, values) < 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("smol_append: new rows of index \"%s\" sort before its last key",
+                        RelationGetRelationName(index)),
+                 errhint("Appended rows must not sort below the indexed ones; use REINDEX instead.")));
+    as->nrows++;
+    as->cb(index, tid, values, isnull, tupleIsAlive, as->cb_state);
+}
+
+/* Feed the spooled rows of smol_build_many to a build callback in heap order */
+static double
+smol_many_replay(SmolManySpool *sp, Relation index, IndexBuildCallback callback, void *callback_state)
+{
+    TupleTableSlot *slot = MakeSingleTupleTableSlot(sp->desc, &TTSOpsMinimalTuple);
+    double      nrows = 0;
+
+    tuplestore_rescan(sp->ts);
+    while (tuplestore_gettupleslot(sp->ts, true, false, slot))
+    {
+        ItemPointerData tid;
+        int64       t;
+
+        slot_getallattrs(slot);
+        t = DatumGetInt64(slot->tts_values[sp->natts]);
+        ItemPointerSet(&tid, (BlockNumber) (t >> 16), (OffsetNumber) (t & 0xFFFF));
+        callback(index, &tid, slot->tts_values, slot->tts_isnull, true, callback_state);
+        nrows++;
+    }
+    ExecDropSingleTupleTableSlot(slot);
+    return nrows;
+}
+
+/*
+ * smol_heap_build_scan - table_index_build_scan for the serial build paths
+ *
+ * Under smol_append only the heap blocks from the high-water mark on are
+ * scanned, and rows up to the mark on its block are skipped.  Under
+ * smol_build_many the rows come from the spool of the shared heap scan.
+ */
+static double
+smol_heap_build_scan(Relation heap, Relation index, IndexInfo *indexInfo,
+                     IndexBuildCallback callback, void *callback_state)
+{
+    SmolAppendScan *as = smol_append_scan;
+
+    if (smol_many_spool != NULL && smol_many_spool->indexoid == RelationGetRelid(index))
+        return smol_many_replay(smol_many_spool, index, callback, callback_state);
+    if (as == NULL)
+        return table_index_build_scan(heap, index, indexInfo, true, true, callback, callback_state, NULL);
+    as->cb = callback;
+    as->cb_state = callback_state;
+    return table_index_build_range_scan(heap, index, indexInfo, false, false, false,
+                                        as->hwm_blk, InvalidBlockNumber,
+                                        smol_append_filter_cb, (void *) as, NULL);
+}
+
 /* Background worker: sort assigned bucket ranges in-place inside DSM arrays */
 /* --- Minimal implementations --- */
 IndexBuildResult *
@@ -229,13 +401,19 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
     INSTR_TIME_SET_CURRENT(t_sort_end);
     INSTR_TIME_SET_CURRENT(t_write_end);
 
-    /* Request parallel workers for single-key builds without INCLUDE columns */
+    /*
+     * Request parallel workers.  Single-key builds without INCLUDE columns
+     * stream straight from the merged tuplesort; INCLUDE and two-column builds
+     * collect the merged rows into their column arrays instead of scanning.
+     */
     int parallel_workers = indexInfo->ii_ParallelWorkers;
 #ifdef SMOL_TEST_COVERAGE
     if (smol_test_force_parallel_workers > 0)
         parallel_workers = smol_test_force_parallel_workers;
 #endif
-    if (nkeyatts == 1 && ninclude == 0 && parallel_workers > 0)
+    if ((nkeyatts == 1 || nkeyatts == 2) && parallel_workers > 0 && smol_append_scan == NULL &&
+        smol_many_spool == NULL &&
+        ((nkeyatts == 1 && ninclude == 0) || smol_parallel_collect_ok(index)))
     {
         elog(LOG, "[smol] About to call smol_begin_parallel, parallel_workers=%d", parallel_workers);
         smol_begin_parallel(&buildstate, indexInfo->ii_Concurrent,
@@ -396,7 +574,20 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
             cctx.inumeric_scale[i] = inc_numeric_scale_arr[i];
         }
         cctx.pcap=&cap; cctx.pcount=&n; cctx.incn=inc_count;
-        table_index_build_scan(heap, index, indexInfo, true, true, smol_build_cb_inc, (void *) &cctx, NULL);
+        /* Parallel build: workers sorted disjoint heap ranges, rows arrive merged in key order */
+        bool presorted = (buildstate.smolleader != NULL);
+        /*
+         * Single-key builds that are parallel or too large for
+         * maintenance_work_mem go through an external sort and stream the
+         * merged rows into the leaf writers instead of collecting whole columns.
+         */
+        bool streamed = (nkeyatts == 1) && (presorted || smol_inc_build_spills(heap, index));
+        if (streamed)
+            smol_build_inc_streamed(&buildstate, &cctx, inc_lens);
+        else if (presorted)
+            smol_parallel_merge_collect(&buildstate, smol_build_cb_inc, (void *) &cctx);
+        else
+            smol_heap_build_scan(heap, index, indexInfo, smol_build_cb_inc, (void *) &cctx);
         INSTR_TIME_SET_CURRENT(t_collect_end);
         SMOL_LOGF("build: collected rows=%zu (key+%d includes)", (size_t) n, inc_count);
         /* Specialize INCLUDE text caps (8/16/32) and repack source buffers to new stride. */
@@ -436,7 +627,18 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
         /* Build permutation via radix sort */
         if (n > 0)
         {
-            char *sinc[16]; for (int i=0;i<inc_count;i++) sinc[i] = (char *) MemoryContextAllocHuge(CurrentMemoryContext, ((Size) n) * inc_lens[i]);
+            char *sinc[16];
+            for (int i=0;i<inc_count;i++)
+            {
+                if (presorted)
+                {
+                    /* Already in order: write straight from the collection buffers */
+                    sinc[i] = incarr[i];
+                    incarr[i] = NULL;
+                }
+                else
+                    sinc[i] = (char *) MemoryContextAllocHuge(CurrentMemoryContext, ((Size) n) * inc_lens[i]);
+            }
 
             if (nkeyatts == 2)
             {
@@ -452,10 +654,12 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
                 uint32 *idx = (uint32 *) MemoryContextAllocHuge(CurrentMemoryContext, n * sizeof(uint32)); for (Size i=0;i<n;i++) idx[i] = (uint32) i;
                 /* set global comparator context */
                 smol_sort_k1_buffer = k1buf; smol_sort_k2_buffer = k2buf; smol_sort_key_len1 = key_len; smol_sort_key_len2 = key_len2; smol_sort_byval1 = cctx.byval1; smol_sort_byval2 = cctx.byval2; smol_sort_coll1 = coll1; smol_sort_coll2 = coll2; smol_sort_typoid1 = typoid1; smol_sort_typoid2 = typoid2; memcpy(&smol_sort_cmp1, &cmp1, sizeof(FmgrInfo)); memcpy(&smol_sort_cmp2, &cmp2, sizeof(FmgrInfo));
-                qsort(idx, n, sizeof(uint32), smol_pair_qsort_cmp);
+                if (!presorted &&
+                    !smol_radix_sort_packed(idx, n, k1buf, key_len, typoid1, k2buf, key_len2, typoid2))
+                    qsort(idx, n, sizeof(uint32), smol_pair_qsort_cmp);
                 INSTR_TIME_SET_CURRENT(t_sort_end);
                 /* Apply permutation to INCLUDE columns */
-                for (Size i = 0; i < n; i++)
+                for (Size i = 0; i < n && !presorted; i++)
                 {
                     uint32 j = idx[i];
                     for (int c = 0; c < inc_count; c++)
@@ -472,32 +676,46 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
                     MarkBufferDirty(mb); UnlockReleaseBuffer(mb);
                 }
                 /* Write leaves in two-key + INCLUDE layout */
-                Size i = 0; BlockNumber prev = InvalidBlockNumber; char *scratch = (char *) palloc(BLCKSZ);
+                Size i = 0; BlockNumber first_leaf = InvalidBlockNumber; char *scratch = (char *) palloc(BLCKSZ);
+                SmolLeafWriter lw; smol_leaf_writer_start(&lw, index);
                 while (i < n)
                 {
-                    Buffer buf = smol_extend(index); Page page = BufferGetPage(buf); smol_init_page(buf, true, InvalidBlockNumber);
+                    Page page = smol_leaf_writer_next(&lw);
                     Size fs = PageGetFreeSpace(page); Size avail = (fs > sizeof(ItemIdData)) ? (fs - sizeof(ItemIdData)) : 0;
                     Size header = sizeof(uint16);
                     Size perrow = (Size) key_len + (Size) key_len2;
                     for (int c=0;c<inc_count;c++) perrow += inc_lens[c];
                     Size maxn = (avail > header) ? ((avail - header) / perrow) : 0; Size rem = n - i; Size n_this = (rem < maxn) ? rem : maxn;
-                    if (n_this == 0) ereport(ERROR,(errmsg("smol: two-col+INCLUDE row too large for page")));
-                    memcpy(scratch, &n_this, sizeof(uint16)); char *p = scratch + sizeof(uint16);
-                    /* Use index permutation to access sorted data */
-                    for (Size j=0;j<n_this;j++)
+                    Size sz;
+                    /* k1-grouped layout when repeated leading keys let it hold more rows */
+                    Size n_grp = smol_two_col_groups ? smol12_group_fit(k1buf, idx, i, n, key_len, perrow - key_len, avail) : 0;
+                    if (n_grp > n_this)
+                    {
+                        n_this = n_grp;
+                        sz = smol12_group_encode(scratch, k1buf, k2buf, idx, i, (uint16) n_this, key_len, key_len2, sinc, inc_count, inc_lens);
+                    }
+                    else
                     {
-                        uint32 id = idx[i+j];
-                        memcpy(p, k1buf + (size_t) id * key_len, key_len); p += key_len;
-                        memcpy(p, k2buf + (size_t) id * key_len2, key_len2); p += key_len2;
-                        for (int c=0;c<inc_count;c++) { memcpy(p, sinc[c] + (size_t) (i+j) * inc_lens[c], inc_lens[c]); p += inc_lens[c]; }
+                        if (n_this == 0) ereport(ERROR,(errmsg("smol: two-col+INCLUDE row too large for page")));
+                        memcpy(scratch, &n_this, sizeof(uint16)); char *p = scratch + sizeof(uint16);
+                        /* Use index permutation to access sorted data */
+                        for (Size j=0;j<n_this;j++)
+                        {
+                            uint32 id = idx[i+j];
+                            memcpy(p, k1buf + (size_t) id * key_len, key_len); p += key_len;
+                            memcpy(p, k2buf + (size_t) id * key_len2, key_len2); p += key_len2;
+                            for (int c=0;c<inc_count;c++) { memcpy(p, sinc[c] + (size_t) (i+j) * inc_lens[c], inc_lens[c]); p += inc_lens[c]; }
+                        }
+                        sz = (Size) (p - scratch);
                     }
-                    Size sz = (Size) (p - scratch);
                     OffsetNumber off = PageAddItem(page, (Item) scratch, sz, FirstOffsetNumber, false, false);
                     Assert(off != InvalidOffsetNumber); (void) off;
-                    MarkBufferDirty(buf); BlockNumber cur = BufferGetBlockNumber(buf); UnlockReleaseBuffer(buf);
-                    smol_link_siblings(index, prev, cur); prev = cur; i += n_this;
+                    BlockNumber cur = lw.blkno;
+                    if (!BlockNumberIsValid(first_leaf)) first_leaf = cur;
+                    i += n_this;
                 }
-                Buffer mb = ReadBuffer(index, 0); LockBuffer(mb, BUFFER_LOCK_EXCLUSIVE); Page pg = BufferGetPage(mb); SmolMeta *m = smol_meta_ptr(pg); m->root_blkno = 1; m->height = 1; MarkBufferDirty(mb); UnlockReleaseBuffer(mb);
+                smol_leaf_writer_finish(&lw);
+                Buffer mb = ReadBuffer(index, 0); LockBuffer(mb, BUFFER_LOCK_EXCLUSIVE); Page pg = BufferGetPage(mb); SmolMeta *m = smol_meta_ptr(pg); m->root_blkno = first_leaf; m->height = 1; MarkBufferDirty(mb); UnlockReleaseBuffer(mb);
                 pfree(idx);
                 pfree(scratch);
                 for (int i=0;i<inc_count;i++) pfree(sinc[i]);
@@ -510,11 +728,21 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
                 for (Size i = 0; i < n; i++) idx[i] = (uint32) i;
                 if (!cctx.key_is_text32)
                 {
-                    /* radix sort by int64 key */
+                    /* radix sort by the key's normalized image (floats, oid and lsn included) */
                     uint64 *norm = (uint64 *) MemoryContextAllocHuge(CurrentMemoryContext, n * sizeof(uint64));
                     uint32 *tmp = (uint32 *) MemoryContextAllocHuge(CurrentMemoryContext, n * sizeof(uint32));
-                    for (Size i = 0; i < n; i++) norm[i] = smol_norm64(karr[i]);
-                    smol_radix_sort_idx_u64(norm, idx, tmp, n);
+                    bool normalized = (smol_norm_nwords(atttypid, key_len) == 1);
+                    for (Size i = 0; i < n; i++)
+                    {
+                        char kb[sizeof(int64)];
+
+                        if (normalized)
+                            smol_norm_key(smol_datum_key_bytes(Int64GetDatum(karr[i]), key_len, true, kb),
+                                          key_len, atttypid, &norm[i]);
+                        else
+                            norm[i] = smol_norm64(karr[i]);
+                    }
+                    smol_radix_sort_idx_words(norm, 1, idx, tmp, n);
                     pfree(norm); pfree(tmp);
                     /* Apply permutation */
                     int64 *sk = (int64 *) MemoryContextAllocHuge(CurrentMemoryContext, n * sizeof(int64));
@@ -526,7 +754,7 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
                     }
                     pfree(idx);
                     SMOL_LOGF("build phase: write start n=%zu (includes=%d)", (size_t) n, inc_count);
-                    smol_build_tree1_inc_from_sorted(index, sk, (const char * const *) sinc, n, key_len, inc_count, inc_lens);
+                    smol_build_tree1_inc_from_sorted(index, sk, (const char * const *) sinc, n, key_len, inc_count, inc_lens, NULL);
                     for (int i=0;i<inc_count;i++) pfree(sinc[i]);
                     pfree(sk);
                 }
@@ -536,7 +764,8 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
                     /* n * key_len */
                     /* qsort indices by key bytes */
                     smol_sort_k1_buffer = kbytes; smol_sort_key_len1 = key_len; /* reuse globals for simple cmp */
-                    qsort(idx, n, sizeof(uint32), smol_qsort_cmp_bytes);
+                    if (!smol_radix_sort_packed(idx, n, kbytes, key_len, TEXTOID, NULL, 0, InvalidOid))
+                        qsort(idx, n, sizeof(uint32), smol_qsort_cmp_bytes);
                     /* Apply permutation */
                     char *skeys = (char *) MemoryContextAllocHuge(CurrentMemoryContext, ((Size) n) * key_len);
                     for (Size i = 0; i < n; i++)
@@ -547,24 +776,25 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
                             memcpy(sinc[c] + ((size_t) i * inc_lens[c]), incarr[c] + ((size_t) j * inc_lens[c]), inc_lens[c]);
                     }
                     pfree(idx);
+                    INSTR_TIME_SET_CURRENT(t_sort_end);
                     SMOL_LOGF("build phase: write start n=%zu (includes=%d, text32)", (size_t) n, inc_count);
-                    smol_build_text_inc_from_sorted(index, (const char *) skeys, (const char * const *) sinc, n, key_len, inc_count, inc_lens);
+                    smol_build_text_inc_from_sorted(index, (const char *) skeys, (const char * const *) sinc, n, key_len, inc_count, inc_lens, NULL);
                     for (int i=0;i<inc_count;i++) pfree(sinc[i]);
                     pfree(skeys);
                     pfree(kbytes);
                 }
             }
         }
-        else
+        else if (!streamed)
         {
             /* Empty index: metapage already initialized by smol_buildempty */
             if (!cctx.key_is_text32)
             {
-                smol_build_tree1_inc_from_sorted(index, NULL, NULL, 0, key_len, inc_count, inc_lens);
+                smol_build_tree1_inc_from_sorted(index, NULL, NULL, 0, key_len, inc_count, inc_lens, NULL);
             }
             else
             {
-                smol_build_text_inc_from_sorted(index, NULL, NULL, 0, key_len, inc_count, inc_lens);
+                smol_build_text_inc_from_sorted(index, NULL, NULL, 0, key_len, inc_count, inc_lens, NULL);
             }
         }
         for (int i=0;i<inc_count;i++) if (incarr[i]) pfree(incarr[i]);
@@ -595,41 +825,28 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
         if (!buildstate.smolleader)
         {
             /* Serial build: leader does the scan */
-            table_index_build_scan(heap, index, indexInfo, true, true, ts_build_cb_text, (void *) &cb, NULL);
+            smol_heap_build_scan(heap, index, indexInfo, ts_build_cb_text, (void *) &cb);
             INSTR_TIME_SET_CURRENT(t_collect_end);
             tuplesort_performsort(ts);
         }
         else
         {
             /* Parallel build: wait for all workers to finish, then merge */
-            SMOLShared *smolshared = buildstate.smolleader->smolshared;
-
-            /* Wait for all workers to finish sorting */
-            for (;;)
-            {
-                SpinLockAcquire(&smolshared->mutex);
-                if (smolshared->nparticipantsdone == buildstate.smolleader->nparticipanttuplesorts)
-                {
-                    nkeys = smolshared->reltuples;
-                    maxlen = smolshared->maxlen;
-                    SpinLockRelease(&smolshared->mutex);
-                    break;
-                }
-                SpinLockRelease(&smolshared->mutex);
-                ConditionVariableSleep(&smolshared->workersdonecv, WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
-            }
-            ConditionVariableCancelSleep();
+            smol_parallel_wait_workers(buildstate.smolleader, &nkeys, &maxlen);
             INSTR_TIME_SET_CURRENT(t_collect_end);
 
             /* Now perform sort on leader's tuplesort, which merges worker results */
             tuplesort_performsort(ts);
         }
         INSTR_TIME_SET_CURRENT(t_sort_end);
-        if (maxlen > 32) ereport(ERROR, (errmsg("smol text32 key exceeds 32 bytes")));
+        if (maxlen > 32 && !smol_text_prefix) ereport(ERROR, (errmsg("smol text32 key exceeds 32 bytes")));
+        if (maxlen > SMOL_TEXT_KEY_MAX)
+            ereport(ERROR, (errmsg("smol text key exceeds %d bytes", SMOL_TEXT_KEY_MAX)));
 
-        /* Choose key length based on max text length (8/16/32 bytes)
+        /* Choose key length based on max text length (8/16/32 bytes, then
+         * multiples of 32 for prefix-truncated leaves).
          * We store original text (not transformed), so all collations use same sizing */
-        uint16 cap = (maxlen <= 8) ? 8 : (maxlen <= 16 ? 16 : 32);
+        uint16 cap = (maxlen <= 8) ? 8 : (maxlen <= 16 ? 16 : (uint16) TYPEALIGN(32, maxlen));
 
         /* stream write */
         smol_build_text_stream_from_tuplesort(index, ts, nkeys, cap);
@@ -668,46 +885,64 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
             coordinate->nParticipants = buildstate.smolleader->nparticipanttuplesorts;
             coordinate->sharedsort = buildstate.smolleader->sharedsort;
         }
-        ts = tuplesort_begin_index_btree(heap, index, false, false, maintenance_work_mem, coordinate, TUPLESORT_NONE);
-        SmolTuplesortContext gcb; gcb.ts = ts; gcb.pnkeys = &nkeys;
-
-        /* In parallel mode, only workers scan the table. Leader just waits and merges. */
-        if (!buildstate.smolleader)
+        /*
+         * Serial builds of normalizable keys whose heap fits in
+         * maintenance_work_mem collect keys and heap blocks into arrays and
+         * radix-sort their normalized images; tuplesort's comparator calls
+         * dominate these builds for uuid, float and timestamp keys.
+         */
+        if (!buildstate.smolleader && smol_build_radix_sort &&
+            smol_norm_nwords(atttypid, key_len) > 0 &&
+            (double) RelationGetNumberOfBlocks(heap) * BLCKSZ <= (double) maintenance_work_mem * 1024.0)
         {
-            /* Serial build: leader does the scan */
-            table_index_build_scan(heap, index, indexInfo, true, true, ts_build_cb_any, (void *) &gcb, NULL);
+            SmolKeyArrayContext kcb;
+            uint32 *perm;
+
+            memset(&kcb, 0, sizeof(kcb));
+            kcb.key_len = key_len;
+            kcb.byval = byval;
+            smol_heap_build_scan(heap, index, indexInfo, smol_build_cb_keys, (void *) &kcb);
             INSTR_TIME_SET_CURRENT(t_collect_end);
-            tuplesort_performsort(ts);
+            nkeys = kcb.n;
+            perm = (uint32 *) MemoryContextAllocHuge(CurrentMemoryContext, Max(nkeys, 1) * sizeof(uint32));
+            for (Size i = 0; i < nkeys; i++) perm[i] = (uint32) i;
+            if (nkeys > 0)
+                (void) smol_radix_sort_packed(perm, nkeys, kcb.keys, key_len, atttypid, NULL, 0, InvalidOid);
+            INSTR_TIME_SET_CURRENT(t_sort_end);
+            smol_build_fixed_stream(index, NULL, nkeys, key_len, byval, kcb.keys, perm, kcb.blks);
+            pfree(perm);
+            if (kcb.keys) pfree(kcb.keys);
+            if (kcb.blks) pfree(kcb.blks);
+            INSTR_TIME_SET_CURRENT(t_write_end);
         }
         else
         {
-            /* Parallel build: wait for all workers to finish, then merge */
-            SMOLShared *smolshared = buildstate.smolleader->smolshared;
+            ts = tuplesort_begin_index_btree(heap, index, false, false, maintenance_work_mem, coordinate, TUPLESORT_NONE);
+            SmolTuplesortContext gcb; gcb.ts = ts; gcb.pnkeys = &nkeys;
 
-            /* Wait for all workers to finish sorting */
-            for (;;)
+            /* In parallel mode, only workers scan the table. Leader just waits and merges. */
+            if (!buildstate.smolleader)
             {
-                SpinLockAcquire(&smolshared->mutex);
-                if (smolshared->nparticipantsdone == buildstate.smolleader->nparticipanttuplesorts)
-                {
-                    nkeys = smolshared->reltuples;
-                    SpinLockRelease(&smolshared->mutex);
-                    break;
-                }
-                SpinLockRelease(&smolshared->mutex);
-                ConditionVariableSleep(&smolshared->workersdonecv, WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+                /* Serial build: leader does the scan */
+                smol_heap_build_scan(heap, index, indexInfo, ts_build_cb_any, (void *) &gcb);
+                INSTR_TIME_SET_CURRENT(t_collect_end);
+                tuplesort_performsort(ts);
             }
-            ConditionVariableCancelSleep();
-            INSTR_TIME_SET_CURRENT(t_collect_end);
+            else
+            {
+                /* Parallel build: wait for all workers to finish, then merge */
+                smol_parallel_wait_workers(buildstate.smolleader, &nkeys, NULL);
+                INSTR_TIME_SET_CURRENT(t_collect_end);
 
-            /* Now perform sort on leader's tuplesort, which merges worker results */
-            tuplesort_performsort(ts);
+                /* Now perform sort on leader's tuplesort, which merges worker results */
+                tuplesort_performsort(ts);
+            }
+            INSTR_TIME_SET_CURRENT(t_sort_end);
+            /* stream write directly from tuplesort */
+            smol_build_fixed_stream(index, ts, nkeys, key_len, byval, NULL, NULL, NULL);
+            tuplesort_end(ts);
+            INSTR_TIME_SET_CURRENT(t_write_end);
         }
-        INSTR_TIME_SET_CURRENT(t_sort_end);
-        /* stream write directly from tuplesort */
-        smol_build_fixed_stream_from_tuplesort(index, ts, nkeys, key_len, byval);
-        tuplesort_end(ts);
-        INSTR_TIME_SET_CURRENT(t_write_end);
     }
     else /* 2-column: collect generic fixed-length pairs and write row-major */
     {
@@ -719,15 +954,23 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
             get_typlenbyvalalign(atttypid, &l, &bv, &al); cctx.byval1 = bv;
             get_typlenbyvalalign(atttypid2, &l, &bv, &al); cctx.byval2 = bv;
         }
-        table_index_build_scan(heap, index, indexInfo, true, true, smol_build_cb_pair, (void *) &cctx, NULL);
+        /* Parallel build: workers sorted disjoint heap ranges, rows arrive merged in key order */
+        bool presorted = (buildstate.smolleader != NULL);
+        if (presorted)
+            smol_parallel_merge_collect(&buildstate, smol_build_cb_pair, (void *) &cctx);
+        else
+            smol_heap_build_scan(heap, index, indexInfo, smol_build_cb_pair, (void *) &cctx);
         INSTR_TIME_SET_CURRENT(t_collect_end);
         if (n > 0)
         {
             /* Fast path: radix sort for (int64, int64) pairs */
-            bool use_radix = (atttypid == INT8OID && atttypid2 == INT8OID);
+            bool use_radix = !presorted && (atttypid == INT8OID && atttypid2 == INT8OID);
+            bool in_place = presorted || use_radix;  /* rows already sorted in k1buf/k2buf */
             uint32 *idx = NULL;
 
-            if (use_radix)
+            if (presorted)
+                INSTR_TIME_SET_CURRENT(t_sort_end);
+            else if (use_radix)
             {
                 /* Direct radix sort on int64 pairs (stable, O(n) time) */
                 smol_sort_pairs_rows64((int64 *) k1buf, (int64 *) k2buf, n);
@@ -747,7 +990,9 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
                 idx = (uint32 *) MemoryContextAllocHuge(CurrentMemoryContext, n * sizeof(uint32)); for (Size i=0;i<n;i++) idx[i] = (uint32) i;
                 /* set global comparator context */
                 smol_sort_k1_buffer = k1buf; smol_sort_k2_buffer = k2buf; smol_sort_key_len1 = key_len; smol_sort_key_len2 = key_len2; smol_sort_byval1 = cctx.byval1; smol_sort_byval2 = cctx.byval2; smol_sort_coll1 = coll1; smol_sort_coll2 = coll2; smol_sort_typoid1 = typoid1; smol_sort_typoid2 = typoid2; memcpy(&smol_sort_cmp1, &cmp1, sizeof(FmgrInfo)); memcpy(&smol_sort_cmp2, &cmp2, sizeof(FmgrInfo));
-                qsort(idx, n, sizeof(uint32), smol_pair_qsort_cmp);
+                /* Normalized radix sort when both key types have an image, else fmgr comparisons */
+                if (!smol_radix_sort_packed(idx, n, k1buf, key_len, typoid1, k2buf, key_len2, typoid2))
+                    qsort(idx, n, sizeof(uint32), smol_pair_qsort_cmp);
                 INSTR_TIME_SET_CURRENT(t_sort_end);
             }
             /* init meta if new */
@@ -761,37 +1006,51 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
              * payload: [uint16 nrows][row0: k1||k2][row1: k1||k2]...
              * One ItemId (FirstOffsetNumber) per leaf.
              */
-            Size i = 0; BlockNumber prev = InvalidBlockNumber; char *scratch = (char *) palloc(BLCKSZ);
+            Size i = 0; char *scratch = (char *) palloc(BLCKSZ);
+            SmolLeafWriter lw;
 
             /* Track leaf pages for building internal levels with zone map stats */
             Size nleaves = 0, aleaves = 0;
             SmolLeafStats *leaf_stats = NULL;
             Oid typid = atttypid; /* First key type for zone maps */
 
+            smol_leaf_writer_start(&lw, index);
             while (i < n)
             {
-                Buffer buf = smol_extend(index); Page page = BufferGetPage(buf); smol_init_page(buf, true, InvalidBlockNumber);
+                Page page = smol_leaf_writer_next(&lw);
                 Size fs = PageGetFreeSpace(page); Size avail = (fs > sizeof(ItemIdData)) ? (fs - sizeof(ItemIdData)) : 0;
                 Size header = sizeof(uint16); Size perrow = (Size) key_len + (Size) key_len2;
-                Size maxn = (avail > header) ? ((avail - header) / perrow) : 0; Size rem = n - i; Size n_this = (rem < maxn) ? rem : maxn; if (n_this == 0) ereport(ERROR,(errmsg("smol: two-col row too large for page")));
-                memcpy(scratch, &n_this, sizeof(uint16)); char *p = scratch + sizeof(uint16);
-                if (use_radix)
+                Size maxn = (avail > header) ? ((avail - header) / perrow) : 0; Size rem = n - i; Size n_this = (rem < maxn) ? rem : maxn;
+                Size sz;
+                /* k1-grouped layout when repeated leading keys let it hold more rows */
+                const uint32 *perm = in_place ? NULL : idx;
+                Size n_grp = smol_two_col_groups ? smol12_group_fit(k1buf, perm, i, n, key_len, key_len2, avail) : 0;
+                if (n_grp > n_this)
                 {
-                    /* Data is already sorted in-place, copy sequentially */
-                    for (Size j=0;j<n_this;j++) { memcpy(p, k1buf + (size_t) (i+j) * key_len, key_len); p += key_len; memcpy(p, k2buf + (size_t) (i+j) * key_len2, key_len2); p += key_len2; }
+                    n_this = n_grp;
+                    sz = smol12_group_encode(scratch, k1buf, k2buf, perm, i, (uint16) n_this, key_len, key_len2, NULL, 0, NULL);
                 }
                 else
                 {
-                    /* Use index permutation to access sorted order */
-                    for (Size j=0;j<n_this;j++) { uint32 id = idx[i+j]; memcpy(p, k1buf + (size_t) id * key_len, key_len); p += key_len; memcpy(p, k2buf + (size_t) id * key_len2, key_len2); p += key_len2; }
+                    if (n_this == 0) ereport(ERROR,(errmsg("smol: two-col row too large for page")));
+                    memcpy(scratch, &n_this, sizeof(uint16)); char *p = scratch + sizeof(uint16);
+                    if (in_place)
+                    {
+                        /* Data is already sorted in-place, copy sequentially */
+                        for (Size j=0;j<n_this;j++) { memcpy(p, k1buf + (size_t) (i+j) * key_len, key_len); p += key_len; memcpy(p, k2buf + (size_t) (i+j) * key_len2, key_len2); p += key_len2; }
+                    }
+                    else
+                    {
+                        /* Use index permutation to access sorted order */
+                        for (Size j=0;j<n_this;j++) { uint32 id = idx[i+j]; memcpy(p, k1buf + (size_t) id * key_len, key_len); p += key_len; memcpy(p, k2buf + (size_t) id * key_len2, key_len2); p += key_len2; }
+                    }
+                    sz = (Size) (p - scratch);
                 }
-                Size sz = (Size) (p - scratch);
                 OffsetNumber off = PageAddItem(page, (Item) scratch, sz, FirstOffsetNumber, false, false);
                 /* Should always succeed since we validated n_this > 0 and calculated sz to fit */
                 Assert(off != InvalidOffsetNumber);
                 (void) off; /* suppress unused variable warning in non-assert builds */
-                MarkBufferDirty(buf); BlockNumber cur = BufferGetBlockNumber(buf); UnlockReleaseBuffer(buf);
-                if (BlockNumberIsValid(prev)) { Buffer pb = ReadBuffer(index, prev); LockBuffer(pb, BUFFER_LOCK_EXCLUSIVE); Page pp=BufferGetPage(pb); smol_page_opaque(pp)->rightlink=cur; MarkBufferDirty(pb); UnlockReleaseBuffer(pb);} prev = cur;
+                BlockNumber cur = lw.blkno;
 
                 /* Track this leaf and collect zone map statistics */
                 if (nleaves == aleaves)
@@ -806,7 +1065,7 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
                 {
                     /* For two-column indexes, extract first key column for zone map statistics */
                     char *keys_for_stats = (char *) palloc(n_this * key_len);
-                    if (use_radix)
+                    if (in_place)
                     {
                         /* Data is already sorted, copy k1 values */
                         for (Size j = 0; j < n_this; j++)
@@ -827,22 +1086,15 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
                 else
                 {
                     /* Zone maps disabled: fill minimal stats */
-                    leaf_stats[nleaves].blk = cur;
-                    /* Store last key's first 4 bytes as maxkey */
-                    if (use_radix)
-                        memcpy(&leaf_stats[nleaves].maxkey, k1buf + (i + n_this - 1) * key_len, Min(sizeof(int32), key_len));
-                    else
-                        memcpy(&leaf_stats[nleaves].maxkey, k1buf + idx[i + n_this - 1] * key_len, Min(sizeof(int32), key_len));
-                    leaf_stats[nleaves].minkey = 0;
-                    leaf_stats[nleaves].row_count = 0;
-                    leaf_stats[nleaves].distinct_count = 0;
-                    leaf_stats[nleaves].bloom_filter = 0;
-                    leaf_stats[nleaves].padding = 0;
+                    const char *lastk1 = in_place ? k1buf + (i + n_this - 1) * key_len
+                                                   : k1buf + idx[i + n_this - 1] * key_len;
+                    smol_leaf_stats_highkey_only(&leaf_stats[nleaves], cur, lastk1, key_len, typid);
                 }
 
                 nleaves++;
                 i += n_this;
             }
+            smol_leaf_writer_finish(&lw);
 
             /* Build internal levels with zone map aggregation if we have multiple leaves */
             if (nleaves > 1)
@@ -895,6 +1147,12 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
         ms_sort = (double) INSTR_TIME_GET_MILLISEC(d_sort);
         ms_write = (double) INSTR_TIME_GET_MILLISEC(d_write);
         ms_total = (double) INSTR_TIME_GET_MILLISEC(d_total);
+        smol_last_build.indexoid = RelationGetRelid(index);
+        smol_last_build.tuples = (double) nkeys;
+        smol_last_build.collect_ms = ms_collect;
+        smol_last_build.sort_ms = ms_sort;
+        smol_last_build.write_ms = ms_write;
+        smol_last_build.total_ms = ms_total;
         SMOL_LOGF("build finish tuples=%zu profile: collect=%.3f ms sort=%.3f ms write=%.3f ms total~%.3f ms",
                   nkeys, ms_collect, ms_sort, ms_write, ms_total);
     }
@@ -907,14 +1165,12 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
         SMOL_LOG("parallel build complete");
     }
 
-    /* Build leaf directory for parallel scans (only for large indexes) */
-    BlockNumber nblocks = RelationGetNumberOfBlocks(index);
-
-    /* DISABLED: Directory-based parallel scan has race condition causing 1-4% overcounting */
-    /* TODO: Debug and fix the chunk boundary logic in smol_scan.c */
-    if (nblocks > 1000000)  /* Effectively disabled - was: Build directory for large indexes (>100 blocks) */
-    { /* GCOV_EXCL_START - directory feature disabled due to bug */
-        elog(LOG, "smol_build: calling directory build");
+    /*
+     * Build leaf directory for parallel scans of single-column indexes; the
+     * directory build itself declines indexes below SMOL_DIR_MIN_LEAVES.
+     */
+    if (nkeyatts == 1 && smol_append_scan == NULL && RelationGetNumberOfBlocks(index) > SMOL_DIR_MIN_LEAVES)
+    {
         BlockNumber dir_blk = smol_build_and_write_directory(index);
 
         if (BlockNumberIsValid(dir_blk))
@@ -932,7 +1188,62 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
 
             SMOL_LOGF("stored directory block %u in metadata", dir_blk);
         }
-    } /* GCOV_EXCL_STOP */
+    }
+
+    /*
+     * Per-leaf bloom pages for equality probes; appended segments rely on
+     * the filters of the tree they join and never write their own.
+     */
+    if (nkeyatts == 1 && smol_append_scan == NULL && smol_bloom_leaf_bits > 0 && smol_build_bloom_filters)
+    {
+        SmolMeta bm;
+
+        smol_meta_read(index, &bm);
+        if (BlockNumberIsValid(smol_build_and_write_leaf_blooms(index, &bm)))
+        {
+            Buffer mbuf = ReadBuffer(index, 0);
+            SmolMeta *meta;
+
+            LockBuffer(mbuf, BUFFER_LOCK_EXCLUSIVE);
+            meta = smol_meta_ptr(BufferGetPage(mbuf));
+            meta->leaf_bloom_words = bm.leaf_bloom_words;
+            meta->leaf_bloom_blkno = bm.leaf_bloom_blkno;
+            meta->leaf_bloom_first = bm.leaf_bloom_first;
+            meta->leaf_bloom_nslots = bm.leaf_bloom_nslots;
+            MarkBufferDirty(mbuf);
+            UnlockReleaseBuffer(mbuf);
+        }
+    }
+
+    /* Per-leaf INCLUDE ranges for smol_group_agg filters; segments have none either */
+    if (nkeyatts == 1 && ninclude > 0 && smol_append_scan == NULL && smol_build_include_zones)
+    {
+        SmolMeta zm;
+
+        smol_meta_read(index, &zm);
+        if (BlockNumberIsValid(smol_build_and_write_inc_zones(index, &zm)))
+        {
+            Buffer mbuf = ReadBuffer(index, 0);
+            SmolMeta *meta;
+
+            LockBuffer(mbuf, BUFFER_LOCK_EXCLUSIVE);
+            meta = smol_meta_ptr(BufferGetPage(mbuf));
+            meta->inc_zone_mask = zm.inc_zone_mask;
+            meta->inc_zone_ncols = zm.inc_zone_ncols;
+            meta->inc_zone_blkno = zm.inc_zone_blkno;
+            meta->inc_zone_first = zm.inc_zone_first;
+            meta->inc_zone_nslots = zm.inc_zone_nslots;
+            MarkBufferDirty(mbuf);
+            UnlockReleaseBuffer(mbuf);
+        }
+    }
+
+    /* Summary statistics for smol_costestimate */
+    smol_collect_meta_stats(index);
+
+    /* Heap rows now covered, where smol_append resumes (it records its own) */
+    if (smol_append_scan == NULL)
+        smol_meta_set_append_mark(index, heap);
 
     /* Store NUMERIC metadata to metapage for scan-time conversion (INCLUDE columns only) */
     if (ninclude > 0)
@@ -963,6 +1274,7 @@ smol_build(Relation heap, Relation index, struct IndexInfo *indexInfo)
             SMOL_LOG("stored NUMERIC metadata for INCLUDE columns");
     }
 
+    smol_last_build.nblocks = RelationGetNumberOfBlocks(index);
     return res;
 }
 
@@ -1006,10 +1318,13 @@ smol_buildempty(Relation index)
 
 /* Build single-column tree with INCLUDE attrs from sorted arrays.
  * Variant for integer-like keys (keys as int64 normalized/sign-preserving).
+ * With a row window the arrays hold only the current window and are refilled
+ * from the sorted stream as leaves consume it.
  */
 static void
 smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * const *incs,
-                                 Size nkeys, uint16 key_len, int inc_count, const uint16 *inc_lens)
+                                 Size nkeys, uint16 key_len, int inc_count, const uint16 *inc_lens,
+                                 SmolRowWindow *win)
 {
     Buffer mbuf;
     Page mpage;
@@ -1040,18 +1355,28 @@ smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * c
     if (nkeys == 0)
         return;
 
-    Size i = 0; BlockNumber prev = InvalidBlockNumber; char *scratch = (char *) palloc(BLCKSZ);
+    Size i = 0; char *scratch = (char *) palloc(BLCKSZ);
+    SmolLeafWriter lw; smol_leaf_writer_start(&lw, idx);
     Size ninc_bytes = 0; for (int c=0;c<inc_count;c++) ninc_bytes += inc_lens[c];
+    char *dict_keys = smol_include_dict ? (char *) palloc(BLCKSZ) : NULL;
 
     /* Track leaf pages for building internal levels (with zone map stats) */
     Size nleaves = 0, aleaves = 0;
     SmolLeafStats *leaf_stats = NULL;
+    const char *winc[16];
 
     while (i < nkeys)
     {
-        Buffer buf = smol_extend(idx);
-        Page page = BufferGetPage(buf);
-        smol_init_page(buf, true, InvalidBlockNumber);
+        /* Streamed build: slide the window so the run scan below sees a full lookahead */
+        if (win && !win->done && nkeys - i < SMOL_BUILD_LOOKAHEAD_ROWS)
+        {
+            nkeys = smol_row_window_refill(win, i);
+            i = 0;
+            keys = *win->cctx->pk;
+            for (int c = 0; c < inc_count; c++) winc[c] = *win->cctx->pi[c];
+            incs = winc;
+        }
+        Page page = smol_leaf_writer_next(&lw);
         Size fs = PageGetFreeSpace(page);
         Size avail = (fs > sizeof(ItemIdData)) ? (fs - sizeof(ItemIdData)) : 0;
         Size header = sizeof(uint16);
@@ -1126,6 +1451,19 @@ smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * c
             use_inc_rle = false;
         }
 
+        /* Dictionary-coded INCLUDE columns win when they fit still more rows */
+        bool use_inc_dict = false;
+        if (smol_include_dict)
+        {
+            Size n_dict = smol_inc_dict_fit(incs, i, remaining, key_len, inc_count, inc_lens, avail);
+            if (n_dict > n_this)
+            {
+                n_this = n_dict;
+                use_inc_rle = false;
+                use_inc_dict = true;
+            }
+        }
+
         /* Test GUC: cap tuples per page to force taller trees */
                 /* TEST-ONLY: smol_test_* GUC check (compiled out in production) */
         if (smol_test_max_tuples_per_page > 0 && n_this > (Size) smol_test_max_tuples_per_page)
@@ -1134,7 +1472,18 @@ smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * c
         SMOL_DEFENSIVE_CHECK(n_this > 0, ERROR,
             (errmsg("smol: cannot fit tuple with INCLUDE on a leaf (perrow=%zu avail=%zu)", (size_t) perrow, (size_t) avail)));
 
-        if (use_inc_rle)
+        if (use_inc_dict)
+        {
+            /* Write dictionary-coded INCLUDE leaf: keys stay plain, packed to key_len */
+            for (Size j = 0; j < n_this; j++)
+                smol_for_store_key(dict_keys + j * key_len, keys[i + j], key_len);
+            Size sz = smol_inc_dict_encode(scratch, dict_keys, incs, i, (uint16) n_this,
+                                           key_len, inc_count, inc_lens);
+            OffsetNumber off = PageAddItem(page, (Item) scratch, sz, FirstOffsetNumber, false, false);
+            SMOL_DEFENSIVE_CHECK(off != InvalidOffsetNumber, ERROR,
+                (errmsg("smol: failed to add leaf payload (INCLUDE dictionary)")));
+        }
+        else if (use_inc_rle)
         {
             /* Write Include-RLE: [0x8003][nitems][nruns][runs...] */
             uint16 tag = 0x8003u;
@@ -1207,11 +1556,7 @@ smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * c
             SMOL_DEFENSIVE_CHECK(off != InvalidOffsetNumber, ERROR,
                 (errmsg("smol: failed to add leaf payload (INCLUDE)")));
         }
-        MarkBufferDirty(buf);
-        BlockNumber cur = BufferGetBlockNumber(buf);
-        UnlockReleaseBuffer(buf);
-        smol_link_siblings(idx, prev, cur);
-        prev = cur;
+        BlockNumber cur = lw.blkno;
 
         /* Track this leaf and collect zone map statistics */
         if (nleaves == aleaves)
@@ -1224,49 +1569,26 @@ smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * c
         /* Collect zone map statistics for this leaf */
         if (smol_build_zone_maps)
         {
-            /* keys is int64 array, need to extract first/last correctly */
-            int64 first_val = keys[i];
-            int64 last_val = keys[i + n_this - 1];
-
+            /* keys is a sorted int64 array: first/last are the leaf's min/max */
+            memset(&leaf_stats[nleaves], 0, sizeof(SmolLeafStats));
             leaf_stats[nleaves].blk = cur;
             leaf_stats[nleaves].row_count = n_this;
-
-            /* Extract min/max based on actual key type */
-            if (key_len == 2)
-            {
-                leaf_stats[nleaves].minkey = (int32)(int16)first_val;
-                leaf_stats[nleaves].maxkey = (int32)(int16)last_val;
-            }
-            else if (key_len == 4)
-            {
-                leaf_stats[nleaves].minkey = (int32)first_val;
-                leaf_stats[nleaves].maxkey = (int32)last_val;
-            }
-            else /* key_len == 8 */
-            {
-                leaf_stats[nleaves].minkey = (int32)first_val;
-                leaf_stats[nleaves].maxkey = (int32)last_val;
-            }
-
+            smol_zkey_from_int64(leaf_stats[nleaves].minkey, keys[i]);
+            smol_zkey_from_int64(leaf_stats[nleaves].maxkey, keys[i + n_this - 1]);
             leaf_stats[nleaves].distinct_count = (uint16)Min(n_this, 65535);
-            leaf_stats[nleaves].bloom_filter = 0;
-            leaf_stats[nleaves].padding = 0;
         }
         else
         {
             /* Zone maps disabled: fill minimal stats */
+            memset(&leaf_stats[nleaves], 0, sizeof(SmolLeafStats));
             leaf_stats[nleaves].blk = cur;
-            leaf_stats[nleaves].maxkey = (int32)keys[i + n_this - 1]; /* highkey */
-            leaf_stats[nleaves].minkey = 0;
-            leaf_stats[nleaves].row_count = 0;
-            leaf_stats[nleaves].distinct_count = 0;
-            leaf_stats[nleaves].bloom_filter = 0;
-            leaf_stats[nleaves].padding = 0;
+            smol_zkey_from_int64(leaf_stats[nleaves].maxkey, keys[i + n_this - 1]); /* highkey */
         }
         nleaves++;
 
         i += n_this;
     }
+    smol_leaf_writer_finish(&lw);
 
     /* Build internal levels if we have multiple leaves */
     if (nleaves == 1)
@@ -1276,7 +1598,7 @@ smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * c
         LockBuffer(mbuf, BUFFER_LOCK_EXCLUSIVE);
         mpage = BufferGetPage(mbuf);
         meta = smol_meta_ptr(mpage);
-        meta->root_blkno = 1;
+        meta->root_blkno = leaf_stats[0].blk;
         meta->height = 1;
         MarkBufferDirty(mbuf);
         UnlockReleaseBuffer(mbuf);
@@ -1292,13 +1614,17 @@ smol_build_tree1_inc_from_sorted(Relation idx, const int64 *keys, const char * c
         pfree(leaf_stats);
     }
 
+    if (dict_keys)
+        pfree(dict_keys);
     pfree(scratch);
 }
 
-/* Build single-column TEXT(<=32) keys with INCLUDE attrs from sorted arrays. */
+/* Build single-column TEXT(<=32) keys with INCLUDE attrs from sorted arrays
+ * (or a refillable row window, as for smol_build_tree1_inc_from_sorted). */
 static void
 smol_build_text_inc_from_sorted(Relation idx, const char *keys32, const char * const *incs,
-                                Size nkeys, uint16 key_len, int inc_count, const uint16 *inc_lens)
+                                Size nkeys, uint16 key_len, int inc_count, const uint16 *inc_lens,
+                                SmolRowWindow *win)
 {
     Buffer mbuf; Page mpage; SmolMeta *meta;
     if (RelationGetNumberOfBlocks(idx) == 0)
@@ -1324,19 +1650,28 @@ smol_build_text_inc_from_sorted(Relation idx, const char *keys32, const char * c
         UnlockReleaseBuffer(mbuf);
     }
     if (nkeys == 0) return;
-    Size i = 0; BlockNumber prev = InvalidBlockNumber; char *scratch = (char *) palloc(BLCKSZ);
+    Size i = 0; char *scratch = (char *) palloc(BLCKSZ);
+    SmolLeafWriter lw; smol_leaf_writer_start(&lw, idx);
     Size ninc_bytes = 0; for (int c=0;c<inc_count;c++) ninc_bytes += inc_lens[c];
 
     /* Track leaf pages for building internal levels (with zone map stats) */
     Size nleaves = 0, aleaves = 0;
     SmolLeafStats *leaf_stats = NULL;
     Oid typid = TEXTOID;  /* Text key type for zone maps */
+    const char *winc[16];
 
     while (i < nkeys)
     {
-        Buffer buf = smol_extend(idx);
-        Page page = BufferGetPage(buf);
-        smol_init_page(buf, true, InvalidBlockNumber);
+        /* Streamed build: slide the window so the run scan below sees a full lookahead */
+        if (win && !win->done && nkeys - i < SMOL_BUILD_LOOKAHEAD_ROWS)
+        {
+            nkeys = smol_row_window_refill(win, i);
+            i = 0;
+            keys32 = *win->cctx->pkbytes;
+            for (int c = 0; c < inc_count; c++) winc[c] = *win->cctx->pi[c];
+            incs = winc;
+        }
+        Page page = smol_leaf_writer_next(&lw);
         Size fs = PageGetFreeSpace(page);
         Size avail = (fs > sizeof(ItemIdData)) ? (fs - sizeof(ItemIdData)) : 0;
         Size header = sizeof(uint16);
@@ -1412,6 +1747,19 @@ smol_build_text_inc_from_sorted(Relation idx, const char *keys32, const char * c
             use_inc_rle = false;
         }
 
+        /* Dictionary-coded INCLUDE columns win when they fit still more rows */
+        bool use_inc_dict = false;
+        if (smol_include_dict)
+        {
+            Size n_dict = smol_inc_dict_fit(incs, i, remaining, key_len, inc_count, inc_lens, avail);
+            if (n_dict > n_this)
+            {
+                n_this = n_dict;
+                use_inc_rle = false;
+                use_inc_dict = true;
+            }
+        }
+
         /* Test GUC: cap tuples per page to force taller trees */
                 /* TEST-ONLY: smol_test_* GUC check (compiled out in production) */
         if (smol_test_max_tuples_per_page > 0 && n_this > (Size) smol_test_max_tuples_per_page)
@@ -1420,7 +1768,16 @@ smol_build_text_inc_from_sorted(Relation idx, const char *keys32, const char * c
         SMOL_DEFENSIVE_CHECK(n_this > 0, ERROR,
             (errmsg("smol: cannot fit tuple with INCLUDE on a leaf (perrow=%zu avail=%zu)", (size_t) perrow, (size_t) avail)));
 
-        if (use_inc_rle)
+        if (use_inc_dict)
+        {
+            /* Write dictionary-coded INCLUDE leaf: keys stay plain */
+            Size sz = smol_inc_dict_encode(scratch, keys32 + (size_t) i * key_len, incs, i, (uint16) n_this,
+                                           key_len, inc_count, inc_lens);
+            OffsetNumber off = PageAddItem(page, (Item) scratch, sz, FirstOffsetNumber, false, false);
+            SMOL_DEFENSIVE_CHECK(off != InvalidOffsetNumber, ERROR,
+                (errmsg("smol: failed to add leaf payload (TEXT INCLUDE dictionary)")));
+        }
+        else if (use_inc_rle)
         {
             /* Write Include-RLE: [0x8003][nitems][nruns][runs...] */
             uint16 tag = 0x8003u;
@@ -1487,11 +1844,7 @@ smol_build_text_inc_from_sorted(Relation idx, const char *keys32, const char * c
             SMOL_DEFENSIVE_CHECK(PageAddItem(page, (Item) scratch, sz, FirstOffsetNumber, false, false) != InvalidOffsetNumber,
                                  WARNING, (errmsg("smol: failed to add leaf payload (TEXT+INCLUDE)")));
         }
-        MarkBufferDirty(buf);
-        BlockNumber cur = BufferGetBlockNumber(buf);
-        UnlockReleaseBuffer(buf);
-        smol_link_siblings(idx, prev, cur);
-        prev = cur;
+        BlockNumber cur = lw.blkno;
 
         /* Track this leaf and collect zone map statistics */
         if (nleaves == aleaves)
@@ -1509,19 +1862,13 @@ smol_build_text_inc_from_sorted(Relation idx, const char *keys32, const char * c
         else
         {
             /* Zone maps disabled: fill minimal stats */
-            leaf_stats[nleaves].blk = cur;
-            /* For text, store first 4 bytes of last key as maxkey */
-            memcpy(&leaf_stats[nleaves].maxkey, keys32 + (i + n_this - 1) * key_len, Min(sizeof(int32), key_len));
-            leaf_stats[nleaves].minkey = 0;
-            leaf_stats[nleaves].row_count = 0;
-            leaf_stats[nleaves].distinct_count = 0;
-            leaf_stats[nleaves].bloom_filter = 0;
-            leaf_stats[nleaves].padding = 0;
+            smol_leaf_stats_highkey_only(&leaf_stats[nleaves], cur, keys32 + (i + n_this - 1) * key_len, key_len, typid);
         }
         nleaves++;
 
         i += n_this;
     }
+    smol_leaf_writer_finish(&lw);
 
     /* Build internal levels if we have multiple leaves */
     if (nleaves == 1)
@@ -1531,7 +1878,7 @@ smol_build_text_inc_from_sorted(Relation idx, const char *keys32, const char * c
         LockBuffer(mbuf, BUFFER_LOCK_EXCLUSIVE);
         mpage = BufferGetPage(mbuf);
         meta = smol_meta_ptr(mpage);
-        meta->root_blkno = 1;
+        meta->root_blkno = leaf_stats[0].blk;
         meta->height = 1;
         MarkBufferDirty(mbuf);
         UnlockReleaseBuffer(mbuf);
@@ -1696,39 +2043,50 @@ smol_build_internal_levels_with_stats(Relation idx,
             Buffer ibuf = smol_extend(idx);
             smol_init_page(ibuf, false, InvalidBlockNumber);
             Page ipg = BufferGetPage(ibuf);
-            Size item_sz = sizeof(SmolInternalItem);
-            SmolInternalItem *item = (SmolInternalItem *) palloc(item_sz);
+            Size item_sz = sizeof(SmolInternalItemV6) + 2 * (Size) smol_meta_zkey_len(&meta);
+            char *item = (char *) palloc(item_sz);
             Size children_added = 0;
 
             /* Initialize aggregated stats for this internal node */
             SmolLeafStats aggregated;
+            memset(&aggregated, 0, sizeof(SmolLeafStats));
             aggregated.blk = BufferGetBlockNumber(ibuf);
-            aggregated.minkey = INT32_MAX;
-            aggregated.maxkey = INT32_MIN;
-            aggregated.row_count = 0;
-            aggregated.distinct_count = 0;
-            aggregated.bloom_filter = 0;
-            aggregated.padding = 0;
 
             for (; i < cur_n; i++)
             {
+                SmolZoneItem zitem;
+
+                /* Check for room first so the parent aggregates only children on this page */
+                if (PageGetFreeSpace(ipg) < item_sz + sizeof(ItemIdData))
+                    break;
+
                 /* Build internal node entry with zone map metadata */
-                item->child = cur_stats[i].blk;
-                item->highkey = cur_stats[i].maxkey;
+                memset(&zitem, 0, sizeof(SmolZoneItem));
+                zitem.child = cur_stats[i].blk;
+                memcpy(zitem.highkey, cur_stats[i].maxkey, SMOL_ZKEY_MAX);
+                if (zone_maps_enabled)
+                {
+                    memcpy(zitem.minkey, cur_stats[i].minkey, SMOL_ZKEY_MAX);
+                    zitem.row_count = cur_stats[i].row_count;
+                    zitem.distinct_count = cur_stats[i].distinct_count;
+                    zitem.bloom_filter = cur_stats[i].bloom_filter;
+                }
+                /* else: zone maps disabled, min/count/bloom stay zero */
+
+                OffsetNumber off = PageAddItem(ipg, (Item) item, smol_internal_item_write(item, &zitem, &meta),
+                                               InvalidOffsetNumber, false, false);
+                SMOL_DEFENSIVE_CHECK(off != InvalidOffsetNumber, WARNING,
+                    (errmsg("smol: internal page add failed during build (with stats)")));
+                if (off == InvalidOffsetNumber)
+                    break; /* GCOV_EXCL_LINE - Defensive: PageAddItem should never fail during build */
 
+                /* Aggregate statistics for parent level (the highkey is needed for navigation) */
+                if (children_added == 0 || memcmp(cur_stats[i].maxkey, aggregated.maxkey, SMOL_ZKEY_MAX) > 0)
+                    memcpy(aggregated.maxkey, cur_stats[i].maxkey, SMOL_ZKEY_MAX);
                 if (zone_maps_enabled)
                 {
-                    item->minkey = cur_stats[i].minkey;
-                    item->row_count = cur_stats[i].row_count;
-                    item->distinct_count = cur_stats[i].distinct_count;
-                    item->bloom_filter = cur_stats[i].bloom_filter;
-                    item->padding = 0;
-
-                    /* Aggregate statistics for parent level */
-                    if (cur_stats[i].minkey < aggregated.minkey)
-                        aggregated.minkey = cur_stats[i].minkey;
-                    if (cur_stats[i].maxkey > aggregated.maxkey)
-                        aggregated.maxkey = cur_stats[i].maxkey;
+                    if (children_added == 0 || memcmp(cur_stats[i].minkey, aggregated.minkey, SMOL_ZKEY_MAX) < 0)
+                        memcpy(aggregated.minkey, cur_stats[i].minkey, SMOL_ZKEY_MAX);
                     aggregated.row_count += cur_stats[i].row_count;
                     /* Sum distinct counts, saturate at UINT16_MAX */
                     if ((uint32)aggregated.distinct_count + (uint32)cur_stats[i].distinct_count > UINT16_MAX)
@@ -1738,24 +2096,6 @@ smol_build_internal_levels_with_stats(Relation idx,
                     /* OR bloom filters together */
                     aggregated.bloom_filter |= cur_stats[i].bloom_filter;
                 }
-                else
-                {
-                    /* Zone maps disabled: zero out fields */
-                    item->minkey = 0;
-                    item->row_count = 0;
-                    item->distinct_count = 0;
-                    item->bloom_filter = 0;
-                    item->padding = 0;
-                }
-
-                if (PageGetFreeSpace(ipg) < item_sz + sizeof(ItemIdData))
-                    break;
-
-                OffsetNumber off = PageAddItem(ipg, (Item) item, item_sz, InvalidOffsetNumber, false, false);
-                SMOL_DEFENSIVE_CHECK(off != InvalidOffsetNumber, WARNING,
-                    (errmsg("smol: internal page add failed during build (with stats)")));
-                if (off == InvalidOffsetNumber)
-                    break; /* GCOV_EXCL_LINE - Defensive: PageAddItem should never fail during build */
 
                 children_added++;
 
@@ -1929,7 +2269,9 @@ smol_build_internal_levels_bytes(Relation idx,
 }
 /* GCOV_EXCL_STOP */
 
-/* Stream-write text keys from tuplesort into leaf pages with given cap (8/16/32).
+/* Stream-write text keys from tuplesort into leaf pages with given cap (8/16/32,
+ * or up to SMOL_TEXT_KEY_MAX under smol.text_prefix).  Pages are padded, RLE, or
+ * prefix-truncated when that fits more rows.
  * Stores original text (not transformed). Collation handling is done at scan time. */
 static void
 smol_build_text_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nkeys, uint16 key_len)
@@ -1957,70 +2299,104 @@ smol_build_text_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nke
     }
     if (nkeys == 0)
         return;
-    BlockNumber prev = InvalidBlockNumber;
+    SmolLeafWriter lw; smol_leaf_writer_start(&lw, idx);
     Size nleaves = 0, aleaves = 0;
     SmolLeafStats *leaf_stats = NULL;
     Oid typid = TEXTOID;
-    char lastkey[32];
-    Size remaining = nkeys;
+    char lastkey[SMOL_TEXT_KEY_MAX];
+    Size remaining = nkeys, unread = nkeys;
 
     /* Allocate scratch buffer for page construction (reused across pages) */
     char *scratch = (char *) palloc(BLCKSZ);
 
+    /*
+     * Lookahead window of padded keys and their heap blocks.  A prefix page
+     * can hold up to BLCKSZ / 2 rows, so at least wmin rows stay buffered;
+     * the window is twice that so each refill's memmove is amortized.
+     */
+    Size wmin = smol_text_prefix ? BLCKSZ / sizeof(uint16) : BLCKSZ / key_len;
+    Size wcap = wmin * 2, win_off = 0, win_n = 0;
+    char *win = (char *) palloc(wcap * key_len);
+    BlockNumber *win_blk = (BlockNumber *) palloc(wcap * sizeof(BlockNumber));
+
     while (remaining > 0)
     {
-        Buffer buf = smol_extend(idx);
-        smol_init_page(buf, true, InvalidBlockNumber);
-        Page page = BufferGetPage(buf);
+        Page page = smol_leaf_writer_next(&lw);
         Size fs = PageGetFreeSpace(page);
         Size avail = (fs > sizeof(ItemIdData)) ? (fs - sizeof(ItemIdData)) : 0;
 
         /* Calculate max tuples for plain format */
         Size header_plain = sizeof(uint16);
         Size max_n_plain = (avail > header_plain) ? ((avail - header_plain) / key_len) : 0;
-        SMOL_DEFENSIVE_CHECK(max_n_plain > 0, ERROR, (errmsg("smol: cannot fit any tuple on a leaf (key_len=%u)", key_len)));
-        Size n_this = (remaining < max_n_plain) ? remaining : max_n_plain;
+
+        /* Top up the window of padded keys for format analysis */
+        if (win_n - win_off < wmin && unread > 0)
+        {
+            memmove(win, win + win_off * key_len, (win_n - win_off) * key_len);
+            memmove(win_blk, win_blk + win_off, (win_n - win_off) * sizeof(BlockNumber));
+            win_n -= win_off;
+            win_off = 0;
+            for (; win_n < wcap && unread > 0; win_n++, unread--)
+            {
+                IndexTuple itup = tuplesort_getindextuple(ts, true);
+                SMOL_DEFENSIVE_CHECK(itup != NULL, ERROR,
+                                    (errmsg("smol: unexpected end of tuplesort stream")));
+                win_blk[win_n] = ItemPointerGetBlockNumber(&itup->t_tid);
+                bool isnull;
+                Datum val = index_getattr(itup, 1, idx->rd_att, &isnull);
+                if (isnull) ereport(ERROR,(errmsg("smol does not support NULL values")));
+
+                text *t = DatumGetTextPP(val);
+                int blen = VARSIZE_ANY_EXHDR(t);
+                const char *src = VARDATA_ANY(t);
+                if (blen > (int) key_len) ereport(ERROR,(errmsg("smol text key exceeds cap")));
+
+                char *dest = win + (win_n * key_len);
+
+                /* Store original text (zero-padded) for all collations.
+                 * Tuplesort has already sorted using the correct collation comparator,
+                 * so the keys are in the right order. We store original text to support
+                 * index-only scans. During scan, we'll transform both stored keys and
+                 * query bounds for comparison. */
+                if (blen > 0) memcpy(dest, src, blen);
+                if (blen < (int) key_len) memset(dest + blen, 0, key_len - blen);
+                /* Do not pfree itup - owned by tuplesort */
+            }
+        }
+        char *keys_buf = win + win_off * key_len;
+        Size buffered = win_n - win_off;
+        Size n_this = (buffered < max_n_plain) ? buffered : max_n_plain;
+
+        /* Prefix-truncated layout when it fits more rows than the padded one */
+        bool use_prefix = false;
+        if (smol_text_prefix)
+        {
+            Size n_tp = smol_tp_fit(keys_buf, buffered, key_len, avail);
+
+            if (n_tp > n_this)
+            {
+                use_prefix = true;
+                n_this = n_tp;
+            }
+        }
+        SMOL_DEFENSIVE_CHECK(n_this > 0, ERROR, (errmsg("smol: cannot fit any tuple on a leaf (key_len=%u)", key_len)));
 
         /* Test GUC: cap tuples per page to force taller trees */
                 /* TEST-ONLY: smol_test_* GUC check (compiled out in production) */
         if (smol_test_max_tuples_per_page > 0 && n_this > (Size) smol_test_max_tuples_per_page)
             n_this = (Size) smol_test_max_tuples_per_page;
 
-        /* Collect n_this tuples into a buffer for RLE analysis */
-        char *keys_buf = (char *) palloc(n_this * key_len);
+        BlockNumber heap_lo = InvalidBlockNumber, heap_hi = InvalidBlockNumber;
         for (Size i = 0; i < n_this; i++)
-        {
-            IndexTuple itup = tuplesort_getindextuple(ts, true);
-            SMOL_DEFENSIVE_CHECK(itup != NULL, ERROR,
-                                (errmsg("smol: unexpected end of tuplesort stream")));
-            bool isnull;
-            Datum val = index_getattr(itup, 1, idx->rd_att, &isnull);
-            if (isnull) ereport(ERROR,(errmsg("smol does not support NULL values")));
-
-            text *t = DatumGetTextPP(val);
-            int blen = VARSIZE_ANY_EXHDR(t);
-            const char *src = VARDATA_ANY(t);
-            if (blen > (int) key_len) ereport(ERROR,(errmsg("smol text key exceeds cap")));
-
-            char *dest = keys_buf + (i * key_len);
-
-            /* Store original text (zero-padded) for all collations.
-             * Tuplesort has already sorted using the correct collation comparator,
-             * so the keys are in the right order. We store original text to support
-             * index-only scans. During scan, we'll transform both stored keys and
-             * query bounds for comparison. */
-            if (blen > 0) memcpy(dest, src, blen);
-            if (blen < (int) key_len) memset(dest + blen, 0, key_len - blen);
-
-            if (i == n_this - 1) memcpy(lastkey, dest, key_len);
-            /* Do not pfree itup - owned by tuplesort */
-        }
+            smol_heap_range_add(&heap_lo, &heap_hi, win_blk[win_off + i]);
+        memcpy(lastkey, keys_buf + (n_this - 1) * key_len, key_len);
 
         /* Analyze for RLE opportunities */
         bool use_rle = false;
         Size rle_sz = 0;
         uint16 rle_nruns = 0;
 
+        if (!use_prefix)
         {
             Size pos = 0; Size sz_runs = 0; uint16 nr = 0;
             while (pos < n_this)
@@ -2055,7 +2431,9 @@ smol_build_text_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nke
 
         /* Write page with chosen format */
         Size sz;
-        if (use_rle)
+        if (use_prefix)
+            sz = smol_tp_encode(scratch, keys_buf, (uint16) n_this, key_len);
+        else if (use_rle)
         {
             /* RLE format with version controlled by GUC */
             /* Determine which format to use based on GUC setting */
@@ -2106,14 +2484,11 @@ smol_build_text_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nke
 
         OffsetNumber off = PageAddItem(page, (Item) scratch, sz, FirstOffsetNumber, false, false);
         SMOL_DEFENSIVE_CHECK(off != InvalidOffsetNumber, WARNING,
-            (errmsg("smol: failed to add leaf payload (text%s)", use_rle ? " RLE" : "")));
+            (errmsg("smol: failed to add leaf payload (text%s)", use_prefix ? " prefix" : use_rle ? " RLE" : "")));
 
-        pfree(keys_buf);
-        MarkBufferDirty(buf);
-        BlockNumber cur = BufferGetBlockNumber(buf);
-        UnlockReleaseBuffer(buf);
-        smol_link_siblings(idx, prev, cur);
-        prev = cur;
+        win_off += n_this;
+        smol_page_set_heap_range(page, heap_lo, heap_hi);
+        BlockNumber cur = lw.blkno;
         /* record leaf statistics */
         if (nleaves == aleaves)
         {
@@ -2122,10 +2497,8 @@ smol_build_text_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nke
         }
         if (smol_build_zone_maps)
         {
-            /* Collect zone map stats by re-reading the leaf page we just wrote */
-            Buffer rbuf = ReadBuffer(idx, cur);
-            LockBuffer(rbuf, BUFFER_LOCK_SHARE);
-            Page rpage = BufferGetPage(rbuf);
+            /* Collect zone map stats from the leaf just filled; the writer still holds it */
+            Page rpage = page;
             OffsetNumber roff = FirstOffsetNumber;
             ItemId iid = PageGetItemId(rpage, roff);
             Item item = PageGetItem(rpage, iid);
@@ -2154,6 +2527,14 @@ smol_build_text_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nke
                 }
                 n_for_stats = nitems;
             }
+            else if (tag == SMOL_TAG_TEXT_PREFIX)
+            {
+                uint16 nitems = smol_leaf_nitems(rpage);
+
+                keys_for_stats = (char *) palloc((Size) nitems * key_len);
+                smol_tp_decode((const char *) item, keys_for_stats, key_len);
+                n_for_stats = nitems;
+            }
             else
             {
                 /* Plain format */
@@ -2164,24 +2545,21 @@ smol_build_text_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nke
                 n_for_stats = nitems;
             }
             smol_collect_leaf_stats(&leaf_stats[nleaves], keys_for_stats, n_for_stats, key_len, typid, cur);
-            if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2)
+            if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2 || tag == SMOL_TAG_TEXT_PREFIX)
                 pfree(keys_for_stats);
-            UnlockReleaseBuffer(rbuf);
         }
         else
         {
             /* Minimal stats when zone maps disabled */
-            leaf_stats[nleaves].blk = cur;
-            memcpy(&leaf_stats[nleaves].maxkey, lastkey, sizeof(int32));
-            leaf_stats[nleaves].minkey = 0;
-            leaf_stats[nleaves].row_count = 0;
-            leaf_stats[nleaves].distinct_count = 0;
-            leaf_stats[nleaves].bloom_filter = 0;
+            smol_leaf_stats_highkey_only(&leaf_stats[nleaves], cur, lastkey, key_len, typid);
         }
         nleaves++;
         remaining -= n_this;
     }
+    smol_leaf_writer_finish(&lw);
     pfree(scratch);
+    pfree(win);
+    pfree(win_blk);
     /* set meta or build internal */
     if (nleaves == 1)
     {
@@ -2202,9 +2580,14 @@ smol_build_text_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nke
     }
 }
 
-/* Stream-write fixed-length keys from tuplesort into leaf pages. */
+/*
+ * Stream-write fixed-length keys into leaf pages, either from tuplesort or
+ * (ts == NULL) from collected arrays: akeys[aperm[i]] is the i-th key in
+ * order and ablks[aperm[i]] its heap block.
+ */
 static void
-smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nkeys, uint16 key_len, bool byval)
+smol_build_fixed_stream(Relation idx, Tuplesortstate *ts, Size nkeys, uint16 key_len, bool byval,
+                        const char *akeys, const uint32 *aperm, const BlockNumber *ablks)
 {
     /* init meta page if new */
     if (RelationGetNumberOfBlocks(idx) == 0)
@@ -2229,12 +2612,13 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
     }
     if (nkeys == 0)
         return;
-    BlockNumber prev = InvalidBlockNumber;
+    SmolLeafWriter lw; smol_leaf_writer_start(&lw, idx);
     Size nleaves = 0, aleaves = 0;
     SmolLeafStats *leaf_stats = NULL;
     Oid typid = TupleDescAttr(idx->rd_att, 0)->atttypid;
     char lastkey[16]; /* buffer for last key (max 16 bytes for UUID) */
     Size remaining = nkeys;
+    Size next_row = 0;   /* next array row when ts == NULL */
     IndexTuple itup;
     memset(lastkey, 0, sizeof(lastkey));
 
@@ -2245,15 +2629,18 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
     char prev_page_last_key[16];
     bool prev_page_has_key = false;
 
+    /* Frame-of-reference leaves compete with plain/RLE for integer keys */
+    bool bitpack = smol_key_bitpack && byval && smol_zkey_type_is_int64(typid) &&
+                   (key_len == 2 || key_len == 4 || key_len == 8);
+
     /* Pending tuple from previous page (when page filled up) */
     char *pending_key = NULL;
     bool has_pending = false;
+    BlockNumber pending_heap_blk = InvalidBlockNumber;
 
     while (remaining > 0)
     {
-        Buffer buf = smol_extend(idx);
-        smol_init_page(buf, true, InvalidBlockNumber);
-        Page page = BufferGetPage(buf);
+        Page page = smol_leaf_writer_next(&lw);
         Size fs = PageGetFreeSpace(page);
         Size avail = (fs > sizeof(ItemIdData)) ? (fs - sizeof(ItemIdData)) : 0;
 
@@ -2267,10 +2654,17 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
         uint16 rle_current_count = 0;
         bool rle_has_key = false;
 
+        /* FOR size so far: finished blocks plus the open block's count/range */
+        Size for_done_size = 0;
+        uint32 for_blk_cnt = 0;
+        int64 for_blk_min = 0, for_blk_max = 0;
+        Size for_size = SMOL_FOR_HEADER + SMOL_FOR_SLACK;
+
         /* Dynamic buffer for keys on this page */
         Size keys_buf_cap = 256;  /* initial capacity */
         Size keys_buf_len = 0;
         char *keys_buf = (char *) palloc(keys_buf_cap * key_len);
+        BlockNumber heap_lo = InvalidBlockNumber, heap_hi = InvalidBlockNumber;
 
         /* Process pending tuple from previous page first */
         if (has_pending)
@@ -2283,46 +2677,68 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
             rle_nruns = 1;
             rle_current_size += key_len + sizeof(uint16);
             rle_has_key = true;
+            if (bitpack)
+            {
+                for_blk_min = for_blk_max = smol_for_load_key(pending_key, key_len);
+                for_blk_cnt = 1;
+                for_size = SMOL_FOR_HEADER + SMOL_FOR_SLACK + smol_for_block_bytes(1, 0);
+            }
             has_pending = false;
+            smol_heap_range_add(&heap_lo, &heap_hi, pending_heap_blk);
         }
 
         /* Fetch and pack tuples incrementally until page full */
         while (remaining > 0)
         {
-            /* Fetch next tuple */
-            itup = tuplesort_getindextuple(ts, true);
-            if (itup == NULL)
+            char key_scratch[16];
+            char *k = key_scratch;
+            BlockNumber heap_blk;
+
+            if (ts == NULL)
             {
-                /* Don't modify remaining here - it will be decremented by n_this at end of page loop */
-                break;
+                /* Sorted arrays: no more rows once every key has been placed */
+                if (next_row >= nkeys)
+                    break;
+                uint32 j = aperm[next_row++];
+                memcpy(k, akeys + (size_t) j * key_len, key_len);
+                heap_blk = ablks[j];
             }
+            else
+            {
+                /* Fetch next tuple */
+                itup = tuplesort_getindextuple(ts, true);
+                if (itup == NULL)
+                {
+                    /* Don't modify remaining here - it will be decremented by n_this at end of page loop */
+                    break;
+                }
+                heap_blk = ItemPointerGetBlockNumber(&itup->t_tid);
 
-            /* Extract key value */
-            bool isnull;
-            Datum val = index_getattr(itup, 1, idx->rd_att, &isnull);
-            if (isnull) ereport(ERROR,(errmsg("smol does not support NULL values")));
+                /* Extract key value */
+                bool isnull;
+                Datum val = index_getattr(itup, 1, idx->rd_att, &isnull);
+                if (isnull) ereport(ERROR,(errmsg("smol does not support NULL values")));
 
-            char key_scratch[16];
-            char *k = key_scratch;
-            if (byval)
-            {
-                SMOL_DEFENSIVE_CHECK(key_len == 1 || key_len == 2 || key_len == 4 || key_len == 8 || key_len == 16, ERROR,
-                                    (errmsg("key_len %d must be 1,2,4,8, or 16 for byval types", (int) key_len)));
-                switch (key_len)
+                if (byval)
                 {
-                    case 1: { char v = DatumGetChar(val); memcpy(k, &v, 1); break; }
-                    case 2: { int16 v = DatumGetInt16(val); memcpy(k, &v, 2); break; }
-                    case 4: { int32 v = DatumGetInt32(val); memcpy(k, &v, 4); break; }
-                    case 8: { int64 v = DatumGetInt64(val); memcpy(k, &v, 8); break; }
-                    case 16: { /* GCOV_EXCL_LINE */
-                        memcpy(k, DatumGetPointer(val), 16); /* GCOV_EXCL_LINE */
-                        break; /* GCOV_EXCL_LINE */
+                    SMOL_DEFENSIVE_CHECK(key_len == 1 || key_len == 2 || key_len == 4 || key_len == 8 || key_len == 16, ERROR,
+                                        (errmsg("key_len %d must be 1,2,4,8, or 16 for byval types", (int) key_len)));
+                    switch (key_len)
+                    {
+                        case 1: { char v = DatumGetChar(val); memcpy(k, &v, 1); break; }
+                        case 2: { int16 v = DatumGetInt16(val); memcpy(k, &v, 2); break; }
+                        case 4: { int32 v = DatumGetInt32(val); memcpy(k, &v, 4); break; }
+                        case 8: { int64 v = DatumGetInt64(val); memcpy(k, &v, 8); break; }
+                        case 16: { /* GCOV_EXCL_LINE */
+                            memcpy(k, DatumGetPointer(val), 16); /* GCOV_EXCL_LINE */
+                            break; /* GCOV_EXCL_LINE */
+                        }
                     }
                 }
-            }
-            else
-            {
-                memcpy(k, DatumGetPointer(val), key_len);
+                else
+                {
+                    memcpy(k, DatumGetPointer(val), key_len);
+                }
             }
 
             /* Calculate delta size for this tuple */
@@ -2346,6 +2762,7 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
                 if (!pending_key) pending_key = (char *) palloc(key_len);
                 memcpy(pending_key, k, key_len);
                 has_pending = true;
+                pending_heap_blk = heap_blk;
                 break;
             }
 
@@ -2356,16 +2773,31 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
                 if (!pending_key) pending_key = (char *) palloc(key_len);
                 memcpy(pending_key, k, key_len);
                 has_pending = true;
+                pending_heap_blk = heap_blk;
                 break;
             }
 
-            /* Would this overflow the page (RLE format)? */
-            if (rle_current_size + delta_size > avail)
+            /* FOR size with this key appended to the open (or a new) block */
+            Size for_next = 0;
+            if (bitpack)
+            {
+                int64 v = smol_for_load_key(k, key_len);
+                if (for_blk_cnt == 0 || for_blk_cnt == SMOL_FOR_BLOCK)
+                    for_next = for_size + smol_for_block_bytes(1, 0);
+                else
+                    for_next = SMOL_FOR_HEADER + SMOL_FOR_SLACK + for_done_size +
+                        smol_for_block_bytes(for_blk_cnt + 1,
+                                             smol_for_width((uint64) Max(v, for_blk_max) - (uint64) Min(v, for_blk_min)));
+            }
+
+            /* Would this overflow the page (RLE format, and FOR when enabled)? */
+            if (rle_current_size + delta_size > avail && !(bitpack && for_next <= avail))
             {
                 /* Page full - save tuple for next page */
                 if (!pending_key) pending_key = (char *) palloc(key_len);
                 memcpy(pending_key, k, key_len);
                 has_pending = true;
+                pending_heap_blk = heap_blk;
                 break;
             }
 
@@ -2377,6 +2809,25 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
             }
             memcpy(keys_buf + (keys_buf_len * key_len), k, key_len);
             keys_buf_len++;
+            smol_heap_range_add(&heap_lo, &heap_hi, heap_blk);
+
+            if (bitpack)
+            {
+                int64 v = smol_for_load_key(k, key_len);
+                if (for_blk_cnt == 0 || for_blk_cnt == SMOL_FOR_BLOCK)
+                {
+                    for_done_size = for_size - SMOL_FOR_HEADER - SMOL_FOR_SLACK;
+                    for_blk_min = for_blk_max = v;
+                    for_blk_cnt = 1;
+                }
+                else
+                {
+                    for_blk_min = Min(v, for_blk_min);
+                    for_blk_max = Max(v, for_blk_max);
+                    for_blk_cnt++;
+                }
+                for_size = for_next;
+            }
 
             if (!rle_has_key || memcmp(k, rle_current_key, key_len) != 0)
             {
@@ -2415,9 +2866,33 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
                      n_this, rle_nruns, uniqueness_ratio, rle_sz, plain_sz);
         }
 
+        /* FOR wins when it fits and beats both alternatives (or is the only fit) */
+        bool use_for = false;
+        if (bitpack && for_size <= avail &&
+            (plain_sz > avail || for_size < plain_sz) && !(use_rle && rle_sz <= for_size))
+        {
+            use_for = true;
+            use_rle = false;
+            SMOL_LOGF("FOR format: n=%zu for_sz=%zu rle_sz=%zu plain_sz=%zu",
+                     n_this, for_size, rle_sz, plain_sz);
+        }
+        else if (bitpack && plain_sz > avail)
+        {
+            /* Every key was admitted under RLE or FOR; FOR lost, so RLE fits */
+            use_rle = true;
+        }
+
         /* Write page with chosen format */
         Size sz;
-        if (use_rle)
+        if (use_for)
+        {
+            sz = smol_for_encode(scratch, keys_buf, (uint16) n_this, key_len);
+            Assert(sz == for_size);
+
+            memcpy(prev_page_last_key, lastkey, key_len);
+            prev_page_has_key = true;
+        }
+        else if (use_rle)
         {
             /* PHASE 2: RLE V2 with continuation detection */
             uint16 tag = SMOL_TAG_KEY_RLE_V2;
@@ -2475,26 +2950,25 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
 
         OffsetNumber off = PageAddItem(page, (Item) scratch, sz, FirstOffsetNumber, false, false);
         SMOL_DEFENSIVE_CHECK(off != InvalidOffsetNumber, ERROR,
-            (errmsg("smol: failed to add leaf payload (fixed%s)", use_rle ? " RLE" : "")));
+            (errmsg("smol: failed to add leaf payload (fixed%s)", use_rle ? " RLE" : use_for ? " FOR" : "")));
 
-        pfree(keys_buf);
-        MarkBufferDirty(buf);
-        BlockNumber cur = BufferGetBlockNumber(buf);
-        UnlockReleaseBuffer(buf);
-        smol_link_siblings(idx, prev, cur);
-        prev = cur;
+        smol_page_set_heap_range(page, heap_lo, heap_hi);
+        BlockNumber cur = lw.blkno;
         /* record leaf statistics */
         if (nleaves == aleaves)
         {
             aleaves = (aleaves == 0 ? 64 : aleaves * 2);
             leaf_stats = (leaf_stats == NULL) ? (SmolLeafStats *) palloc(aleaves * sizeof(SmolLeafStats)) : (SmolLeafStats *) repalloc(leaf_stats, aleaves * sizeof(SmolLeafStats));
         }
-        if (smol_build_zone_maps)
+        if (smol_build_zone_maps && use_for)
         {
-            /* Collect zone map stats by re-reading the leaf page we just wrote */
-            Buffer rbuf = ReadBuffer(idx, cur);
-            LockBuffer(rbuf, BUFFER_LOCK_SHARE);
-            Page rpage = BufferGetPage(rbuf);
+            /* FOR pages hold no key array; the keys are still in keys_buf */
+            smol_collect_leaf_stats(&leaf_stats[nleaves], keys_buf, n_this, key_len, typid, cur);
+        }
+        else if (smol_build_zone_maps)
+        {
+            /* Collect zone map stats from the leaf just filled; the writer still holds it */
+            Page rpage = page;
             OffsetNumber roff = FirstOffsetNumber;
             ItemId iid = PageGetItemId(rpage, roff);
             Item item = PageGetItem(rpage, iid);
@@ -2534,21 +3008,17 @@ smol_build_fixed_stream_from_tuplesort(Relation idx, Tuplesortstate *ts, Size nk
             smol_collect_leaf_stats(&leaf_stats[nleaves], keys_for_stats, n_for_stats, key_len, typid, cur);
             if (tag == SMOL_TAG_KEY_RLE_V2)
                 pfree(keys_for_stats);
-            UnlockReleaseBuffer(rbuf);
         }
         else
         {
             /* Minimal stats when zone maps disabled */
-            leaf_stats[nleaves].blk = cur;
-            memcpy(&leaf_stats[nleaves].maxkey, lastkey, sizeof(int32));
-            leaf_stats[nleaves].minkey = 0;
-            leaf_stats[nleaves].row_count = 0;
-            leaf_stats[nleaves].distinct_count = 0;
-            leaf_stats[nleaves].bloom_filter = 0;
+            smol_leaf_stats_highkey_only(&leaf_stats[nleaves], cur, lastkey, key_len, typid);
         }
+        pfree(keys_buf);
         nleaves++;
         remaining -= n_this;
     }
+    smol_leaf_writer_finish(&lw);
     pfree(scratch);
     /* set meta or build internal */
     if (nleaves == 1)
@@ -2630,6 +3100,118 @@ smol_test_backward_scan(PG_FUNCTION_ARGS)
     PG_RETURN_INT32(count);
 }
 
+/* --- Microbenchmark functions (bench/micro.py, make bench-micro) --- */
+
+/*
+ * smol_bench_scan(idx regclass, loops int4, backward bool) - time the AM scan
+ * loop without the executor
+ *
+ * Runs 'loops' unbounded index-only scans through smol_rescan/smol_gettuple,
+ * the way smol_test_backward_scan drives a scan, so planner, executor and
+ * heap costs stay out of the measurement.  Returns the tuples returned by
+ * one loop, nanoseconds per tuple and the decoded key + INCLUDE bytes per
+ * second.
+ */
+PG_FUNCTION_INFO_V1(smol_bench_scan);
+Datum
+smol_bench_scan(PG_FUNCTION_ARGS)
+{
+    Oid indexoid = PG_GETARG_OID(0);
+    int32 loops = PG_GETARG_INT32(1);
+    ScanDirection dir = PG_GETARG_BOOL(2) ? BackwardScanDirection : ForwardScanDirection;
+    Relation idx;
+    IndexScanDesc scan;
+    SmolScanOpaque so;
+    TupleDesc tupdesc;
+    Datum values[3];
+    bool nulls[3] = {false, false, false};
+    instr_time t0, elapsed;
+    uint64 ntuples = 0;
+    double ns, row_bytes;
+
+    if (loops < 1)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("smol_bench_scan: loops must be at least 1")));
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "function returning record called in invalid context"); /* GCOV_EXCL_LINE */
+
+    idx = index_open(indexoid, AccessShareLock);
+    if (idx->rd_indam->ambuild != smol_build)
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("smol_bench_scan: \"%s\" is not a smol index", RelationGetRelationName(idx))));
+    smol_agg_check_access(idx, "smol_bench_scan");
+
+    scan = smol_beginscan(idx, 0, 0);
+    scan->xs_want_itup = true;
+    so = (SmolScanOpaque) scan->opaque;
+    row_bytes = (double) so->key_len + (double) so->key_len2;
+    for (int i = 0; i < so->ninclude; i++)
+        row_bytes += (double) so->inc_meta->inc_len[i];
+
+    INSTR_TIME_SET_CURRENT(t0);
+    for (int l = 0; l < loops; l++)
+    {
+        CHECK_FOR_INTERRUPTS();
+        smol_rescan(scan, NULL, 0, NULL, 0);
+        while (smol_gettuple(scan, dir))
+            ntuples++;
+    }
+    INSTR_TIME_SET_CURRENT(elapsed);
+    INSTR_TIME_SUBTRACT(elapsed, t0);
+
+    smol_endscan(scan);
+    index_close(idx, AccessShareLock);
+
+    ns = (double) INSTR_TIME_GET_NANOSEC(elapsed);
+    values[0] = Int64GetDatum((int64) (ntuples / (uint64) loops));
+    if (ntuples > 0 && ns > 0)
+    {
+        values[1] = Float8GetDatum(ns / (double) ntuples);
+        values[2] = Float8GetDatum((double) ntuples * row_bytes / (1024.0 * 1024.0) / (ns / 1e9));
+    }
+    else
+        nulls[1] = nulls[2] = true;
+
+    tupdesc = BlessTupleDesc(tupdesc);
+    PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * smol_bench_build_profile() - phase timings of this backend's last build
+ *
+ * smol_build records its collect/sort/write markers in smol_last_build; this
+ * returns them with the index size and the build rate in index MB/s.  All
+ * columns are NULL before the first build in the session.
+ */
+PG_FUNCTION_INFO_V1(smol_bench_build_profile);
+Datum
+smol_bench_build_profile(PG_FUNCTION_ARGS)
+{
+    TupleDesc tupdesc;
+    Datum values[8];
+    bool nulls[8];
+    double mb;
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "function returning record called in invalid context"); /* GCOV_EXCL_LINE */
+
+    memset(nulls, !OidIsValid(smol_last_build.indexoid), sizeof(nulls));
+    mb = (double) smol_last_build.nblocks * BLCKSZ / (1024.0 * 1024.0);
+    values[0] = ObjectIdGetDatum(smol_last_build.indexoid);
+    values[1] = Int64GetDatum((int64) smol_last_build.tuples);
+    values[2] = Float8GetDatum(smol_last_build.collect_ms);
+    values[3] = Float8GetDatum(smol_last_build.sort_ms);
+    values[4] = Float8GetDatum(smol_last_build.write_ms);
+    values[5] = Float8GetDatum(smol_last_build.total_ms);
+    values[6] = Float8GetDatum(mb);
+    values[7] = Float8GetDatum(smol_last_build.total_ms > 0 ? mb / (smol_last_build.total_ms / 1000.0) : 0.0);
+
+    tupdesc = BlessTupleDesc(tupdesc);
+    PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
 /*
  * NOTE: smol_test_parallel_scan was removed because parallel scan paths
  * are properly tested via SQL queries with forced parallel workers.
@@ -2763,6 +3345,882 @@ smol_inspect(PG_FUNCTION_ARGS)
     PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
 }
 
+/* Claim and load chunks until none are left */
+static void
+smol_prewarm_claim(Relation idx, SmolPrewarmShared *shared)
+{
+    for (;;)
+    {
+        uint32 r = pg_atomic_fetch_add_u32(&shared->next_range, 1);
+
+        if (r >= shared->nranges)
+            break;
+        pg_atomic_fetch_add_u64(&shared->blocks_read,
+                                smol_prewarm_blocks(idx, shared->ranges[r].start, shared->ranges[r].end));
+    }
+}
+
+/*
+ * smol_prewarm(idx regclass, workers int4) - load a SMOL index into shared
+ * buffers in the order scans need it
+ *
+ * The leader first reads the metapage, leaf directory and internal levels so
+ * descents stop missing as early as possible, then the leaf block range is
+ * cut into chunks claimed by the leader and up to 'workers' parallel workers.
+ * With a directory the chunks follow its entries and carry equal row counts;
+ * otherwise they are equal block ranges.  Returns the number of blocks read.
+ */
+PG_FUNCTION_INFO_V1(smol_prewarm);
+
+Datum
+smol_prewarm(PG_FUNCTION_ARGS)
+{
+    Oid         indexoid = PG_GETARG_OID(0);
+    int         nworkers = PG_GETARG_INT32(1);
+    Relation    idx;
+    SmolMeta    meta;
+    SmolDirectory *dir;
+    SmolPrewarmShared *shared;
+    ParallelContext *pcxt = NULL;
+    BlockNumber nblocks;
+    BlockNumber first = 1;
+    uint32      nranges;
+    Size        sz;
+    uint64      nread;
+    AclResult   aclresult;
+
+    if (nworkers < 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("smol_prewarm: workers must not be negative")));
+    nworkers = Min(nworkers, MAX_PARALLEL_WORKER_LIMIT);
+
+    idx = index_open(indexoid, AccessShareLock);
+    if (idx->rd_indam->ambuild != smol_build)
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("smol_prewarm: \"%s\" is not a smol index", RelationGetRelationName(idx))));
+    /* Like pg_prewarm, loading a relation takes SELECT on it (here: its table) */
+    aclresult = pg_class_aclcheck(idx->rd_index->indrelid, GetUserId(), ACL_SELECT);
+    if (aclresult != ACLCHECK_OK)
+        aclcheck_error(aclresult, OBJECT_TABLE, get_rel_name(idx->rd_index->indrelid));
+    nblocks = RelationGetNumberOfBlocks(idx);
+    if (nblocks == 0)
+    {
+        index_close(idx, AccessShareLock);
+        PG_RETURN_INT64(0);
+    }
+    smol_meta_read(idx, &meta);
+    if (meta.magic != SMOL_META_MAGIC)
+        ereport(ERROR,
+                (errcode(ERRCODE_INDEX_CORRUPTED),
+                 errmsg("smol_prewarm: index \"%s\" has no valid SMOL metapage",
+                        RelationGetRelationName(idx))));
+    nread = smol_prewarm_upper(idx, &meta);
+
+    /* Four chunks per participant lets early finishers pick up slack */
+    nranges = (uint32) (nworkers + 1) * 4;
+    dir = smol_read_directory(idx, meta.directory_blkno);
+    if (dir)
+        first = dir->entries[0].leaf_blkno;
+    nranges = Max(Min(nranges, nblocks - first), 1);
+    sz = add_size(offsetof(SmolPrewarmShared, ranges), mul_size(nranges, sizeof(SmolPrewarmRange)));
+
+    if (nworkers > 0)
+    {
+        EnterParallelMode();
+        pcxt = CreateParallelContext("$libdir/smol", "smol_parallel_prewarm_main", nworkers);
+        shm_toc_estimate_chunk(&pcxt->estimator, sz);
+        shm_toc_estimate_keys(&pcxt->estimator, 1);
+        InitializeParallelDSM(pcxt);
+        shared = (SmolPrewarmShared *) shm_toc_allocate(pcxt->toc, sz);
+    }
+    else
+        shared = (SmolPrewarmShared *) palloc(sz);
+
+    shared->indexrelid = indexoid;
+    shared->nranges = nranges;
+    pg_atomic_init_u32(&shared->next_range, 0);
+    pg_atomic_init_u64(&shared->blocks_read, 0);
+    for (uint32 r = 0; r < nranges; r++)
+    {
+        if (dir)
+        {
+            /* Entry whose cumulative rows reach this chunk's share; leaves increase in block order */
+            uint64 target = dir->row_start[dir->num_entries] * r / nranges;
+            uint32 lo = 0, hi = dir->num_entries;
+
+            while (hi - lo > 1)
+            {
+                uint32 mid = lo + (hi - lo) / 2;
+
+                if (dir->row_start[mid] <= target)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            shared->ranges[r].start = (r == 0) ? first : dir->entries[lo].leaf_blkno;
+        }
+        else
+            shared->ranges[r].start = first + (BlockNumber) ((uint64) (nblocks - first) * r / nranges);
+        if (r > 0)
+            shared->ranges[r - 1].end = Max(shared->ranges[r].start, shared->ranges[r - 1].start);
+    }
+    shared->ranges[nranges - 1].end = nblocks;
+
+    if (pcxt)
+    {
+        shm_toc_insert(pcxt->toc, PARALLEL_KEY_SMOL_PREWARM, shared);
+        LaunchParallelWorkers(pcxt);
+        SMOL_LOGF("prewarm: launched %d of %d workers for %u chunks",
+                  pcxt->nworkers_launched, nworkers, nranges);
+    }
+
+    /* The leader takes chunks too, so fewer launched workers only slow it down */
+    smol_prewarm_claim(idx, shared);
+    if (pcxt)
+    {
+        WaitForParallelWorkersToFinish(pcxt);
+        nread += pg_atomic_read_u64(&shared->blocks_read);
+        DestroyParallelContext(pcxt);
+        ExitParallelMode();
+    }
+    else
+    {
+        nread += pg_atomic_read_u64(&shared->blocks_read);
+        pfree(shared);
+    }
+
+    if (dir)
+    {
+        pfree(dir->row_start);
+        pfree(dir);
+    }
+    index_close(idx, AccessShareLock);
+    PG_RETURN_INT64((int64) nread);
+}
+
+/* Parallel worker for smol_prewarm: claim chunks from the shared list */
+PGDLLEXPORT void
+smol_parallel_prewarm_main(dsm_segment *seg, shm_toc *toc)
+{
+    SmolPrewarmShared *shared;
+    Relation idx;
+
+    (void) seg;
+    shared = (SmolPrewarmShared *) shm_toc_lookup(toc, PARALLEL_KEY_SMOL_PREWARM, false);
+    idx = index_open(shared->indexrelid, AccessShareLock);
+    smol_prewarm_claim(idx, shared);
+    index_close(idx, AccessShareLock);
+}
+
+/*
+ * ========================================================================
+ * Append segments and compaction
+ * ========================================================================
+ *
+ * smol_append indexes the heap rows added since the last build as a new
+ * segment: an ordinary smol_build run over the rows past the high-water
+ * mark, written into fresh blocks after the existing ones.  The new rows
+ * must sort at or above the index's last key, so the segment's leaves are
+ * linked onto the right end of the leaf chain and a fresh upper tree is
+ * built over both halves; scans then see one ordered chain and need no merge.
+ * smol_compact rebuilds the internal levels, directory and statistics over
+ * the whole chain once several segments have been added.
+ */
+
+/* Overwrite the metapage with *m */
+static void
+smol_meta_write(Relation idx, const SmolMeta *m)
+{
+    Buffer buf = ReadBuffer(idx, 0);
+
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    memcpy(smol_meta_ptr(BufferGetPage(buf)), m, sizeof(SmolMeta));
+    MarkBufferDirty(buf);
+    UnlockReleaseBuffer(buf);
+}
+
+/* First or last child of an internal page */
+static BlockNumber
+smol_internal_edge_child(Relation idx, const SmolMeta *meta, BlockNumber blk, bool right)
+{
+    Buffer buf = ReadBuffer(idx, blk);
+    Page page;
+    SmolZoneItem item;
+
+    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    page = BufferGetPage(buf);
+    smol_internal_item_read(page, right ? PageGetMaxOffsetNumber(page) : FirstOffsetNumber, meta, &item);
+    UnlockReleaseBuffer(buf);
+    return item.child;
+}
+
+/* Leftmost or rightmost node 'level' levels above the leaves (0 = leaf) */
+static BlockNumber
+smol_tree_edge(Relation idx, const SmolMeta *meta, BlockNumber root, uint16 height,
+               uint16 level, bool right)
+{
+    BlockNumber blk = root;
+
+    for (uint16 l = height - 1; l > level; l--)
+        blk = smol_internal_edge_child(idx, meta, blk, right);
+    return blk;
+}
+
+/* First or last leading key of a leaf, in its on-page width */
+static const char *
+smol_leaf_edge_key(Page page, const SmolMeta *meta, bool last)
+{
+    uint32 inc_cumul[17];
+
+    inc_cumul[0] = 0;
+    for (uint16 i = 0; i < meta->inc_count; i++)
+        inc_cumul[i + 1] = inc_cumul[i] + meta->inc_len[i];
+    if (meta->nkeyatts == 2)
+    {
+        uint16 n = smol12_leaf_nrows(page);
+
+        return smol12_row_k1_ptr(page, last ? n : 1, meta->key_len1, meta->key_len2,
+                                 inc_cumul[meta->inc_count]);
+    }
+    return smol_leaf_keyptr_ex(page, last ? smol_leaf_nitems(page) : 1, meta->key_len1,
+                               meta->inc_len, meta->inc_count, inc_cumul);
+}
+
+/*
+ * Stats for a leaf read back from its page.  Bloom filters are not rebuilt:
+ * an all-ones filter passes every probe and keeps the parents' OR sound.
+ */
+static void
+smol_leaf_edge_stats(Relation idx, const SmolMeta *meta, BlockNumber blk, SmolLeafStats *st)
+{
+    Oid typid = TupleDescAttr(RelationGetDescr(idx), 0)->atttypid;
+    Buffer buf = ReadBuffer(idx, blk);
+    Page page;
+    uint32 n;
+
+    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    page = BufferGetPage(buf);
+    n = meta->nkeyatts == 2 ? smol12_leaf_nrows(page) : smol_leaf_nitems(page);
+    smol_leaf_stats_highkey_only(st, blk, smol_leaf_edge_key(page, meta, true), meta->key_len1, typid);
+    if (meta->zone_maps_enabled)
+    {
+        smol_zkey_from_keyptr(st->minkey, SMOL_ZKEY_MAX, smol_leaf_edge_key(page, meta, false),
+                              meta->key_len1, typid);
+        st->row_count = n;
+        st->distinct_count = (uint16) Min(n, 65535);
+        st->bloom_filter = meta->bloom_enabled ? ~UINT64_C(0) : 0;
+    }
+    UnlockReleaseBuffer(buf);
+}
+
+static void
+smol_zone_item_to_stats(const SmolZoneItem *item, SmolLeafStats *st)
+{
+    memset(st, 0, sizeof(SmolLeafStats));
+    st->blk = item->child;
+    st->row_count = item->row_count;
+    st->distinct_count = item->distinct_count;
+    st->bloom_filter = item->bloom_filter;
+    memcpy(st->minkey, item->minkey, SMOL_ZKEY_MAX);
+    memcpy(st->maxkey, item->highkey, SMOL_ZKEY_MAX);
+}
+
+/*
+ * smol_tree_nodes - stats for every node of a tree at 'level' (1 = leaves,
+ * 2 = leaf parents), in key order, as smol_build_internal_levels_with_stats
+ * takes them.  *last_blk is set to the rightmost node of that level.
+ */
+static SmolLeafStats *
+smol_tree_nodes(Relation idx, const SmolMeta *meta, BlockNumber root, uint16 height,
+                uint16 level, Size *n, BlockNumber *last_blk)
+{
+    Size cap = 64;
+    SmolLeafStats *out = (SmolLeafStats *) palloc(cap * sizeof(SmolLeafStats));
+    BlockNumber blk;
+
+    *n = 0;
+    if (height == 1)
+    {
+        smol_leaf_edge_stats(idx, meta, root, &out[0]);
+        *n = 1;
+        *last_blk = root;
+        return out;
+    }
+
+    /* Walk the leaf-parent level along its rightlinks */
+    blk = smol_tree_edge(idx, meta, root, height, 1, false);
+    while (BlockNumberIsValid(blk))
+    {
+        Buffer buf = ReadBuffer(idx, blk);
+        Page page;
+        OffsetNumber maxoff;
+        SmolLeafStats agg;
+
+        CHECK_FOR_INTERRUPTS();
+        LockBuffer(buf, BUFFER_LOCK_SHARE);
+        page = BufferGetPage(buf);
+        maxoff = PageGetMaxOffsetNumber(page);
+        memset(&agg, 0, sizeof(SmolLeafStats));
+        agg.blk = blk;
+        for (OffsetNumber off = FirstOffsetNumber; off <= maxoff; off++)
+        {
+            SmolZoneItem item;
+            SmolLeafStats st;
+
+            smol_internal_item_read(page, off, meta, &item);
+            smol_zone_item_to_stats(&item, &st);
+            if (level == 1)
+            {
+                if (*n >= cap)
+                {
+                    cap *= 2;
+                    out = (SmolLeafStats *) repalloc(out, cap * sizeof(SmolLeafStats));
+                }
+                out[(*n)++] = st;
+                *last_blk = st.blk;
+                continue;
+            }
+            if (off == FirstOffsetNumber || memcmp(st.maxkey, agg.maxkey, SMOL_ZKEY_MAX) > 0)
+                memcpy(agg.maxkey, st.maxkey, SMOL_ZKEY_MAX);
+            if (off == FirstOffsetNumber || memcmp(st.minkey, agg.minkey, SMOL_ZKEY_MAX) < 0)
+                memcpy(agg.minkey, st.minkey, SMOL_ZKEY_MAX);
+            agg.row_count += st.row_count;
+            agg.distinct_count = (uint16) Min((uint32) agg.distinct_count + st.distinct_count, UINT16_MAX);
+            agg.bloom_filter |= st.bloom_filter;
+        }
+        blk = smol_page_opaque(page)->rightlink;
+        UnlockReleaseBuffer(buf);
+        if (level == 2)
+        {
+            if (*n >= cap)
+            {
+                cap *= 2;
+                out = (SmolLeafStats *) repalloc(out, cap * sizeof(SmolLeafStats));
+            }
+            out[(*n)++] = agg;
+            *last_blk = agg.blk;
+        }
+    }
+    return out;
+}
+
+/*
+ * smol_append_join - put a freshly built segment to the right of the base
+ * tree and fill *fin with the combined metapage.  The two are joined at the
+ * highest level both have below their roots; a new upper tree is built over
+ * the nodes of that level and the old upper pages are left unreferenced.
+ */
+static void
+smol_append_join(Relation idx, const SmolMeta *base, const SmolMeta *seg, SmolMeta *fin)
+{
+    uint16 level;
+    Size nb, ns;
+    BlockNumber base_last, seg_last;
+    SmolLeafStats *bn, *sn, *all;
+    BlockNumber base_leaf, seg_leaf;
+    BlockNumber root;
+    uint16 levels;
+
+    *fin = *base;
+    if (!BlockNumberIsValid(seg->root_blkno) || seg->height < 1)
+        return;                 /* nothing new was visible: only the mark moves */
+    SMOL_DEFENSIVE_CHECK(seg->key_len1 == base->key_len1 && seg->key_len2 == base->key_len2 &&
+                         seg->inc_count == base->inc_count &&
+                         memcmp(seg->inc_len, base->inc_len, sizeof(base->inc_len)) == 0, ERROR,
+                         (errmsg("smol_append: segment layout differs from index \"%s\"",
+                                 RelationGetRelationName(idx))));
+    fin->nsegments = base->nsegments + 1;
+    fin->directory_blkno = InvalidBlockNumber;
+    if (!BlockNumberIsValid(base->root_blkno) || base->height < 1)
+    {
+        /* The base index was empty: the segment is the whole tree */
+        fin->root_blkno = seg->root_blkno;
+        fin->height = seg->height;
+        fin->stat_rows = seg->stat_rows;
+        fin->stat_distinct = seg->stat_distinct;
+        fin->stat_leaves = seg->stat_leaves;
+        fin->stat_packed_leaves = seg->stat_packed_leaves;
+        memcpy(fin->stat_fanout, seg->stat_fanout, sizeof(fin->stat_fanout));
+        return;
+    }
+
+    level = (base->height >= 2 && seg->height >= 2) ? 2 : 1;
+    bn = smol_tree_nodes(idx, base, base->root_blkno, base->height, level, &nb, &base_last);
+    sn = smol_tree_nodes(idx, base, seg->root_blkno, seg->height, level, &ns, &seg_last);
+    all = (SmolLeafStats *) palloc((nb + ns) * sizeof(SmolLeafStats));
+    memcpy(all, bn, nb * sizeof(SmolLeafStats));
+    memcpy(all + nb, sn, ns * sizeof(SmolLeafStats));
+    base_leaf = smol_tree_edge(idx, base, base->root_blkno, base->height, 0, true);
+    seg_leaf = smol_tree_edge(idx, base, seg->root_blkno, seg->height, 0, false);
+    smol_build_internal_levels_with_stats(idx, all, nb + ns, base->key_len1, &root, &levels);
+    /* The builder points the metapage at the new root; the caller rewrites it */
+    smol_meta_write(idx, base);
+
+    smol_link_siblings(idx, base_leaf, seg_leaf);
+    if (level == 2)
+    {
+        Buffer pb = ReadBuffer(idx, base_last);
+
+        LockBuffer(pb, BUFFER_LOCK_EXCLUSIVE);
+        smol_page_opaque(BufferGetPage(pb))->rightlink = sn[0].blk;
+        MarkBufferDirty(pb);
+        UnlockReleaseBuffer(pb);
+    }
+    fin->root_blkno = root;
+    fin->height = (uint16) (levels + level);
+    fin->stat_rows = base->stat_rows + seg->stat_rows;
+    fin->stat_distinct = base->stat_distinct + seg->stat_distinct;
+    fin->stat_leaves = base->stat_leaves + seg->stat_leaves;
+    fin->stat_packed_leaves = base->stat_packed_leaves + seg->stat_packed_leaves;
+    pfree(all);
+    pfree(bn);
+    pfree(sn);
+}
+
+/* Open a SMOL index for maintenance by the owner of its table */
+static Relation
+smol_maint_open(Oid indexoid, const char *fn, Relation *heap)
+{
+    Oid heapoid;
+    Relation idx;
+
+    if (get_rel_relkind(indexoid) != RELKIND_INDEX)
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("%s: \"%s\" is not an index", fn, get_rel_name(indexoid))));
+    heapoid = IndexGetRelation(indexoid, false);
+    *heap = table_open(heapoid, ShareLock);
+    if (!object_ownercheck(RelationRelationId, heapoid, GetUserId()))
+        aclcheck_error(ACLCHECK_NOT_OWNER, OBJECT_TABLE, RelationGetRelationName(*heap));
+    idx = index_open(indexoid, AccessExclusiveLock);
+    if (idx->rd_indam->ambuild != smol_build)
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("%s: \"%s\" is not a smol index", fn, RelationGetRelationName(idx))));
+    return idx;
+}
+
+/*
+ * smol_append(idx regclass) - index the heap rows added since the last build
+ * or append as a new segment.  Returns the number of rows added.
+ */
+PG_FUNCTION_INFO_V1(smol_append);
+
+Datum
+smol_append(PG_FUNCTION_ARGS)
+{
+    Oid         indexoid = PG_GETARG_OID(0);
+    Relation    heap;
+    Relation    idx;
+    TupleDesc   desc;
+    SmolMeta    base, seg, fin;
+    SmolAppendScan as;
+    BlockNumber mark_blk;
+    OffsetNumber mark_off;
+    bool        cur_xact;
+    bool        updated;
+    int         nest;
+
+    idx = smol_maint_open(indexoid, "smol_append", &heap);
+    desc = RelationGetDescr(idx);
+    smol_meta_read(idx, &base);
+    if (base.version < SMOL_META_VERSION_APPEND)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("smol_append: index \"%s\" predates append support", RelationGetRelationName(idx)),
+                 errhint("REINDEX the index first.")));
+    for (int i = 0; i < desc->natts; i++)
+        if (TupleDescAttr(desc, i)->atttypid == TEXTOID)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("smol_append does not support text columns"),
+                     errdetail("Text widths are fixed when the index is built.")));
+
+    /* smol_insert saw a row placed where the range scan of new rows does not look */
+    if (base.append_stale)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("smol_append: rows of table \"%s\" were placed at or below the indexed ones",
+                        RelationGetRelationName(heap)),
+                 errdetail("An UPDATE or reuse of free space put them before the high-water mark."),
+                 errhint("REINDEX the index instead.")));
+
+    smol_heap_append_mark(heap, &mark_blk, &mark_off);
+    if (mark_blk < base.append_heap_blk ||
+        (mark_blk == base.append_heap_blk && mark_off <= base.append_heap_off))
+    {
+        index_close(idx, NoLock);
+        table_close(heap, NoLock);
+        PG_RETURN_INT64(0);
+    }
+
+    /*
+     * The segment is written in place and outlives an abort, so it may only
+     * hold committed rows.  ShareLock has waited out every other writer; an
+     * aborted insert is dead and the build scan leaves it out.  A non-HOT
+     * UPDATE would leave its old version in the index next to the new one.
+     */
+    smol_heap_new_rows_check(heap, base.append_heap_blk, base.append_heap_off, mark_blk, mark_off,
+                             &cur_xact, &updated);
+    if (cur_xact)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("smol_append: new rows of table \"%s\" were inserted by the current transaction",
+                        RelationGetRelationName(heap)),
+                 errdetail("Appended segments are not rolled back with the transaction."),
+                 errhint("Commit the inserts, then call smol_append.")));
+    if (updated)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("smol_append: rows of table \"%s\" were updated since the last build or append",
+                        RelationGetRelationName(heap)),
+                 errdetail("The index would keep the old versions of the updated rows."),
+                 errhint("REINDEX the index instead.")));
+
+    /* New rows are checked against the last key before any page is written */
+    memset(&as, 0, sizeof(as));
+    as.hwm_blk = base.append_heap_blk;
+    as.hwm_off = base.append_heap_off;
+    as.nkeys = base.nkeyatts;
+    for (int k = 0; k < as.nkeys; k++)
+    {
+        fmgr_info_copy(&as.cmp[k], index_getprocinfo(idx, k + 1, 1), CurrentMemoryContext);
+        as.coll[k] = idx->rd_indcollation[k];
+    }
+    if (BlockNumberIsValid(base.root_blkno) && base.height >= 1)
+    {
+        BlockNumber leaf = smol_tree_edge(idx, &base, base.root_blkno, base.height, 0, true);
+        Buffer buf = ReadBuffer(idx, leaf);
+        Page page;
+        uint32 inc_total = 0;
+
+        for (uint16 i = 0; i < base.inc_count; i++)
+            inc_total += base.inc_len[i];
+        LockBuffer(buf, BUFFER_LOCK_SHARE);
+        page = BufferGetPage(buf);
+        for (int k = 0; k < as.nkeys; k++)
+        {
+            Form_pg_attribute att = TupleDescAttr(desc, k);
+            const char *kp;
+
+            if (k == 0)
+                kp = smol_leaf_edge_key(page, &base, true);
+            else
+                kp = smol12_row_k2_ptr(page, smol12_leaf_nrows(page), base.key_len1, base.key_len2, inc_total);
+            as.last[k] = datumCopy(fetch_att(kp, att->attbyval, att->attlen), att->attbyval, att->attlen);
+        }
+        UnlockReleaseBuffer(buf);
+        as.have_last = true;
+    }
+
+    /* Build the segment with the base index's zone map and bloom layout */
+    nest = NewGUCNestLevel();
+    (void) set_config_option("smol.build_zone_maps", base.zone_maps_enabled ? "on" : "off",
+                             PGC_USERSET, PGC_S_SESSION, GUC_ACTION_SAVE, true, 0, false);
+    (void) set_config_option("smol.build_bloom_filters", base.bloom_enabled ? "on" : "off",
+                             PGC_USERSET, PGC_S_SESSION, GUC_ACTION_SAVE, true, 0, false);
+    if (base.bloom_enabled)
+    {
+        char nhash[8];
+
+        snprintf(nhash, sizeof(nhash), "%d", (int) base.bloom_nhash);
+        (void) set_config_option("smol.bloom_nhash", nhash,
+                                 PGC_USERSET, PGC_S_SESSION, GUC_ACTION_SAVE, true, 0, false);
+    }
+
+    /* The segment starts from an empty tree; on error the base metapage is put back */
+    seg = base;
+    seg.root_blkno = InvalidBlockNumber;
+    seg.height = 0;
+    seg.directory_blkno = InvalidBlockNumber;
+    smol_meta_write(idx, &seg);
+    PG_TRY();
+    {
+        smol_append_scan = &as;
+        (void) smol_build(heap, idx, BuildIndexInfo(idx));
+        smol_append_scan = NULL;
+        smol_meta_read(idx, &seg);
+        smol_meta_write(idx, &base);
+        smol_append_join(idx, &base, &seg, &fin);
+    }
+    PG_CATCH();
+    {
+        smol_append_scan = NULL;
+        smol_meta_write(idx, &base);
+        PG_RE_THROW();
+    }
+    PG_END_TRY();
+    AtEOXact_GUC(true, nest);
+    fin.append_heap_blk = mark_blk;
+    fin.append_heap_off = mark_off;
+    smol_meta_write(idx, &fin);
+    SMOL_LOGF("append: %.0f rows, %u segments, root=%u height=%u",
+              as.nrows, fin.nsegments, fin.root_blkno, fin.height);
+    /* The upper levels changed under the same relfilenumber */
+    smol_tree_cache_invalidate(idx);
+
+    index_close(idx, NoLock);
+    table_close(heap, NoLock);
+    PG_RETURN_INT64(BlockNumberIsValid(seg.root_blkno) ? (int64) seg.stat_rows : 0);
+}
+
+/*
+ * smol_compact(idx regclass) - rebuild the internal levels, leaf directory
+ * and statistics of an index grown by smol_append.  Leaves are untouched.
+ * Returns the tree height; indexes with no appended segments are left alone.
+ */
+PG_FUNCTION_INFO_V1(smol_compact);
+
+Datum
+smol_compact(PG_FUNCTION_ARGS)
+{
+    Oid         indexoid = PG_GETARG_OID(0);
+    Relation    heap;
+    Relation    idx;
+    SmolMeta    meta;
+
+    idx = smol_maint_open(indexoid, "smol_compact", &heap);
+    smol_meta_read(idx, &meta);
+    if (meta.nsegments == 0)
+    {
+        /* Nothing appended since the last build or compaction */
+        index_close(idx, NoLock);
+        table_close(heap, NoLock);
+        PG_RETURN_INT32((int32) meta.height);
+    }
+    if (meta.height >= 2 && BlockNumberIsValid(meta.root_blkno))
+    {
+        Size n;
+        BlockNumber last;
+        BlockNumber root;
+        uint16 levels;
+        SmolLeafStats *leaves = smol_tree_nodes(idx, &meta, meta.root_blkno, meta.height, 1, &n, &last);
+
+        smol_build_internal_levels_with_stats(idx, leaves, n, meta.key_len1, &root, &levels);
+        pfree(leaves);
+    }
+
+    smol_meta_read(idx, &meta);
+    meta.directory_blkno = InvalidBlockNumber;
+    meta.nsegments = 0;
+    smol_meta_write(idx, &meta);
+    if (meta.nkeyatts == 1 && BlockNumberIsValid(meta.root_blkno) &&
+        RelationGetNumberOfBlocks(idx) > SMOL_DIR_MIN_LEAVES)
+    {
+        meta.directory_blkno = smol_build_and_write_directory(idx);
+        smol_meta_write(idx, &meta);
+    }
+    smol_collect_meta_stats(idx);
+    smol_tree_cache_invalidate(idx);
+
+    index_close(idx, NoLock);
+    table_close(heap, NoLock);
+    PG_RETURN_INT32((int32) meta.height);
+}
+
+/* smol_build_many: distribute one row of the shared heap scan to every spool */
+typedef struct SmolManyScan
+{
+    SmolManySpool *spools;
+    int         nspools;
+} SmolManyScan;
+
+static void
+smol_many_scan_cb(Relation index, ItemPointer tid, Datum *values, bool *isnull,
+                  bool tupleIsAlive, void *state)
+{
+    SmolManyScan *ms = (SmolManyScan *) state;
+    Datum       v[INDEX_MAX_KEYS + 1];
+    bool        n[INDEX_MAX_KEYS + 1];
+
+    (void) index;
+    (void) tupleIsAlive;
+    for (int s = 0; s < ms->nspools; s++)
+    {
+        SmolManySpool *sp = &ms->spools[s];
+
+        for (int j = 0; j < sp->natts; j++)
+        {
+            v[j] = values[sp->map[j]];
+            n[j] = isnull[sp->map[j]];
+        }
+        v[sp->natts] = Int64GetDatum(((int64) ItemPointerGetBlockNumber(tid) << 16) |
+                                     ItemPointerGetOffsetNumber(tid));
+        n[sp->natts] = false;
+        tuplestore_putvalues(sp->ts, sp->desc, v, n);
+    }
+}
+
+/*
+ * smol_build_many(tbl regclass, indexes regclass[]) - rebuild several SMOL
+ * indexes of a table from one heap scan.  The scan collects the union of
+ * their columns and spools each index's rows; each index is then rebuilt as
+ * by REINDEX INDEX, reading its spool instead of the heap.  An empty array
+ * rebuilds every SMOL index of the table.  Returns the number rebuilt.
+ */
+PG_FUNCTION_INFO_V1(smol_build_many);
+
+Datum
+smol_build_many(PG_FUNCTION_ARGS)
+{
+    Oid         heapoid = PG_GETARG_OID(0);
+    ArrayType  *arr = PG_GETARG_ARRAYTYPE_P(1);
+    Relation    heap;
+    List       *oids = NIL;
+    ListCell   *lc;
+    SmolManyScan ms;
+    SmolManySpool *spools;
+    IndexInfo  *scanInfo = NULL;
+    Relation    first = NULL;
+    int         nunion = 0;
+    AttrNumber  attnos[INDEX_MAX_KEYS];
+    int         nidx;
+    int         spool_kb;
+
+    if (get_rel_relkind(heapoid) != RELKIND_RELATION && get_rel_relkind(heapoid) != RELKIND_MATVIEW)
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("smol_build_many: \"%s\" is not a table", get_rel_name(heapoid))));
+    heap = table_open(heapoid, ShareLock);
+    if (!object_ownercheck(RelationRelationId, heapoid, GetUserId()))
+        aclcheck_error(ACLCHECK_NOT_OWNER, OBJECT_TABLE, RelationGetRelationName(heap));
+
+    if (ARR_NDIM(arr) == 0)
+    {
+        Oid smolam = get_am_oid("smol", false);
+        List *all = RelationGetIndexList(heap);
+
+        foreach(lc, all)
+            if (get_rel_relam(lfirst_oid(lc)) == smolam)
+                oids = lappend_oid(oids, lfirst_oid(lc));
+        list_free(all);
+    }
+    else
+    {
+        Datum *elems;
+        bool *nulls;
+        int nelems;
+
+        deconstruct_array_builtin(arr, REGCLASSOID, &elems, &nulls, &nelems);
+        for (int i = 0; i < nelems; i++)
+        {
+            if (nulls[i])
+                ereport(ERROR,
+                        (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                         errmsg("smol_build_many: index list must not contain nulls")));
+            oids = list_append_unique_oid(oids, DatumGetObjectId(elems[i]));
+        }
+    }
+
+    /* Lock and check every index, and collect the union of their heap columns */
+    nidx = 0;
+    spools = (SmolManySpool *) palloc0(sizeof(SmolManySpool) * Max(list_length(oids), 1));
+    foreach(lc, oids)
+    {
+        Oid indexoid = lfirst_oid(lc);
+        Relation idx;
+        IndexInfo *ii;
+        SmolManySpool *sp;
+
+        if (get_rel_relkind(indexoid) != RELKIND_INDEX)
+            ereport(ERROR,
+                    (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                     errmsg("smol_build_many: \"%s\" is not an index", get_rel_name(indexoid))));
+        idx = index_open(indexoid, AccessExclusiveLock);
+        if (idx->rd_indam->ambuild != smol_build)
+            ereport(ERROR,
+                    (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                     errmsg("smol_build_many: \"%s\" is not a smol index", RelationGetRelationName(idx))));
+        if (idx->rd_index->indrelid != heapoid)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("smol_build_many: index \"%s\" is not on table \"%s\"",
+                            RelationGetRelationName(idx), RelationGetRelationName(heap))));
+        ii = BuildIndexInfo(idx);
+        if (ii->ii_Expressions != NIL || ii->ii_Predicate != NIL)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("smol_build_many: index \"%s\" has expressions or a predicate",
+                            RelationGetRelationName(idx)),
+                     errhint("Rebuild it with REINDEX INDEX.")));
+
+        sp = &spools[nidx++];
+        sp->indexoid = indexoid;
+        sp->natts = ii->ii_NumIndexAttrs;
+        for (int j = 0; j < sp->natts; j++)
+        {
+            AttrNumber attno = ii->ii_IndexAttrNumbers[j];
+            int u = 0;
+
+            while (u < nunion && attnos[u] != attno)
+                u++;
+            if (u == nunion)
+            {
+                if (nunion == INDEX_MAX_KEYS)
+                    ereport(ERROR,
+                            (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                             errmsg("smol_build_many: the indexes cover more than %d columns", INDEX_MAX_KEYS)));
+                attnos[nunion++] = attno;
+            }
+            sp->map[j] = u;
+        }
+        sp->desc = CreateTemplateTupleDesc(sp->natts + 1);
+        for (int j = 0; j < sp->natts; j++)
+            TupleDescCopyEntry(sp->desc, j + 1, RelationGetDescr(idx), j + 1);
+        TupleDescInitEntry(sp->desc, sp->natts + 1, "tid", INT8OID, -1, 0);
+        if (first == NULL)
+        {
+            first = idx;
+            scanInfo = ii;
+        }
+        else
+            index_close(idx, NoLock);
+    }
+    if (nidx == 0)
+    {
+        table_close(heap, NoLock);
+        PG_RETURN_INT32(0);
+    }
+
+    /* One heap scan; the first index stands in for all of them */
+    spool_kb = Max(maintenance_work_mem / nidx, 64);
+    for (int i = 0; i < nidx; i++)
+        spools[i].ts = tuplestore_begin_heap(false, false, spool_kb);
+    scanInfo->ii_NumIndexAttrs = nunion;
+    scanInfo->ii_NumIndexKeyAttrs = nunion;
+    memcpy(scanInfo->ii_IndexAttrNumbers, attnos, sizeof(AttrNumber) * nunion);
+    ms.spools = spools;
+    ms.nspools = nidx;
+    (void) table_index_build_scan(heap, first, scanInfo, true, true, smol_many_scan_cb, (void *) &ms, NULL);
+    SMOL_LOGF("build_many: %d indexes, %d columns from one heap scan", nidx, nunion);
+    /* REINDEX refuses an index this backend still has open */
+    index_close(first, NoLock);
+
+    for (int i = 0; i < nidx; i++)
+    {
+        ReindexParams params = {0};
+
+        PG_TRY();
+        {
+            smol_many_spool = &spools[i];
+            reindex_index(NULL, spools[i].indexoid, false, get_rel_persistence(spools[i].indexoid), &params);
+            smol_many_spool = NULL;
+        }
+        PG_CATCH();
+        {
+            smol_many_spool = NULL;
+            PG_RE_THROW();
+        }
+        PG_END_TRY();
+        tuplestore_end(spools[i].ts);
+    }
+
+    table_close(heap, NoLock);
+    PG_RETURN_INT32(nidx);
+}
+
 /*
  * Whitebox test functions to directly call internal tree navigation functions
  */
@@ -2957,6 +4415,7 @@ smol_begin_parallel(SMOLBuildState *buildstate, bool isconcurrent, int request)
     smolshared->nparticipantsdone = 0;
     smolshared->reltuples = 0.0;
     smolshared->maxlen = 0;
+    memset(smolshared->inc_maxlen, 0, sizeof(smolshared->inc_maxlen));
 
     /* Initialize parallel table scan with snapshot */
     table_parallelscan_initialize(buildstate->heap,
@@ -3024,6 +4483,252 @@ smol_end_parallel(SMOLLeader *smolleader)
     ExitParallelMode();
 }
 
+/*
+ * smol_parallel_collect_ok - can INCLUDE/two-column builds merge worker runs?
+ *
+ * Worker tuplesorts order rows by the index opclasses.  The serial INCLUDE
+ * path orders text keys by memcmp, so text leading keys only go parallel
+ * under a C collation, where both orders agree.  Single-key INCLUDE builds
+ * order other keys by their int64 value, which matches the opclass order for
+ * the integer types only.  The same test gates the external-sort INCLUDE path.
+ */
+static bool
+smol_parallel_collect_ok(Relation index)
+{
+    Oid typid = TupleDescAttr(RelationGetDescr(index), 0)->atttypid;
+
+    if (IndexRelationGetNumberOfKeyAttributes(index) == 1 && typid != TEXTOID)
+        return typid == INT2OID || typid == INT4OID || typid == INT8OID;
+    if (typid == TEXTOID)
+    {
+        pg_locale_t locale = pg_newlocale_from_collation(index->rd_indcollation[0]);
+
+        return locale && locale->collate_is_c;
+    }
+    return true;
+}
+
+/*
+ * smol_parallel_wait_workers - sleep until every worker has sorted its share;
+ * returns the total row count and the longest text key seen (maxlen may be NULL).
+ */
+static void
+smol_parallel_wait_workers(SMOLLeader *smolleader, Size *nkeys, int *maxlen)
+{
+    SMOLShared *smolshared = smolleader->smolshared;
+
+    for (;;)
+    {
+        SpinLockAcquire(&smolshared->mutex);
+        if (smolshared->nparticipantsdone == smolleader->nparticipanttuplesorts)
+        {
+            *nkeys = smolshared->reltuples;
+            if (maxlen)
+                *maxlen = smolshared->maxlen;
+            SpinLockRelease(&smolshared->mutex);
+            break;
+        }
+        SpinLockRelease(&smolshared->mutex);
+        ConditionVariableSleep(&smolshared->workersdonecv, WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+    }
+    ConditionVariableCancelSleep();
+}
+
+/*
+ * smol_parallel_merge_collect - merge the workers' sorted runs and feed each
+ * row, in key order, to a build collection callback
+ *
+ * Used by the INCLUDE and two-column paths, which keep their column-array
+ * collection and leaf writers but skip their own sort.  Returns the number
+ * of rows delivered.
+ */
+static Size
+smol_parallel_merge_collect(SMOLBuildState *buildstate, IndexBuildCallback cb, void *state)
+{
+    SMOLLeader *smolleader = buildstate->smolleader;
+    Relation index = buildstate->index;
+    TupleDesc tupdesc = RelationGetDescr(index);
+    SortCoordinate coordinate;
+    Tuplesortstate *ts;
+    Datum values[INDEX_MAX_KEYS];
+    bool isnull[INDEX_MAX_KEYS];
+    IndexTuple itup;
+    Size nkeys = 0;
+    Size nrows = 0;
+
+    coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+    coordinate->isWorker = false;
+    coordinate->nParticipants = smolleader->nparticipanttuplesorts;
+    coordinate->sharedsort = smolleader->sharedsort;
+    ts = tuplesort_begin_index_btree(buildstate->heap, index, false, false, maintenance_work_mem,
+                                     coordinate, TUPLESORT_NONE);
+
+    smol_parallel_wait_workers(smolleader, &nkeys, NULL);
+    tuplesort_performsort(ts);
+
+    while ((itup = tuplesort_getindextuple(ts, true)) != NULL)
+    {
+        CHECK_FOR_INTERRUPTS();
+        index_deform_tuple(itup, tupdesc, values, isnull);
+        cb(index, &itup->t_tid, values, isnull, true, state);
+        nrows++;
+    }
+    tuplesort_end(ts);
+    pfree(coordinate);
+
+    SMOL_LOGF("parallel build: merged %zu rows from %d workers (workers reported %zu)",
+              nrows, smolleader->nparticipanttuplesorts, nkeys);
+    return nrows;
+}
+
+/*
+ * smol_inc_build_spills - should a serial single-key INCLUDE build sort externally?
+ *
+ * The collected key and INCLUDE columns are a subset of each heap row, so a
+ * heap that fits in maintenance_work_mem keeps the in-memory radix/qsort
+ * path.  Larger heaps go through tuplesort, which bounds its own memory and
+ * spills sorted runs to temp files.
+ */
+static bool
+smol_inc_build_spills(Relation heap, Relation index)
+{
+    double heap_bytes = (double) RelationGetNumberOfBlocks(heap) * BLCKSZ;
+
+    if (heap_bytes <= (double) maintenance_work_mem * 1024.0)
+        return false;
+    return smol_parallel_collect_ok(index);
+}
+
+/*
+ * smol_row_window_refill - slide the row window and top it up from the sort
+ *
+ * Rows before 'consumed' have been written to leaves.  The rest move to the
+ * front of the collection arrays, then merged rows are packed behind them
+ * until the window is full or the stream ends.  The collection arrays may be
+ * reallocated, so callers re-read them.  Returns the rows now buffered.
+ */
+static Size
+smol_row_window_refill(SmolRowWindow *win, Size consumed)
+{
+    SmolIncludeContext *c = win->cctx;
+    Size keep = *c->pcount - consumed;
+    Datum values[INDEX_MAX_KEYS];
+    bool isnull[INDEX_MAX_KEYS];
+    IndexTuple itup;
+
+    if (consumed > 0 && keep > 0)
+    {
+        if (c->key_is_text32)
+            memmove(*c->pkbytes, *c->pkbytes + (size_t) consumed * c->key_len, (size_t) keep * c->key_len);
+        else
+            memmove(*c->pk, *c->pk + consumed, (size_t) keep * sizeof(int64));
+        for (int i = 0; i < c->incn; i++)
+            memmove(*c->pi[i], *c->pi[i] + (size_t) consumed * c->ilen[i], (size_t) keep * c->ilen[i]);
+    }
+    *c->pcount = keep;
+
+    while (*c->pcount < SMOL_BUILD_WINDOW_ROWS)
+    {
+        itup = tuplesort_getindextuple(win->ts, true);
+        if (itup == NULL)
+        {
+            win->done = true;
+            break;
+        }
+        CHECK_FOR_INTERRUPTS();
+        index_deform_tuple(itup, win->tupdesc, values, isnull);
+        smol_build_cb_inc(win->index, &itup->t_tid, values, isnull, true, (void *) c);
+        win->nrows++;
+    }
+    return *c->pcount;
+}
+
+/*
+ * smol_build_inc_streamed - single-key INCLUDE build through an external sort
+ *
+ * Rows are sorted by tuplesort: the serial heap scan feeds it directly, or the
+ * leader merges the workers' runs.  Either way it holds at most
+ * maintenance_work_mem and merges spilled runs from temp files.  The merged
+ * stream is packed into the collection arrays one SmolRowWindow at a time and
+ * written by the usual leaf writers, so memory stays bounded by the window
+ * rather than growing with the table.  Text INCLUDE strides (8/16/32) are
+ * sized from the longest values seen while sorting.
+ */
+static void
+smol_build_inc_streamed(SMOLBuildState *buildstate, SmolIncludeContext *cctx, uint16 *inc_lens)
+{
+    Relation index = buildstate->index;
+    SortCoordinate coordinate = NULL;
+    Tuplesortstate *ts;
+    SmolRowWindow win;
+    const char *incs[16];
+    int inc_maxlen[16] = {0};
+    Size nkeys = 0;
+    Size n;
+
+    if (buildstate->smolleader)
+    {
+        coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+        coordinate->isWorker = false;
+        coordinate->nParticipants = buildstate->smolleader->nparticipanttuplesorts;
+        coordinate->sharedsort = buildstate->smolleader->sharedsort;
+    }
+    ts = tuplesort_begin_index_btree(buildstate->heap, index, false, false, maintenance_work_mem,
+                                     coordinate, TUPLESORT_NONE);
+
+    if (buildstate->smolleader)
+    {
+        SMOLShared *smolshared = buildstate->smolleader->smolshared;
+
+        smol_parallel_wait_workers(buildstate->smolleader, &nkeys, NULL);
+        SpinLockAcquire(&smolshared->mutex);
+        memcpy(inc_maxlen, smolshared->inc_maxlen, sizeof(inc_maxlen));
+        SpinLockRelease(&smolshared->mutex);
+    }
+    else
+    {
+        SmolIncSortContext sc;
+
+        smol_inc_sort_context_init(&sc, index, ts, &nkeys);
+        smol_heap_build_scan(buildstate->heap, index, buildstate->indexInfo,
+                             ts_build_cb_inc, (void *) &sc);
+        memcpy(inc_maxlen, sc.imax, sizeof(inc_maxlen));
+    }
+    tuplesort_performsort(ts);
+
+    for (int c = 0; c < cctx->incn; c++)
+    {
+        if (!cctx->itext[c]) continue;
+        inc_lens[c] = (inc_maxlen[c] <= 8) ? 8 : (inc_maxlen[c] <= 16 ? 16 : 32);
+        cctx->ilen[c] = inc_lens[c];
+    }
+
+    memset(&win, 0, sizeof(win));
+    win.ts = ts;
+    win.index = index;
+    win.tupdesc = RelationGetDescr(index);
+    win.cctx = cctx;
+    SMOL_LOGF("build: external sort of %zu rows (key+%d includes), window=%d rows",
+              nkeys, cctx->incn, SMOL_BUILD_WINDOW_ROWS);
+
+    n = smol_row_window_refill(&win, 0);
+    for (int c = 0; c < cctx->incn; c++)
+        incs[c] = *cctx->pi[c];
+    if (!cctx->key_is_text32)
+        smol_build_tree1_inc_from_sorted(index, *cctx->pk, incs, n, cctx->key_len, cctx->incn, inc_lens, &win);
+    else
+        smol_build_text_inc_from_sorted(index, *cctx->pkbytes, incs, n, cctx->key_len, cctx->incn, inc_lens, &win);
+    SMOL_LOGF("build: streamed %zu rows into leaves", win.nrows);
+
+    tuplesort_end(ts);
+    if (coordinate)
+        pfree(coordinate);
+    if (*cctx->pk) { pfree(*cctx->pk); *cctx->pk = NULL; }
+    if (*cctx->pkbytes) { pfree(*cctx->pkbytes); *cctx->pkbytes = NULL; }
+    for (int c = 0; c < cctx->incn; c++)
+        if (*cctx->pi[c]) { pfree(*cctx->pi[c]); *cctx->pi[c] = NULL; }
+}
+
 /*
  * smol_parallel_build_main - Entry point for parallel worker processes
  *
@@ -3096,12 +4801,31 @@ smol_parallel_build_main(dsm_segment *seg, shm_toc *toc)
     {
         Size nkeys = 0;
         Oid atttypid = TupleDescAttr(RelationGetDescr(index), 0)->atttypid;
+        int nkeyatts = IndexRelationGetNumberOfKeyAttributes(index);
+        int ninclude = RelationGetDescr(index)->natts - nkeyatts;
         TableScanDesc scan;
 
         /* Join the parallel scan */
         scan = table_beginscan_parallel(heap, ParallelTableScanFromSMOLShared(smolshared));
 
-        if (atttypid == TEXTOID)
+        if (ninclude > 0)
+        {
+            /* INCLUDE builds: the leader sizes text INCLUDE strides from these maxima */
+            SmolIncSortContext cb;
+            smol_inc_sort_context_init(&cb, index, ts, &nkeys);
+            table_index_build_scan(heap, index, indexInfo, true, true,
+                                 ts_build_cb_inc, (void *) &cb, scan);
+            tuplesort_performsort(ts);
+
+            SpinLockAcquire(&smolshared->mutex);
+            smolshared->nparticipantsdone++;
+            smolshared->reltuples += (double) nkeys;
+            for (int i = 0; i < cb.incn; i++)
+                if (cb.imax[i] > smolshared->inc_maxlen[i])
+                    smolshared->inc_maxlen[i] = cb.imax[i];
+            SpinLockRelease(&smolshared->mutex);
+        }
+        else if (atttypid == TEXTOID)
         {
             SmolTextBuildContext cb;
             int maxlen = 0;
@@ -3182,6 +4906,37 @@ ts_build_cb_text(Relation rel, ItemPointer tid, Datum *values, bool *isnull, boo
     (*c->pnkeys)++;
 }
 
+/* Set up a SmolIncSortContext for an index with INCLUDE columns */
+static void
+smol_inc_sort_context_init(SmolIncSortContext *c, Relation index, Tuplesortstate *ts, Size *pnkeys)
+{
+    TupleDesc desc = RelationGetDescr(index);
+
+    memset(c, 0, sizeof(*c));
+    c->ts = ts;
+    c->pnkeys = pnkeys;
+    c->nkeyatts = IndexRelationGetNumberOfKeyAttributes(index);
+    c->incn = desc->natts - c->nkeyatts;
+    for (int i = 0; i < c->incn && i < 16; i++)
+        c->itext[i] = (TupleDescAttr(desc, c->nkeyatts + i)->atttypid == TEXTOID);
+}
+
+static void
+ts_build_cb_inc(Relation rel, ItemPointer tid, Datum *values, bool *isnull, bool tupleIsAlive, void *state)
+{
+    SmolIncSortContext *c = (SmolIncSortContext *) state; (void) tupleIsAlive;
+    if (isnull[0]) ereport(ERROR,(errmsg("smol does not support NULL values")));
+    for (int i = 0; i < c->incn; i++)
+    {
+        /* NULL INCLUDE values are rejected when the merged rows are packed */
+        if (!c->itext[i] || isnull[c->nkeyatts + i]) continue;
+        text *t = DatumGetTextPP(values[c->nkeyatts + i]); int blen = VARSIZE_ANY_EXHDR(t);
+        if (blen > c->imax[i]) c->imax[i] = blen;
+    }
+    tuplesort_putindextuplevalues(c->ts, rel, tid, values, isnull);
+    (*c->pnkeys)++;
+}
+
 /* 2-col builder helper */
 static void
 smol_build_cb_pair(Relation rel, ItemPointer tid, Datum *values, bool *isnull, bool tupleIsAlive, void *state)
@@ -3242,6 +4997,40 @@ smol_build_cb_pair(Relation rel, ItemPointer tid, Datum *values, bool *isnull, b
         SMOL_LOGF("collect pair: tuples=%zu", *c->pcount); /* GCOV_EXCL_LINE - debug-only logging */
 }
 
+/* Key-only single-column collector for the in-memory radix build */
+static void
+smol_build_cb_keys(Relation rel, ItemPointer tid, Datum *values, bool *isnull, bool tupleIsAlive, void *state)
+{
+    SmolKeyArrayContext *c = (SmolKeyArrayContext *) state;
+    char buf[sizeof(int64)];
+    (void) rel; (void) tupleIsAlive;
+    if (isnull[0]) ereport(ERROR, (errmsg("smol does not support NULL values")));
+    if (c->n == c->cap)
+    {
+        /* Grow exponentially up to 8M entries, then linearly by 2M to avoid MaxAllocSize (1GB) */
+        Size newcap;
+#ifdef SMOL_TEST_COVERAGE
+        Size growth_threshold = smol_growth_threshold_test > 0 ? (Size) smol_growth_threshold_test : 8388608;
+#else
+        Size growth_threshold = 8388608;
+#endif
+        if (c->cap == 0)
+            newcap = 1024;
+        else if (c->cap < growth_threshold)
+            newcap = c->cap * 2;
+        else
+            newcap = c->cap + 2097152;
+        c->keys = (c->cap == 0) ? (char *) MemoryContextAllocHuge(CurrentMemoryContext, newcap * c->key_len)
+                                : (char *) repalloc_huge(c->keys, newcap * c->key_len);
+        c->blks = (c->cap == 0) ? (BlockNumber *) MemoryContextAllocHuge(CurrentMemoryContext, newcap * sizeof(BlockNumber))
+                                : (BlockNumber *) repalloc_huge(c->blks, newcap * sizeof(BlockNumber));
+        c->cap = newcap;
+    }
+    memcpy(c->keys + (size_t) c->n * c->key_len, smol_datum_key_bytes(values[0], c->key_len, c->byval, buf), c->key_len);
+    c->blks[c->n] = ItemPointerGetBlockNumber(tid);
+    c->n++;
+}
+
 static void
 smol_build_cb_inc(Relation rel, ItemPointer tid, Datum *values, bool *isnull, bool tupleIsAlive, void *state)
 {
@@ -106,13 +106,13 @@ smol_cmp_keyptr_to_bound(SmolScanOpaque so, const char *keyp)
 			return smol_cmp_keyptr_bound_generic(&so->cmp_fmgr, so->collation, so->atttypid, keyp, so->key_len, so->key_byval, so->bound_datum);
 		}
 
-		/* C collation: compare 32-byte padded keyp with detoasted bound text (binary) */
+		/* C collation: compare NUL-padded keyp with detoasted bound text (binary) */
 		text *bt = DatumGetTextPP(so->bound_datum);
 		int blen = VARSIZE_ANY_EXHDR(bt);
 		const char *b = VARDATA_ANY(bt);
 		/* Compute key length up to first zero using memchr */
-		const char *kend = (const char *) memchr(keyp, '\0', 32);
-		int klen = kend ? (int)(kend - keyp) : 32;
+		const char *kend = (const char *) memchr(keyp, '\0', so->key_len);
+		int klen = kend ? (int)(kend - keyp) : so->key_len;
 		int minl = (klen < blen) ? klen : blen;
 		int cmp = minl ? memcmp(keyp, b, minl) : 0;
 		if (cmp != 0) return (cmp > 0) - (cmp < 0);
@@ -147,8 +147,8 @@ smol_cmp_keyptr_to_upper_bound(SmolScanOpaque so, const char *keyp)
 		text *bt = DatumGetTextPP(so->upper_bound_datum);
 		int blen = VARSIZE_ANY_EXHDR(bt);
 		const char *b = VARDATA_ANY(bt);
-		const char *kend = (const char *) memchr(keyp, '\0', 32);
-		int klen = kend ? (int)(kend - keyp) : 32;
+		const char *kend = (const char *) memchr(keyp, '\0', so->key_len);
+		int klen = kend ? (int)(kend - keyp) : so->key_len;
 		int minl = (klen < blen) ? klen : blen;
 		int cmp = minl ? memcmp(keyp, b, minl) : 0;
 		if (cmp != 0) return (cmp > 0) - (cmp < 0);
@@ -40,6 +40,13 @@ smol1_inc_ptr_any(Page page, uint16 key_len, uint16 n, const uint16 *inc_lens, u
     ItemId iid = PageGetItemId(page, FirstOffsetNumber);
     char *base = (char *) PageGetItem(page, iid);
     uint16 tag; memcpy(&tag, base, sizeof(uint16));
+    if (tag == SMOL_TAG_INC_DICT)
+    {
+        /* Dictionary-coded INCLUDE columns: the value lives on the page either way */
+        SmolIncDictCol c;
+        smol_incdict_col(base, inc_idx, inc_lens[inc_idx], &c);
+        return (char *) smol_incdict_value(&c, row, inc_lens[inc_idx]);
+    }
     if (!(tag == 0x8001u || tag == 0x8003u))
     {
         /* Plain layout: [u16 n][keys][inc1 block][inc2 block]... */
@@ -127,6 +134,487 @@ smol_page_matches_scan_bounds(SmolScanOpaque so, Page page, uint16 nitems, bool
     return true;
 }
 
+/* ---- Work-stealing parallel scan over the leaf directory ---- */
+
+static inline uint64
+smol_pscan_pack(uint32 lo, uint32 hi)
+{
+    return ((uint64) hi << 32) | (uint64) lo;
+}
+
+static void
+smol_pscan_init(SmolParallelScan *ps)
+{
+    pg_atomic_init_u32(&ps->curr, 0u);
+    pg_atomic_init_u32(&ps->nslots, 0u);
+    pg_atomic_init_u32(&ps->stop_entry, SMOL_PSCAN_NO_ENTRY);
+    pg_atomic_init_u64(&ps->range[0], smol_pscan_pack(0, SMOL_PSCAN_RANGE_UNSET));
+    for (int i = 1; i < SMOL_PSCAN_MAX_SLOTS; i++)
+        pg_atomic_init_u64(&ps->range[i], smol_pscan_pack(0, 0));
+}
+
+/* No entry at or past 'entry' can match: stop handing them out */
+static void
+smol_pscan_stop_at(SmolParallelScan *ps, uint32 entry)
+{
+    uint32 cur = pg_atomic_read_u32(&ps->stop_entry);
+
+    while (entry < cur && !pg_atomic_compare_exchange_u32(&ps->stop_entry, &cur, entry))
+        ;
+}
+
+/* Last directory entry whose zone key is below zk (0 when none is) */
+static uint32
+smol_pscan_entry_before(const SmolDirectory *d, const uint8 *zk)
+{
+    uint32 lo = 0, hi = d->num_entries;
+
+    while (lo < hi)
+    {
+        uint32 mid = lo + (hi - lo) / 2;
+
+        if (memcmp(d->entries[mid].minkey, zk, d->zkey_len) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo > 0 ? lo - 1 : 0;
+}
+
+/* First directory entry whose zone key is above zk (num_entries when none is) */
+static uint32
+smol_pscan_entry_after(const SmolDirectory *d, const uint8 *zk)
+{
+    uint32 lo = 0, hi = d->num_entries;
+
+    while (lo < hi)
+    {
+        uint32 mid = lo + (hi - lo) / 2;
+
+        if (memcmp(d->entries[mid].minkey, zk, d->zkey_len) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * smol_pscan_entry_range - directory entries [*start, *end) that can hold
+ * keys inside the scan bounds.
+ *
+ * Entry zone keys are compared with the bound zone keys when both use the
+ * same encoding; an entry whose first key is past the upper (or equality)
+ * bound rules out every later entry, so no worker reads a leaf outside the
+ * range.  Other types fall back to descending the tree for the lower bound
+ * and checking each claimed entry's first leaf for the upper bound.
+ */
+static void
+smol_pscan_entry_range(Relation idx, SmolScanOpaque so, const SmolMeta *meta, uint32 *start, uint32 *end)
+{
+    const SmolDirectory *d = so->dir_data;
+    bool keyed = smol_meta_wide_keys(meta) && d->zkey_len == smol_meta_zkey_len(meta);
+    uint8 zk[SMOL_ZKEY_MAX];
+    bool exact;
+
+    *start = 0;
+    *end = d->num_entries;
+    so->dir_keyed = !so->have_upper_bound && !so->have_k1_eq;
+
+    if (so->have_bound)
+    {
+        if (keyed && smol_scan_bound_zkey(so, meta, false, zk, &exact))
+            *start = smol_pscan_entry_before(d, zk);
+        else
+        {
+            /* Leaves are in block order along the rightlinks (the directory build checks) */
+            BlockNumber left;
+            uint32 lo = 0, hi = d->num_entries;
+
+            if (so->atttypid == TEXTOID || so->atttypid == UUIDOID)
+                left = smol_find_first_leaf_generic(idx, so);
+            else
+                left = smol_find_first_leaf(idx, smol_bound_to_int64(so->atttypid, so->bound_datum, PG_INT64_MIN),
+                                            so->atttypid, so->key_len);
+            if (!BlockNumberIsValid(left))
+            {
+                *start = d->num_entries;
+                so->dir_keyed = true;
+                return;
+            }
+            while (hi - lo > 1)
+            {
+                uint32 mid = lo + (hi - lo) / 2;
+
+                if (d->entries[mid].leaf_blkno <= left)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            *start = lo;
+        }
+    }
+
+    if (keyed && (so->have_upper_bound || so->have_k1_eq) &&
+        smol_scan_bound_zkey(so, meta, so->have_upper_bound, zk, &exact))
+    {
+        *end = smol_pscan_entry_after(d, zk);
+        so->dir_keyed = true;
+    }
+}
+
+/* First worker in publishes the entry range into slot 0 */
+static void
+smol_pscan_publish(SmolParallelScan *ps, const SmolDirectory *d, uint32 start, uint32 end)
+{
+    uint64 unset = smol_pscan_pack(0, SMOL_PSCAN_RANGE_UNSET);
+
+    (void) pg_atomic_compare_exchange_u64(&ps->range[0], &unset, smol_pscan_pack(start, d->num_entries));
+    smol_pscan_stop_at(ps, end);
+}
+
+/* Rows held by entries [lo, hi) */
+static inline uint64
+smol_pscan_rows(const SmolDirectory *d, uint32 lo, uint32 hi)
+{
+    return d->row_start[hi] - d->row_start[lo];
+}
+
+/* Next directory entry for this worker: own range first, then steal */
+static uint32
+smol_pscan_next_entry(SmolScanOpaque so, SmolParallelScan *ps)
+{
+    const SmolDirectory *d = so->dir_data;
+
+    for (;;)
+    {
+        uint32 lim = Min(d->num_entries, pg_atomic_read_u32(&ps->stop_entry));
+        uint32 nslots = Min(Max(pg_atomic_read_u32(&ps->nslots), 1u), (uint32) SMOL_PSCAN_MAX_SLOTS);
+        int best = -1;
+        uint64 best_v = 0;
+        uint64 best_rows = 0;
+        bool retry = false;
+
+        for (uint32 s = 0; s < nslots; s++)
+        {
+            uint64 v = pg_atomic_read_u64(&ps->range[s]);
+            uint32 lo = (uint32) v, hi = (uint32) (v >> 32);
+
+            if (hi == SMOL_PSCAN_RANGE_UNSET)
+                continue; /* GCOV_EXCL_LINE - published before the first claim */
+            hi = Min(hi, lim);
+            if (lo >= hi)
+                continue;
+            if ((int32) s == so->pscan_slot)
+            {
+                /* Own range: take the front entry */
+                if (pg_atomic_compare_exchange_u64(&ps->range[s], &v, smol_pscan_pack(lo + 1, hi)))
+                {
+                    so->prof_dir_claims++;
+                    return lo;
+                }
+                retry = true;
+                break;
+            }
+            if (best < 0 || smol_pscan_rows(d, lo, hi) > best_rows)
+            {
+                best = (int) s;
+                best_v = v;
+                best_rows = smol_pscan_rows(d, lo, hi);
+            }
+        }
+        if (retry)
+            continue;
+        if (best < 0)
+            return SMOL_PSCAN_NO_ENTRY;
+
+        /* Idle: steal the back half (by rows) of the largest remaining range */
+        {
+            uint32 lo = (uint32) best_v;
+            uint32 hi = Min((uint32) (best_v >> 32), lim);
+            uint32 mid = hi - 1;
+
+            if (so->pscan_slot >= 0 && hi - lo > 1)
+            {
+                /* first entry at or past the row midpoint, leaving the victim at least one */
+                uint64 half = d->row_start[lo] + smol_pscan_rows(d, lo, hi) / 2;
+                uint32 l = lo + 1, h = hi - 1;
+
+                while (l < h)
+                {
+                    uint32 m = l + (h - l) / 2;
+
+                    if (d->row_start[m] < half)
+                        l = m + 1;
+                    else
+                        h = m;
+                }
+                mid = l;
+            }
+
+            if (!pg_atomic_compare_exchange_u64(&ps->range[best], &best_v, smol_pscan_pack(lo, mid)))
+                continue;
+            so->prof_dir_steals++;
+            if (so->pscan_slot >= 0)
+                pg_atomic_write_u64(&ps->range[so->pscan_slot], smol_pscan_pack(mid + 1, hi));
+            return mid;
+        }
+    }
+}
+
+/*
+ * smol_pscan_claim_leaf - first leaf of the next directory entry this worker
+ * scans, or InvalidBlockNumber when no entry is left.  Sets dir_current_idx
+ * and dir_current_end (the next entry's first leaf) for the claimed entry.
+ */
+static BlockNumber
+smol_pscan_claim_leaf(Relation idx, SmolScanOpaque so, SmolParallelScan *ps)
+{
+    const SmolDirectory *d = so->dir_data;
+
+    for (;;)
+    {
+        uint32 e = smol_pscan_next_entry(so, ps);
+        BlockNumber blk;
+
+        if (e == SMOL_PSCAN_NO_ENTRY)
+            return InvalidBlockNumber;
+        blk = d->entries[e].leaf_blkno;
+        if (!so->dir_keyed)
+        {
+            /* An entry starting past the range rules out every later entry too */
+            Buffer b = ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, so->bstrategy);
+            Page pg = BufferGetPage(b);
+            uint16 n = smol_leaf_nitems(pg);
+            bool stop = false;
+
+            if (n > 0)
+                (void) smol_page_matches_scan_bounds(so, pg, n, &stop);
+            ReleaseBuffer(b);
+            if (stop)
+            {
+                smol_pscan_stop_at(ps, e);
+                continue;
+            }
+        }
+        so->dir_current_idx = e;
+        so->dir_current_end = (e + 1 < d->num_entries) ? d->entries[e + 1].leaf_blkno : InvalidBlockNumber;
+        SMOL_LOGF("worker claimed directory entry %u, blocks [%u, %u)", e, blk, so->dir_current_end);
+        return blk;
+    }
+}
+
+/*
+ * smol_leaf_seek_bound - first offset on a single-column leaf that satisfies
+ * the lower bound (>= or >), or nitems + 1 when no key does.  Plain leaves
+ * with integer keys use the vector search kernel and FOR leaves search their
+ * block bases without unpacking; everything else binary-searches through
+ * the key comparator.
+ */
+static uint16
+smol_leaf_seek_bound(SmolScanOpaque so, Page page)
+{
+    uint16 n = smol_leaf_nitems(page);
+    uint16 lo = FirstOffsetNumber, hi = n, ans = InvalidOffsetNumber;
+
+    if (so->leaf_kernel_len != 0)
+    {
+        uint16 nplain;
+        char *payload = smol1_payload(page);
+        char *keys;
+        uint16 tag;
+
+        memcpy(&tag, payload, sizeof(uint16));
+        if (tag == SMOL_TAG_KEY_FOR)
+        {
+            if (so->prof_enabled) so->prof_bsteps++;
+            return (uint16) (smol_for_search_int(payload,
+                                                 smol_bound_to_int64(so->atttypid, so->bound_datum, 0),
+                                                 so->bound_strict) + 1);
+        }
+        keys = smol_leaf_plain_keys(page, &nplain);
+        if (keys != NULL)
+            return (uint16) (smol_leaf_search_int(keys, nplain, so->key_len,
+                                                  smol_bound_to_int64(so->atttypid, so->bound_datum, 0),
+                                                  so->bound_strict,
+                                                  so->prof_enabled ? &so->prof_bsteps : NULL) + 1);
+    }
+    while (lo <= hi)
+    {
+        uint16 mid = (uint16) (lo + ((hi - lo) >> 1));
+        char *kp = smol_leaf_keyptr_ex(page, mid, so->key_len, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
+        int c = smol_cmp_keyptr_to_bound(so, kp);
+        if (so->prof_enabled) so->prof_bsteps++;
+        if ((so->bound_strict ? (c > 0) : (c >= 0))) { ans = mid; if (mid == 0) break; hi = (uint16) (mid - 1); }
+        else lo = (uint16) (mid + 1);
+    }
+    return (ans != InvalidOffsetNumber) ? ans : (uint16) (n + 1);
+}
+
+/*
+ * smol_leaf_seek_upper - last offset on a single-column leaf that satisfies
+ * the upper bound (<= or <; the equality key when there is no upper bound),
+ * or 0 when no key does; nitems when the scan has neither.  Backward
+ * counterpart of smol_leaf_seek_bound, using the same search kernels.
+ */
+static uint16
+smol_leaf_seek_upper(SmolScanOpaque so, Page page)
+{
+    uint16 n = smol_leaf_nitems(page);
+    bool use_upper = so->have_upper_bound;
+    bool strict = use_upper && so->upper_bound_strict;
+    Datum ub = use_upper ? so->upper_bound_datum : so->bound_datum;
+    uint16 lo = FirstOffsetNumber, hi = n, ans = 0;
+
+    if (!use_upper && !so->have_k1_eq)
+        return n;
+    if (so->leaf_kernel_len != 0)
+    {
+        /* Count of keys within the bound = first key past it */
+        int64 b = smol_bound_to_int64(so->atttypid, ub, 0);
+        char *payload = smol1_payload(page);
+        uint16 nplain;
+        char *keys;
+        uint16 tag;
+
+        memcpy(&tag, payload, sizeof(uint16));
+        if (tag == SMOL_TAG_KEY_FOR)
+        {
+            if (so->prof_enabled) so->prof_bsteps++;
+            return smol_for_search_int(payload, b, !strict);
+        }
+        keys = smol_leaf_plain_keys(page, &nplain);
+        if (keys != NULL)
+            return smol_leaf_search_int(keys, nplain, so->key_len, b, !strict,
+                                        so->prof_enabled ? &so->prof_bsteps : NULL);
+    }
+    while (lo <= hi)
+    {
+        uint16 mid = (uint16) (lo + ((hi - lo) >> 1));
+        char *kp = smol_leaf_keyptr_ex(page, mid, so->key_len, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
+        int c = use_upper ? smol_cmp_keyptr_to_upper_bound(so, kp) : smol_cmp_keyptr_to_bound(so, kp);
+        if (so->prof_enabled) so->prof_bsteps++;
+        if (strict ? (c < 0) : (c <= 0)) { ans = mid; lo = (uint16) (mid + 1); }
+        else hi = (uint16) (mid - 1);
+    }
+    return ans;
+}
+
+/*
+ * Specialized plain-page refill kernels
+ *
+ * smol_refill_tuple_buffer_plain tests the bounds per row and walks the
+ * INCLUDE columns through their run-time lengths.  For int-ordered keys the
+ * caller finds the last row within the upper (or equality) bound once with
+ * the leaf search kernel, so a kernel only copies.  Each variant is generated
+ * for one key width, INCLUDE width and INCLUDE count, which makes every copy
+ * length and the column loop compile-time constants.  smol_plain_kernel_for
+ * picks the variant once per scan; other shapes keep the generic refill.
+ */
+#define SMOL_PLAIN_KERNEL(name, KEY_T, INC_T, NINC) \
+static uint16 \
+name(SmolScanOpaque so, const char *keys, uint16 start, uint16 count) \
+{ \
+    char *dst = so->tuple_buffer_data; \
+    const Size stride = so->tuple_size; \
+    const char *inc_base[(NINC) > 0 ? (NINC) : 1] = {NULL}; \
+    uint16 inc_offs[(NINC) > 0 ? (NINC) : 1] = {0}; \
+    const Size first = (Size) (start - 1); \
+\
+    for (int c = 0; c < (NINC); c++) \
+    { \
+        inc_base[c] = so->inc_meta->plain_inc_base[c] + first * sizeof(INC_T); \
+        inc_offs[c] = so->inc_meta->inc_offs[c]; \
+    } \
+    keys += first * sizeof(KEY_T); \
+    for (uint16 i = 0; i < count; i++, dst += stride) \
+    { \
+        char *data = dst + MAXALIGN(sizeof(IndexTupleData)); \
+\
+        memcpy(data, keys + (Size) i * sizeof(KEY_T), sizeof(KEY_T)); \
+        for (int c = 0; c < (NINC); c++) \
+            memcpy(data + inc_offs[c], inc_base[c] + (Size) i * sizeof(INC_T), sizeof(INC_T)); \
+        ((IndexTuple) dst)->t_info = (unsigned short) stride; \
+    } \
+    return count; \
+}
+
+SMOL_PLAIN_KERNEL(smol_plain_k4, int32, char, 0)
+SMOL_PLAIN_KERNEL(smol_plain_k8, int64, char, 0)
+SMOL_PLAIN_KERNEL(smol_plain_k4_i4x1, int32, int32, 1)
+SMOL_PLAIN_KERNEL(smol_plain_k4_i4x2, int32, int32, 2)
+SMOL_PLAIN_KERNEL(smol_plain_k4_i4x3, int32, int32, 3)
+SMOL_PLAIN_KERNEL(smol_plain_k4_i4x4, int32, int32, 4)
+SMOL_PLAIN_KERNEL(smol_plain_k4_i8x1, int32, int64, 1)
+SMOL_PLAIN_KERNEL(smol_plain_k4_i8x2, int32, int64, 2)
+SMOL_PLAIN_KERNEL(smol_plain_k4_i8x3, int32, int64, 3)
+SMOL_PLAIN_KERNEL(smol_plain_k4_i8x4, int32, int64, 4)
+SMOL_PLAIN_KERNEL(smol_plain_k8_i4x1, int64, int32, 1)
+SMOL_PLAIN_KERNEL(smol_plain_k8_i4x2, int64, int32, 2)
+SMOL_PLAIN_KERNEL(smol_plain_k8_i4x3, int64, int32, 3)
+SMOL_PLAIN_KERNEL(smol_plain_k8_i4x4, int64, int32, 4)
+SMOL_PLAIN_KERNEL(smol_plain_k8_i8x1, int64, int64, 1)
+SMOL_PLAIN_KERNEL(smol_plain_k8_i8x2, int64, int64, 2)
+SMOL_PLAIN_KERNEL(smol_plain_k8_i8x3, int64, int64, 3)
+SMOL_PLAIN_KERNEL(smol_plain_k8_i8x4, int64, int64, 4)
+
+/* [key 4/8][INCLUDE width none/4/8][INCLUDE count] */
+static const SmolPlainKernel smol_plain_kernels[2][3][5] = {
+    {
+        {smol_plain_k4, NULL, NULL, NULL, NULL},
+        {NULL, smol_plain_k4_i4x1, smol_plain_k4_i4x2, smol_plain_k4_i4x3, smol_plain_k4_i4x4},
+        {NULL, smol_plain_k4_i8x1, smol_plain_k4_i8x2, smol_plain_k4_i8x3, smol_plain_k4_i8x4},
+    },
+    {
+        {smol_plain_k8, NULL, NULL, NULL, NULL},
+        {NULL, smol_plain_k8_i4x1, smol_plain_k8_i4x2, smol_plain_k8_i4x3, smol_plain_k8_i4x4},
+        {NULL, smol_plain_k8_i8x1, smol_plain_k8_i8x2, smol_plain_k8_i8x3, smol_plain_k8_i8x4},
+    },
+};
+
+/* Kernel for this scan's tuple shape, or NULL for the generic refill */
+static SmolPlainKernel
+smol_plain_kernel_for(SmolScanOpaque so)
+{
+    int iw = 0;
+
+    if (!smol_scan_kernels || !so->tuple_buffering_enabled || so->has_varwidth ||
+        so->ninclude > 4 || (so->leaf_kernel_len != 4 && so->leaf_kernel_len != 8))
+        return NULL;
+    for (uint16 i = 0; i < so->ninclude; i++)
+    {
+        uint16 len = so->inc_meta->inc_len[i];
+
+        if ((len != 4 && len != 8) || len != so->inc_meta->inc_len[0])
+            return NULL;
+    }
+    if (so->ninclude > 0)
+        iw = (so->inc_meta->inc_len[0] == 4) ? 1 : 2;
+    return smol_plain_kernels[so->leaf_kernel_len == 8][iw][so->ninclude];
+}
+
+/* Two-column counterpart: 0-based row of the last leading key within the bound, or -1 */
+static int32
+smol12_leaf_seek_upper(SmolScanOpaque so, Page page, uint16 nrows)
+{
+    bool use_upper = so->have_upper_bound;
+    bool strict = use_upper && so->upper_bound_strict;
+    uint16 lo = FirstOffsetNumber, hi = nrows, ans = 0;
+
+    if (!use_upper && !so->have_k1_eq)
+        return (int32) nrows - 1;
+    while (lo <= hi)
+    {
+        uint16 mid = (uint16) (lo + ((hi - lo) >> 1));
+        char *k1p = smol12_row_k1_ptr(page, mid, so->key_len, so->key_len2, so->inc_meta ? so->inc_meta->inc_cumul_offs[so->ninclude] : 0);
+        int c = use_upper ? smol_cmp_keyptr_to_upper_bound(so, k1p) : smol_cmp_keyptr_to_bound(so, k1p);
+        if (so->prof_enabled) so->prof_bsteps++;
+        if (strict ? (c < 0) : (c <= 0)) { ans = mid; lo = (uint16) (mid + 1); }
+        else hi = (uint16) (mid - 1);
+    }
+    return (int32) ans - 1;
+}
+
 static bool
 smol_leaf_run_bounds_rle_ex(Page page, uint16 idx, uint16 key_len,
                          uint16 *run_start_out, uint16 *run_end_out,
@@ -176,33 +664,149 @@ smol_leaf_run_bounds_rle_ex(Page page, uint16 idx, uint16 key_len,
     return false; /* GCOV_EXCL_LINE */
 }
 
+/*
+ * smol12_form_tuple - build one two-column tuple at data (the tuple's data area)
+ *
+ * Shared by the row loop, which builds into so->itup, and the buffered refill,
+ * which builds into a slot; t_info is the caller's.
+ */
 static inline void
-smol_emit_single_tuple(SmolScanOpaque so, Page page, const char *keyp, uint32 row)
+smol12_form_tuple(SmolScanOpaque so, Page page, uint16 row, const char *k1p, const char *k2p, char *data)
 {
-//    static int emit_count = 0;
-//    if (emit_count < 3) {
-//        elog(NOTICE, "smol_emit_single_tuple called: ninclude=%d, has_numeric=%d",
-//             so->ninclude, so->has_numeric);
-//        emit_count++;
-//    }
+    /* Optimized copies for common fixed lengths; fallback for others */
+    int text_len = 0;
+    if (so->key_is_text32)
+    {
+        /* TEXT: wrap in varlena header */
+        while (text_len < (int)so->key_len && k1p[text_len] != '\0') text_len++;
+        SET_VARSIZE(data, VARHDRSZ + text_len);
+        if (text_len > 0) memcpy(VARDATA(data), k1p, text_len);
+    }
+    else if (so->key_len == 2) smol_copy2(data, k1p);
+    else if (so->key_len == 4) smol_copy4(data, k1p);
+    else if (so->key_len == 8) smol_copy8(data, k1p);
+    else if (so->key_len == 16) smol_copy16(data, k1p);
+    else smol_copy_small(data, k1p, so->key_len);
+
+    /* For two-column indexes, compute k2 offset dynamically when k1 is TEXT */
+    uint16 k2_off = so->itup_off2;
+    if (so->two_col && so->key_is_text32)
+    {
+        /* TEXT k1 is variable-length, so k2 offset depends on actual text length */
+        Size k1_actual_size = VARHDRSZ + text_len;
+        k2_off = (uint16) att_align_nominal(k1_actual_size, so->align2);
+    }
+
+    if (so->key_len2 == 2) smol_copy2(data + k2_off, k2p);
+    else if (so->key_len2 == 4) smol_copy4(data + k2_off, k2p);
+    else if (so->key_len2 == 8) smol_copy8(data + k2_off, k2p);
+    else if (so->key_len2 == 16) smol_copy16(data + k2_off, k2p);
+    else smol_copy_small(data + k2_off, k2p, so->key_len2);
+
+    /* Copy INCLUDE columns for two-column indexes */
+    if (so->ninclude > 0)
+    {
+        char *inc_start = smol12_row_inc_ptr(page, row, so->key_len, so->key_len2, so->inc_meta->inc_cumul_offs[so->ninclude]);
+
+        /* If any NUMERIC columns or TEXT k1 in two-column, compute offsets incrementally due to variable varlena size */
+        if (so->has_numeric || (so->two_col && so->key_is_text32))
+        {
+            /* Start offset: for TEXT k1, must compute from actual k2 position */
+            Size cur_off;
+            if (so->two_col && so->key_is_text32)
+                cur_off = k2_off + so->key_len2;
+            else
+                cur_off = so->inc_meta->inc_offs[0];
+            for (uint16 i = 0; i < so->ninclude; i++)
+            {
+                char *inc_src = inc_start + so->inc_meta->inc_cumul_offs[i];
+                cur_off = att_align_nominal(cur_off, so->inc_meta->inc_align[i]);
+                char *inc_dst = data + cur_off;
+
+                if (so->inc_meta->inc_is_text[i])
+                {
+                    /* Text: add VARHDRSZ and copy */
+                    SET_VARSIZE(inc_dst, VARHDRSZ + so->inc_meta->inc_len[i]);
+                    memcpy(VARDATA(inc_dst), inc_src, so->inc_meta->inc_len[i]);
+                    cur_off += VARHDRSZ + so->inc_meta->inc_len[i];
+                }
+                else if (so->inc_is_numeric[i])
+                {
+                    /* NUMERIC: stored as int64, convert to NUMERIC varlena */
+                    int64 int_val;
+                    if (so->inc_meta->inc_len[i] == 2)
+                        int_val = (int64) *((int16 *) inc_src);
+                    else if (so->inc_meta->inc_len[i] == 4)
+                        int_val = (int64) *((int32 *) inc_src);
+                    else
+                        int_val = *((int64 *) inc_src);
+
+                    Datum numeric_datum = smol_int64_to_numeric(int_val, so->inc_numeric_scale[i]);
+                    struct varlena *numeric_vl = (struct varlena *) DatumGetPointer(numeric_datum);
+                    Size numeric_size = VARSIZE_ANY(numeric_vl);
+                    memcpy(inc_dst, numeric_vl, numeric_size);
+                    cur_off += numeric_size;
+                }
+                else
+                {
+                    /* Fixed-length: direct copy */
+                    memcpy(inc_dst, inc_src, so->inc_meta->inc_len[i]);
+                    cur_off += so->inc_meta->inc_len[i];
+                }
+            }
+        }
+        else
+        {
+            /* Fast path: no NUMERIC, use pre-computed offsets */
+            for (uint16 i = 0; i < so->ninclude; i++)
+            {
+                char *inc_src = inc_start + so->inc_meta->inc_cumul_offs[i];
+                char *inc_dst = data + so->inc_meta->inc_offs[i];
+                if (so->inc_meta->inc_is_text[i])
+                {
+                    /* Text: add VARHDRSZ and copy */
+                    SET_VARSIZE(inc_dst, VARHDRSZ + so->inc_meta->inc_len[i]);
+                    memcpy(VARDATA(inc_dst), inc_src, so->inc_meta->inc_len[i]);
+                }
+                else
+                {
+                    /* Fixed-length: direct copy */
+                    memcpy(inc_dst, inc_src, so->inc_meta->inc_len[i]);
+                }
+            }
+        }
+    }
+}
 
+/*
+ * smol_form_single_tuple - build one single-column tuple into itup
+ *
+ * Lays the key and INCLUDE columns out the way index_getattr reads them,
+ * text as varlena cut at its NUL padding.  use_run_cache lets the row loop
+ * reuse the varlena forms it cached for the current run; the buffered
+ * refill has no run state and passes false.
+ */
+static inline void
+smol_form_single_tuple(SmolScanOpaque so, Page page, const char *keyp, uint32 row,
+                       IndexTuple itup, bool use_run_cache)
+{
     Size cur = so->itup_data_off; /* absolute offset from tuple start */
-    char *base = (char *) so->itup;
+    char *base = (char *) itup;
     char *wp;
     /* key */
     cur = att_align_nominal(cur, so->align1);
     wp = base + cur;
     if (so->key_is_text32)
     {
-        if (so->run_active && so->run_key_built && so->run_key_vl_len > 0)
+        if (use_run_cache && so->run_active && so->run_key_built && so->run_key_vl_len > 0)
         {
             memcpy(wp, so->run_key_vl, (size_t) so->run_key_vl_len);
             cur += (Size) so->run_key_vl_len;
         }
         else /* GCOV_EXCL_LINE */
         { /* GCOV_EXCL_LINE */
-            const char *kend = (const char *) memchr(keyp, '\0', 32);
-            int klen = kend ? (int)(kend - keyp) : 32;
+            const char *kend = (const char *) memchr(keyp, '\0', so->key_len);
+            int klen = kend ? (int)(kend - keyp) : so->key_len;
             SET_VARSIZE((struct varlena *) wp, klen + VARHDRSZ);
             memcpy(wp + VARHDRSZ, keyp, klen);
             cur += VARHDRSZ + (Size) klen;
@@ -225,10 +829,12 @@ smol_emit_single_tuple(SmolScanOpaque so, Page page, const char *keyp, uint32 ro
         {
             cur = att_align_nominal(cur, so->inc_meta->inc_align[ii]);
             wp = base + cur;
-            char *ip = smol1_inc_ptr_any(page, so->key_len, n2, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, ii, row, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
+            char *ip = so->plain_inc_cached
+                ? so->inc_meta->plain_inc_base[ii] + (size_t) row * so->inc_meta->inc_len[ii]
+                : smol1_inc_ptr_any(page, so->key_len, n2, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, ii, row, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
             if (so->inc_meta->inc_is_text[ii])
             {
-                if (so->run_active && so->inc_meta->inc_const[ii] && so->inc_meta->run_inc_built[ii] && so->inc_meta->run_inc_vl_len[ii] > 0)
+                if (use_run_cache && so->run_active && so->inc_meta->inc_const[ii] && so->inc_meta->run_inc_built[ii] && so->inc_meta->run_inc_vl_len[ii] > 0)
                 {
                     memcpy(wp, so->inc_meta->run_inc_vl[ii], (size_t) so->inc_meta->run_inc_vl_len[ii]);
                     cur += (Size) so->inc_meta->run_inc_vl_len[ii];
@@ -289,7 +895,13 @@ smol_emit_single_tuple(SmolScanOpaque so, Page page, const char *keyp, uint32 ro
         }
     }
     cur = MAXALIGN(cur);
-    so->itup->t_info = (unsigned short) (cur | (so->has_varwidth ? INDEX_VAR_MASK : 0));
+    itup->t_info = (unsigned short) (cur | (so->has_varwidth ? INDEX_VAR_MASK : 0));
+}
+
+static inline void
+smol_emit_single_tuple(SmolScanOpaque so, Page page, const char *keyp, uint32 row)
+{
+    smol_form_single_tuple(so, page, keyp, row, so->itup, true);
 }
 
 IndexScanDesc
@@ -310,6 +922,11 @@ smol_beginscan(Relation index, int nkeys, int norderbys)
     so->cur_buf = InvalidBuffer;
     so->have_pin = false;
     so->rle_cached_page_blk = InvalidBlockNumber;  /* Initialize RLE cache as invalid */
+    so->for_blk = InvalidBlockNumber;
+    so->leaf_stream = NULL;
+    so->stream_next = InvalidBlockNumber;
+    so->stream_last = InvalidBlockNumber;
+    so->stream_limit = InvalidBlockNumber;
     so->have_bound = false;
     so->have_k1_eq = false;
     so->bound_strict = false;
@@ -318,15 +935,28 @@ smol_beginscan(Relation index, int nkeys, int norderbys)
     so->dir_data = NULL;
     so->dir_current_idx = 0;
     so->dir_current_end = InvalidBlockNumber;
+    so->pscan_slot = -1;
+    so->dir_keyed = false;
     so->runtime_keys = NULL;
     so->n_runtime_keys = 0;
+    so->probe_buf = InvalidBuffer;
+    so->probe_start_blk = InvalidBlockNumber;
     so->atttypid = TupleDescAttr(RelationGetDescr(index), 0)->atttypid;
     so->atttypid2 = (RelationGetDescr(index)->natts >= 2) ? TupleDescAttr(RelationGetDescr(index), 1)->atttypid : InvalidOid;
     /* read meta */
-    smol_meta_read(index, &meta);
+    smol_meta_get(index, &meta);
+    if (SmolIndexIsResident(index))
+        smol_resident_warm(index, &meta);
     so->two_col = (meta.nkeyatts == 2);
     so->key_len = meta.key_len1;
     so->key_len2 = meta.key_len2;
+    /* Leading-key groups longer than a leaf on average: skips re-descend past them */
+    so->skip_wide_groups = (meta.stat_distinct > 0 && meta.stat_distinct < (double) meta.stat_leaves);
+    so->skip_next_blk = InvalidBlockNumber;
+    /* Pick the in-leaf search kernel once: integer-ordered keys of 2/4/8 bytes */
+    so->leaf_kernel_len = (!so->two_col && smol_zkey_type_is_int64(so->atttypid) &&
+                           (so->key_len == 2 || so->key_len == 4 || so->key_len == 8))
+                          ? so->key_len : 0;
     so->cur_group = 0;
     so->pos_in_group = 0;
     smol_run_reset(so);
@@ -352,7 +982,7 @@ smol_beginscan(Relation index, int nkeys, int norderbys)
          * so that our prebuilt tuple layout matches index_getattr logic.
          */
         {
-            SmolMeta m; smol_meta_read(index, &m);
+            SmolMeta m; smol_meta_get(index, &m);
             so->ninclude = m.inc_count;  /* Read INCLUDE count for both single-col and two-col */
 
             /* Load NUMERIC conversion metadata for INCLUDE columns (zero overhead if none) */
@@ -541,6 +1171,9 @@ smol_beginscan(Relation index, int nkeys, int norderbys)
     so->prof_subtrees_skipped = 0;
     so->prof_bloom_checks = 0;
     so->prof_bloom_skips = 0;
+    so->prof_dir_claims = 0;
+    so->prof_dir_steals = 0;
+    so->stat_last_blk = InvalidBlockNumber;
     so->run_key_built = false;
     if (so->inc_meta)
     {
@@ -557,19 +1190,17 @@ smol_beginscan(Relation index, int nkeys, int norderbys)
     so->pages_scanned = 0;
     so->adaptive_prefetch_depth = 0;
 
-    /* Initialize tuple buffering (forward scans only, fixed-width tuples only) */
-    if (smol_use_tuple_buffering && !so->two_col && !so->has_varwidth)
+    /* Initialize tuple buffering (NUMERIC INCLUDE values are converted per row, unbuffered) */
+    if (smol_use_tuple_buffering && !so->has_numeric)
     {
         so->tuple_buffering_enabled = true;
+        so->tuple_buffer_aliased = false;
         so->tuple_buffer_capacity = smol_tuple_buffer_size;
         so->tuple_buffer_count = 0;
         so->tuple_buffer_current = 0;
 
-        /* Calculate tuple size: header + key + INCLUDE columns */
-        so->tuple_size = MAXALIGN(sizeof(IndexTupleData)) + MAXALIGN(so->key_len);
-        if (so->ninclude > 0)
-            so->tuple_size += so->inc_meta->inc_cumul_offs[so->ninclude - 1] +
-                             so->inc_meta->inc_len[so->ninclude - 1];
+        /* Slot size: the prebuilt tuple's aligned layout, varlena fields at full width */
+        so->tuple_size = (uint16) IndexTupleSize(so->itup);
 
         /* Allocate buffer arrays */
         so->tuple_buffer = palloc(so->tuple_buffer_capacity * sizeof(IndexTuple));
@@ -585,53 +1216,682 @@ smol_beginscan(Relation index, int nkeys, int norderbys)
         so->tuple_buffer = NULL;
         so->tuple_buffer_data = NULL;
     }
+    so->plain_kernel = smol_plain_kernel_for(so);
 
     scan->opaque = so;
     return scan;
 }
 
-void
-smol_rescan(IndexScanDesc scan, ScanKey keys, int nkeys, ScanKey orderbys, int norderbys)
+/* ---- ScalarArrayOp (= ANY) support ---- */
+
+typedef struct SmolArraySortCxt
 {
-    SmolScanOpaque so = (SmolScanOpaque) scan->opaque;
-    so->initialized = false;
-    so->cur_blk = InvalidBlockNumber;
-    so->cur_off = InvalidOffsetNumber;
-    /* Release buffer pin if held from previous scan.
-     * Hard to trigger: requires rescan while holding pin, depends on PostgreSQL executor
-     * timing. Pattern follows btree (BTScanPosUnpinIfPinned) and hash (_hash_dropscanbuf). */
-    if (so->have_pin && BufferIsValid(so->cur_buf)) 
+    FmgrInfo   *cmp;
+    Oid         collation;
+} SmolArraySortCxt;
+
+static int
+smol_array_elem_cmp(const void *a, const void *b, void *arg)
+{
+    SmolArraySortCxt *cxt = (SmolArraySortCxt *) arg;
+    return DatumGetInt32(FunctionCall2Coll(cxt->cmp, cxt->collation,
+                                           *(const Datum *) a, *(const Datum *) b));
+}
+
+/* Binary search for key in a sorted, de-duplicated array */
+static bool
+smol_array_contains(FmgrInfo *cmp, Oid collation, const Datum *vals, int n, Datum key)
+{
+    int lo = 0, hi = n - 1;
+    while (lo <= hi)
     {
-        ReleaseBuffer(so->cur_buf); 
-        so->cur_buf = InvalidBuffer; 
-        so->have_pin = false; 
+        int mid = lo + ((hi - lo) >> 1);
+        int c = DatumGetInt32(FunctionCall2Coll(cmp, collation, vals[mid], key));
+        if (c == 0)
+            return true;
+        if (c < 0)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
     }
-    so->have_bound = false;
-    so->have_upper_bound = false;
-    so->have_k1_eq = false;
-    so->have_k2_eq = false;
-    so->use_generic_cmp = false;
-    so->chunk_left = 0;
+    return false;
+}
 
-    /* Store all scankeys for runtime filtering */
-    if (so->runtime_keys)
-        pfree(so->runtime_keys);
-    so->runtime_keys = NULL;
-    so->n_runtime_keys = 0;
+/*
+ * Convert an array element to the key's integer type for cross-type integer
+ * operators (e.g. int4 = ANY(int8[])).  Returns false when the value is out
+ * of range for the key type, in which case it cannot be equal to any key.
+ */
+static bool
+smol_array_elem_to_keytype(Datum v, Oid elemtype, Oid keytype, Datum *out)
+{
+    int64 x;
 
-    if (keys && nkeys > 0)
+    *out = v;
+    if (elemtype == keytype ||
+        (elemtype != INT2OID && elemtype != INT4OID && elemtype != INT8OID) ||
+        (keytype != INT2OID && keytype != INT4OID && keytype != INT8OID))
+        return true;
+
+    x = (elemtype == INT2OID) ? (int64) DatumGetInt16(v) :
+        (elemtype == INT4OID) ? (int64) DatumGetInt32(v) : DatumGetInt64(v);
+    if (keytype == INT2OID)
     {
-        /* PROGRAMMING BY CONTRACT: SMOL does not support searching for NULL values
-         * SK_SEARCHNULL: IS NULL query - reject with clear error
-         * SK_ISNULL (scan key argument is NULL) is allowed: k > NULL returns 0 rows gracefully
-         * SK_SEARCHNOTNULL (IS NOT NULL) is allowed: works correctly since index has no NULLs */
-        for (int i = 0; i < nkeys; i++)
-        {
-            ScanKey sk = &keys[i];
-            /* Defensive check - no if-statement needed, macro handles everything */
-            SMOL_DEFENSIVE_CHECK(!(sk->sk_flags & SK_SEARCHNULL), ERROR,
-                (errmsg("smol does not support NULL values"),
-                 errdetail("Query uses IS NULL which is not supported. SMOL indexes do not contain NULL values.")));
+        if (x < PG_INT16_MIN || x > PG_INT16_MAX)
+            return false;
+        *out = Int16GetDatum((int16) x);
+    }
+    else if (keytype == INT4OID)
+    {
+        if (x < PG_INT32_MIN || x > PG_INT32_MAX)
+            return false;
+        *out = Int32GetDatum((int32) x);
+    }
+    else
+        *out = Int64GetDatum(x);
+    return true;
+}
+
+/*
+ * Deconstruct the array of an = ANY(array) key into key-typed values, sorted
+ * and de-duplicated with cmp.  NULL elements are dropped since they never
+ * match.  Returns the number of values left in *vals_out.
+ */
+static int
+smol_array_key_values(ScanKey sk, Oid keytype, FmgrInfo *cmp, Oid collation, Datum **vals_out)
+{
+    ArrayType  *arr = DatumGetArrayTypeP(sk->sk_argument);
+    Oid         elemtype = ARR_ELEMTYPE(arr);
+    int16       elmlen;
+    bool        elmbyval;
+    char        elmalign;
+    Datum      *elems;
+    bool       *nulls;
+    int         nelems, n = 0, ndistinct = 0;
+    SmolArraySortCxt cxt;
+
+    get_typlenbyvalalign(elemtype, &elmlen, &elmbyval, &elmalign);
+    deconstruct_array(arr, elemtype, elmlen, elmbyval, elmalign, &elems, &nulls, &nelems);
+    for (int i = 0; i < nelems; i++)
+    {
+        if (!nulls[i] && smol_array_elem_to_keytype(elems[i], elemtype, keytype, &elems[n]))
+            n++;
+    }
+    pfree(nulls);
+
+    cxt.cmp = cmp;
+    cxt.collation = collation;
+    if (n > 1)
+        qsort_arg(elems, n, sizeof(Datum), smol_array_elem_cmp, &cxt);
+    for (int i = 0; i < n; i++)
+    {
+        if (ndistinct == 0 || smol_array_elem_cmp(&elems[ndistinct - 1], &elems[i], &cxt) != 0)
+            elems[ndistinct++] = elems[i];
+    }
+    *vals_out = elems;
+    return ndistinct;
+}
+
+/* Keep only the values of vals[] that also appear in other[] (both sorted) */
+static int
+smol_array_intersect(Datum *vals, int n, const Datum *other, int m, FmgrInfo *cmp, Oid collation)
+{
+    int k = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (smol_array_contains(cmp, collation, other, m, vals[i]))
+            vals[k++] = vals[i];
+    }
+    return k;
+}
+
+/*
+ * Reduce a non-equality array key to a scalar one: k > ANY(a) is k > min(a),
+ * k < ANY(a) is k < max(a).  Compared with the element type's own ordering
+ * so cross-type keys keep their subtype.  Returns false if no element is
+ * non-NULL (the key can never be satisfied).
+ */
+static bool
+smol_array_key_to_scalar(ScanKey sk)
+{
+    ArrayType  *arr = DatumGetArrayTypeP(sk->sk_argument);
+    Oid         elemtype = ARR_ELEMTYPE(arr);
+    TypeCacheEntry *tce = lookup_type_cache(elemtype, TYPECACHE_CMP_PROC_FINFO);
+    bool        want_max = (sk->sk_strategy == BTLessStrategyNumber ||
+                            sk->sk_strategy == BTLessEqualStrategyNumber);
+    int16       elmlen;
+    bool        elmbyval;
+    char        elmalign;
+    Datum      *elems;
+    bool       *nulls;
+    int         nelems;
+    bool        found = false;
+    Datum       best = (Datum) 0;
+
+    if (!OidIsValid(tce->cmp_proc_finfo.fn_oid))
+        ereport(ERROR, (errmsg("smol: no ordering for array element type %u", elemtype))); /* GCOV_EXCL_LINE */
+
+    get_typlenbyvalalign(elemtype, &elmlen, &elmbyval, &elmalign);
+    deconstruct_array(arr, elemtype, elmlen, elmbyval, elmalign, &elems, &nulls, &nelems);
+    for (int i = 0; i < nelems; i++)
+    {
+        int c;
+        if (nulls[i])
+            continue;
+        if (!found)
+        {
+            best = elems[i];
+            found = true;
+            continue;
+        }
+        c = DatumGetInt32(FunctionCall2Coll(&tce->cmp_proc_finfo, sk->sk_collation, elems[i], best));
+        if (want_max ? (c > 0) : (c < 0))
+            best = elems[i];
+    }
+    pfree(nulls);
+    sk->sk_argument = best;
+    sk->sk_flags &= ~SK_SEARCHARRAY;
+    return found;
+}
+
+/*
+ * Preprocess = ANY(array) keys in so->runtime_keys: build the sorted leading
+ * key probe list (intersecting several arrays and filtering by any scalar
+ * leading-key quals), collect second-key arrays for the runtime test, and
+ * reduce inequality arrays to scalar keys.
+ */
+static void
+smol_preprocess_array_keys(IndexScanDesc scan, SmolScanOpaque so)
+{
+    Relation idx = scan->indexRelation;
+
+    for (int i = 0; i < so->n_runtime_keys; i++)
+    {
+        ScanKey sk = &so->runtime_keys[i];
+        Datum *vals;
+        int n;
+
+        if (!(sk->sk_flags & SK_SEARCHARRAY))
+            continue;
+        if (sk->sk_strategy != BTEqualStrategyNumber)
+        {
+            if (!smol_array_key_to_scalar(sk))
+                so->keys_unsatisfiable = true;
+            continue;
+        }
+        if (sk->sk_attno == 1)
+        {
+            n = smol_array_key_values(sk, so->atttypid, &so->cmp_fmgr, so->collation, &vals);
+            if (so->probe_vals == NULL)
+            {
+                so->probe_vals = vals;
+                so->nprobes = n;
+            }
+            else
+            {
+                so->nprobes = smol_array_intersect(so->probe_vals, so->nprobes, vals, n,
+                                                   &so->cmp_fmgr, so->collation);
+                pfree(vals);
+            }
+        }
+        else
+        {
+            Oid coll2 = idx->rd_indcollation[1];
+            if (so->k2_cmp == NULL)
+            {
+                so->k2_cmp = (FmgrInfo *) palloc(sizeof(FmgrInfo));
+                fmgr_info_copy(so->k2_cmp, index_getprocinfo(idx, 2, 1), CurrentMemoryContext);
+            }
+            n = smol_array_key_values(sk, so->atttypid2, so->k2_cmp, coll2, &vals);
+            if (so->k2_vals == NULL)
+            {
+                so->k2_vals = vals;
+                so->k2_nvals = n;
+            }
+            else
+            {
+                so->k2_nvals = smol_array_intersect(so->k2_vals, so->k2_nvals, vals, n,
+                                                    so->k2_cmp, coll2);
+                pfree(vals);
+            }
+            if (so->k2_nvals == 0)
+                so->keys_unsatisfiable = true;
+        }
+    }
+
+    if (so->probe_vals == NULL)
+        return;
+
+    /* Apply scalar leading-key quals to the probes so the probe list is exact */
+    for (int i = 0; i < so->n_runtime_keys; i++)
+    {
+        ScanKey sk = &so->runtime_keys[i];
+        int k = 0;
+
+        if (sk->sk_attno != 1 || (sk->sk_flags & SK_SEARCHARRAY))
+            continue;
+        if (sk->sk_flags & SK_ISNULL)
+        {
+            so->nprobes = 0;
+            break;
+        }
+        for (int j = 0; j < so->nprobes; j++)
+        {
+            if (DatumGetBool(FunctionCall2Coll(&sk->sk_func, sk->sk_collation,
+                                               so->probe_vals[j], sk->sk_argument)))
+                so->probe_vals[k++] = so->probe_vals[j];
+        }
+        so->nprobes = k;
+    }
+}
+
+/*
+ * Range mode for leading-key probes: scan [first probe, last probe] and let
+ * smol_test_runtime_keys drop keys that are not in the probe list.  Used by
+ * backward, parallel and bitmap scans, and for single-probe arrays.
+ */
+static void
+smol_probe_set_range(SmolScanOpaque so)
+{
+    so->probe_mode = false;
+    so->probe_start_blk = InvalidBlockNumber;
+    if (so->nprobes == 0)
+    {
+        so->keys_unsatisfiable = true;
+        return;
+    }
+    so->have_bound = true;
+    so->bound_strict = false;
+    so->bound_datum = so->probe_vals[0];
+    so->have_k1_eq = (so->nprobes == 1);
+    so->have_upper_bound = true;
+    so->upper_bound_strict = false;
+    so->upper_bound_datum = so->probe_vals[so->nprobes - 1];
+    so->need_runtime_key_test = so->need_runtime_key_test_base || so->nprobes > 1;
+}
+
+/* Drop the pin carried between probes */
+static void
+smol_probe_release(SmolScanOpaque so)
+{
+    if (BufferIsValid(so->probe_buf))
+        ReleaseBuffer(so->probe_buf);
+    so->probe_buf = InvalidBuffer;
+    so->probe_start_blk = InvalidBlockNumber;
+}
+
+/*
+ * Pin a leaf for the initial seek, sharing the pin carried between probes
+ * when it is the same block (no buffer mapping lookup needed).
+ */
+static inline Buffer
+smol_probe_read_leaf(Relation idx, SmolScanOpaque so, BlockNumber blk)
+{
+    if (BufferIsValid(so->probe_buf) && BufferGetBlockNumber(so->probe_buf) == blk)
+    {
+        IncrBufferRefCount(so->probe_buf);
+        return so->probe_buf;
+    }
+    return ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, so->bstrategy);
+}
+
+/* True when every key on the leaf sorts below the current probe (so->bound_datum) */
+static bool
+smol_probe_past_leaf(SmolScanOpaque so, Page page)
+{
+    uint16 n = so->two_col ? smol12_leaf_nrows(page) : smol_leaf_nitems(page);
+    char *last;
+
+    if (n == 0)
+        return true; /* GCOV_EXCL_LINE - defensive: leaves are never empty */
+    if (so->two_col)
+        last = smol12_row_k1_ptr(page, n, so->key_len, so->key_len2,
+                                 so->inc_meta ? so->inc_meta->inc_cumul_offs[so->ninclude] : 0);
+    else
+        last = smol_leaf_keyptr_ex(page, n, so->key_len,
+                                   so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude,
+                                   so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
+    return smol_cmp_keyptr_to_bound(so, last) < 0;
+}
+
+/*
+ * Rescan repositioning.  A serial bounded scan keeps its start leaf pinned
+ * in probe_buf after it ends.  When the next rescan's lower bound falls on
+ * that leaf or its right sibling, as it does for nested-loop probes driven
+ * by a sorted outer side, the scan starts there instead of descending from
+ * the root.
+ */
+static inline void
+smol_rescan_remember(SmolScanOpaque so, Buffer buf)
+{
+    if (!smol_rescan_reposition || so->probe_vals != NULL || so->probe_buf == buf)
+        return;
+    if (BufferIsValid(so->probe_buf))
+        ReleaseBuffer(so->probe_buf);
+    IncrBufferRefCount(buf);
+    so->probe_buf = buf;
+}
+
+/*
+ * smol_rescan_position - start leaf for the new keys from the remembered leaf
+ *
+ * The leaf is a valid start when it holds keys at or above the lower bound
+ * and its first key is below it (at or below it for a strict bound): every
+ * key further left then fails the bound.  When the whole leaf is below the
+ * bound, its right sibling only has to hold a key at or above it.  Otherwise
+ * the pin is dropped and the scan descends as usual.
+ */
+static void
+smol_rescan_position(IndexScanDesc scan, SmolScanOpaque so)
+{
+    Page page;
+    char *first;
+    int c;
+
+    if (!BufferIsValid(so->probe_buf))
+        return;
+    if (!smol_rescan_reposition || !so->have_bound || so->probe_vals != NULL ||
+        so->keys_unsatisfiable || scan->parallel_scan)
+    {
+        smol_probe_release(so);
+        return;
+    }
+    page = BufferGetPage(so->probe_buf);
+    if (smol_probe_past_leaf(so, page))
+    {
+        BlockNumber next = smol_page_opaque(page)->rightlink;
+
+        smol_probe_release(so);
+        if (!BlockNumberIsValid(next))
+            return;
+        so->probe_buf = ReadBufferExtended(scan->indexRelation, MAIN_FORKNUM, next, RBM_NORMAL, so->bstrategy);
+        if (smol_probe_past_leaf(so, BufferGetPage(so->probe_buf)))
+            smol_probe_release(so);
+        else
+            so->probe_start_blk = next;
+        return;
+    }
+    if (so->two_col)
+        first = smol12_row_k1_ptr(page, 1, so->key_len, so->key_len2,
+                                  so->inc_meta ? so->inc_meta->inc_cumul_offs[so->ninclude] : 0);
+    else
+        first = smol_leaf_keyptr_ex(page, 1, so->key_len,
+                                    so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude,
+                                    so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
+    c = smol_cmp_keyptr_to_bound(so, first);
+    if (so->bound_strict ? c <= 0 : c < 0)
+        so->probe_start_blk = BufferGetBlockNumber(so->probe_buf);
+    else
+        smol_probe_release(so);
+}
+
+/*
+ * Leaf read stream.  The build writes leaves in key order, so the sibling
+ * chain runs through consecutive blocks: the callback predicts the blocks
+ * after the current leaf in the scan direction, up to the last leaf the scan
+ * can reach, and the read stream combines them into vectored (and, where the
+ * server supports it, asynchronous) reads.  A sibling link that breaks the
+ * pattern resets the stream at the real block.
+ */
+static BlockNumber
+smol_leaf_stream_cb(ReadStream *stream, void *callback_private_data, void *per_buffer_data)
+{
+    SmolScanOpaque so = (SmolScanOpaque) callback_private_data;
+    BlockNumber blk = so->stream_next;
+
+    (void) stream;
+    (void) per_buffer_data;
+    if (!BlockNumberIsValid(blk) || !BlockNumberIsValid(so->stream_last))
+        return InvalidBlockNumber;
+    if (so->stream_backward)
+    {
+        if (blk < so->stream_last)
+            return InvalidBlockNumber;
+        so->stream_next = (blk > 1) ? blk - 1 : InvalidBlockNumber;  /* block 0 is the metapage */
+    }
+    else
+    {
+        if (blk > so->stream_last)
+            return InvalidBlockNumber;
+        so->stream_next = blk + 1;
+    }
+    so->stat_prefetches++;
+    return blk;
+}
+
+/* Leaf reads go through the stream outside = ANY probes and atomic-claim parallel scans */
+static inline bool
+smol_leaf_stream_enabled(IndexScanDesc scan, SmolScanOpaque so)
+{
+    return smol_read_stream && !so->probe_mode && (!scan->parallel_scan || so->use_directory);
+}
+
+/* Last leaf a walk in 'dir' can reach: the upper-bound leaf forward, the lower-bound leaf backward */
+static BlockNumber
+smol_leaf_stream_end(Relation idx, SmolScanOpaque so, bool backward)
+{
+    if (backward)
+    {
+        BlockNumber left;
+
+        if (!so->have_bound || so->two_col)
+            return 1;
+        if (so->atttypid == TEXTOID || so->atttypid == UUIDOID)
+            left = smol_find_first_leaf_generic(idx, so);
+        else if (!smol_zkey_type_is_int64(so->atttypid))
+            return 1;
+        else
+            left = smol_find_first_leaf(idx, smol_bound_to_int64(so->atttypid, so->bound_datum, PG_INT64_MIN),
+                                        so->atttypid, so->key_len);
+        return BlockNumberIsValid(left) ? left : 1;
+    }
+    if (!BlockNumberIsValid(so->stream_limit))
+    {
+        so->stream_limit = smol_find_leaf_for_upper_bound(idx, so);
+        if (!BlockNumberIsValid(so->stream_limit))
+            so->stream_limit = RelationGetNumberOfBlocks(idx) - 1; /* GCOV_EXCL_LINE - defensive: scans only advance in non-empty indexes */
+    }
+    return so->stream_limit;
+}
+
+/* Release the stream and its read-ahead pins */
+static void
+smol_leaf_stream_release(SmolScanOpaque so)
+{
+    if (so->leaf_stream)
+        read_stream_end(so->leaf_stream);
+    so->leaf_stream = NULL;
+    so->stream_next = InvalidBlockNumber;
+    so->stream_last = InvalidBlockNumber;
+    so->stream_limit = InvalidBlockNumber;
+}
+
+/*
+ * Pin leaf 'blk' reached by a sibling link, through the leaf stream when it is
+ * enabled.  The stream is created on the first sibling step (scans that end
+ * on their first leaf never pay for the end-leaf descent) and reseeded when
+ * the direction changes or the chain leaves the predicted blocks.
+ */
+static Buffer
+smol_leaf_stream_read(IndexScanDesc scan, SmolScanOpaque so, BlockNumber blk, ScanDirection dir)
+{
+    Relation idx = scan->indexRelation;
+    bool backward = (dir == BackwardScanDirection);
+
+    if (!smol_leaf_stream_enabled(scan, so))
+        return ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, so->bstrategy);
+
+    if (so->leaf_stream == NULL)
+    {
+        MemoryContext old = MemoryContextSwitchTo(GetMemoryChunkContext(so));
+        int flags = READ_STREAM_DEFAULT;
+
+#ifdef READ_STREAM_USE_BATCHING
+        flags |= READ_STREAM_USE_BATCHING;  /* the callback neither locks nor reads */
+#endif
+        so->leaf_stream = read_stream_begin_relation(flags, so->bstrategy, idx, MAIN_FORKNUM,
+                                                     smol_leaf_stream_cb, so, 0);
+        MemoryContextSwitchTo(old);
+        so->stream_backward = backward;
+        so->stream_last = smol_leaf_stream_end(idx, so, backward);
+        so->stream_next = blk;
+    }
+    else if (so->stream_backward != backward)
+    {
+        read_stream_reset(so->leaf_stream);
+        so->stream_backward = backward;
+        so->stream_last = smol_leaf_stream_end(idx, so, backward);
+        so->stream_next = blk;
+    }
+    /* Parallel scans stop at the end of the claimed directory entry */
+    if (scan->parallel_scan && !backward)
+    {
+        BlockNumber last = smol_leaf_stream_end(idx, so, false);
+
+        if (BlockNumberIsValid(so->dir_current_end) && so->dir_current_end - 1 < last)
+            last = so->dir_current_end - 1;
+        so->stream_last = last;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        Buffer buf = read_stream_next_buffer(so->leaf_stream, NULL);
+
+        if (BufferIsValid(buf) && BufferGetBlockNumber(buf) == blk)
+            return buf;
+        if (BufferIsValid(buf))
+            ReleaseBuffer(buf);
+        /* Off the predicted chain (or past its end): restart at the real block */
+        read_stream_reset(so->leaf_stream);
+        so->stream_next = blk;
+    }
+    /* Outside the stream's range, e.g. a parallel steal past the claimed entry */
+    return ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, so->bstrategy);
+}
+
+/* True for the types whose values compare as int64 among themselves */
+static inline bool
+smol_type_is_plain_int(Oid typid)
+{
+    return typid == INT2OID || typid == INT4OID || typid == INT8OID;
+}
+
+/*
+ * Narrow [k2_lo, k2_hi] by a scalar second-key qual.  Only same-type (or
+ * integer cross-type) quals on an integer-ordered k2 count; the others stay
+ * runtime-tested and leave the range open.
+ */
+static void
+smol_skip_add_k2_bound(SmolScanOpaque so, ScanKey sk)
+{
+    Oid subtype = OidIsValid(sk->sk_subtype) ? sk->sk_subtype : so->atttypid2;
+    int64 v;
+
+    if ((sk->sk_flags & SK_ISNULL) || !smol_zkey_type_is_int64(so->atttypid2) ||
+        !(subtype == so->atttypid2 || (smol_type_is_plain_int(subtype) && smol_type_is_plain_int(so->atttypid2))))
+        return;
+    v = smol_bound_to_int64(subtype, sk->sk_argument, 0);
+    switch (sk->sk_strategy)
+    {
+        case BTEqualStrategyNumber:
+            so->k2_lo = Max(so->k2_lo, v);
+            so->k2_hi = Min(so->k2_hi, v);
+            break;
+        case BTGreaterEqualStrategyNumber:
+            so->k2_lo = Max(so->k2_lo, v);
+            break;
+        case BTGreaterStrategyNumber:
+            if (v == PG_INT64_MAX)
+            {
+                so->k2_lo = PG_INT64_MAX;   /* empty range */
+                so->k2_hi = PG_INT64_MIN;
+            }
+            else
+                so->k2_lo = Max(so->k2_lo, v + 1);
+            break;
+        case BTLessEqualStrategyNumber:
+            so->k2_hi = Min(so->k2_hi, v);
+            break;
+        case BTLessStrategyNumber:
+            if (v == PG_INT64_MIN)
+            {
+                so->k2_lo = PG_INT64_MAX;   /* empty range */
+                so->k2_hi = PG_INT64_MIN;
+            }
+            else
+                so->k2_hi = Min(so->k2_hi, v - 1);
+            break;
+        default:
+            break;                          /* GCOV_EXCL_LINE - btree strategies only */
+    }
+}
+
+void
+smol_rescan(IndexScanDesc scan, ScanKey keys, int nkeys, ScanKey orderbys, int norderbys)
+{
+    SmolScanOpaque so = (SmolScanOpaque) scan->opaque;
+    so->initialized = false;
+    so->cur_blk = InvalidBlockNumber;
+    so->cur_off = InvalidOffsetNumber;
+    so->stat_scans++;
+    so->stat_last_blk = InvalidBlockNumber;
+    /* Rows buffered for the previous scan keys must not leak into this one */
+    so->tuple_buffer_count = 0;
+    so->tuple_buffer_current = 0;
+    /* Release buffer pin if held from previous scan.
+     * Hard to trigger: requires rescan while holding pin, depends on PostgreSQL executor
+     * timing. Pattern follows btree (BTScanPosUnpinIfPinned) and hash (_hash_dropscanbuf). */
+    if (so->have_pin && BufferIsValid(so->cur_buf)) 
+    {
+        ReleaseBuffer(so->cur_buf); 
+        so->cur_buf = InvalidBuffer; 
+        so->have_pin = false; 
+    }
+    so->have_bound = false;
+    so->have_upper_bound = false;
+    so->have_k1_eq = false;
+    so->have_k2_eq = false;
+    so->skip_scan = false;
+    so->k2_lo = PG_INT64_MIN;
+    so->k2_hi = PG_INT64_MAX;
+    so->skip_next_blk = InvalidBlockNumber;
+    so->use_generic_cmp = false;
+    so->chunk_left = 0;
+    smol_leaf_stream_release(so);
+
+    /* Reset = ANY(array) state; the pinned start leaf may serve the new keys (smol_rescan_position) */
+    so->probe_start_blk = InvalidBlockNumber;
+    if (so->probe_vals)
+        pfree(so->probe_vals);
+    if (so->k2_vals)
+        pfree(so->k2_vals);
+    so->probe_vals = NULL;
+    so->k2_vals = NULL;
+    so->nprobes = 0;
+    so->k2_nvals = 0;
+    so->probe_idx = 0;
+    so->probe_mode = false;
+    so->keys_unsatisfiable = false;
+
+    /* Store all scankeys for runtime filtering */
+    if (so->runtime_keys)
+        pfree(so->runtime_keys);
+    so->runtime_keys = NULL;
+    so->n_runtime_keys = 0;
+
+    if (keys && nkeys > 0)
+    {
+        /* PROGRAMMING BY CONTRACT: SMOL does not support searching for NULL values
+         * SK_SEARCHNULL: IS NULL query - reject with clear error
+         * SK_ISNULL (scan key argument is NULL) is allowed: k > NULL returns 0 rows gracefully
+         * SK_SEARCHNOTNULL (IS NOT NULL) is allowed: works correctly since index has no NULLs */
+        for (int i = 0; i < nkeys; i++)
+        {
+            ScanKey sk = &keys[i];
+            /* Defensive check - no if-statement needed, macro handles everything */
+            SMOL_DEFENSIVE_CHECK(!(sk->sk_flags & SK_SEARCHNULL), ERROR,
+                (errmsg("smol does not support NULL values"),
+                 errdetail("Query uses IS NULL which is not supported. SMOL indexes do not contain NULL values.")));
         }
 
         /* Copy scankeys for later filtering */
@@ -642,9 +1902,19 @@ smol_rescan(IndexScanDesc scan, ScanKey keys, int nkeys, ScanKey orderbys, int n
         /* Opt #4: Cache whether runtime key testing is needed (checked once per scan, not per tuple) */
         so->need_runtime_key_test = false;
 
+        /* = ANY(array) keys: probes for attno 1, runtime sets for attno 2 */
+        smol_preprocess_array_keys(scan, so);
+
         for (int i = 0; i < nkeys; i++)
         {
-            ScanKey sk = &keys[i];
+            ScanKey sk = &so->runtime_keys[i];
+            if (sk->sk_flags & SK_SEARCHARRAY)
+            {
+                /* Leading-key probes are applied below; second-key arrays are runtime-tested */
+                if (sk->sk_attno != 1)
+                    so->need_runtime_key_test = true;
+                continue;
+            }
             if (sk->sk_attno == 1)
             {
                 if (sk->sk_strategy == BTGreaterEqualStrategyNumber ||
@@ -679,9 +1949,20 @@ smol_rescan(IndexScanDesc scan, ScanKey keys, int nkeys, ScanKey orderbys, int n
                     /* Attribute 2 with non-equality: requires runtime testing */
                     so->need_runtime_key_test = true;
                 }
+                smol_skip_add_k2_bound(so, sk);
             }
         }
 
+        /* Probes replace the scalar leading-key bounds (they were folded into the probe list) */
+        so->need_runtime_key_test_base = so->need_runtime_key_test;
+        if (so->k2_lo > so->k2_hi)
+            so->keys_unsatisfiable = true;
+        so->skip_scan = smol_skip_scan && so->two_col && !so->have_k1_eq && !so->probe_vals &&
+                        !scan->parallel_scan && smol_zkey_type_is_int64(so->atttypid) &&
+                        (so->k2_lo != PG_INT64_MIN || so->k2_hi != PG_INT64_MAX);
+        if (so->probe_vals)
+            smol_probe_set_range(so);
+
         /* Check if we need to use generic comparator for non-C collation text keys */
         if ((so->have_bound || so->have_upper_bound) && so->atttypid == TEXTOID)
         {
@@ -710,6 +1991,8 @@ smol_rescan(IndexScanDesc scan, ScanKey keys, int nkeys, ScanKey orderbys, int n
         so->upper_bound_datum = Int32GetDatum(10000);
     }
 #endif
+
+    smol_rescan_position(scan, so);
 }
 
 /*
@@ -723,6 +2006,7 @@ smol_rescan(IndexScanDesc scan, ScanKey keys, int nkeys, ScanKey orderbys, int n
  *
  * We need to recheck:
  * - Attribute 2 (second key): Range predicates (>=, >, <=, <)
+ * - = ANY(array) on attribute 2, and on attribute 1 outside probe_mode
  */
 static bool
 smol_test_runtime_keys(IndexScanDesc scan, SmolScanOpaque so)
@@ -745,6 +2029,26 @@ smol_test_runtime_keys(IndexScanDesc scan, SmolScanOpaque so)
     {
         ScanKey key = &so->runtime_keys[i];
 
+        /* = ANY(array) keys: membership in the preprocessed value lists */
+        if (key->sk_flags & SK_SEARCHARRAY)
+        {
+            bool member;
+            if (key->sk_attno == 1)
+                member = so->probe_mode ||
+                    smol_array_contains(&so->cmp_fmgr, so->collation, so->probe_vals, so->nprobes, values[0]);
+            else
+                member = !isnull[key->sk_attno - 1] &&
+                    smol_array_contains(so->k2_cmp, scan->indexRelation->rd_indcollation[1],
+                                        so->k2_vals, so->k2_nvals, values[key->sk_attno - 1]);
+            if (!member)
+            {
+                pfree(values);
+                pfree(isnull);
+                return false;
+            }
+            continue;
+        }
+
         /* Skip keys that SMOL handles natively */
         if (key->sk_attno == 1)
             continue; /* SMOL handles all attribute 1 predicates */
@@ -813,6 +2117,10 @@ static inline char *
 smol_leaf_keyptr_cached(SmolScanOpaque so, Page page, uint16 idx, uint16 key_len,
                         uint16 inc_len[], uint16 ninc, uint32 inc_cumul_offs[])
 {
+    /* FOR or prefix-text page: keys were unpacked into so->for_keys for this leaf */
+    if (so->for_active && so->for_blk == so->cur_blk)
+        return so->for_keys + sizeof(uint16) + ((size_t) (idx - 1)) * key_len;
+
     /* Check if we need to invalidate cache (changed pages or first call) */
     if (so->rle_cached_page_blk != so->cur_blk || so->rle_cached_run_keyptr == NULL)
     {
@@ -903,10 +2211,11 @@ smol_leaf_keyptr_cached(SmolScanOpaque so, Page page, uint16 idx, uint16 key_len
  * smol_refill_tuple_buffer - Pre-build multiple tuples into buffer
  *
  * Returns number of tuples buffered (0 if end of scan or no matches)
- * Only handles plain pages with fixed-width keys and INCLUDE columns.
+ * Only handles forward scans of plain pages with fixed-width keys and
+ * INCLUDE columns; smol_refill_tuple_buffer_rows covers the rest.
  */
 static uint16
-smol_refill_tuple_buffer_plain(SmolScanOpaque so, Page page)
+smol_refill_tuple_buffer_plain(SmolScanOpaque so, char *base)
 {
     uint16 n = so->cur_page_nitems;
     uint16 count = 0;
@@ -919,9 +2228,7 @@ smol_refill_tuple_buffer_plain(SmolScanOpaque so, Page page)
     if (max_tuples == 0)
         return 0; // GCOV_EXCL_LINE - defensive: should never happen in normal operation
 
-    /* Get base pointer for keys: [uint16 n][keys][inc blocks...] */
-    ItemId iid = PageGetItemId(page, 1);
-    char *base = (char *) PageGetItem(page, iid);
+    /* base is the leaf image (decoded for dictionary leaves): [uint16 n][keys][inc blocks...] */
     char *key_base = base + sizeof(uint16);  /* Skip nitems count */
 
     /* Bulk copy tuples */
@@ -976,14 +2283,286 @@ smol_refill_tuple_buffer_plain(SmolScanOpaque so, Page page)
     return count;
 }
 
-bool
-smol_gettuple(IndexScanDesc scan, ScanDirection dir)
+/*
+ * smol_row_key_in_bounds - may the row keyed at keyp be buffered?
+ *
+ * A refill stops at the first row the row loop would not emit as is: past the
+ * upper or equality bound or, walking backward, below the lower bound.  The
+ * row loop then decides whether that row is skipped or ends the scan.
+ */
+static inline bool
+smol_row_key_in_bounds(SmolScanOpaque so, const char *keyp, bool backward)
 {
-    Relation idx = scan->indexRelation;
-    SmolScanOpaque so = (SmolScanOpaque) scan->opaque;
-    Page page;
-    Buffer buf;
-    if (so->prof_enabled)
+    if (so->have_upper_bound && (backward || !so->use_position_scan))
+    {
+        int c = smol_cmp_keyptr_to_upper_bound(so, keyp);
+        if (so->upper_bound_strict ? (c >= 0) : (c > 0))
+            return false;
+    }
+    if (so->have_k1_eq)
+        return smol_cmp_keyptr_to_bound(so, keyp) == 0;
+    if (backward && so->have_bound)
+    {
+        int c = smol_cmp_keyptr_to_bound(so, keyp);
+        if (so->bound_strict ? (c <= 0) : (c < 0))
+            return false;
+    }
+    return true;
+}
+
+/*
+ * smol_refill_tuple_buffer_rows - buffer single-column rows of any leaf layout
+ *
+ * Walks from cur_off toward the end of the page the scan is heading for.  On
+ * RLE leaves the rows of a run share one tuple (equal keys, and on include-RLE
+ * leaves equal INCLUDE values), so it is formed once and the rest of the run
+ * points at that slot.  Returns the number of rows buffered.
+ */
+static uint16
+smol_refill_tuple_buffer_rows(SmolScanOpaque so, Page page, bool backward)
+{
+    uint16 n = so->cur_page_nitems;
+    bool share_runs = so->cur_page_format != 0 && (so->ninclude == 0 || so->cur_page_format == 3);
+    int32 run_lo = 1, run_hi = 0; /* offsets of the run formed last; empty */
+    uint16 count = 0;
+
+    for (int32 off = so->cur_off;
+         off >= FirstOffsetNumber && off <= n && count < so->tuple_buffer_capacity;
+         off += backward ? -1 : 1)
+    {
+        IndexTuple itup = (IndexTuple) (so->tuple_buffer_data + (Size) count * so->tuple_size);
+        char *keyp;
+
+        /* Position-based scan: stop at the end position, like the row loop */
+        if (!backward && so->use_position_scan && BlockNumberIsValid(so->end_blk) &&
+            (so->cur_blk > so->end_blk || (so->cur_blk == so->end_blk && off >= so->end_off)))
+            break;
+        if (off >= run_lo && off <= run_hi)
+        {
+            so->tuple_buffer[count] = so->tuple_buffer[count - 1];
+            so->tuple_buffer_aliased = true;
+            count++;
+            continue;
+        }
+        keyp = smol_leaf_keyptr_cached(so, page, (uint16) off, so->key_len, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
+        if (!smol_row_key_in_bounds(so, keyp, backward))
+            break;
+        smol_form_single_tuple(so, page, keyp, (uint32) (off - 1), itup, false);
+        so->tuple_buffer[count++] = itup;
+        so->stat_runs++;
+        if (share_runs)
+        {
+            uint16 start = (uint16) off, end = (uint16) off;
+
+            if (!smol_get_cached_run_bounds(so, (uint16) off, &start, &end))
+                (void) smol_leaf_run_bounds_rle_ex(page, (uint16) off, so->key_len, &start, &end, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude);
+            run_lo = start;
+            run_hi = end;
+        }
+    }
+    /* so->itup does not hold the key of the run the row loop resumes in */
+    so->run_active = false;
+    return count;
+}
+
+/*
+ * smol_skip_target - leaf to continue at once every row with leading key
+ * <= key is behind the scan: the first leaf whose highkey is above key, if
+ * it lies past the rightlink (leaves sit in chain order).  Otherwise
+ * InvalidBlockNumber, and the sibling walk goes on.
+ */
+static BlockNumber
+smol_skip_target(Relation idx, int64 key, Oid typid, uint16 key_len, BlockNumber rightlink)
+{
+    BlockNumber target;
+
+    if (!BlockNumberIsValid(rightlink) || key == PG_INT64_MAX)
+        return InvalidBlockNumber;
+    target = smol_find_first_leaf(idx, key + 1, typid, key_len);
+    return (BlockNumberIsValid(target) && target > rightlink) ? target : InvalidBlockNumber;
+}
+
+/*
+ * smol12_seek_row - first 0-based row in [from, leaf_n) at or after (k1, k2),
+ * or after every row of group k1 when next_group.  Integer-ordered keys.
+ */
+static uint32
+smol12_seek_row(SmolScanOpaque so, Page page, uint32 from, int64 k1, int64 k2, bool next_group)
+{
+    uint32 inc_total = so->inc_meta ? so->inc_meta->inc_cumul_offs[so->ninclude] : 0;
+    uint32 lo = from, hi = so->leaf_n;
+
+    while (lo < hi)
+    {
+        uint32 mid = lo + ((hi - lo) >> 1);
+        uint16 row = (uint16) (mid + 1);
+        int64 a = smol_for_load_key(smol12_row_k1_ptr(page, row, so->key_len, so->key_len2, inc_total), so->key_len);
+        bool before = (a < k1) ||
+            (a == k1 && (next_group ||
+                         smol_for_load_key(smol12_row_k2_ptr(page, row, so->key_len, so->key_len2, inc_total),
+                                           so->key_len2) < k2));
+
+        if (so->prof_enabled) so->prof_bsteps++;
+        if (before) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * smol12_skip_row - forward skip scan step for a row whose k2 is outside
+ * [k2_lo, k2_hi].  Below the range the group is binary-searched to k2_lo;
+ * above it the scan jumps to the next k1 group.  When that group starts
+ * past this leaf and groups are long (this leaf holds only k1, or the build
+ * counted fewer distinct k1 than leaves), the next leaf comes from a
+ * descent instead of the rightlink.  Returns false for rows in the range.
+ */
+static bool
+smol12_skip_row(IndexScanDesc scan, SmolScanOpaque so, Page page, const char *k1p, const char *k2p)
+{
+    int64 v = smol_for_load_key(k2p, so->key_len2);
+    int64 k1;
+
+    if (v >= so->k2_lo && v <= so->k2_hi)
+        return false;
+    k1 = smol_for_load_key(k1p, so->key_len);
+    if (v < so->k2_lo)
+    {
+        so->leaf_i = smol12_seek_row(so, page, so->leaf_i + 1, k1, so->k2_lo, false);
+        return true;
+    }
+    so->leaf_i = smol12_seek_row(so, page, so->leaf_i + 1, k1, 0, true);
+    if (so->leaf_i >= so->leaf_n)
+    {
+        uint32 inc_total = so->inc_meta ? so->inc_meta->inc_cumul_offs[so->ninclude] : 0;
+        int64 first = smol_for_load_key(smol12_row_k1_ptr(page, FirstOffsetNumber, so->key_len, so->key_len2, inc_total),
+                                        so->key_len);
+
+        if (so->skip_wide_groups || first == k1)
+            so->skip_next_blk = smol_skip_target(scan->indexRelation, k1, so->atttypid, so->key_len,
+                                                 smol_page_opaque(page)->rightlink);
+    }
+    return true;
+}
+
+/*
+ * smol12_refill_tuple_buffer - buffer two-column rows from leaf_i
+ *
+ * Stops at the first row outside the leading-key bounds or failing the k2
+ * equality; the row loop skips such rows or ends the scan.
+ */
+static uint16
+smol12_refill_tuple_buffer(SmolScanOpaque so, Page page, bool backward)
+{
+    uint32 inc_total = so->inc_meta ? so->inc_meta->inc_cumul_offs[so->ninclude] : 0;
+    uint16 count = 0;
+
+    /* leaf_i is unsigned: stepping below row 0 wraps past leaf_n */
+    for (uint32 i = so->leaf_i; i < so->leaf_n && count < so->tuple_buffer_capacity;
+         i = backward ? i - 1 : i + 1)
+    {
+        uint16 row = (uint16) (i + 1);
+        char *k1p = smol12_row_k1_ptr(page, row, so->key_len, so->key_len2, inc_total);
+        char *k2p = smol12_row_k2_ptr(page, row, so->key_len, so->key_len2, inc_total);
+        IndexTuple itup;
+
+        if (so->have_bound)
+        {
+            int c = smol_cmp_keyptr_to_bound(so, k1p);
+            if (so->bound_strict ? (c <= 0) : (c < 0))
+                break;
+            if (so->have_k1_eq && c > 0)
+                break;
+        }
+        if (so->have_upper_bound)
+        {
+            int c = smol_cmp_keyptr_to_upper_bound(so, k1p);
+            if (so->upper_bound_strict ? (c >= 0) : (c > 0))
+                break;
+        }
+        if (so->have_k2_eq && smol_for_load_key(k2p, so->key_len2) != so->k2_eq)
+            break;
+        itup = so->tuple_buffer[count++];
+        smol12_form_tuple(so, page, row, k1p, k2p, (char *) itup + so->itup_data_off);
+        itup->t_info = so->itup->t_info;
+    }
+    return count;
+}
+
+/*
+ * smol_tuple_buffer_emit - return the next row through the tuple buffer
+ *
+ * Refills from the current position once the buffer is drained (a direction
+ * change empties it): forward scans of plain fixed-width leaves use the
+ * copy kernels, every other shape the row refills above.  Returns false when
+ * no row could be buffered; the caller's row loop then takes that row (skips
+ * it, ends the scan or moves on to the next leaf).
+ */
+static bool
+smol_tuple_buffer_emit(IndexScanDesc scan, SmolScanOpaque so, Page page, char *base, ScanDirection dir)
+{
+    bool backward = (dir == BackwardScanDirection);
+
+    if (so->tuple_buffer_current >= so->tuple_buffer_count)
+    {
+        uint16 n = so->cur_page_nitems;
+
+        /* The other refills write slot i for entry i */
+        if (so->tuple_buffer_aliased)
+        {
+            for (int i = 0; i < so->tuple_buffer_capacity; i++)
+                so->tuple_buffer[i] = (IndexTuple) (so->tuple_buffer_data + i * so->tuple_size);
+            so->tuple_buffer_aliased = false;
+        }
+        if (so->two_col)
+            so->tuple_buffer_count = smol12_refill_tuple_buffer(so, page, backward);
+        else if (so->cur_off < FirstOffsetNumber || so->cur_off > n)
+            so->tuple_buffer_count = 0;
+        else if (!backward && !so->has_varwidth &&
+                 (so->plain_inc_cached || (so->plain_kernel != NULL && so->page_is_plain)))
+        {
+            if (so->plain_kernel != NULL)
+            {
+                /* Rows within the upper bound are found once; the kernel only copies */
+                uint16 stop = smol_leaf_seek_upper(so, page);
+
+                so->tuple_buffer_count = (stop >= so->cur_off)
+                    ? so->plain_kernel(so, base + sizeof(uint16), so->cur_off,
+                                       Min((uint16) (stop - so->cur_off + 1), so->tuple_buffer_capacity))
+                    : 0;
+            }
+            else
+                so->tuple_buffer_count = smol_refill_tuple_buffer_plain(so, base);
+        }
+        else
+            so->tuple_buffer_count = smol_refill_tuple_buffer_rows(so, page, backward);
+        so->tuple_buffer_current = 0;
+        if (so->tuple_buffer_count == 0)
+            return false;
+    }
+
+    scan->xs_itup = so->tuple_buffer[so->tuple_buffer_current++];
+    /* Set synthetic TID directly (not stored in itup->t_tid - see TID OPTIMIZATION) */
+    ItemPointerSet(&scan->xs_heaptid, 0, 1);
+    if (so->two_col)
+        so->leaf_i = backward ? so->leaf_i - 1 : so->leaf_i + 1;
+    else
+        so->cur_off = backward ? so->cur_off - 1 : so->cur_off + 1;
+    if (so->prof_enabled)
+    {
+        so->prof_rows++; // GCOV_EXCL_LINE - profiling instrumentation
+        so->prof_bytes += so->tuple_size; // GCOV_EXCL_LINE - profiling instrumentation
+    }
+    return true;
+}
+
+static bool
+smol_gettuple_internal(IndexScanDesc scan, ScanDirection dir)
+{
+    Relation idx = scan->indexRelation;
+    SmolScanOpaque so = (SmolScanOpaque) scan->opaque;
+    Page page;
+    Buffer buf;
+    if (so->prof_enabled)
         so->prof_calls++;
 
     /* SMOL is IOS-only; executor must request index attributes */
@@ -999,6 +2578,8 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
     {
         /* Direction changed - need to reinitialize scan */
         so->initialized = false;
+        so->tuple_buffer_count = 0;
+        so->tuple_buffer_current = 0;
         /* Release any pinned buffer */
         if (so->have_pin && BufferIsValid(so->cur_buf))
         {
@@ -1023,18 +2604,24 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
         /* no local variables needed here */
         if (dir == BackwardScanDirection)
         {
-            /* For now, always start at rightmost leaf for backward scans
-             * TODO: Optimize by seeking to leaf containing upper bound */
-            so->cur_blk = smol_rightmost_leaf(idx);
-            /* position within leaf: set to end; we'll walk backward */
+            /* Descend to the leaf holding the last key within the upper bound
+             * (or the equality key); unbounded scans take the rightmost path.
+             * The walk then follows leftlinks, so a LIMIT costs O(height + N). */
+            so->cur_blk = smol_find_leaf_for_upper_bound(idx, so);
+            if (!BlockNumberIsValid(so->cur_blk))
+                return false;  /* empty index */
+            so->pages_scanned = 0;
             buf = ReadBufferExtended(idx, MAIN_FORKNUM, so->cur_blk, RBM_NORMAL, so->bstrategy);
             page = BufferGetPage(buf);
 
             if (so->two_col)
             {
-                /* Two-column backward scan: initialize leaf_i for backward iteration */
+                /* Two-column backward scan: start at the last row within the bound */
+                int32 last;
+
                 so->leaf_n = smol12_leaf_nrows(page);
-                so->leaf_i = (so->leaf_n > 0) ? (so->leaf_n - 1) : 0;
+                last = smol12_leaf_seek_upper(so, page, (uint16) so->leaf_n);
+                so->leaf_i = (last >= 0) ? (uint32) last : (uint32) so->leaf_n;
                 so->cur_buf = buf; so->have_pin = true;
                 so->initialized = true;
                 so->last_dir = dir;
@@ -1043,9 +2630,8 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
             }
             else
             {
-                /* Single-column backward scan: use cur_off */
-                uint16 n = smol_leaf_nitems(page);
-                so->cur_off = n;
+                /* Single-column backward scan: cur_off = last key within the bound (0 = none here) */
+                so->cur_off = smol_leaf_seek_upper(so, page);
                 so->cur_buf = buf; so->have_pin = true;
                 so->initialized = true;
                 so->last_dir = dir;
@@ -1060,67 +2646,48 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                 {
                     SmolParallelScan *ps = (SmolParallelScan *) ((char *) scan->parallel_scan + scan->parallel_scan->ps_offset_am);
 
-                    /* Try directory-based static partitioning first */
+                    /* Leaf directory present: work-stealing over directory entries */
                     SmolMeta meta;
-                    smol_meta_read(idx, &meta);
+                    smol_meta_get(idx, &meta);
                     if (BlockNumberIsValid(meta.directory_blkno))
-                    { /* GCOV_EXCL_START - directory feature disabled due to bug */
-                        SmolDirectory *dir_data = smol_read_directory(idx, meta.directory_blkno);
-                        if (dir_data && dir_data->num_entries > 0)
+                    {
+                        if (so->dir_data)
                         {
-                            /* Use directory for atomic claiming of chunks */
-                            so->use_directory = true;
-                            so->dir_data = dir_data;  /* Keep directory cached */
-                            so->dir_current_idx = 0;  /* Will claim atomically */
-                            so->dir_current_end = InvalidBlockNumber;
-
-                            /* Try to claim first directory entry */
-                            uint32 claimed_idx = pg_atomic_fetch_add_u32(&ps->curr, 1);
-
-                            if (claimed_idx < dir_data->num_entries)
-                            {
-                                /* Successfully claimed an entry */
-                                so->dir_current_idx = claimed_idx;
-
-                                /* Determine end block for this chunk */
-                                if (claimed_idx + 1 < dir_data->num_entries)
-                                    so->dir_current_end = dir_data->entries[claimed_idx + 1].leaf_blkno;
-                                else
-                                    so->dir_current_end = InvalidBlockNumber;  /* Last chunk */
-
-                                so->cur_blk = dir_data->entries[claimed_idx].leaf_blkno;
-                                so->cur_off = FirstOffsetNumber;
-                                so->initialized = true;
-                                so->last_dir = dir;
-
-                                SMOL_LOGF("worker claimed directory entry %u, blocks [%u, %s)",
-                                         claimed_idx, so->cur_blk,
-                                         BlockNumberIsValid(so->dir_current_end) ? psprintf("%u", so->dir_current_end) : "end");
+                            pfree(so->dir_data->row_start);
+                            pfree(so->dir_data);
+                        }
+                        so->dir_data = smol_read_directory(idx, meta.directory_blkno);
+                    }
+                    if (so->dir_data && so->dir_data->num_entries > 0)
+                    {
+                        so->use_directory = true;
+                        if (so->pscan_slot < 0)
+                        {
+                            uint32 slot = pg_atomic_fetch_add_u32(&ps->nslots, 1);
 
-                                /* Prefetch and read first leaf */
-                                if (BlockNumberIsValid(so->cur_blk))
-                                {
-                                    PrefetchBuffer(idx, MAIN_FORKNUM, so->cur_blk);
-                                    buf = ReadBufferExtended(idx, MAIN_FORKNUM, so->cur_blk, RBM_NORMAL, so->bstrategy);
-                                    page = BufferGetPage(buf);
-                                    so->cur_buf = buf; so->have_pin = true;
-                                }
+                            /* Workers beyond the slot table only steal single entries */
+                            so->pscan_slot = (slot < SMOL_PSCAN_MAX_SLOTS) ? (int32) slot : -1;
+                        }
+                        {
+                            uint32 start, end;
 
-                                /* Skip fallback atomic claiming */
-                                goto parallel_init_done;
-                            }
-                            else
-                            {
-                                /* No entries left to claim */
-                                so->cur_blk = InvalidBlockNumber;
-                                so->initialized = true;
-                                so->last_dir = dir;
-                                return false;
-                            }
+                            smol_pscan_entry_range(idx, so, &meta, &start, &end);
+                            smol_pscan_publish(ps, so->dir_data, start, end);
                         }
-                        if (dir_data)
-                            pfree(dir_data);
-                    } /* GCOV_EXCL_STOP */
+                        so->cur_blk = smol_pscan_claim_leaf(idx, so, ps);
+                        so->cur_off = FirstOffsetNumber;
+                        so->initialized = true;
+                        so->last_dir = dir;
+                        if (!BlockNumberIsValid(so->cur_blk))
+                            return false;
+                        buf = ReadBufferExtended(idx, MAIN_FORKNUM, so->cur_blk, RBM_NORMAL, so->bstrategy);
+                        page = BufferGetPage(buf);
+                        so->cur_buf = buf; so->have_pin = true;
+                        /* Every claim may start before the bound, not just the first */
+                        if (so->have_bound)
+                            so->cur_off = smol_leaf_seek_bound(so, page);
+                        goto parallel_init_done;
+                    }
 
                     /* Fallback to atomic claiming if no directory */
                     /* claim first leaf from shared state */
@@ -1130,13 +2697,8 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                         if (curv == 0u)
 			{ /* GCOV_EXCL_LINE (flaky) - opening brace artifact: gcov inconsistently reports this */
                             /* Use actual lower bound when available to avoid over-emitting from the first leaf */
-                            int64 lb = PG_INT64_MIN;
-                            if (so->have_bound)
-                            {
-                                if (so->atttypid == INT2OID) lb = (int64) DatumGetInt16(so->bound_datum);
-                                else if (so->atttypid == INT4OID) lb = (int64) DatumGetInt32(so->bound_datum);
-                                else if (so->atttypid == INT8OID) lb = DatumGetInt64(so->bound_datum);
-                            }
+                            int64 lb = so->have_bound ? smol_bound_to_int64(so->atttypid, so->bound_datum, PG_INT64_MIN)
+                                                      : PG_INT64_MIN;
                             BlockNumber left = smol_find_first_leaf(idx, lb, so->atttypid, so->key_len);
                             /* Optimized: claim leaf and publish rightlink without batch skip-ahead
                              * This eliminates 15+ page reads per claim (pure overhead) */
@@ -1175,7 +2737,10 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                     so->last_dir = dir;
                     /* prefetch the first claimed leaf */
                     if (BlockNumberIsValid(so->cur_blk))
+                    {
                         PrefetchBuffer(idx, MAIN_FORKNUM, so->cur_blk);
+                        so->stat_prefetches++;
+                    }
                     if (BlockNumberIsValid(so->cur_blk))
                     {
                         buf = ReadBufferExtended(idx, MAIN_FORKNUM, so->cur_blk, RBM_NORMAL, so->bstrategy);
@@ -1183,20 +2748,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                         so->cur_buf = buf; so->have_pin = true;
                         /* Seek within first claimed leaf to the bound (forward scans) */
                         if (so->have_bound && dir != BackwardScanDirection && !so->two_col)
-                        {
-                            uint16 n2 = smol_leaf_nitems(page);
-                            uint16 lo2 = FirstOffsetNumber, hi2 = n2, ans2 = InvalidOffsetNumber;
-                            while (lo2 <= hi2)
-                            {
-                                uint16 mid2 = (uint16) (lo2 + ((hi2 - lo2) >> 1));
-                                char *kp2 = smol_leaf_keyptr_ex(page, mid2, so->key_len, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
-                                int cc = smol_cmp_keyptr_to_bound(so, kp2);
-                                if (so->prof_enabled) so->prof_bsteps++;
-                                if ((so->bound_strict ? (cc > 0) : (cc >= 0))) { ans2 = mid2; if (mid2 == 0) break; hi2 = (uint16) (mid2 - 1); }
-                                else lo2 = (uint16) (mid2 + 1);
-                            }
-                            so->cur_off = (ans2 != InvalidOffsetNumber) ? ans2 : (uint16) (n2 + 1);
-                        }
+                            so->cur_off = smol_leaf_seek_bound(so, page);
                     }
 
                 parallel_init_done:
@@ -1207,23 +2759,21 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                     /* Single-threaded scan: seek to first leaf containing bound
                      * For equality queries (k = value), this seeks directly to the page containing value
                      * instead of starting at leftmost leaf and scanning sequentially */
-                    if (so->have_bound && so->atttypid == TEXTOID)
+                    if (BlockNumberIsValid(so->probe_start_blk))
+                    {
+                        /* = ANY probe: smol_probe_position already chose the leaf */
+                        so->cur_blk = so->probe_start_blk;
+                    }
+                    else if (so->have_bound && (so->atttypid == TEXTOID || so->atttypid == UUIDOID))
                     {
-                        /* TEXT types: use generic find_first_leaf that handles text comparison correctly */
+                        /* TEXT/UUID types: use generic find_first_leaf that compares byte zone keys */
                         so->cur_blk = smol_find_first_leaf_generic(idx, so);
                     }
                     else
                     {
-                        /* Integer and date types or unbounded: use fast integer-only path */
-                        int64 lb = 0;  /* Default for unbounded scans: start at leftmost leaf */
-                        if (so->have_bound)
-                        {
-                            if (so->atttypid == INT2OID) lb = (int64) DatumGetInt16(so->bound_datum);
-                            else if (so->atttypid == INT4OID) lb = (int64) DatumGetInt32(so->bound_datum);
-                            else if (so->atttypid == INT8OID) lb = DatumGetInt64(so->bound_datum);
-                            else if (so->atttypid == DATEOID) lb = (int64) DatumGetInt32(so->bound_datum);  /* DATE is int32 internally */
-                            else lb = 0;  /* Other types (timestamp, etc.): leftmost leaf */
-                        }
+                        /* Integer-like types (int2/4/8, date, time, timestamp[tz]) or unbounded: fast int64 path */
+                        int64 lb = so->have_bound ? smol_bound_to_int64(so->atttypid, so->bound_datum, PG_INT64_MIN)
+                                                  : PG_INT64_MIN;  /* unbounded or other types: leftmost leaf */
                         so->cur_blk = smol_find_first_leaf(idx, lb, so->atttypid, so->key_len);
                     }
 
@@ -1242,23 +2792,12 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                     /* seek within leaf to >= bound */
                     if (so->have_bound)
                     {
-                        /* Pin leaf and binary-search to first >= or > bound */
-                        uint16 n2, lo = FirstOffsetNumber, hi, ans = InvalidOffsetNumber;
-                        buf = ReadBufferExtended(idx, MAIN_FORKNUM, so->cur_blk, RBM_NORMAL, so->bstrategy);
+                        /* Pin leaf and search to first >= or > bound */
+                        buf = smol_probe_read_leaf(idx, so, so->cur_blk);
                         page = BufferGetPage(buf);
-                        n2 = smol_leaf_nitems(page);
-                        hi = n2;
-                        while (lo <= hi)
-                        {
-                            uint16 mid = (uint16) (lo + ((hi - lo) >> 1));
-                            char *keyp = smol_leaf_keyptr_ex(page, mid, so->key_len, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
-                            int c = smol_cmp_keyptr_to_bound(so, keyp);
-                            if (so->prof_enabled) so->prof_bsteps++;
-                            if ((so->bound_strict ? (c > 0) : (c >= 0))) { ans = mid; if (mid == 0) break; hi = (uint16) (mid - 1); }
-                            else lo = (uint16) (mid + 1);
-                        }
-                        so->cur_off = (ans != InvalidOffsetNumber) ? ans : (uint16) (n2 + 1);
+                        so->cur_off = smol_leaf_seek_bound(so, page);
                         so->cur_buf = buf; so->have_pin = true;
+                        smol_rescan_remember(so, buf);
                         SMOL_LOGF("seeked (binsearch) within leaf off=%u", so->cur_off);
                     }
                     else
@@ -1271,7 +2810,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
 
                     /* Position-based scan optimization: Find end position */
                     if (smol_use_position_scan && !so->two_col && !so->need_runtime_key_test &&
-                        dir == ForwardScanDirection && !scan->parallel_scan)
+                        !so->probe_mode && dir == ForwardScanDirection && !scan->parallel_scan)
                     {
                         smol_find_end_position(idx, so, &so->end_blk, &so->end_off);
                         so->use_position_scan = BlockNumberIsValid(so->end_blk) ||
@@ -1302,11 +2841,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                             /* Defensive: PostgreSQL planner only uses parallel index scans with WHERE clauses, so have_bound must be true */
                             SMOL_DEFENSIVE_CHECK(so->have_bound, ERROR,
                                                 (errmsg("smol: parallel scan without bound")));
-                            int64 lb;
-                            if (so->atttypid == INT2OID) lb = (int64) DatumGetInt16(so->bound_datum);
-                            else if (so->atttypid == INT4OID) lb = (int64) DatumGetInt32(so->bound_datum);
-                            else if (so->atttypid == INT8OID) lb = DatumGetInt64(so->bound_datum);
-                            else lb = PG_INT64_MIN; /* Non-INT types: use minimum for conservative bound */
+                            int64 lb = smol_bound_to_int64(so->atttypid, so->bound_datum, PG_INT64_MIN);
                             BlockNumber left = smol_find_first_leaf(idx, lb, so->atttypid, so->key_len);
                             Buffer lbuf = ReadBuffer(idx, left);
                             Page lpg = BufferGetPage(lbuf);
@@ -1336,6 +2871,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                     if (BlockNumberIsValid(so->cur_blk))
                     {
                         PrefetchBuffer(idx, MAIN_FORKNUM, so->cur_blk);
+                        so->stat_prefetches++;
                         buf = ReadBufferExtended(idx, MAIN_FORKNUM, so->cur_blk, RBM_NORMAL, so->bstrategy);
                         page = BufferGetPage(buf);
                         so->cur_buf = buf; so->have_pin = true;
@@ -1360,15 +2896,12 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                 else
                 {
                     /* Two-column single-threaded scan: seek to first leaf containing bound */
-                    int64 lb = 0;  /* Default for unbounded scans */
-                    if (so->have_bound)
-                    {
-                        if (so->atttypid == INT2OID) lb = (int64) DatumGetInt16(so->bound_datum);
-                        else if (so->atttypid == INT4OID) lb = (int64) DatumGetInt32(so->bound_datum);
-                        else if (so->atttypid == INT8OID) lb = DatumGetInt64(so->bound_datum);
-                        else lb = 0;
-                    }
-                    so->cur_blk = smol_find_first_leaf(idx, lb, so->atttypid, so->key_len);
+                    int64 lb = so->have_bound ? smol_bound_to_int64(so->atttypid, so->bound_datum, PG_INT64_MIN)
+                                              : PG_INT64_MIN;  /* unbounded: leftmost leaf */
+                    if (BlockNumberIsValid(so->probe_start_blk))
+                        so->cur_blk = so->probe_start_blk;
+                    else
+                        so->cur_blk = smol_find_first_leaf(idx, lb, so->atttypid, so->key_len);
                     so->cur_group = 0;
                     so->pos_in_group = 0;
                     so->initialized = true;
@@ -1377,7 +2910,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                     {
                         /* Pin leaf and binary-search rows on k1 (>= or > bound) */
                         uint16 lo = FirstOffsetNumber, hi, ans = InvalidOffsetNumber;
-                        buf = ReadBufferExtended(idx, MAIN_FORKNUM, so->cur_blk, RBM_NORMAL, so->bstrategy);
+                        buf = smol_probe_read_leaf(idx, so, so->cur_blk);
                         page = BufferGetPage(buf);
                         so->leaf_n = smol12_leaf_nrows(page);
                         hi = so->leaf_n;
@@ -1393,6 +2926,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                         }
                         so->cur_buf = buf; so->have_pin = true;
                         so->leaf_i = (ans != InvalidOffsetNumber) ? (uint32) (ans - 1) : (uint32) so->leaf_n;
+                        smol_rescan_remember(so, buf);
                     }
                     else
                     {
@@ -1419,14 +2953,60 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
         }
         buf = so->cur_buf;
         page = BufferGetPage(buf);
+        if (so->cur_blk != so->stat_last_blk)
+        {
+            so->stat_leaves++;
+            so->stat_last_blk = so->cur_blk;
+        }
         /* Detect page format: plain or RLE */
         ItemId iid = PageGetItemId(page, FirstOffsetNumber);
         char *base = (char *) PageGetItem(page, iid);
 	/* memcpy() is same perf but handles unaligned - uint16 tag = *((uint16*)base) is unsafe */
         uint16 tag; memcpy(&tag, base, sizeof(uint16));
 
+        /* FOR, prefix-text and dictionary-coded INCLUDE leaves: unpack once
+         * into a plain-layout image and scan that.  The index is immutable,
+         * so the image stays valid across rescans. */
+        so->for_active = false;
+        if (tag == SMOL_TAG_KEY_FOR || tag == SMOL_TAG_TEXT_PREFIX ||
+            (tag == SMOL_TAG_INC_DICT && so->inc_meta))
+        {
+            uint16 nitems;
+            memcpy(&nitems, base + sizeof(uint16), sizeof(uint16));
+            if (so->for_blk != so->cur_blk)
+            {
+                Size need = sizeof(uint16) + (Size) nitems * so->key_len;
+                if (tag == SMOL_TAG_INC_DICT)
+                    need += (Size) nitems * so->inc_meta->inc_cumul_offs[so->ninclude];
+                if (need > so->for_keys_cap)
+                {
+                    if (so->for_keys)
+                        pfree(so->for_keys);
+                    so->for_keys = MemoryContextAlloc(GetMemoryChunkContext(so), need);
+                    so->for_keys_cap = need;
+                }
+                memcpy(so->for_keys, &nitems, sizeof(uint16));
+                if (tag == SMOL_TAG_KEY_FOR)
+                    smol_for_decode(base, so->for_keys + sizeof(uint16), so->key_len);
+                else if (tag == SMOL_TAG_TEXT_PREFIX)
+                    smol_tp_decode(base, so->for_keys + sizeof(uint16), so->key_len);
+                else
+                    smol_inc_dict_decode(base, so->for_keys + sizeof(uint16), so->key_len,
+                                         so->inc_meta->inc_len);
+                so->for_blk = so->cur_blk;
+            }
+            base = so->for_keys;
+            so->for_active = true;
+        }
+
         /* Opt #5: Cache page metadata once per page (nitems and format) */
-        if (tag == SMOL_TAG_KEY_RLE ||
+        if (so->for_active)
+        {
+            /* Decoded image is plain-layout; nitems may exceed the plain range */
+            memcpy(&so->cur_page_nitems, base, sizeof(uint16));
+            so->cur_page_format = 0;
+        }
+        else if (tag == SMOL_TAG_KEY_RLE ||
             tag == SMOL_TAG_KEY_RLE_V2 || tag == SMOL_TAG_INC_RLE)
         {
             /* Tagged formats: [u16 tag][u16 nitems][...] */
@@ -1455,32 +3035,41 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
          * - When bloom filters are enabled globally and in metadata
          * - NOT the first page (prof_pages > 0): first page found via B-tree descent should contain target
          *
-         * NOTE: Bloom filters are built on-the-fly for each page during rightlink sequential scanning.
-         * While this adds overhead, it can save significant work if the bloom indicates the page
-         * definitely doesn't contain the search value, allowing us to skip scanning potentially
-         * thousands of tuples. A better implementation would check blooms during B-tree descent
-         * using pre-built blooms stored in internal nodes, but that requires more invasive changes.
+         * NOTE: Indexes built with smol.bloom_leaf_bits read this leaf's filter from the bloom
+         * pages; otherwise a 64-bit bloom is built on-the-fly for each page during rightlink
+         * sequential scanning.  While this adds overhead, it can save significant work if the
+         * bloom indicates the page definitely doesn't contain the search value.
          */
-        if (smol_bloom_filters && so->have_k1_eq && !so->two_col && dir == ForwardScanDirection && so->prof_pages > 0)
+        if (smol_bloom_filters && so->have_k1_eq && !so->two_col && dir == ForwardScanDirection && so->prof_pages > 0 &&
+            so->cur_blk != so->probe_start_blk)
         {
             SmolMeta meta;
-            smol_meta_read(idx, &meta);
-            if (meta.bloom_enabled && meta.bloom_nhash > 0)
+            smol_meta_get(idx, &meta);
+            if (smol_scan_bloom_usable(so, &meta))
             {
-                /* Build bloom filter for this page on-the-fly */
-                uint64 page_bloom = smol_bloom_build_page(page, so->key_len, so->atttypid, meta.bloom_nhash);
-                if (so->prof_enabled)
-                    so->prof_bloom_checks++;
+                uint64 h = smol_bloom_hash_bound(so->bound_datum, so->atttypid, so->key_len, so->key_byval);
+                bool maybe;
 
-                SMOL_LOGF("bloom check page %u: bloom=%lx key=%d nhash=%d", so->cur_blk,
-                         (unsigned long)page_bloom, DatumGetInt32(so->bound_datum), meta.bloom_nhash);
+                so->prof_bloom_checks++;
+                if (smol_meta_has_leaf_blooms(&meta))
+                    maybe = smol_leaf_bloom_test(idx, &meta, so->cur_blk, h);
+                else
+                {
+                    /* Build bloom filter for this page on-the-fly */
+                    uint64 page_bloom = smol_bloom_build_page(page, so->key_len,
+                                                              so->inc_meta ? so->inc_meta->inc_cumul_offs[so->ninclude] : 0,
+                                                              so->atttypid, meta.bloom_nhash);
+
+                    maybe = smol_bloom_test(&page_bloom, 64, h, meta.bloom_nhash);
+                }
+                SMOL_LOGF("bloom check page %u: hash=%lx nhash=%d maybe=%d", so->cur_blk,
+                         (unsigned long) h, meta.bloom_nhash, (int) maybe);
 
                 /* Test if our search key might be in this page */
-                if (!smol_bloom_test(page_bloom, so->bound_datum, so->atttypid, meta.bloom_nhash))
+                if (!maybe)
                 {
                     /* Bloom filter says the key is definitely NOT in this page - skip it */
-                    if (so->prof_enabled)
-                        so->prof_bloom_skips++;
+                    so->prof_bloom_skips++;
                     SMOL_LOGF("bloom SKIP page %u for equality scan", so->cur_blk);
 
                     /* Advance to next page */
@@ -1534,10 +3123,11 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
         if (!so->two_col && so->ninclude > 0)
         {
             /* Reuse iid, base, tag from above */
-            /* Plain format has no tag - first u16 is the count n (< 0x8000) */
-            if (tag != 0x8001u && tag != 0x8003u)
+            /* Plain format has no tag - first u16 is the count n (< 0x8000);
+             * a decoded dictionary leaf is a plain image */
+            if (so->for_active || (tag != 0x8001u && tag != 0x8003u))
             {
-                uint16 n = tag; /* First u16 is count, not a tag */
+                uint16 n = so->for_active ? so->cur_page_nitems : tag; /* First u16 is count, not a tag */
                 char *base_ptr = base + sizeof(uint16) + (size_t) n * so->key_len;
                 /* Use precomputed cumulative offsets for O(1) per-column computation */
                 for (uint16 ii = 0; ii < so->ninclude; ii++)
@@ -1550,6 +3140,9 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
 
         if (so->two_col)
         {
+            if (so->tuple_buffering_enabled && !so->need_runtime_key_test &&
+                smol_tuple_buffer_emit(scan, so, page, base, dir))
+                return true;
             if (so->leaf_i < so->leaf_n)
             {
                 uint16 row = (uint16) (so->leaf_i + 1);
@@ -1561,7 +3154,19 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                     int c = smol_cmp_keyptr_to_bound(so, k1p);
                     if (so->bound_strict ? (c <= 0) : (c < 0))
                     {
-                        if (dir == BackwardScanDirection) so->leaf_i--; else so->leaf_i++;
+                        if (dir == BackwardScanDirection)
+                        {
+                            /* Walking left below the lower bound: nothing further matches */
+                            if (so->have_pin && BufferIsValid(so->cur_buf)) { ReleaseBuffer(so->cur_buf); so->have_pin=false; }
+                            so->cur_blk = InvalidBlockNumber;
+                            return false;
+                        }
+                        so->leaf_i++;
+                        continue;
+                    }
+                    if (so->have_k1_eq && c > 0 && dir == BackwardScanDirection)
+                    {
+                        so->leaf_i--;
                         continue;
                     }
                     if (so->have_k1_eq && c > 0)
@@ -1578,12 +3183,22 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                     int c = smol_cmp_keyptr_to_upper_bound(so, k1p);
                     if (so->upper_bound_strict ? (c >= 0) : (c > 0))
                     {
+                        if (dir == BackwardScanDirection)
+                        {
+                            /* Above the bound on the starting leaf: keep walking left */
+                            so->leaf_i--;
+                            continue;
+                        }
                         /* Exceeded upper bound, stop scan */
                         if (so->have_pin && BufferIsValid(so->cur_buf)) { ReleaseBuffer(so->cur_buf); so->have_pin=false; }
                         so->cur_blk = InvalidBlockNumber;
                         return false;
                     }
                 }
+                /* Skip scan: jump over second keys outside the k2 bounds */
+                if (so->skip_scan && dir != BackwardScanDirection &&
+                    smol12_skip_row(scan, so, page, k1p, k2p))
+                    continue;
                 /* Optional equality on second key (int2/int4/int8 only) */
                 if (so->have_k2_eq)
                 {
@@ -1593,114 +3208,38 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                     else /* 8 */ { int64 t; memcpy(&t, k2p, 8); v = t; }
                     if (v != so->k2_eq)
                     {
-                        if (dir == BackwardScanDirection) so->leaf_i--; else so->leaf_i++;
-                        continue;
-                    }
-                }
-                /* Optimized copies for common fixed lengths; fallback for others */
-                int text_len = 0;
-                if (so->key_is_text32)
-                {
-                    /* TEXT: wrap in varlena header */
-                    while (text_len < (int)so->key_len && k1p[text_len] != '\0') text_len++;
-                    SET_VARSIZE(so->itup_data, VARHDRSZ + text_len);
-                    if (text_len > 0) memcpy(VARDATA(so->itup_data), k1p, text_len);
-                }
-                else if (so->key_len == 2) smol_copy2(so->itup_data, k1p);
-                else if (so->key_len == 4) smol_copy4(so->itup_data, k1p);
-                else if (so->key_len == 8) smol_copy8(so->itup_data, k1p);
-                else if (so->key_len == 16) smol_copy16(so->itup_data, k1p);
-                else smol_copy_small(so->itup_data, k1p, so->key_len);
-
-                /* For two-column indexes, compute k2 offset dynamically when k1 is TEXT */
-                uint16 k2_off = so->itup_off2;
-                if (so->two_col && so->key_is_text32)
-                {
-                    /* TEXT k1 is variable-length, so k2 offset depends on actual text length */
-                    Size k1_actual_size = VARHDRSZ + text_len;
-                    k2_off = (uint16) att_align_nominal(k1_actual_size, so->align2);
-                }
-
-                if (so->key_len2 == 2) smol_copy2(so->itup_data + k2_off, k2p);
-                else if (so->key_len2 == 4) smol_copy4(so->itup_data + k2_off, k2p);
-                else if (so->key_len2 == 8) smol_copy8(so->itup_data + k2_off, k2p);
-                else if (so->key_len2 == 16) smol_copy16(so->itup_data + k2_off, k2p);
-                else smol_copy_small(so->itup_data + k2_off, k2p, so->key_len2);
-
-                /* Copy INCLUDE columns for two-column indexes */
-                if (so->ninclude > 0)
-                {
-                    char *row_ptr = smol12_row_ptr(page, row, so->key_len, so->key_len2, so->inc_meta->inc_cumul_offs[so->ninclude]);
-                    char *inc_start = row_ptr + so->key_len + so->key_len2;
-
-                    /* If any NUMERIC columns or TEXT k1 in two-column, compute offsets incrementally due to variable varlena size */
-                    if (so->has_numeric || (so->two_col && so->key_is_text32))
-                    {
-                        /* Start offset: for TEXT k1, must compute from actual k2 position */
-                        Size cur_off;
-                        if (so->two_col && so->key_is_text32)
-                            cur_off = k2_off + so->key_len2;
-                        else
-                            cur_off = so->inc_meta->inc_offs[0];
-                        for (uint16 i = 0; i < so->ninclude; i++)
+                        char *gp = smol12_payload(page);
+                        if (smol12_is_grouped(gp))
                         {
-                            char *inc_src = inc_start + so->inc_meta->inc_cumul_offs[i];
-                            cur_off = att_align_nominal(cur_off, so->inc_meta->inc_align[i]);
-                            char *inc_dst = so->itup_data + cur_off;
-
-                            if (so->inc_meta->inc_is_text[i])
-                            {
-                                /* Text: add VARHDRSZ and copy */
-                                SET_VARSIZE(inc_dst, VARHDRSZ + so->inc_meta->inc_len[i]);
-                                memcpy(VARDATA(inc_dst), inc_src, so->inc_meta->inc_len[i]);
-                                cur_off += VARHDRSZ + so->inc_meta->inc_len[i];
-                            }
-                            else if (so->inc_is_numeric[i])
+                            /* k2 is sorted within a k1 group: skip the group on its
+                             * min/max, else binary-search to the only spot that can match */
+                            uint16 g = smol12_group_of_row(gp, (uint16) so->leaf_i, so->key_len);
+                            uint16 first, cnt;
+                            smol12_group_range(gp, g, so->key_len, &first, &cnt);
+                            const char *k2s = smol12_group_k2_base(gp, so->key_len) + (size_t) first * so->key_len2;
+                            int64 gmin = smol_for_load_key(k2s, so->key_len2);
+                            int64 gmax = smol_for_load_key(k2s + (size_t) (cnt - 1) * so->key_len2, so->key_len2);
+                            if (dir == BackwardScanDirection)
                             {
-                                /* NUMERIC: stored as int64, convert to NUMERIC varlena */
-                                int64 int_val;
-                                if (so->inc_meta->inc_len[i] == 2)
-                                    int_val = (int64) *((int16 *) inc_src);
-                                else if (so->inc_meta->inc_len[i] == 4)
-                                    int_val = (int64) *((int32 *) inc_src);
+                                if (v < so->k2_eq || so->k2_eq < gmin)
+                                    so->leaf_i = (uint32) first - 1;      /* rest of the group is below */
                                 else
-                                    int_val = *((int64 *) inc_src);
-
-                                Datum numeric_datum = smol_int64_to_numeric(int_val, so->inc_numeric_scale[i]);
-                                struct varlena *numeric_vl = (struct varlena *) DatumGetPointer(numeric_datum);
-                                Size numeric_size = VARSIZE_ANY(numeric_vl);
-                                memcpy(inc_dst, numeric_vl, numeric_size);
-                                cur_off += numeric_size;
+                                    so->leaf_i = (uint32) first + smol_leaf_search_int(k2s, cnt, so->key_len2, so->k2_eq, true, NULL) - 1;
                             }
                             else
                             {
-                                /* Fixed-length: direct copy */
-                                memcpy(inc_dst, inc_src, so->inc_meta->inc_len[i]);
-                                cur_off += so->inc_meta->inc_len[i];
-                            }
-                        }
-                    }
-                    else
-                    {
-                        /* Fast path: no NUMERIC, use pre-computed offsets */
-                        for (uint16 i = 0; i < so->ninclude; i++)
-                        {
-                            char *inc_src = inc_start + so->inc_meta->inc_cumul_offs[i];
-                            char *inc_dst = so->itup_data + so->inc_meta->inc_offs[i];
-                            if (so->inc_meta->inc_is_text[i])
-                            {
-                                /* Text: add VARHDRSZ and copy */
-                                SET_VARSIZE(inc_dst, VARHDRSZ + so->inc_meta->inc_len[i]);
-                                memcpy(VARDATA(inc_dst), inc_src, so->inc_meta->inc_len[i]);
-                            }
-                            else
-                            {
-                                /* Fixed-length: direct copy */
-                                memcpy(inc_dst, inc_src, so->inc_meta->inc_len[i]);
+                                if (v > so->k2_eq || so->k2_eq > gmax)
+                                    so->leaf_i = (uint32) first + cnt;    /* rest of the group is above */
+                                else
+                                    so->leaf_i = (uint32) first + smol_leaf_search_int(k2s, cnt, so->key_len2, so->k2_eq, false, NULL);
                             }
+                            continue;
                         }
+                        if (dir == BackwardScanDirection) so->leaf_i--; else so->leaf_i++;
+                        continue;
                     }
                 }
+                smol12_form_tuple(so, page, row, k1p, k2p, so->itup_data);
 
                 /* Test runtime keys before returning */
                 if (!smol_test_runtime_keys(scan, so))
@@ -1728,6 +3267,10 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                  * - After processing all items: cur_off becomes 0, which exits the while loop below
                  * DO NOT reset cur_off here, as cur_off=0 is a valid state meaning "finished this page" */
 
+                if (so->tuple_buffering_enabled && !so->need_runtime_key_test &&
+                    smol_tuple_buffer_emit(scan, so, page, base, dir))
+                    return true;
+
                 while (so->cur_off >= FirstOffsetNumber)
                 {
                     /* Fast path for plain pages: compute keyptr inline (O(1) pointer arithmetic) */
@@ -1826,6 +3369,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                                 so->run_start_off = start;
                                 so->run_end_off = so->cur_off; /* not used in backward path */
                                 so->run_active = true;
+                                so->stat_runs++;
                             }
                         }
                         /* build tuple (varlena dynamic or fixed-size fast path) */
@@ -1939,72 +3483,23 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                 if (so->cur_off == InvalidOffsetNumber || so->cur_off == 0)
                     so->cur_off = FirstOffsetNumber; /* GCOV_EXCL_LINE - defensive: cur_off always FirstOffsetNumber (set at lines 2464, 2522, 3495) */
 
-                /* Tuple buffering optimization for plain pages (forward scans only) */
-                if (so->tuple_buffering_enabled && so->plain_inc_cached)
+                /* Tuple buffering: rows are prebuilt a batch at a time */
+                if (so->tuple_buffering_enabled && !so->need_runtime_key_test &&
+                    smol_tuple_buffer_emit(scan, so, page, base, dir))
+                    return true;
+
+                while (so->cur_off <= n)
                 {
-                    /* Check if we have buffered tuples available */
-                    if (so->tuple_buffer_current < so->tuple_buffer_count)
+                    /* Position-based scan: check if we've reached end position */
+                    if (so->use_position_scan && BlockNumberIsValid(so->end_blk))
                     {
-                        /* Return next tuple from buffer */
-                        IndexTuple itup = so->tuple_buffer[so->tuple_buffer_current];
-                        scan->xs_itup = itup;
-                        /* Set synthetic TID directly (not stored in itup->t_tid - see TID OPTIMIZATION) */
-                        ItemPointerSet(&scan->xs_heaptid, 0, 1);
-
-                        so->tuple_buffer_current++;
-                        so->cur_off++;
-
-                        if (so->prof_enabled)
+                        if (so->cur_blk > so->end_blk ||
+                            (so->cur_blk == so->end_blk && so->cur_off >= so->end_off))
                         {
-                            so->prof_rows++; // GCOV_EXCL_LINE - profiling instrumentation
-                            so->prof_bytes += so->tuple_size; // GCOV_EXCL_LINE - profiling instrumentation
-                        }
-
-                        return true;
-                    }
-
-                    /* Buffer empty - try to refill from current page */
-                    if (so->cur_off <= n)
-                    {
-                        so->tuple_buffer_count = smol_refill_tuple_buffer_plain(so, page);
-                        so->tuple_buffer_current = 0;
-
-                        if (so->tuple_buffer_count > 0)
-                        {
-                            /* Successfully refilled, return first tuple */
-                            IndexTuple itup = so->tuple_buffer[0];
-                            scan->xs_itup = itup;
-                            /* Set synthetic TID directly (not stored in itup->t_tid - see TID OPTIMIZATION) */
-                            ItemPointerSet(&scan->xs_heaptid, 0, 1);
-
-                            so->tuple_buffer_current = 1;  /* Consumed first tuple */
-                            so->cur_off++;
-
-                            if (so->prof_enabled)
-                            {
-                                so->prof_rows++; // GCOV_EXCL_LINE - profiling instrumentation
-                                so->prof_bytes += so->tuple_size; // GCOV_EXCL_LINE - profiling instrumentation
-                            }
-
-                            return true;
-                        }
-                        /* else: refill returned 0, fall through to page advance */
-                    }
-                    /* else: cur_off > n, fall through to page advance */
-                }
-
-                while (so->cur_off <= n)
-                {
-                    /* Position-based scan: check if we've reached end position */
-                    if (so->use_position_scan && BlockNumberIsValid(so->end_blk))
-                    {
-                        if (so->cur_blk > so->end_blk ||
-                            (so->cur_blk == so->end_blk && so->cur_off >= so->end_off))
-                        {
-                            /* Reached end position, stop scan */
-                            if (so->have_pin && BufferIsValid(so->cur_buf)) { ReleaseBuffer(so->cur_buf); so->have_pin=false; }
-                            so->cur_blk = InvalidBlockNumber;
-                            return false;
+                            /* Reached end position, stop scan */
+                            if (so->have_pin && BufferIsValid(so->cur_buf)) { ReleaseBuffer(so->cur_buf); so->have_pin=false; }
+                            so->cur_blk = InvalidBlockNumber;
+                            return false;
                         }
                     }
 
@@ -2063,12 +3558,21 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                                          !smol_leaf_run_bounds_rle_ex(page, so->cur_off, so->key_len, &start, &end, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude))
                                 {
                                     /* RLE page but not encoded: scan forward to find run end */
-                                    while (end < n)
+                                    if (so->leaf_kernel_len != 0 && so->cur_page_format == 0)
                                     {
-                                        const char *kp = smol_leaf_keyptr_ex(page, (uint16) (end + 1), so->key_len, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
-                                        if (!smol_key_eq_len(k0, kp, so->key_len))
-                                            break;
-                                        end++;
+                                        /* Plain key array: vector compare against the run key */
+                                        end = (uint16) (smol_leaf_run_end_int(base + sizeof(uint16), n, so->key_len,
+                                                                              (uint16) (so->cur_off - 1)) + 1);
+                                    }
+                                    else
+                                    {
+                                        while (end < n)
+                                        {
+                                            const char *kp = smol_leaf_keyptr_ex(page, (uint16) (end + 1), so->key_len, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
+                                            if (!smol_key_eq_len(k0, kp, so->key_len))
+                                                break;
+                                            end++;
+                                        }
                                     }
                                     so->rle_run_inc_cached = false; /* Non-RLE page, no caching */
                                 }
@@ -2096,11 +3600,12 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                                 so->run_start_off = start; /* not used in forward path */
                                 so->run_end_off = end;
                                 so->run_active = true;
+                                so->stat_runs++;
                                 so->run_inc_evaluated = false;
                                 if (so->key_is_text32)
                                 {
-                                    const char *kend = (const char *) memchr(k0, '\0', 32);
-                                    int klen = (int) (kend ? (kend - k0) : 32);
+                                    const char *kend = (const char *) memchr(k0, '\0', so->key_len);
+                                    int klen = (int) (kend ? (kend - k0) : so->key_len);
                                     so->run_text_klen = (int16) klen;
                                     SET_VARSIZE((struct varlena *) so->run_key_vl, klen + VARHDRSZ);
                                     memcpy(so->run_key_vl + VARHDRSZ, k0, (size_t) klen);
@@ -2263,61 +3768,33 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
         {
             SmolParallelScan *ps = (SmolParallelScan *) ((char *) scan->parallel_scan + scan->parallel_scan->ps_offset_am);
 
-            /* Directory-based advancement: follow rightlinks within partition */
+            /* Directory-based advancement: follow rightlinks within the claimed entry */
             if (so->use_directory)
-            { /* GCOV_EXCL_START - directory feature disabled due to bug */
-                /* Follow rightlink to next leaf */
+            {
                 Buffer cbuf = ReadBufferExtended(idx, MAIN_FORKNUM, so->cur_blk, RBM_NORMAL, so->bstrategy);
                 Page cpage = BufferGetPage(cbuf);
                 BlockNumber rightlink = smol_page_opaque(cpage)->rightlink;
                 ReleaseBuffer(cbuf);
 
-                if (BlockNumberIsValid(rightlink))
+                if (BlockNumberIsValid(rightlink) &&
+                    (!BlockNumberIsValid(so->dir_current_end) || rightlink < so->dir_current_end))
                 {
-                    /* Check if still within current chunk */
-                    if (!BlockNumberIsValid(so->dir_current_end) || rightlink < so->dir_current_end)
-                    {
-                        next = rightlink;
-                        SMOL_LOGF("directory advance to leaf %u", next);
-                        if (BlockNumberIsValid(next))
-                            PrefetchBuffer(idx, MAIN_FORKNUM, next);
-                    }
-                    else
-                    {
-                        /* Reached end of current chunk, claim next directory entry */
-                        SMOL_LOGF("finished chunk at block %u, claiming next", rightlink);
-
-                        uint32 next_idx = pg_atomic_fetch_add_u32(&ps->curr, 1);
-                        if (next_idx < so->dir_data->num_entries)
-                        {
-                            /* Claimed next chunk */
-                            so->dir_current_idx = next_idx;
-
-                            if (next_idx + 1 < so->dir_data->num_entries)
-                                so->dir_current_end = so->dir_data->entries[next_idx + 1].leaf_blkno;
-                            else
-                                so->dir_current_end = InvalidBlockNumber;
-
-                            next = so->dir_data->entries[next_idx].leaf_blkno;
-                            SMOL_LOGF("claimed directory entry %u, starting at block %u", next_idx, next);
-
-                            if (BlockNumberIsValid(next))
-                                PrefetchBuffer(idx, MAIN_FORKNUM, next);
-                        }
-                        else
-                        {
-                            /* No more directory entries to claim */
-                            next = InvalidBlockNumber;
-                            SMOL_LOG("no more directory entries");
-                        }
-                    }
+                    next = rightlink;
+                    SMOL_LOGF("directory advance to leaf %u", next);
                 }
                 else
                 {
-                    /* No more leaves in index */
-                    next = InvalidBlockNumber;
+                    /* Entry finished: claim our next one, or steal from a busier worker */
+                    next = smol_pscan_claim_leaf(idx, so, ps);
+                    if (!BlockNumberIsValid(next))
+                        SMOL_LOG("no more directory entries");
                 }
-            } /* GCOV_EXCL_STOP */
+                if (BlockNumberIsValid(next) && !smol_read_stream)
+                {
+                    PrefetchBuffer(idx, MAIN_FORKNUM, next);
+                    so->stat_prefetches++;
+                }
+            }
             else
             {
                 /* Fallback: atomic claiming */
@@ -2331,11 +3808,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                         /* Defensive: PostgreSQL planner only uses parallel index scans with WHERE clauses, so have_bound must be true */
                         SMOL_DEFENSIVE_CHECK(so->have_bound, ERROR,
                                             (errmsg("smol: parallel scan without bound")));
-                        int64 lb;
-                        if (so->atttypid == INT2OID) lb = (int64) DatumGetInt16(so->bound_datum);
-                        else if (so->atttypid == INT4OID) lb = (int64) DatumGetInt32(so->bound_datum);
-                        else if (so->atttypid == INT8OID) lb = DatumGetInt64(so->bound_datum);
-                        else lb = PG_INT64_MIN; /* Non-INT types: use minimum for conservative bound */
+                        int64 lb = smol_bound_to_int64(so->atttypid, so->bound_datum, PG_INT64_MIN);
                         BlockNumber left = smol_find_first_leaf(idx, lb, so->atttypid, so->key_len);
                         Buffer lbuf = ReadBufferExtended(idx, MAIN_FORKNUM, left, RBM_NORMAL, so->bstrategy);
                         Page lpg = BufferGetPage(lbuf);
@@ -2348,7 +3821,10 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                             next = left;
                             so->chunk_left = 0;
                             if (BlockNumberIsValid(next))
+                            {
                                 PrefetchBuffer(idx, MAIN_FORKNUM, next);
+                                so->stat_prefetches++;
+                            }
                             break;
                         }
                         continue;
@@ -2367,7 +3843,10 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                         next = (BlockNumber) curv;
                         so->chunk_left = 0;
                         if (BlockNumberIsValid(next))
+                        {
                             PrefetchBuffer(idx, MAIN_FORKNUM, next);
+                            so->stat_prefetches++;
+                        }
                         break;
                     }
                 }
@@ -2377,20 +3856,31 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
         else
         {
             /* Increment pages_scanned for adaptive prefetch tracking (non-parallel path) */
-            if (dir != BackwardScanDirection && so->pages_scanned < 65535)
+            if (so->pages_scanned < 65535)
                 so->pages_scanned++;
 
             /* Read rightlink/leftlink BEFORE releasing buffer */
             op = smol_page_opaque(page);
             next = (dir == BackwardScanDirection) ? op->leftlink : op->rightlink;
+            /* A skip scan jumps past the rest of a long k1 group */
+            if (BlockNumberIsValid(so->skip_next_blk))
+            {
+                if (dir != BackwardScanDirection)
+                    next = so->skip_next_blk;
+                so->skip_next_blk = InvalidBlockNumber;
+            }
 
             /* Adaptive prefetching with slow-start for bounded scans
              * Avoids over-prefetching for equality lookups and narrow ranges
-             * while ramping up for larger scans */
-            if (dir != BackwardScanDirection && BlockNumberIsValid(next))
+             * while ramping up for larger scans.  Backward scans walk leftlinks,
+             * where the lower bound is what limits how far they go.  The leaf
+             * stream does its own look-ahead, bounded by the end leaf. */
+            if (BlockNumberIsValid(next) && !smol_leaf_stream_enabled(scan, so))
             {
                 /* Determine effective prefetch depth using adaptive slow-start */
                 int effective_depth;
+                bool backward = (dir == BackwardScanDirection);
+                bool range_bounded = backward ? so->have_bound : so->have_upper_bound;
 
                 if (so->have_k1_eq)
                 {
@@ -2403,7 +3893,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                     else
                         effective_depth = Min(2, smol_prefetch_depth); /* Cap at 2 for equality */
                 }
-                else if (so->have_upper_bound)
+                else if (range_bounded)
                 {
                     /* Bounded range queries: Slow-start ramp
                      * Start conservatively, increase as we confirm scan is large */
@@ -2420,7 +3910,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                 }
                 else
                 {
-                    /* Unbounded forward scans: Use full prefetch depth immediately
+                    /* Unbounded scans (either direction): Use full prefetch depth immediately
                      * These benefit from aggressive prefetching */
                     effective_depth = smol_prefetch_depth;
                 }
@@ -2429,17 +3919,32 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
                 if (effective_depth > 0)
                 {
                     PrefetchBuffer(idx, MAIN_FORKNUM, next);
+                    so->stat_prefetches++;
                     SMOL_LOGF("NON-PARALLEL: adaptive_prefetch_depth=%d pages_scanned=%u next=%u",
                               effective_depth, so->pages_scanned, next);
 
                     if (effective_depth > 1)
                     {
+                        /* Leaves are written in key order, so the sibling chain
+                         * runs through consecutive blocks in either direction */
                         BlockNumber nblocks = RelationGetNumberOfBlocks(idx);
                         for (int d = 2; d <= effective_depth; d++)
                         {
-                            BlockNumber pb = next + (BlockNumber) (d - 1);
+                            BlockNumber pb;
+
+                            if (backward)
+                            {
+                                if (next <= (BlockNumber) (d - 1))
+                                    break;  /* block 0 is the metapage */
+                                pb = next - (BlockNumber) (d - 1);
+                            }
+                            else
+                                pb = next + (BlockNumber) (d - 1);
                             if (pb < nblocks)
+                            {
                                 PrefetchBuffer(idx, MAIN_FORKNUM, pb);
+                                so->stat_prefetches++;
+                            }
                             else
                                 break;
                         }
@@ -2470,7 +3975,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
             if (scan->parallel_scan && dir != BackwardScanDirection)
                 so->cur_blk = next;
             /* Pre-pin next leaf and rebuild cache for two-col */
-            Buffer nbuf = ReadBufferExtended(idx, MAIN_FORKNUM, so->cur_blk, RBM_NORMAL, so->bstrategy);
+            Buffer nbuf = smol_leaf_stream_read(scan, so, so->cur_blk, dir);
             Page np = BufferGetPage(nbuf);
 
             /* For backward scans, set cur_off to last item in new page */
@@ -2518,7 +4023,12 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
             {
                 so->leaf_n = smol12_leaf_nrows(np);
                 so->leaf_i = 0;
-                if (so->have_bound)
+                if (dir == BackwardScanDirection)
+                {
+                    /* Walking left: every row of an earlier leaf is within the upper bound */
+                    so->leaf_i = (so->leaf_n > 0) ? (uint32) (so->leaf_n - 1) : 0;
+                }
+                else if (so->have_bound)
                 {
                     uint16 lo = FirstOffsetNumber, hi = so->leaf_n, ans = InvalidOffsetNumber;
                     while (lo <= hi)
@@ -2537,20 +4047,7 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
             {
                 /* single-col: if we have a bound, re-seek within new leaf */
                 if (so->have_bound && dir != BackwardScanDirection)
-                {
-                    uint16 n2 = smol_leaf_nitems(np);
-                    uint16 lo2 = FirstOffsetNumber, hi2 = n2, ans2 = InvalidOffsetNumber;
-                    while (lo2 <= hi2)
-                    {
-                        uint16 mid2 = (uint16) (lo2 + ((hi2 - lo2) >> 1));
-                        char *kp2 = smol_leaf_keyptr_ex(np, mid2, so->key_len, so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude, so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
-                        int cc = smol_cmp_keyptr_to_bound(so, kp2);
-                        if (so->prof_enabled) so->prof_bsteps++;
-                        if ((so->bound_strict ? (cc > 0) : (cc >= 0))) { ans2 = mid2; if (mid2 == 0) break; hi2 = (uint16) (mid2 - 1); }
-                        else lo2 = (uint16) (mid2 + 1);
-                    }
-                    so->cur_off = (ans2 != InvalidOffsetNumber) ? ans2 : (uint16) (n2 + 1);
-                }
+                    so->cur_off = smol_leaf_seek_bound(so, np);
 #ifdef SMOL_PLANNER_BACKWARD_BOUNDS
                 else if (so->have_bound && dir == BackwardScanDirection)
                 {
@@ -2586,6 +4083,278 @@ smol_gettuple(IndexScanDesc scan, ScanDirection dir)
     return false;
 }
 
+/*
+ * smol_probe_position - choose the start leaf for the next probe that can match
+ *
+ * Probes are sorted, so the next probe can only start on the leaf the
+ * previous one started on or further right.  That leaf (still pinned) and
+ * its right sibling are tried before descending from the root; the descent
+ * consults the parents' zone maps and bloom filters so probes that cannot
+ * be present cost no leaf read.  Returns false once the probes run out.
+ */
+static bool
+smol_probe_position(IndexScanDesc scan, SmolScanOpaque so)
+{
+    Relation idx = scan->indexRelation;
+
+    while (so->probe_idx < so->nprobes)
+    {
+        so->bound_datum = so->probe_vals[so->probe_idx];
+        so->probe_start_blk = InvalidBlockNumber;
+
+        if (BufferIsValid(so->probe_buf))
+        {
+            Page page = BufferGetPage(so->probe_buf);
+
+            if (!smol_probe_past_leaf(so, page))
+                so->probe_start_blk = BufferGetBlockNumber(so->probe_buf);
+            else
+            {
+                BlockNumber next = smol_page_opaque(page)->rightlink;
+
+                ReleaseBuffer(so->probe_buf);
+                so->probe_buf = InvalidBuffer;
+                if (!BlockNumberIsValid(next))
+                    break;      /* beyond the last leaf: later probes are too */
+                so->probe_buf = ReadBufferExtended(idx, MAIN_FORKNUM, next, RBM_NORMAL, so->bstrategy);
+                if (!smol_probe_past_leaf(so, BufferGetPage(so->probe_buf)))
+                    so->probe_start_blk = next;
+            }
+        }
+
+        if (!BlockNumberIsValid(so->probe_start_blk))
+        {
+            bool absent;
+            BlockNumber blk = smol_find_probe_leaf(idx, so, &absent);
+
+            smol_probe_release(so);
+            if (absent)
+            {
+                so->probe_idx++;
+                continue;
+            }
+            if (!BlockNumberIsValid(blk))
+                break;          /* above every key in the index */
+            so->probe_buf = ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, so->bstrategy);
+            so->probe_start_blk = blk;
+        }
+        SMOL_LOGF("probe %d/%d starts at leaf %u", so->probe_idx + 1, so->nprobes, so->probe_start_blk);
+        return true;
+    }
+    so->probe_idx = so->nprobes;
+    smol_probe_release(so);
+    return false;
+}
+
+/*
+ * smol_gettuple - amgettuple
+ *
+ * Leading-key = ANY(array) quals in a serial forward scan run one equality
+ * scan per probe (smol_gettuple_internal with bound_datum set to the probe);
+ * all other scans go straight to smol_gettuple_internal.
+ */
+bool
+smol_gettuple(IndexScanDesc scan, ScanDirection dir)
+{
+    SmolScanOpaque so = (SmolScanOpaque) scan->opaque;
+
+    if (so->keys_unsatisfiable)
+        return false;
+    if (so->probe_vals == NULL || dir == NoMovementScanDirection)
+        return smol_gettuple_internal(scan, dir);
+
+    if (so->probe_mode && dir != ForwardScanDirection)
+    {
+        /* Direction change: restart in range mode, like the plain scan does */
+        smol_probe_release(so);
+        smol_probe_set_range(so);
+        so->probe_idx = so->nprobes;
+        so->initialized = false;
+    }
+    else if (!so->probe_mode && !so->initialized && so->probe_idx == 0 && so->nprobes > 1 &&
+             dir == ForwardScanDirection && !scan->parallel_scan)
+    {
+        so->probe_mode = true;
+        so->have_upper_bound = false;
+        so->have_k1_eq = true;
+        so->need_runtime_key_test = so->need_runtime_key_test_base;
+    }
+    if (!so->probe_mode)
+        return smol_gettuple_internal(scan, dir);
+
+    for (;;)
+    {
+        if (!so->initialized && !smol_probe_position(scan, so))
+            return false;
+        if (smol_gettuple_internal(scan, dir))
+            return true;
+
+        /* Probe exhausted: drop per-position state and move to the next one */
+        if (so->have_pin && BufferIsValid(so->cur_buf))
+            ReleaseBuffer(so->cur_buf);
+        so->have_pin = false;
+        so->cur_buf = InvalidBuffer;
+        so->cur_blk = InvalidBlockNumber;
+        so->initialized = false;
+        so->rle_cached_page_blk = InvalidBlockNumber;
+        so->prev_page_last_run_active = false;
+        so->tuple_buffer_count = 0;
+        so->tuple_buffer_current = 0;
+        smol_run_reset(so);
+        so->probe_idx++;
+    }
+}
+
+/*
+ * Bitmap scan support
+ *
+ * SMOL stores no heap TIDs, so amgetbitmap can only report whole heap blocks:
+ * each leaf carries the [heap_lo, heap_lo + heap_nblocks) range recorded by the
+ * build, and every block in the ranges of matching leaves is added to the
+ * bitmap as a lossy page.  The executor rechecks all tuples on lossy pages
+ * against the original quals, so results stay exact.
+ */
+
+/* True when the first key on a leaf is already past the upper/equality bound */
+static bool
+smol_bitmap_leaf_past_bounds(SmolScanOpaque so, Page page)
+{
+    char *first;
+
+    if (!so->have_upper_bound && !so->have_k1_eq)
+        return false;
+    if (so->two_col)
+        first = smol12_row_k1_ptr(page, FirstOffsetNumber, so->key_len, so->key_len2,
+                                  so->inc_meta ? so->inc_meta->inc_cumul_offs[so->ninclude] : 0);
+    else
+        first = smol_leaf_keyptr_ex(page, FirstOffsetNumber, so->key_len,
+                                    so->inc_meta ? so->inc_meta->inc_len : NULL, so->ninclude,
+                                    so->inc_meta ? so->inc_meta->inc_cumul_offs : NULL);
+    if (so->have_upper_bound)
+    {
+        int c = smol_cmp_keyptr_to_upper_bound(so, first);
+        if (so->upper_bound_strict ? (c >= 0) : (c > 0))
+            return true;
+    }
+    if (so->have_k1_eq && smol_cmp_keyptr_to_bound(so, first) > 0)
+        return true;
+    return false;
+}
+
+/* Add heap blocks [lo, hi] to the bitmap, skipping the part already covered by [*cov_lo, *cov_hi] */
+static void
+smol_bitmap_add_range(TIDBitmap *tbm, BlockNumber lo, BlockNumber hi,
+                      BlockNumber *cov_lo, BlockNumber *cov_hi)
+{
+    if (BlockNumberIsValid(*cov_lo) && lo <= *cov_hi + 1 && hi + 1 >= *cov_lo)
+    {
+        /* Overlapping or adjacent (the common case for correlated heaps) */
+        for (BlockNumber b = lo; b < *cov_lo; b++)
+            tbm_add_page(tbm, b);
+        for (BlockNumber b = *cov_hi + 1; b <= hi; b++)
+            tbm_add_page(tbm, b);
+        *cov_lo = Min(*cov_lo, lo);
+        *cov_hi = Max(*cov_hi, hi);
+        return;
+    }
+    for (BlockNumber b = lo; b <= hi; b++)
+        tbm_add_page(tbm, b);
+    *cov_lo = lo;
+    *cov_hi = hi;
+}
+
+int64
+smol_getbitmap(IndexScanDesc scan, TIDBitmap *tbm)
+{
+    Relation idx = scan->indexRelation;
+    SmolScanOpaque so = (SmolScanOpaque) scan->opaque;
+    BlockNumber blk;
+    BlockNumber heap_nblocks = InvalidBlockNumber;
+    BlockNumber cov_lo = InvalidBlockNumber, cov_hi = InvalidBlockNumber;
+    bool whole_heap = false;
+    int64 ntuples = 0;
+
+    SMOL_DEFENSIVE_CHECK(scan->numberOfKeys == 0 || so->runtime_keys != NULL, ERROR,
+                        (errmsg("smol: amgetbitmap called before amrescan")));
+    if (so->keys_unsatisfiable)
+        return 0;
+
+    /* Seek to the first leaf that can contain the lower bound, as gettuple does */
+    if (so->have_bound && (so->atttypid == TEXTOID || so->atttypid == UUIDOID) && !so->two_col)
+        blk = smol_find_first_leaf_generic(idx, so);
+    else
+    {
+        int64 lb = so->have_bound ? smol_bound_to_int64(so->atttypid, so->bound_datum, PG_INT64_MIN)
+                                  : PG_INT64_MIN;
+        blk = smol_find_first_leaf(idx, lb, so->atttypid, so->key_len);
+    }
+
+    while (BlockNumberIsValid(blk))
+    {
+        Buffer buf;
+        Page page;
+        SmolPageOpaqueData *op;
+        uint16 n;
+
+        CHECK_FOR_INTERRUPTS();
+        buf = ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, so->bstrategy);
+        page = BufferGetPage(buf);
+        op = smol_page_opaque(page);
+        n = so->two_col ? smol12_leaf_nrows(page) : smol_leaf_nitems(page);
+        if (so->prof_enabled)
+            so->prof_pages++;
+        so->stat_leaves++;
+
+        if (n == 0 || smol_bitmap_leaf_past_bounds(so, page))
+        {
+            ReleaseBuffer(buf);
+            break;
+        }
+        ntuples += n;
+
+        if (op->heap_nblocks == 0)
+        {
+            /* Leaf written without a heap range (array-based build paths) */
+            whole_heap = true;
+            ReleaseBuffer(buf);
+            break;
+        }
+        if (op->heap_nblocks == SMOL_HEAP_NBLOCKS_OPEN)
+        {
+            if (!BlockNumberIsValid(heap_nblocks))
+            {
+                /* heapRelation is not set up for bitmap index scans */
+                Relation heap = table_open(idx->rd_index->indrelid, AccessShareLock);
+                heap_nblocks = RelationGetNumberOfBlocks(heap);
+                table_close(heap, AccessShareLock);
+            }
+            if (op->heap_lo < heap_nblocks)
+                smol_bitmap_add_range(tbm, op->heap_lo, heap_nblocks - 1, &cov_lo, &cov_hi);
+        }
+        else
+            smol_bitmap_add_range(tbm, op->heap_lo, op->heap_lo + op->heap_nblocks - 1,
+                                  &cov_lo, &cov_hi);
+
+        blk = op->rightlink;
+        ReleaseBuffer(buf);
+    }
+
+    if (whole_heap)
+    {
+        Relation heap = table_open(idx->rd_index->indrelid, AccessShareLock);
+        BlockNumber nb = RelationGetNumberOfBlocks(heap);
+        table_close(heap, AccessShareLock);
+        for (BlockNumber b = 0; b < nb; b++)
+            tbm_add_page(tbm, b);
+    }
+
+    if (so->prof_enabled)
+        so->prof_rows += (uint64) ntuples;
+    SMOL_LOGF("getbitmap: leaves=%lu tuples=%ld whole_heap=%d",
+              (unsigned long) so->prof_pages, (long) ntuples, whole_heap ? 1 : 0);
+    return ntuples;
+}
+
 void
 smol_endscan(IndexScanDesc scan)
 {
@@ -2596,6 +4365,11 @@ smol_endscan(IndexScanDesc scan)
         SmolScanOpaque so = (SmolScanOpaque) scan->opaque;
         if (so->have_pin && BufferIsValid(so->cur_buf))
             ReleaseBuffer(so->cur_buf);
+        smol_probe_release(so);
+        smol_leaf_stream_release(so);
+        if (so->probe_vals) pfree(so->probe_vals);
+        if (so->k2_vals) pfree(so->k2_vals);
+        if (so->k2_cmp) pfree(so->k2_cmp);
         if (so->leaf_k1) pfree(so->leaf_k1);
         if (so->leaf_k2) pfree(so->leaf_k2);
         if (so->itup)
@@ -2606,6 +4380,8 @@ smol_endscan(IndexScanDesc scan)
             pfree(so->runtime_keys);
         if (so->inc_meta)
             pfree(so->inc_meta);
+        if (so->for_keys)
+            pfree(so->for_keys);
         /* Clean up tuple buffer */
         if (so->tuple_buffering_enabled)
         {
@@ -2615,7 +4391,7 @@ smol_endscan(IndexScanDesc scan)
                 pfree(so->tuple_buffer_data);
         }
         if (so->prof_enabled)
-            elog(LOG, "[smol] scan profile: calls=%lu rows=%lu leaf_pages=%lu bytes_copied=%lu bytes_touched=%lu binsearch_steps=%lu bloom_checks=%lu bloom_skips=%lu",
+            elog(LOG, "[smol] scan profile: calls=%lu rows=%lu leaf_pages=%lu bytes_copied=%lu bytes_touched=%lu binsearch_steps=%lu bloom_checks=%lu bloom_skips=%lu dir_claims=%lu dir_steals=%lu",
                  (unsigned long) so->prof_calls,
                  (unsigned long) so->prof_rows,
                  (unsigned long) so->prof_pages,
@@ -2623,7 +4399,10 @@ smol_endscan(IndexScanDesc scan)
                  (unsigned long) so->prof_touched,
                  (unsigned long) so->prof_bsteps,
                  (unsigned long) so->prof_bloom_checks,
-                 (unsigned long) so->prof_bloom_skips);
+                 (unsigned long) so->prof_bloom_skips,
+                 (unsigned long) so->prof_dir_claims,
+                 (unsigned long) so->prof_dir_steals);
+        smol_stats_flush(scan, so);
         pfree(so);
     }
 }
@@ -2644,8 +4423,7 @@ smol_estimateparallelscan(Relation index, int nkeys, int norderbys)
 void
 smol_initparallelscan(void *target)
 {
-    SmolParallelScan *ps = (SmolParallelScan *) target;
-    pg_atomic_init_u32(&ps->curr, 0u);
+    smol_pscan_init((SmolParallelScan *) target);
 }
 
 
@@ -2656,5 +4434,645 @@ smol_parallelrescan(IndexScanDesc scan) /* GCOV_EXCL_START - extremely rare: par
     {
         SmolParallelScan *ps = (SmolParallelScan *) ((char *) scan->parallel_scan + scan->parallel_scan->ps_offset_am);
         pg_atomic_write_u32(&ps->curr, 0u);
+        /* Slot numbers stay assigned to their backends; only the ranges restart */
+        pg_atomic_write_u32(&ps->stop_entry, SMOL_PSCAN_NO_ENTRY);
+        pg_atomic_write_u64(&ps->range[0], smol_pscan_pack(0, SMOL_PSCAN_RANGE_UNSET));
+        for (int i = 1; i < SMOL_PSCAN_MAX_SLOTS; i++)
+            pg_atomic_write_u64(&ps->range[i], smol_pscan_pack(0, 0));
     }
 } /* GCOV_EXCL_STOP */
+
+/*
+ * ========================================================================
+ * Aggregate Pushdown: smol_group_agg()
+ * ========================================================================
+ *
+ * Folds a single-column integer index into one (k, count, sum, min, max) row
+ * per distinct key by reading leaf pages directly instead of emitting every
+ * row as an IndexTuple.  Include-RLE runs contribute count * value in one
+ * step and key-RLE runs add their count, so duplicate-heavy indexes cost
+ * one step per run rather than per row.  Like the scan itself this relies on
+ * the read-only contract: there are no visibility checks.  Since it reads
+ * every row, the caller must hold SELECT on the table and no row-level
+ * security policy may apply to them.
+ *
+ * An optional range filter on an integer INCLUDE column is tested against
+ * the raw leaf bytes of each row.  Indexes built with
+ * smol.build_include_zones also skip, unread, every leaf whose recorded
+ * range of that column misses the filter.
+ */
+
+typedef struct SmolAggGroup
+{
+    bool        active;
+    int64       key;
+    int64       count;
+    int64       sum;            /* exact while it fits, see sum_ovf */
+    Datum       sum_ovf;        /* numeric carry once int64 overflows (0 = none) */
+    int64       min;
+    int64       max;
+} SmolAggGroup;
+
+typedef struct SmolAggState
+{
+    ReturnSetInfo *rsinfo;
+    bool        have_value;     /* aggregating an INCLUDE column */
+    bool        have_lower;
+    bool        have_upper;
+    int64       lower;
+    int64       upper;
+    bool        done;           /* passed the upper bound */
+    bool        have_filter;    /* rows must have filter_lower <= INCLUDE value <= filter_upper */
+    int64       filter_lower;
+    int64       filter_upper;
+    MemoryContext group_cxt;    /* per-group numerics, reset after each emitted row */
+    SmolAggGroup g;
+} SmolAggState;
+
+static inline int64
+smol_agg_read_int(const char *p, uint16 len)
+{
+    if (len == 2)
+    { int16 v; memcpy(&v, p, 2); return v; }
+    if (len == 4)
+    { int32 v; memcpy(&v, p, 4); return v; }
+    { int64 v; memcpy(&v, p, 8); return v; }
+}
+
+/* Leaf readers see every row, so they need what a full-table SELECT needs */
+void
+smol_agg_check_access(Relation idx, const char *fname)
+{
+    Oid         heapoid = idx->rd_index->indrelid;
+    AclResult   aclresult = pg_class_aclcheck(heapoid, GetUserId(), ACL_SELECT);
+
+    if (aclresult != ACLCHECK_OK)
+        aclcheck_error(aclresult, OBJECT_TABLE, get_rel_name(heapoid));
+    if (check_enable_rls(heapoid, InvalidOid, false) == RLS_ENABLED)
+        ereport(ERROR,
+                (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                 errmsg("%s cannot read table \"%s\" under row-level security",
+                        fname, get_rel_name(heapoid))));
+}
+
+static void
+smol_agg_emit(SmolAggState *st)
+{
+    SmolAggGroup *g = &st->g;
+    Datum       values[5];
+    bool        nulls[5] = {false, false, false, false, false};
+    MemoryContext oldcxt = MemoryContextSwitchTo(st->group_cxt);
+
+    values[0] = Int64GetDatum(g->key);
+    values[1] = Int64GetDatum(g->count);
+    if (st->have_value)
+    {
+        values[2] = NumericGetDatum(int64_to_numeric(g->sum));
+        if (g->sum_ovf != (Datum) 0)
+            values[2] = DirectFunctionCall2(numeric_add, g->sum_ovf, values[2]);
+        values[3] = Int64GetDatum(g->min);
+        values[4] = Int64GetDatum(g->max);
+    }
+    else
+        nulls[2] = nulls[3] = nulls[4] = true;
+    tuplestore_putvalues(st->rsinfo->setResult, st->rsinfo->setDesc, values, nulls);
+    MemoryContextSwitchTo(oldcxt);
+    MemoryContextReset(st->group_cxt);
+    g->active = false;
+}
+
+/* Fold cnt rows with key (and INCLUDE value) into the current group, unless
+ * their filter column value fvalue fails the filter */
+static void
+smol_agg_add(SmolAggState *st, int64 key, int64 value, int64 fvalue, int64 cnt)
+{
+    SmolAggGroup *g = &st->g;
+
+    if (st->have_lower && key < st->lower)
+        return;
+    if (st->have_upper && key > st->upper)
+    {
+        st->done = true;
+        return;
+    }
+    if (st->have_filter && (fvalue < st->filter_lower || fvalue > st->filter_upper))
+        return;
+    if (g->active && g->key != key)
+        smol_agg_emit(st);
+    if (!g->active)
+    {
+        g->active = true;
+        g->key = key;
+        g->count = 0;
+        g->sum = 0;
+        g->sum_ovf = (Datum) 0;
+        g->min = value;
+        g->max = value;
+    }
+    g->count += cnt;
+    if (st->have_value)
+    {
+        int64 prod, sum;
+
+        if (pg_mul_s64_overflow(value, cnt, &prod) || pg_add_s64_overflow(g->sum, prod, &sum))
+        {
+            /* Rare: carry the exact total in numeric from here on */
+            MemoryContext oldcxt = MemoryContextSwitchTo(st->group_cxt);
+            Datum part = DirectFunctionCall2(numeric_mul,
+                                             NumericGetDatum(int64_to_numeric(value)),
+                                             NumericGetDatum(int64_to_numeric(cnt)));
+
+            g->sum_ovf = (g->sum_ovf != (Datum) 0) ? DirectFunctionCall2(numeric_add, g->sum_ovf, part) : part;
+            MemoryContextSwitchTo(oldcxt);
+        }
+        else
+            g->sum = sum;
+        if (value < g->min) g->min = value;
+        if (value > g->max) g->max = value;
+    }
+}
+
+PG_FUNCTION_INFO_V1(smol_group_agg);
+
+Datum
+smol_group_agg(PG_FUNCTION_ARGS)
+{
+    Oid         indexoid;
+    int32       inc_col;
+    Relation    idx;
+    SmolMeta    meta;
+    Oid         keytyp;
+    uint16      key_len;
+    uint16      ninc;
+    uint16      val_len = 0;
+    uint32      val_off = 0;    /* bytes of earlier INCLUDE columns per row */
+    int32       filter_col = 0;
+    uint16      flt_len = 0;
+    uint32      flt_off = 0;
+    int         flt_zone = -1;  /* filter column in the INCLUDE zones */
+    uint32      inc_total = 0;
+    int64       tmax;
+    BlockNumber blk;
+    BufferAccessStrategy strategy;
+    Buffer      zbuf = InvalidBuffer;
+    SmolAggState st;
+
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+    indexoid = PG_GETARG_OID(0);
+
+    memset(&st, 0, sizeof(st));
+    InitMaterializedSRF(fcinfo, 0);
+    st.rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    st.have_lower = !PG_ARGISNULL(2);
+    st.lower = st.have_lower ? PG_GETARG_INT64(2) : 0;
+    st.have_upper = !PG_ARGISNULL(3);
+    st.upper = st.have_upper ? PG_GETARG_INT64(3) : 0;
+
+    idx = index_open(indexoid, AccessShareLock);
+    if (idx->rd_rel->relam != get_index_am_oid("smol", false))
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("\"%s\" is not a smol index", RelationGetRelationName(idx))));
+    smol_agg_check_access(idx, "smol_group_agg");
+    smol_meta_read(idx, &meta);
+    keytyp = TupleDescAttr(RelationGetDescr(idx), 0)->atttypid;
+    key_len = meta.key_len1;
+    ninc = meta.inc_count;
+    /* Default: the first INCLUDE column, or counts only when there is none */
+    inc_col = PG_ARGISNULL(1) ? (ninc > 0 ? 1 : 0) : PG_GETARG_INT32(1);
+    if (meta.nkeyatts != 1 || !(keytyp == INT2OID || keytyp == INT4OID || keytyp == INT8OID))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("smol_group_agg requires a single-column int2, int4 or int8 index")));
+    if (inc_col < 0 || inc_col > ninc)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("INCLUDE column %d is out of range for index \"%s\" (it has %u)",
+                        inc_col, RelationGetRelationName(idx), ninc)));
+    for (uint16 i = 0; i < ninc; i++)
+        inc_total += meta.inc_len[i];
+    if (inc_col > 0)
+    {
+        Oid inctyp = TupleDescAttr(RelationGetDescr(idx), inc_col)->atttypid;
+
+        if (!(inctyp == INT2OID || inctyp == INT4OID || inctyp == INT8OID))
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("smol_group_agg can only aggregate int2, int4 or int8 INCLUDE columns")));
+        st.have_value = true;
+        val_len = meta.inc_len[inc_col - 1];
+        for (int i = 0; i < inc_col - 1; i++)
+            val_off += meta.inc_len[i];
+    }
+    if (!PG_ARGISNULL(4))
+    {
+        Oid flttyp;
+
+        filter_col = PG_GETARG_INT32(4);
+        if (filter_col < 1 || filter_col > ninc)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("INCLUDE column %d is out of range for index \"%s\" (it has %u)",
+                            filter_col, RelationGetRelationName(idx), ninc)));
+        flttyp = TupleDescAttr(RelationGetDescr(idx), filter_col)->atttypid;
+        if (!(flttyp == INT2OID || flttyp == INT4OID || flttyp == INT8OID))
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("smol_group_agg can only filter on int2, int4 or int8 INCLUDE columns")));
+        st.have_filter = true;
+        st.filter_lower = PG_ARGISNULL(5) ? PG_INT64_MIN : PG_GETARG_INT64(5);
+        st.filter_upper = PG_ARGISNULL(6) ? PG_INT64_MAX : PG_GETARG_INT64(6);
+        flt_len = meta.inc_len[filter_col - 1];
+        for (int i = 0; i < filter_col - 1; i++)
+            flt_off += meta.inc_len[i];
+        if (smol_meta_has_inc_zones(&meta))
+            flt_zone = smol_inc_zone_col(&meta, filter_col - 1);
+    }
+    /* The plain-key search takes bounds in the key type's range */
+    tmax = key_len == 2 ? PG_INT16_MAX : key_len == 4 ? PG_INT32_MAX : PG_INT64_MAX;
+    if (st.have_lower && st.lower <= -tmax - 1)
+        st.have_lower = false;
+    if (st.have_lower && st.lower > tmax)
+        st.done = true;
+    st.group_cxt = AllocSetContextCreate(CurrentMemoryContext, "smol_group_agg",
+                                         ALLOCSET_SMALL_SIZES);
+
+    strategy = GetAccessStrategy(BAS_BULKREAD);
+    blk = (meta.height == 0) ? InvalidBlockNumber
+        : smol_find_first_leaf(idx, st.have_lower ? st.lower : PG_INT64_MIN, keytyp, key_len);
+
+    while (BlockNumberIsValid(blk) && !st.done)
+    {
+        Buffer      buf;
+        Page        page;
+        char       *p;
+        uint16      tag;
+
+        CHECK_FOR_INTERRUPTS();
+        if (flt_zone >= 0)
+        {
+            /* Step over a leaf whose range of the filter column misses the filter */
+            const SmolIncZoneSlot *z = smol_inc_zone_slot(idx, &meta, blk, &zbuf);
+
+            if (z != NULL && BlockNumberIsValid(z->next) &&
+                (z->bounds[2 * flt_zone] > st.filter_upper || z->bounds[2 * flt_zone + 1] < st.filter_lower))
+            {
+                blk = z->next;
+                continue;
+            }
+        }
+        buf = ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, strategy);
+        page = BufferGetPage(buf);
+        p = smol1_payload(page);
+        memcpy(&tag, p, sizeof(uint16));
+
+        if (tag == SMOL_TAG_INC_RLE)
+        {
+            /* [tag][nitems][nruns] runs of [key][u16 cnt][inc1][inc2]... */
+            uint16 nruns;
+            char *rp = p + sizeof(uint16) * 3;
+
+            memcpy(&nruns, p + sizeof(uint16) * 2, sizeof(uint16));
+            for (uint16 r = 0; r < nruns && !st.done; r++)
+            {
+                uint16 cnt;
+
+                memcpy(&cnt, rp + key_len, sizeof(uint16));
+                smol_agg_add(&st, smol_agg_read_int(rp, key_len),
+                             st.have_value ? smol_agg_read_int(rp + key_len + sizeof(uint16) + val_off, val_len) : 0,
+                             st.have_filter ? smol_agg_read_int(rp + key_len + sizeof(uint16) + flt_off, flt_len) : 0,
+                             cnt);
+                rp += key_len + sizeof(uint16) + inc_total;
+            }
+        }
+        else if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2)
+        {
+            /* [tag][nitems][nruns][continues_byte if V2] runs of [key][u16 cnt] */
+            uint16 nruns;
+            char *rp = p + sizeof(uint16) * 3 + (tag == SMOL_TAG_KEY_RLE_V2 ? 1 : 0);
+
+            SMOL_DEFENSIVE_CHECK(ninc == 0, ERROR,
+                                (errmsg("smol: key-RLE leaf in an index with INCLUDE columns")));
+            memcpy(&nruns, p + sizeof(uint16) * 2, sizeof(uint16));
+            for (uint16 r = 0; r < nruns && !st.done; r++)
+            {
+                uint16 cnt;
+
+                memcpy(&cnt, rp + key_len, sizeof(uint16));
+                smol_agg_add(&st, smol_agg_read_int(rp, key_len), 0, 0, cnt);
+                rp += key_len + sizeof(uint16);
+            }
+        }
+        else if (tag == SMOL_TAG_KEY_FOR)
+        {
+            /* Frame-of-reference keys: locate the lower bound, then extract in order */
+            SmolForLeaf f;
+            uint16 i = 0;
+
+            SMOL_DEFENSIVE_CHECK(ninc == 0, ERROR,
+                                (errmsg("smol: FOR leaf in an index with INCLUDE columns")));
+            smol_for_open(p, &f);
+            if (st.have_lower)
+                i = smol_for_search_int(p, st.lower, false);
+            for (; i < f.nitems && !st.done; i++)
+                smol_agg_add(&st, smol_for_value(&f, i), 0, 0, 1);
+        }
+        else if (tag == SMOL_TAG_INC_DICT)
+        {
+            /* Plain keys; the value column may be dictionary-coded */
+            uint16 n;
+            char *keys = smol_leaf_plain_keys(page, &n);
+            SmolIncDictCol col = {0};
+            SmolIncDictCol fcol = {0};
+            uint16 i = 0;
+
+            if (st.have_value)
+                smol_incdict_col(p, (uint16) (inc_col - 1), val_len, &col);
+            if (st.have_filter)
+                smol_incdict_col(p, (uint16) (filter_col - 1), flt_len, &fcol);
+            if (st.have_lower)
+                i = smol_leaf_search_int(keys, n, key_len, st.lower, false, NULL);
+            for (; i < n && !st.done; i++)
+                smol_agg_add(&st, smol_agg_read_int(keys + (size_t) i * key_len, key_len),
+                             st.have_value ? smol_agg_read_int(smol_incdict_value(&col, i, val_len), val_len) : 0,
+                             st.have_filter ? smol_agg_read_int(smol_incdict_value(&fcol, i, flt_len), flt_len) : 0,
+                             1);
+        }
+        else
+        {
+            /* Plain: [u16 n][keys][inc1 block][inc2 block]... */
+            uint16 n;
+            char *keys = smol_leaf_plain_keys(page, &n);
+            char *vals = keys + (size_t) n * key_len + (size_t) n * val_off;
+            char *fvals = keys + (size_t) n * key_len + (size_t) n * flt_off;
+            uint16 i = 0;
+
+            if (st.have_lower)
+                i = smol_leaf_search_int(keys, n, key_len, st.lower, false, NULL);
+            for (; i < n && !st.done; i++)
+                smol_agg_add(&st, smol_agg_read_int(keys + (size_t) i * key_len, key_len),
+                             st.have_value ? smol_agg_read_int(vals + (size_t) i * val_len, val_len) : 0,
+                             st.have_filter ? smol_agg_read_int(fvals + (size_t) i * flt_len, flt_len) : 0,
+                             1);
+        }
+
+        blk = smol_page_opaque(page)->rightlink;
+        ReleaseBuffer(buf);
+    }
+    if (st.g.active)
+        smol_agg_emit(&st);
+
+    if (BufferIsValid(zbuf))
+        ReleaseBuffer(zbuf);
+    FreeAccessStrategy(strategy);
+    MemoryContextDelete(st.group_cxt);
+    index_close(idx, AccessShareLock);
+    return (Datum) 0;
+}
+
+/*
+ * smol_distinct(idx, lower_key, upper_key) - distinct leading keys
+ *
+ * Returns each leading key of an integer SMOL index once, with the smallest
+ * second key of its group for two-column indexes: SELECT DISTINCT k, or
+ * SELECT k, min(k2) ... GROUP BY k, at one step per key instead of per row.
+ * RLE leaves yield one entry per run, the other layouts binary-search to
+ * the next larger key, and a key that runs on past its leaf is skipped with
+ * a descent when groups are long (see smol_skip_target).  Access is checked
+ * as for smol_group_agg.
+ */
+
+typedef struct SmolDistinctState
+{
+    ReturnSetInfo *rsinfo;
+    bool        have_lower;
+    bool        have_upper;
+    int64       lower;
+    int64       upper;
+    bool        have_last;
+    int64       last;           /* last key reported */
+    bool        done;
+} SmolDistinctState;
+
+/* True while k does not need to be reported: not above the last key or below the lower bound */
+static inline bool
+smol_distinct_behind(const SmolDistinctState *st, int64 k)
+{
+    return st->have_last ? k <= st->last : (st->have_lower && k < st->lower);
+}
+
+/* Report key k with the first k2 of its group (NULL for one column); false once past the upper bound */
+static bool
+smol_distinct_put(SmolDistinctState *st, int64 k, const int64 *k2)
+{
+    Datum       values[2];
+    bool        nulls[2] = {false, k2 == NULL};
+
+    if (st->have_upper && k > st->upper)
+    {
+        st->done = true;
+        return false;
+    }
+    values[0] = Int64GetDatum(k);
+    values[1] = k2 ? Int64GetDatum(*k2) : (Datum) 0;
+    tuplestore_putvalues(st->rsinfo->setResult, st->rsinfo->setDesc, values, nulls);
+    st->have_last = true;
+    st->last = k;
+    return true;
+}
+
+/* First position of n sorted plain integer keys still to report */
+static uint16
+smol_distinct_seek_plain(const SmolDistinctState *st, const char *keys, uint16 n, uint16 key_len)
+{
+    if (st->have_last)
+        return smol_leaf_search_int(keys, n, key_len, st->last, true, NULL);
+    if (st->have_lower)
+        return smol_leaf_search_int(keys, n, key_len, st->lower, false, NULL);
+    return 0;
+}
+
+/* First 0-based two-column row at or after 'from' whose k1 is still to report */
+static uint32
+smol_distinct_seek_rows(const SmolDistinctState *st, Page page, uint32 from, uint16 n,
+                        uint16 key_len, uint16 key_len2, uint32 inc_total)
+{
+    uint32 lo = from, hi = n;
+
+    while (lo < hi)
+    {
+        uint32 mid = lo + ((hi - lo) >> 1);
+
+        if (smol_distinct_behind(st, smol_for_load_key(smol12_row_k1_ptr(page, (uint16) (mid + 1), key_len,
+                                                                         key_len2, inc_total), key_len)))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+PG_FUNCTION_INFO_V1(smol_distinct);
+
+Datum
+smol_distinct(PG_FUNCTION_ARGS)
+{
+    Oid         indexoid;
+    Relation    idx;
+    SmolMeta    meta;
+    Oid         keytyp;
+    Oid         keytyp2 = InvalidOid;
+    uint16      key_len;
+    uint32      inc_total = 0;
+    int64       tmax;
+    bool        wide;
+    BlockNumber blk;
+    BufferAccessStrategy strategy;
+    SmolDistinctState st;
+
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+    indexoid = PG_GETARG_OID(0);
+
+    memset(&st, 0, sizeof(st));
+    InitMaterializedSRF(fcinfo, 0);
+    st.rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    st.have_lower = !PG_ARGISNULL(1);
+    st.lower = st.have_lower ? PG_GETARG_INT64(1) : 0;
+    st.have_upper = !PG_ARGISNULL(2);
+    st.upper = st.have_upper ? PG_GETARG_INT64(2) : 0;
+
+    idx = index_open(indexoid, AccessShareLock);
+    if (idx->rd_rel->relam != get_index_am_oid("smol", false))
+        ereport(ERROR,
+                (errcode(ERRCODE_WRONG_OBJECT_TYPE),
+                 errmsg("\"%s\" is not a smol index", RelationGetRelationName(idx))));
+    smol_agg_check_access(idx, "smol_distinct");
+    smol_meta_read(idx, &meta);
+    keytyp = TupleDescAttr(RelationGetDescr(idx), 0)->atttypid;
+    if (meta.nkeyatts == 2)
+        keytyp2 = TupleDescAttr(RelationGetDescr(idx), 1)->atttypid;
+    if (!smol_type_is_plain_int(keytyp) || (meta.nkeyatts == 2 && !smol_type_is_plain_int(keytyp2)))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("smol_distinct requires an index whose key columns are int2, int4 or int8")));
+    key_len = meta.key_len1;
+    for (uint16 i = 0; i < meta.inc_count; i++)
+        inc_total += meta.inc_len[i];
+
+    /* The plain-key search takes bounds in the key type's range */
+    tmax = key_len == 2 ? PG_INT16_MAX : key_len == 4 ? PG_INT32_MAX : PG_INT64_MAX;
+    if (st.have_lower && st.lower <= -tmax - 1)
+        st.have_lower = false;
+    if (st.have_lower && st.lower > tmax)
+        st.done = true;
+
+    /* Fewer distinct keys than leaves: keys run over several leaves on average */
+    wide = (meta.stat_distinct > 0 && meta.stat_distinct < (double) meta.stat_leaves);
+    strategy = GetAccessStrategy(BAS_BULKREAD);
+    blk = (meta.height == 0) ? InvalidBlockNumber
+        : smol_find_first_leaf(idx, st.have_lower ? st.lower : PG_INT64_MIN, keytyp, key_len);
+
+    while (BlockNumberIsValid(blk) && !st.done)
+    {
+        Buffer      buf;
+        Page        page;
+        BlockNumber next;
+        int64       first = PG_INT64_MIN;
+
+        CHECK_FOR_INTERRUPTS();
+        buf = ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, strategy);
+        page = BufferGetPage(buf);
+
+        if (meta.nkeyatts == 2)
+        {
+            uint16 n = smol12_leaf_nrows(page);
+
+            if (n > 0)
+                first = smol_for_load_key(smol12_row_k1_ptr(page, 1, key_len, meta.key_len2, inc_total), key_len);
+            for (uint32 i = smol_distinct_seek_rows(&st, page, 0, n, key_len, meta.key_len2, inc_total); i < n;
+                 i = smol_distinct_seek_rows(&st, page, i + 1, n, key_len, meta.key_len2, inc_total))
+            {
+                uint16 row = (uint16) (i + 1);
+                int64 k2 = smol_for_load_key(smol12_row_k2_ptr(page, row, key_len, meta.key_len2, inc_total),
+                                             meta.key_len2);
+
+                if (!smol_distinct_put(&st, smol_for_load_key(smol12_row_k1_ptr(page, row, key_len, meta.key_len2,
+                                                                                 inc_total), key_len), &k2))
+                    break;
+            }
+        }
+        else
+        {
+            char *p = smol1_payload(page);
+            uint16 tag;
+
+            memcpy(&tag, p, sizeof(uint16));
+            if (tag == SMOL_TAG_INC_RLE || tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2)
+            {
+                /* [tag][nitems][nruns][continues_byte if V2] runs of [key][u16 cnt][INCLUDE values] */
+                uint16 nruns;
+                char *rp = p + sizeof(uint16) * 3 + (tag == SMOL_TAG_KEY_RLE_V2 ? 1 : 0);
+                Size stride = key_len + sizeof(uint16) + (tag == SMOL_TAG_INC_RLE ? inc_total : 0);
+
+                memcpy(&nruns, p + sizeof(uint16) * 2, sizeof(uint16));
+                if (nruns > 0)
+                    first = smol_agg_read_int(rp, key_len);
+                for (uint16 r = 0; r < nruns; r++, rp += stride)
+                {
+                    int64 k = smol_agg_read_int(rp, key_len);
+
+                    if (!smol_distinct_behind(&st, k) && !smol_distinct_put(&st, k, NULL))
+                        break;
+                }
+            }
+            else if (tag == SMOL_TAG_KEY_FOR)
+            {
+                SmolForLeaf f;
+
+                smol_for_open(p, &f);
+                if (f.nitems > 0)
+                    first = smol_for_value(&f, 0);
+                for (uint16 i = st.have_last ? smol_for_search_int(p, st.last, true)
+                                             : st.have_lower ? smol_for_search_int(p, st.lower, false) : 0;
+                     i < f.nitems; i = smol_for_search_int(p, st.last, true))
+                {
+                    if (!smol_distinct_put(&st, smol_for_value(&f, i), NULL))
+                        break;
+                }
+            }
+            else
+            {
+                /* Plain keys, also the key array of a dictionary-coded INCLUDE leaf */
+                uint16 n;
+                char *keys = smol_leaf_plain_keys(page, &n);
+
+                if (n > 0)
+                    first = smol_agg_read_int(keys, key_len);
+                for (uint16 i = smol_distinct_seek_plain(&st, keys, n, key_len); i < n;
+                     i = smol_distinct_seek_plain(&st, keys, n, key_len))
+                {
+                    if (!smol_distinct_put(&st, smol_agg_read_int(keys + (size_t) i * key_len, key_len), NULL))
+                        break;
+                }
+            }
+        }
+
+        next = smol_page_opaque(page)->rightlink;
+        ReleaseBuffer(buf);
+        /* The last key may fill the next leaves too: descend past it when keys are long-running */
+        if (!st.done && st.have_last && (wide || first == st.last))
+        {
+            BlockNumber target = smol_skip_target(idx, st.last, keytyp, key_len, next);
+
+            if (BlockNumberIsValid(target))
+                next = target;
+        }
+        blk = next;
+    }
+
+    FreeAccessStrategy(strategy);
+    index_close(idx, AccessShareLock);
+    return (Datum) 0;
+}
@@ -25,11 +25,203 @@ smol_meta_read(Relation idx, SmolMeta *out)
               out->root_blkno, out->height, out->zone_maps_enabled, out->bloom_enabled);
 }
 
+/*
+ * Backend-local tree cache
+ *
+ * Every descent used to read the metapage and each internal page through the
+ * buffer manager.  A built SMOL tree never changes in place, so each backend
+ * keeps the metapage and the internal pages it has visited, decoded into
+ * SmolZoneItem arrays, for up to smol.tree_cache_pages pages per index.
+ * Entries are keyed by index OID and checked against the relfilenumber, so a
+ * REINDEX or TRUNCATE reads the new tree; smol_append and smol_compact, which
+ * rewrite the upper levels of the same relfilenumber, drop the entry and send
+ * a relcache invalidation that the relcache callback turns into a drop in
+ * every other backend.  Those rewrites are in place and survive an abort, so
+ * the invalidation is sent at once rather than queued for commit.
+ */
+typedef struct SmolTreeCacheEntry
+{
+    Oid         relid;          /* hash key: index OID */
+    RelFileNumber relnumber;    /* storage the entry was read from */
+    SmolMeta    meta;
+    MemoryContext cxt;          /* holds the node table and the nodes */
+    HTAB       *nodes;          /* BlockNumber -> SmolTreeNodeEntry */
+    uint32      nnodes;
+} SmolTreeCacheEntry;
+
+typedef struct SmolTreeNodeEntry
+{
+    BlockNumber blk;            /* hash key */
+    SmolTreeNode *node;
+} SmolTreeNodeEntry;
+
+static HTAB *smol_tree_cache = NULL;
+
+static void
+smol_tree_cache_drop(SmolTreeCacheEntry *e)
+{
+    MemoryContextDelete(e->cxt);
+    (void) hash_search(smol_tree_cache, &e->relid, HASH_REMOVE, NULL);
+}
+
+/* Relcache callback: drop the entry of an invalidated index, or all on a cache reset */
+static void
+smol_tree_cache_callback(Datum arg, Oid relid)
+{
+    SmolTreeCacheEntry *e;
+
+    if (smol_tree_cache == NULL)
+        return;
+    if (OidIsValid(relid))
+    {
+        e = (SmolTreeCacheEntry *) hash_search(smol_tree_cache, &relid, HASH_FIND, NULL);
+        if (e)
+            smol_tree_cache_drop(e);
+    }
+    else
+    {
+        HASH_SEQ_STATUS st;
+
+        hash_seq_init(&st, smol_tree_cache);
+        while ((e = (SmolTreeCacheEntry *) hash_seq_search(&st)) != NULL)
+            smol_tree_cache_drop(e);
+    }
+}
+
+void
+smol_tree_cache_register(void)
+{
+    CacheRegisterRelcacheCallback(smol_tree_cache_callback, (Datum) 0);
+}
+
+/*
+ * Drop this backend's entry and every other backend's now.  Other backends
+ * act on it when they next lock the index, which waits for the caller's lock.
+ */
+void
+smol_tree_cache_invalidate(Relation idx)
+{
+    smol_tree_cache_callback((Datum) 0, RelationGetRelid(idx));
+    CacheInvalidateRelcacheImmediate(RelationGetRelid(idx));
+}
+
+/* The cache entry of idx, created with its metapage on first use; NULL when the cache is off */
+static SmolTreeCacheEntry *
+smol_tree_cache_lookup(Relation idx)
+{
+    Oid         relid = RelationGetRelid(idx);
+    SmolTreeCacheEntry *e;
+    SmolMeta    meta;
+    MemoryContext cxt;
+    HASHCTL     ctl;
+    HTAB       *nodes;
+
+    if (smol_tree_cache_pages <= 0)
+        return NULL;
+    if (smol_tree_cache == NULL)
+    {
+        ctl.keysize = sizeof(Oid);
+        ctl.entrysize = sizeof(SmolTreeCacheEntry);
+        ctl.hcxt = CacheMemoryContext;
+        smol_tree_cache = hash_create("smol tree cache", 16, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+    }
+    e = (SmolTreeCacheEntry *) hash_search(smol_tree_cache, &relid, HASH_FIND, NULL);
+    if (e && e->relnumber == idx->rd_locator.relNumber)
+        return e;
+    if (e)
+        smol_tree_cache_drop(e);
+
+    smol_meta_read(idx, &meta);
+    if (meta.magic != SMOL_META_MAGIC)
+        return NULL; /* GCOV_EXCL_LINE - defensive: not a built SMOL index */
+    cxt = AllocSetContextCreate(CacheMemoryContext, "smol tree cache entry", ALLOCSET_SMALL_SIZES);
+    ctl.keysize = sizeof(BlockNumber);
+    ctl.entrysize = sizeof(SmolTreeNodeEntry);
+    ctl.hcxt = cxt;
+    nodes = hash_create("smol tree cache nodes", 64, &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+    e = (SmolTreeCacheEntry *) hash_search(smol_tree_cache, &relid, HASH_ENTER, NULL);
+    e->relnumber = idx->rd_locator.relNumber;
+    e->meta = meta;
+    e->cxt = cxt;
+    e->nodes = nodes;
+    e->nnodes = 0;
+    return e;
+}
+
+/* Metapage of idx, from the tree cache when it is on */
+void
+smol_meta_get(Relation idx, SmolMeta *out)
+{
+    SmolTreeCacheEntry *e = smol_tree_cache_lookup(idx);
+
+    if (e)
+        *out = e->meta;
+    else
+        smol_meta_read(idx, out);
+}
+
+/*
+ * smol_node_open - open internal page blk for a descent; returns its item
+ * count.  Cached pages are served from memory; a page seen for the first
+ * time is decoded into the cache while there is room, and otherwise stays
+ * pinned until smol_node_close.
+ */
+OffsetNumber
+smol_node_open(Relation idx, const SmolMeta *meta, BlockNumber blk, SmolNodeView *v)
+{
+    SmolTreeCacheEntry *e = smol_tree_cache_lookup(idx);
+    SmolTreeNodeEntry *ne;
+    SmolTreeNode *node;
+    OffsetNumber maxoff;
+
+    v->node = NULL;
+    v->buf = InvalidBuffer;
+    v->page = NULL;
+    v->meta = meta;
+    if (e)
+    {
+        ne = (SmolTreeNodeEntry *) hash_search(e->nodes, &blk, HASH_FIND, NULL);
+        if (ne)
+        {
+            v->node = ne->node;
+            return ne->node->nitems;
+        }
+    }
+
+    v->buf = ReadBuffer(idx, blk);
+    v->page = BufferGetPage(v->buf);
+    maxoff = PageGetMaxOffsetNumber(v->page);
+    if (e == NULL || e->nnodes >= (uint32) smol_tree_cache_pages)
+        return maxoff;
+
+    node = (SmolTreeNode *) MemoryContextAlloc(e->cxt, offsetof(SmolTreeNode, items) +
+                                               (Size) maxoff * sizeof(SmolZoneItem));
+    node->nitems = maxoff;
+    for (OffsetNumber off = FirstOffsetNumber; off <= maxoff; off++)
+        smol_internal_item_read(v->page, off, &e->meta, &node->items[off - 1]);
+    ne = (SmolTreeNodeEntry *) hash_search(e->nodes, &blk, HASH_ENTER, NULL);
+    ne->node = node;
+    e->nnodes++;
+    ReleaseBuffer(v->buf);
+    v->buf = InvalidBuffer;
+    v->page = NULL;
+    v->node = node;
+    return node->nitems;
+}
+
+void
+smol_node_close(SmolNodeView *v)
+{
+    if (BufferIsValid(v->buf))
+        ReleaseBuffer(v->buf);
+    v->buf = InvalidBuffer;
+}
+
 /*
  * smol_meta_init_zone_maps - Initialize zone map fields in metapage
  *
- * Called after basic metapage fields are set to configure zone maps
- * based on current GUC settings.
+ * Called after basic metapage fields (including key_len1) are set to
+ * configure zone maps based on current GUC settings.
  */
 void
 smol_meta_init_zone_maps(SmolMeta *meta)
@@ -37,7 +229,18 @@ smol_meta_init_zone_maps(SmolMeta *meta)
     meta->zone_maps_enabled = smol_build_zone_maps;
     meta->bloom_enabled = smol_build_bloom_filters;
     meta->bloom_nhash = (uint8) smol_bloom_nhash;
-    meta->padding = 0;
+    /* Per-leaf bloom pages are written after the tree, if at all */
+    meta->leaf_bloom_words = 0;
+    meta->leaf_bloom_blkno = InvalidBlockNumber;
+    meta->leaf_bloom_first = InvalidBlockNumber;
+    meta->leaf_bloom_nslots = 0;
+    meta->inc_zone_mask = 0;
+    meta->inc_zone_ncols = 0;
+    meta->inc_zone_blkno = InvalidBlockNumber;
+    meta->inc_zone_first = InvalidBlockNumber;
+    meta->inc_zone_nslots = 0;
+    /* Keys up to 8 bytes fit a zone key whole; wider keys keep a 16-byte prefix */
+    meta->zkey_len = (meta->key_len1 > 8) ? SMOL_ZKEY_MAX : 8;
 }
 
 void
@@ -87,16 +290,22 @@ smol_extend(Relation idx)
 }
 
 void
-smol_init_page(Buffer buf, bool leaf, BlockNumber rightlink)
+smol_init_page_image(Page page, bool leaf, BlockNumber rightlink)
 {
-    Page page;
     SmolPageOpaqueData *op;
-    page = BufferGetPage(buf);
     PageInit(page, BLCKSZ, sizeof(SmolPageOpaqueData));
     op = smol_page_opaque(page);
     op->flags = leaf ? SMOL_F_LEAF : SMOL_F_INTERNAL;
     op->rightlink = rightlink;
     op->leftlink = InvalidBlockNumber;  /* Will be set when linking siblings */
+    op->heap_nblocks = 0;               /* heap range unknown until the writer records it */
+    op->heap_lo = InvalidBlockNumber;
+}
+
+void
+smol_init_page(Buffer buf, bool leaf, BlockNumber rightlink)
+{
+    smol_init_page_image(BufferGetPage(buf), leaf, rightlink);
     SMOL_LOGF("init page blk=%u leaf=%d rl=%u",
               BufferGetBlockNumber(buf), leaf ? 1 : 0, rightlink);
 }
@@ -125,295 +334,568 @@ smol_link_siblings(Relation idx, BlockNumber prev, BlockNumber cur)
     SMOL_LOGF("linked siblings: %u <- -> %u", prev, cur);
 }
 
-BlockNumber
-smol_find_first_leaf(Relation idx, int64 lower_bound, Oid atttypid, uint16 key_len)
+void
+smol_leaf_writer_begin(SmolLeafWriter *w, Relation idx, bool bulk)
 {
-    SmolMeta meta;
-    smol_meta_read(idx, &meta);
-    BlockNumber cur = meta.root_blkno;
-    uint16 levels = meta.height;
+    memset(w, 0, sizeof(*w));
+    w->idx = idx;
+    w->buf = InvalidBuffer;
+    w->blkno = InvalidBlockNumber;
+    if (bulk)
+    {
+        /* No WAL, like the buffered path; smgr_bulk_finish() fsyncs instead */
+        w->bulk = smgr_bulk_start_smgr(RelationGetSmgr(idx), MAIN_FORKNUM, false);
+        w->next_blkno = RelationGetNumberOfBlocks(idx);
+    }
+}
 
-    /* For zone map filtering - we only have lower_bound, not full SmolScanOpaque */
-    bool use_zone_maps = (smol_zone_maps && meta.zone_maps_enabled);
+/* Write out the held leaf now that its right sibling is known */
+static void
+smol_leaf_writer_flush(SmolLeafWriter *w, BlockNumber rightlink)
+{
+    if (!BlockNumberIsValid(w->blkno))
+        return;
+    if (w->bulk)
+    {
+        smol_page_opaque((Page) w->page)->rightlink = rightlink;
+        smgr_bulk_write(w->bulk, w->blkno, w->page, true);
+        w->page = NULL;
+    }
+    else
+    {
+        smol_page_opaque(BufferGetPage(w->buf))->rightlink = rightlink;
+        MarkBufferDirty(w->buf);
+        UnlockReleaseBuffer(w->buf);
+        w->buf = InvalidBuffer;
+    }
+}
 
-    while (levels > 1)
+Page
+smol_leaf_writer_next(SmolLeafWriter *w)
+{
+    BlockNumber prev = w->blkno, cur;
+    Page page;
+
+    if (w->bulk)
     {
-        Buffer buf = ReadBuffer(idx, cur);
-        Page page = BufferGetPage(buf);
-        OffsetNumber maxoff = PageGetMaxOffsetNumber(page);
-        BlockNumber child = InvalidBlockNumber;
+        BulkWriteBuffer nb = smgr_bulk_get_buf(w->bulk);
+        cur = w->next_blkno++;
+        smol_leaf_writer_flush(w, cur);
+        w->page = nb;
+        page = (Page) nb;
+        smol_init_page_image(page, true, InvalidBlockNumber);
+    }
+    else
+    {
+        Buffer nb = smol_extend(w->idx);
+        cur = BufferGetBlockNumber(nb);
+        smol_leaf_writer_flush(w, cur);
+        w->buf = nb;
+        smol_init_page(nb, true, InvalidBlockNumber);
+        page = BufferGetPage(nb);
+    }
+    smol_page_opaque(page)->leftlink = prev;
+    w->blkno = cur;
+    return page;
+}
 
-        /* Binary search for first child where highkey >= lower_bound */
-        OffsetNumber lo = FirstOffsetNumber, hi = maxoff;
-        while (lo <= hi)
-        {
-            OffsetNumber mid = (OffsetNumber) (lo + ((hi - lo) >> 1));
-            char *itp = (char *) PageGetItem(page, PageGetItemId(page, mid));
+void
+smol_leaf_writer_finish(SmolLeafWriter *w)
+{
+    smol_leaf_writer_flush(w, InvalidBlockNumber);
+    w->blkno = InvalidBlockNumber;
+    if (w->bulk)
+    {
+        smgr_bulk_finish(w->bulk);
+        w->bulk = NULL;
+    }
+}
 
-            /* New format: SmolInternalItem with highkey first, then child */
-            SmolInternalItem item;
-            memcpy(&item, itp, sizeof(SmolInternalItem));
+/*
+ * ========================================================================
+ * Order-Preserving Key Normalization
+ * ========================================================================
+ *
+ * Each fixed-width opclass of smol--1.0.sql except interval, timetz and name
+ * (and C-collation text packed to a multiple of 8 bytes) maps to uint64 words
+ * whose unsigned order, first word most significant, is the opclass order.
+ * Signed types flip their sign bit, floats fold -0 into +0 and every NaN onto
+ * the largest word before the usual sign-magnitude flip, and byte-string
+ * types read big-endian.  Keys that compare equal get equal words, so one
+ * image serves the radix build, zone keys and float bloom hashing.
+ */
 
-            /* highkey is now at offset 0 as int32 */
-            int cmp = ((int64)item.highkey > lower_bound) ? 1 : (((int64)item.highkey < lower_bound) ? -1 : 0);
-            if (cmp >= 0)
-            {
-                child = item.child;
-                if (mid == FirstOffsetNumber) break;
-                hi = (OffsetNumber) (mid - 1);
-            }
-            else
-                lo = (OffsetNumber) (mid + 1);
-        }
-        if (!BlockNumberIsValid(child))
-        {
-            /* choose rightmost child */
-            char *itp = (char *) PageGetItem(page, PageGetItemId(page, maxoff));
-            SmolInternalItem item;
-            memcpy(&item, itp, sizeof(SmolInternalItem));
-            child = item.child;
-        }
+/* Natural on-disk length of a normalizable fixed-width type, else 0 */
+static uint16
+smol_norm_type_len(Oid typid)
+{
+    switch (typid)
+    {
+        case BOOLOID:
+        case CHAROID:
+            return 1;
+        case INT2OID:
+            return 2;
+        case INT4OID:
+        case DATEOID:
+        case OIDOID:
+        case FLOAT4OID:
+            return 4;
+        case MACADDROID:
+            return 6;
+        case INT8OID:
+        case TIMEOID:
+        case TIMESTAMPOID:
+        case TIMESTAMPTZOID:
+        case CASHOID:
+        case LSNOID:
+        case FLOAT8OID:
+        case MACADDR8OID:
+            return 8;
+        case UUIDOID:
+            return UUID_LEN;
+        default:
+            return 0;
+    }
+}
 
-        /* Zone map filtering for range scans (lower bound only)
-         * After binary search finds first candidate, scan forward to find first subtree that can match
-         * NOTE: We keep the rightmost child as fallback to maintain existing behavior for edge cases */
-        if (BlockNumberIsValid(child) && use_zone_maps)
-        {
-            OffsetNumber start_off = lo;
-            BlockNumber rightmost_child = child;
+/*
+ * smol_norm_nwords - words in the normalized image of a key_len-byte key,
+ * or 0 when the type has none
+ */
+int
+smol_norm_nwords(Oid typid, uint16 key_len)
+{
+    uint16 len;
+
+    if (typid == TEXTOID)
+        return (key_len > 0 && key_len % sizeof(uint64) == 0) ? key_len / sizeof(uint64) : 0;
+    len = smol_norm_type_len(typid);
+    if (len == 0 || len != key_len)
+        return 0;
+    return (len + sizeof(uint64) - 1) / sizeof(uint64);
+}
 
-            /* Save rightmost child before filtering */
+/* Big-endian load of a (possibly short) byte string into the top of a word */
+static inline uint64
+smol_norm_be(const char *p, int len)
+{
+    uint64 w = 0;
+
+    if (len == (int) sizeof(uint64))
+    {
+        memcpy(&w, p, sizeof(uint64));
+        return pg_ntoh64(w);
+    }
+    for (int i = 0; i < len; i++)
+        w |= (uint64) (uint8) p[i] << (56 - 8 * i);
+    return w;
+}
+
+/*
+ * smol_norm_key - normalized image of an on-disk key
+ *
+ * Writes smol_norm_nwords() words to out; callers check that it is nonzero.
+ */
+void
+smol_norm_key(const char *key, uint16 key_len, Oid typid, uint64 *out)
+{
+    switch (typid)
+    {
+        case BOOLOID:
+        case CHAROID:
+            out[0] = (uint8) key[0];
+            break;
+        case INT2OID:
             {
-                char *itp = (char *) PageGetItem(page, PageGetItemId(page, maxoff));
-                SmolInternalItem item;
-                memcpy(&item, itp, sizeof(SmolInternalItem));
-                rightmost_child = item.child;
+                int16 v;
+
+                memcpy(&v, key, sizeof(int16));
+                out[0] = smol_norm64((int64) v);
+                break;
             }
+        case INT4OID:
+        case DATEOID:
+            {
+                int32 v;
 
-            bool found_match = false;
-            for (OffsetNumber off = start_off; off <= maxoff; off++)
+                memcpy(&v, key, sizeof(int32));
+                out[0] = smol_norm64((int64) v);
+                break;
+            }
+        case OIDOID:
             {
-                char *itp = (char *) PageGetItem(page, PageGetItemId(page, off));
-                SmolInternalItem item;
-                memcpy(&item, itp, sizeof(SmolInternalItem));
+                uint32 v;
 
-                /* Simple zone map check: subtree's max >= lower_bound */
-                if ((int64)item.highkey >= lower_bound)
+                memcpy(&v, key, sizeof(uint32));
+                out[0] = v;
+                break;
+            }
+        case LSNOID:
+            memcpy(&out[0], key, sizeof(uint64));
+            break;
+        case FLOAT4OID:
+            {
+                float4 f;
+                uint32 u;
+
+                memcpy(&f, key, sizeof(float4));
+                if (isnan(f))
                 {
-                    child = item.child;
-                    found_match = true;
+                    out[0] = PG_UINT32_MAX;
                     break;
                 }
+                if (f == 0.0f)
+                    f = 0.0f;   /* -0 compares equal to +0 */
+                memcpy(&u, &f, sizeof(uint32));
+                out[0] = (u & 0x80000000U) ? (uint32) ~u : (u | 0x80000000U);
+                break;
             }
+        case FLOAT8OID:
+            {
+                float8 f;
+                uint64 u;
 
-            /* If no match found, use rightmost child (maintains existing behavior for unbounded scans) */
-            if (!found_match)
-                child = rightmost_child;
-        }
+                memcpy(&f, key, sizeof(float8));
+                if (isnan(f))
+                {
+                    out[0] = PG_UINT64_MAX;
+                    break;
+                }
+                if (f == 0.0)
+                    f = 0.0;
+                memcpy(&u, &f, sizeof(uint64));
+                out[0] = (u & UINT64_C(0x8000000000000000)) ? ~u : (u | UINT64_C(0x8000000000000000));
+                break;
+            }
+        case MACADDROID:
+            out[0] = smol_norm_be(key, 6);
+            break;
+        case TEXTOID:
+        case MACADDR8OID:
+        case UUIDOID:
+            for (int w = 0; w < key_len / (int) sizeof(uint64); w++)
+                out[w] = smol_norm_be(key + w * sizeof(uint64), sizeof(uint64));
+            break;
+        default:
+            {
+                /* INT8, TIME, TIMESTAMP(TZ), MONEY */
+                int64 v;
 
-        ReleaseBuffer(buf);
-        cur = child;
-        levels--;
+                memcpy(&v, key, sizeof(int64));
+                out[0] = smol_norm64(v);
+                break;
+            }
     }
-    SMOL_LOGF("find_first_leaf: leaf=%u for bound=%ld height=%u", cur, (long) lower_bound, meta.height);
+}
 
-#ifdef SMOL_TEST_COVERAGE
-    /* TEST ONLY: Offset the result backwards to force scanning through multiple leaves */
-    if (smol_test_leaf_offset > 0 && cur > (BlockNumber) smol_test_leaf_offset)
+/*
+ * smol_datum_key_bytes - on-disk bytes of a key Datum of this opclass
+ *
+ * Pass-by-value keys are copied into buf the way the build stores them;
+ * pass-by-reference keys are returned in place.
+ */
+const char *
+smol_datum_key_bytes(Datum d, uint16 key_len, bool byval, char *buf)
+{
+    if (!byval)
+        return (const char *) DatumGetPointer(d);
+    switch (key_len)
     {
-        cur = cur - (BlockNumber) smol_test_leaf_offset;
-        SMOL_LOGF("TEST: find_first_leaf adjusted by -%d, returning leaf=%u", smol_test_leaf_offset, cur);
+        case 1: { char v = DatumGetChar(d); memcpy(buf, &v, 1); break; }
+        case 2: { int16 v = DatumGetInt16(d); memcpy(buf, &v, 2); break; }
+        case 4: { int32 v = DatumGetInt32(d); memcpy(buf, &v, 4); break; }
+        default: { int64 v = DatumGetInt64(d); memcpy(buf, &v, 8); break; }
     }
-#endif
-
-    return cur;
+    return buf;
 }
 
 /*
- * smol_subtree_can_match - Check if a subtree can contain matching rows
- *
- * Uses zone map metadata (min/max keys, bloom filter) to prune entire subtrees
- * that provably cannot contain rows matching the scan predicates.
+ * ========================================================================
+ * Normalized Zone Keys
+ * ========================================================================
  *
- * Returns true if the subtree might contain matches (must descend),
- * false if it definitely has no matches (skip subtree).
+ * Internal items store subtree min/max keys as byte strings whose memcmp
+ * order is the key order, so navigation and pruning share one comparison
+ * for every key type (see SmolInternalItemV6).
  */
-static inline bool
-smol_subtree_can_match(SmolInternalItem *item, SmolScanOpaque so, SmolMeta *meta)
-{
-    /* Skip if zone map filtering disabled */
-    if (!smol_zone_maps || !meta->zone_maps_enabled)
-        return true; /* GCOV_EXCL_LINE (hard to test: generic path only for TEXT, but TEXT queries need collation setup) */
 
-#ifdef SMOL_TEST_COVERAGE
-    /* Disable zone map filtering when testing page-level bloom filters
-     * to avoid interference between the two mechanisms */
-    if (smol_test_force_bloom_rejection)
-    {                                    /* GCOV_EXCL_LINE (defensive: prevents interference, never true during TEXT queries) */
-        elog(DEBUG1, "Zone map filtering disabled due to test GUC"); /* GCOV_EXCL_LINE */
-        return true;                     /* GCOV_EXCL_LINE */
+/* True for key types stored as a signed 2/4/8-byte integer in key order */
+bool
+smol_zkey_type_is_int64(Oid typid)
+{
+    switch (typid)
+    {
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+        case DATEOID:
+        case TIMEOID:
+        case TIMESTAMPOID:
+        case TIMESTAMPTZOID:
+            return true;
+        default:
+            return false;
     }
-#endif
-
-    /* TEMPORARY: Disable filtering for TEXT types until we implement proper byte comparison
-     * The current int32 comparison doesn't handle lexicographic ordering correctly for text prefixes.
-     * TODO: Implement proper byte-wise comparison or use a hash-based approach for TEXT filtering. */
-    if (so->atttypid == TEXTOID)
-        return true;
+}
 
-    /* Lower bound check: if subtree's max < lower_bound, skip entire subtree */ /* GCOV_EXCL_START (unreachable: only called for TEXT, which returns early above) */
-    if (so->have_bound)
+/* int64 image of a scan bound for smol_find_first_leaf(); dflt for other types */
+int64
+smol_bound_to_int64(Oid typid, Datum bound, int64 dflt)
+{
+    switch (typid)
     {
-        int32 bound_prefix = 0;
-
-        /* Extract 32-bit prefix from bound for comparison */
-        if (so->atttypid == INT2OID)
-            bound_prefix = (int32)DatumGetInt16(so->bound_datum);
-        else if (so->atttypid == INT4OID)
-            bound_prefix = DatumGetInt32(so->bound_datum);
-        else if (so->atttypid == INT8OID)
-            bound_prefix = (int32)DatumGetInt64(so->bound_datum); /* Truncate to 32-bit */
-        else if (so->atttypid == TEXTOID && so->key_len >= 4)
+        case INT2OID:
+            return (int64) DatumGetInt16(bound);
+        case INT4OID:
+        case DATEOID:
+            return (int64) DatumGetInt32(bound);
+        case INT8OID:
+        case TIMEOID:
+        case TIMESTAMPOID:
+        case TIMESTAMPTZOID:
+            return DatumGetInt64(bound);
+        default:
+            return dflt;
+    }
+}
+
+/* Zone key of a signed integer: smol_norm64() in big-endian byte order */
+void
+smol_zkey_from_int64(uint8 *out, int64 v)
+{
+    uint64 be = pg_hton64(smol_norm64(v));
+
+    memcpy(out, &be, sizeof(uint64));
+}
+
+/* Zone key of normalized words: big-endian, truncated to zkey_len bytes */
+static void
+smol_zkey_from_norm(uint8 *out, uint16 zkey_len, const uint64 *words, int nwords)
+{
+    for (int w = 0; w < nwords && w * (int) sizeof(uint64) < zkey_len; w++)
+    {
+        uint64 be = pg_hton64(words[w]);
+
+        memcpy(out + w * sizeof(uint64), &be, Min((int) sizeof(uint64), zkey_len - w * (int) sizeof(uint64)));
+    }
+}
+
+/*
+ * smol_zkey_from_keyptr - zone key of an on-disk key
+ *
+ * Integer-like types are widened and normalized, other normalizable types
+ * store their smol_norm_key() words; text keeps its leading bytes, which is
+ * the key order under C collation.
+ */
+void
+smol_zkey_from_keyptr(uint8 *out, uint16 zkey_len, const char *keyp, uint16 key_len, Oid typid)
+{
+    int nwords = (typid == TEXTOID) ? 0 : smol_norm_nwords(typid, key_len);
+
+    memset(out, 0, zkey_len);
+    if (smol_zkey_type_is_int64(typid))
+    {
+        int64 v;
+
+        if (key_len == 2)
         {
-            text *t = DatumGetTextPP(so->bound_datum);
-            const char *str = VARDATA_ANY(t);
-            int len = VARSIZE_ANY_EXHDR(t);
-            if (len >= 4)
-                memcpy(&bound_prefix, str, 4);
-            else if (len > 0)
-                memcpy(&bound_prefix, str, len);
+            int16 t;
+            memcpy(&t, keyp, sizeof(int16));
+            v = t;
         }
-
-        /* If subtree's maxkey < lower_bound, skip */
-        if (item->highkey < bound_prefix || (so->bound_strict && item->highkey == bound_prefix))
+        else if (key_len == 4)
         {
-            if (so->prof_enabled)
-                so->prof_subtrees_skipped++;
-            return false;
+            int32 t;
+            memcpy(&t, keyp, sizeof(int32));
+            v = t;
         }
+        else
+            memcpy(&v, keyp, sizeof(int64));
+        smol_zkey_from_int64(out, v);
     }
+    else if (nwords > 0)
+    {
+        uint64 words[2];
 
-    /* Upper bound check: if subtree's min > upper_bound, skip entire subtree */
-    if (so->have_upper_bound)
+        smol_norm_key(keyp, key_len, typid, words);
+        smol_zkey_from_norm(out, zkey_len, words, nwords);
+    }
+    else
+        memcpy(out, keyp, Min(zkey_len, key_len));
+}
+
+/*
+ * smol_scan_bound_zkey - zone key of the scan's lower (or upper) bound
+ *
+ * Returns false when internal items cannot be compared with the bound (the
+ * type has no order-preserving image, or text under a non-C collation);
+ * callers then descend leftmost and skip pruning.  *exact is set when equal
+ * zone keys imply equal keys, which strict bounds need in order to prune.
+ * Legacy indexes compare against the same truncated int32 prefix they were
+ * built with.
+ */
+bool
+smol_scan_bound_zkey(SmolScanOpaque so, const SmolMeta *meta, bool upper, uint8 *out, bool *exact)
+{
+    Datum d = upper ? so->upper_bound_datum : so->bound_datum;
+    uint16 zkey_len = smol_meta_zkey_len(meta);
+
+    memset(out, 0, SMOL_ZKEY_MAX);
+    *exact = false;
+
+    if (!smol_meta_wide_keys(meta))
     {
-        int32 upper_prefix = 0;
+        int32 prefix = 0;
 
-        /* Extract 32-bit prefix from upper bound */
         if (so->atttypid == INT2OID)
-            upper_prefix = (int32)DatumGetInt16(so->upper_bound_datum);
+            prefix = (int32) DatumGetInt16(d);
         else if (so->atttypid == INT4OID)
-            upper_prefix = DatumGetInt32(so->upper_bound_datum);
-        else if (so->atttypid == INT8OID)
-            upper_prefix = (int32)DatumGetInt64(so->upper_bound_datum);
+            prefix = DatumGetInt32(d);
         else if (so->atttypid == TEXTOID && so->key_len >= 4)
         {
-            text *t = DatumGetTextPP(so->upper_bound_datum);
-            const char *str = VARDATA_ANY(t);
+            text *t = DatumGetTextPP(d);
             int len = VARSIZE_ANY_EXHDR(t);
-            if (len >= 4)
-                memcpy(&upper_prefix, str, 4);
-            else if (len > 0)
-                memcpy(&upper_prefix, str, len);
+            memcpy(&prefix, VARDATA_ANY(t), Min(len, (int) sizeof(int32)));
         }
-
-        /* If subtree's minkey > upper_bound, skip */
-        if (item->minkey > upper_prefix || (so->upper_bound_strict && item->minkey == upper_prefix))
-        {
-            if (so->prof_enabled)
-                so->prof_subtrees_skipped++;
+        else
             return false;
-        }
+        smol_zkey_from_int64(out, (int64) prefix);
+        *exact = (so->atttypid != TEXTOID);
+        return true;
     }
 
-    /* Bloom filter check for equality predicates */
-    if (so->have_k1_eq && smol_bloom_filters && meta->bloom_enabled)
+    if (smol_zkey_type_is_int64(so->atttypid))
     {
-        if (so->prof_enabled)
-            so->prof_bloom_checks++;
+        smol_zkey_from_int64(out, smol_bound_to_int64(so->atttypid, d, 0));
+        *exact = true;
+        return true;
+    }
+    if (so->atttypid == UUIDOID && zkey_len >= UUID_LEN)
+    {
+        memcpy(out, DatumGetUUIDP(d)->data, UUID_LEN);
+        *exact = true;
+        return true;
+    }
+    if (so->atttypid == TEXTOID && !so->use_generic_cmp)
+    {
+        text *t = DatumGetTextPP(d);
+        int len = VARSIZE_ANY_EXHDR(t);
 
-        if (!smol_bloom_test(item->bloom_filter, so->bound_datum, so->atttypid, meta->bloom_nhash))
-        {
-            /* Definitely not in this subtree */
-            if (so->prof_enabled)
-            {
-                so->prof_subtrees_skipped++;
-                so->prof_bloom_skips++;
-            }
+        memcpy(out, VARDATA_ANY(t), Min(len, (int) zkey_len));
+        *exact = (len <= zkey_len && so->key_len <= zkey_len);
+        return true;
+    }
+    /* Floats, oid, money, lsn, bool, "char" and macaddr(8) since v11 */
+    if (meta->version >= SMOL_META_VERSION_NORM_KEYS && so->atttypid != TEXTOID)
+    {
+        int nwords = smol_norm_nwords(so->atttypid, so->key_len);
+        char buf[sizeof(int64)];
+        uint64 words[2];
+
+        if (nwords == 0)
             return false;
-        }
+        smol_norm_key(smol_datum_key_bytes(d, so->key_len, so->key_byval, buf), so->key_len,
+                      so->atttypid, words);
+        smol_zkey_from_norm(out, zkey_len, words, nwords);
+        *exact = (nwords * (int) sizeof(uint64) <= zkey_len);
+        return true;
     }
+    return false;
+}
 
-    /* Subtree might contain matches */
-    if (so->prof_enabled)
-        so->prof_subtrees_checked++;
-    return true;
-} /* GCOV_EXCL_STOP */
+/* Decode internal item 'off' of an internal page in either on-disk layout */
+void
+smol_internal_item_read(Page page, OffsetNumber off, const SmolMeta *meta, SmolZoneItem *out)
+{
+    const char *itp = (const char *) PageGetItem(page, PageGetItemId(page, off));
+
+    if (smol_meta_wide_keys(meta))
+    {
+        SmolInternalItemV6 hdr;
+        uint16 zkey_len = meta->zkey_len;
+
+        memcpy(&hdr, itp, sizeof(SmolInternalItemV6));
+        out->child = hdr.child;
+        out->row_count = hdr.row_count;
+        out->distinct_count = hdr.distinct_count;
+        out->bloom_filter = hdr.bloom_filter;
+        memcpy(out->highkey, itp + sizeof(SmolInternalItemV6), zkey_len);
+        memcpy(out->minkey, itp + sizeof(SmolInternalItemV6) + zkey_len, zkey_len);
+    }
+    else
+    {
+        SmolInternalItem item;
+
+        memcpy(&item, itp, sizeof(SmolInternalItem));
+        out->child = item.child;
+        out->row_count = item.row_count;
+        out->distinct_count = item.distinct_count;
+        out->bloom_filter = item.bloom_filter;
+        smol_zkey_from_int64(out->highkey, (int64) item.highkey);
+        smol_zkey_from_int64(out->minkey, (int64) item.minkey);
+    }
+}
+
+/* Encode an internal item in the SmolInternalItemV6 layout; returns its size */
+Size
+smol_internal_item_write(char *dst, const SmolZoneItem *item, const SmolMeta *meta)
+{
+    SmolInternalItemV6 hdr;
+    uint16 zkey_len = meta->zkey_len;
+
+    SMOL_DEFENSIVE_CHECK(smol_meta_wide_keys(meta) && zkey_len > 0 && zkey_len <= SMOL_ZKEY_MAX, ERROR,
+        (errmsg("smol: cannot write internal items for metapage version %u", meta->version)));
+    memset(&hdr, 0, sizeof(SmolInternalItemV6));
+    hdr.child = item->child;
+    hdr.row_count = item->row_count;
+    hdr.distinct_count = item->distinct_count;
+    hdr.bloom_filter = item->bloom_filter;
+    memcpy(dst, &hdr, sizeof(SmolInternalItemV6));
+    memcpy(dst + sizeof(SmolInternalItemV6), item->highkey, zkey_len);
+    memcpy(dst + sizeof(SmolInternalItemV6) + zkey_len, item->minkey, zkey_len);
+    return sizeof(SmolInternalItemV6) + 2 * (Size) zkey_len;
+}
 
-/* Generic version of smol_find_first_leaf that supports all key types including text.
- * Uses SmolScanOpaque's comparison context to correctly handle text/varchar types.
- *
- * NOTE: Internal nodes store only the first 4 bytes of keys as int32 (truncated highkey).
- * For text and other variable-width types, we compare using the truncated prefix.
- * This is sufficient for navigation - leaf pages have the full keys for exact matching.
- */
 BlockNumber
-smol_find_first_leaf_generic(Relation idx, SmolScanOpaque so)
+smol_find_first_leaf(Relation idx, int64 lower_bound, Oid atttypid, uint16 key_len)
 {
     SmolMeta meta;
-    smol_meta_read(idx, &meta);
+    smol_meta_get(idx, &meta);
     BlockNumber cur = meta.root_blkno;
     uint16 levels = meta.height;
+    uint16 zkey_len = smol_meta_zkey_len(&meta);
+    uint8 bkey[SMOL_ZKEY_MAX];
 
-    /* Extract first 4 bytes of our bound for comparison with truncated highkeys */
-    int32 bound_prefix = 0;
-    if (so->have_bound)
-    {
-        if (so->atttypid == INT2OID)
-            bound_prefix = (int32)DatumGetInt16(so->bound_datum); /* GCOV_EXCL_LINE (flaky)  */
-        else if (so->atttypid == INT4OID)
-            bound_prefix = DatumGetInt32(so->bound_datum); /* GCOV_EXCL_LINE (flaky)  */
-        else if (so->atttypid == INT8OID)
-            bound_prefix = (int32)DatumGetInt64(so->bound_datum); /* GCOV_EXCL_LINE (flaky)  */
-        else if (so->atttypid == TEXTOID && so->key_len >= 4)
-        {
-            /* For text, extract first 4 bytes of the text data */
-            text *t = DatumGetTextPP(so->bound_datum);
-            const char *str = VARDATA_ANY(t);
-            int len = VARSIZE_ANY_EXHDR(t);
-            if (len >= 4)
-                memcpy(&bound_prefix, str, 4);
-            else if (len > 0)
-                memcpy(&bound_prefix, str, len); /* Partial, rest is zero */
-        }
-        else /* GCOV_EXCL_START - Dead code: only TEXTOID reaches this function */
-        {
-            /* For other types, try to extract first 4 bytes */
-            memcpy(&bound_prefix, &so->bound_datum, Min(sizeof(int32), sizeof(Datum)));
-        } /* GCOV_EXCL_STOP */
-    }
+    /* For zone map filtering - we only have lower_bound, not full SmolScanOpaque */
+    bool use_zone_maps = (smol_zone_maps && meta.zone_maps_enabled);
+
+    /*
+     * v6 zone keys have an int64 image for every integer-like type; legacy
+     * int32 items only for the types that always stored one.  For the rest an
+     * all-zero key sorts before every highkey and the descent stays leftmost.
+     */
+    memset(bkey, 0, sizeof(bkey));
+    if (smol_meta_wide_keys(&meta) ? smol_zkey_type_is_int64(atttypid)
+                                   : (atttypid == INT2OID || atttypid == INT4OID ||
+                                      atttypid == INT8OID || atttypid == DATEOID))
+        smol_zkey_from_int64(bkey, lower_bound);
 
     while (levels > 1)
     {
-        Buffer buf = ReadBuffer(idx, cur);
-        Page page = BufferGetPage(buf);
-        OffsetNumber maxoff = PageGetMaxOffsetNumber(page);
+        SmolNodeView node;
+        OffsetNumber maxoff = smol_node_open(idx, &meta, cur, &node);
         BlockNumber child = InvalidBlockNumber;
+        SmolZoneItem item;
 
         /* Binary search for first child where highkey >= lower_bound */
         OffsetNumber lo = FirstOffsetNumber, hi = maxoff;
         while (lo <= hi)
         {
             OffsetNumber mid = (OffsetNumber) (lo + ((hi - lo) >> 1));
-            char *itp = (char *) PageGetItem(page, PageGetItemId(page, mid));
-
-            /* New format: SmolInternalItem with 4-byte truncated highkey */
-            SmolInternalItem item;
-            memcpy(&item, itp, sizeof(SmolInternalItem));
-
-            /* Compare truncated highkey with truncated bound */
-            int cmp = (item.highkey > bound_prefix) ? 1 : ((item.highkey < bound_prefix) ? -1 : 0);
 
-            if (cmp >= 0)
+            smol_node_item(&node, mid, &item);
+            if (memcmp(item.highkey, bkey, zkey_len) >= 0)
             {
                 child = item.child;
                 if (mid == FirstOffsetNumber) break;
@@ -422,177 +904,469 @@ smol_find_first_leaf_generic(Relation idx, SmolScanOpaque so)
             else
                 lo = (OffsetNumber) (mid + 1);
         }
-        if (!BlockNumberIsValid(child)) /* GCOV_EXCL_START - defensive: rightmost child when all keys < lower_bound */
+        if (!BlockNumberIsValid(child))
         {
             /* choose rightmost child */
-            char *itp = (char *) PageGetItem(page, PageGetItemId(page, maxoff));
-            SmolInternalItem item;
-            memcpy(&item, itp, sizeof(SmolInternalItem));
+            smol_node_item(&node, maxoff, &item);
             child = item.child;
-        } /* GCOV_EXCL_STOP */
+        }
 
-        /* Zone map filtering: After finding first candidate child, verify it can match */
-        if (BlockNumberIsValid(child) && smol_zone_maps && meta.zone_maps_enabled)
+        /* Zone map filtering for range scans (lower bound only)
+         * After binary search finds first candidate, scan forward to find first subtree that can match
+         * NOTE: We keep the rightmost child as fallback to maintain existing behavior for edge cases */
+        if (BlockNumberIsValid(child) && use_zone_maps)
         {
-            /* Scan forward from the candidate child to find first subtree that can match */
-            OffsetNumber start_off = lo; /* lo points to where we found the child */
-            bool found_match = false;
+            OffsetNumber start_off = lo;
+            BlockNumber rightmost_child;
+
+            /* Save rightmost child before filtering */
+            smol_node_item(&node, maxoff, &item);
+            rightmost_child = item.child;
 
+            bool found_match = false;
             for (OffsetNumber off = start_off; off <= maxoff; off++)
             {
-                char *itp = (char *) PageGetItem(page, PageGetItemId(page, off));
-                SmolInternalItem item;
-                memcpy(&item, itp, sizeof(SmolInternalItem));
+                smol_node_item(&node, off, &item);
 
-                if (smol_subtree_can_match(&item, so, &meta))
+                /* Simple zone map check: subtree's max >= lower_bound */
+                if (memcmp(item.highkey, bkey, zkey_len) >= 0)
                 {
-                    /* Found a subtree that might contain matches */
                     child = item.child;
                     found_match = true;
                     break;
                 }
             }
 
-            /* If no subtree can match, this query has no results */
+            /* If no match found, use rightmost child (maintains existing behavior for unbounded scans) */
             if (!found_match)
-            {                           /* GCOV_EXCL_LINE (TEXT always matches, so found_match is always true and body never executes) */
-                ReleaseBuffer(buf);     /* GCOV_EXCL_LINE */
-                return InvalidBlockNumber; /* GCOV_EXCL_LINE */
-            }
+                child = rightmost_child;
         }
 
-        ReleaseBuffer(buf);
+        smol_node_close(&node);
         cur = child;
         levels--;
     }
-    SMOL_LOGF("find_first_leaf_generic: leaf=%u height=%u", cur, meta.height);
+    SMOL_LOGF("find_first_leaf: leaf=%u for bound=%ld height=%u", cur, (long) lower_bound, meta.height);
+
+#ifdef SMOL_TEST_COVERAGE
+    /* TEST ONLY: Offset the result backwards to force scanning through multiple leaves */
+    if (smol_test_leaf_offset > 0 && cur > (BlockNumber) smol_test_leaf_offset)
+    {
+        cur = cur - (BlockNumber) smol_test_leaf_offset;
+        SMOL_LOGF("TEST: find_first_leaf adjusted by -%d, returning leaf=%u", smol_test_leaf_offset, cur);
+    }
+#endif
+
     return cur;
 }
 
-/* GCOV_EXCL_START - unused function, kept for future reference */
-/* Find leaf containing values around upper bound for backward scans. */
-BlockNumber __attribute__((unused))
-smol_find_leaf_for_upper_bound(Relation idx, SmolScanOpaque so)
+/*
+ * smol_subtree_can_match - Check if a subtree can contain matching rows
+ *
+ * Uses zone map metadata (min/max keys, bloom filter) to prune entire subtrees
+ * that provably cannot contain rows matching the scan predicates.
+ *
+ * Returns true if the subtree might contain matches (must descend),
+ * false if it definitely has no matches (skip subtree).
+ */
+static inline bool
+smol_subtree_can_match(SmolZoneItem *item, SmolScanOpaque so, SmolMeta *meta)
 {
-    SmolMeta meta;
-    smol_meta_read(idx, &meta);
-    BlockNumber cur = meta.root_blkno;
-    uint16 levels = meta.height;
-    while (levels > 1)
+    uint16 zkey_len = smol_meta_zkey_len(meta);
+    uint8 key[SMOL_ZKEY_MAX];
+    bool exact;
+
+    /* Skip if zone map filtering disabled */
+    if (!smol_zone_maps || !meta->zone_maps_enabled)
+        return true; /* GCOV_EXCL_LINE (hard to test: generic path only for TEXT, but TEXT queries need collation setup) */
+
+#ifdef SMOL_TEST_COVERAGE
+    /* Disable zone map filtering when testing page-level bloom filters
+     * to avoid interference between the two mechanisms */
+    if (smol_test_force_bloom_rejection)
+    {                                    /* GCOV_EXCL_LINE (defensive: prevents interference, never true during TEXT queries) */
+        elog(DEBUG1, "Zone map filtering disabled due to test GUC"); /* GCOV_EXCL_LINE */
+        return true;                     /* GCOV_EXCL_LINE */
+    }
+#endif
+
+    /* Legacy int32 prefixes do not order text, so only v6 items can prune it */
+    if (!smol_meta_wide_keys(meta) && so->atttypid == TEXTOID)
+        return true;
+
+    /* Lower bound check: if subtree's max < lower_bound, skip entire subtree */
+    if (so->have_bound && smol_scan_bound_zkey(so, meta, false, key, &exact))
     {
-        Buffer buf = ReadBuffer(idx, cur);
-        Page page = BufferGetPage(buf);
-        OffsetNumber maxoff = PageGetMaxOffsetNumber(page);
-        BlockNumber child = InvalidBlockNumber;
-        /* Find rightmost child where separator key <= upper_bound */
-        /* Extract first 4 bytes of upper bound for comparison */
-        int32 upper_prefix = 0;
-        if (so->atttypid == INT2OID)
-            upper_prefix = (int32)DatumGetInt16(so->upper_bound_datum);
-        else if (so->atttypid == INT4OID)
-            upper_prefix = DatumGetInt32(so->upper_bound_datum);
-        else if (so->atttypid == INT8OID)
-            upper_prefix = (int32)(DatumGetInt64(so->upper_bound_datum) >> 32);
-        else if (so->atttypid == TEXTOID && so->key_len >= 4)
+        int c = memcmp(item->highkey, key, zkey_len);
+
+        /* Equal prefixes only rule out a strict bound when the zone key is the whole key */
+        if (c < 0 || (c == 0 && exact && so->bound_strict))
         {
-            text *t = DatumGetTextPP(so->upper_bound_datum);
-            const char *str = VARDATA_ANY(t);
-            int len = VARSIZE_ANY_EXHDR(t);
-            if (len >= 4)
-                memcpy(&upper_prefix, str, 4);
-            else if (len > 0)
-                memcpy(&upper_prefix, str, len);
+            so->prof_subtrees_skipped++;
+            return false;
         }
-        else
-            memcpy(&upper_prefix, &so->upper_bound_datum, Min(sizeof(int32), sizeof(Datum)));
+    }
 
-        for (OffsetNumber off = FirstOffsetNumber; off <= maxoff; off++)
+    /* Upper bound check: if subtree's min > upper_bound, skip entire subtree */
+    if (so->have_upper_bound && smol_scan_bound_zkey(so, meta, true, key, &exact))
+    {
+        int c = memcmp(item->minkey, key, zkey_len);
+
+        if (c > 0 || (c == 0 && exact && so->upper_bound_strict))
         {
-            char *itp = (char *) PageGetItem(page, PageGetItemId(page, off));
+            so->prof_subtrees_skipped++;
+            return false;
+        }
+    }
 
-            /* New format: SmolInternalItem with 4-byte truncated highkey */
-            SmolInternalItem item;
-            memcpy(&item, itp, sizeof(SmolInternalItem));
+    /* Equality: the subtree's min must not exceed the value either */
+    if (so->have_k1_eq && !so->have_upper_bound && smol_scan_bound_zkey(so, meta, false, key, &exact) &&
+        memcmp(item->minkey, key, zkey_len) > 0)
+    {
+        so->prof_subtrees_skipped++;
+        return false;
+    }
 
-            /* Compare truncated highkey with truncated upper bound */
-            int cmp = (item.highkey > upper_prefix) ? 1 : ((item.highkey < upper_prefix) ? -1 : 0);
+    /* Bloom filter check for equality predicates */
+    if (so->have_k1_eq && smol_scan_bloom_usable(so, meta))
+    {
+        so->prof_bloom_checks++;
 
-            if (so->upper_bound_strict ? (cmp >= 0) : (cmp > 0))
-            {
-                /* This child's separator > upper_bound, so values <= upper_bound must be in previous child */
-                break;
-            }
-            /* Separator <= upper_bound, remember this child and keep looking */
-            child = item.child;
-        }
-        if (!BlockNumberIsValid(child))
+        if (!smol_bloom_test(&item->bloom_filter, 64,
+                             smol_bloom_hash_bound(so->bound_datum, so->atttypid, so->key_len, so->key_byval),
+                             meta->bloom_nhash))
         {
-            /* All separators > upper_bound, use leftmost child */
-            char *itp = (char *) PageGetItem(page, PageGetItemId(page, FirstOffsetNumber));
-            SmolInternalItem item;
-            memcpy(&item, itp, sizeof(SmolInternalItem));
-            child = item.child;
+            /* Definitely not in this subtree */
+            so->prof_bloom_skips++;
+            return false;
         }
-        ReleaseBuffer(buf);
-        cur = child;
-        levels--;
     }
-    SMOL_LOGF("find_leaf_for_upper_bound: leaf=%u height=%u", cur, meta.height);
-    return cur;
+
+    /* Subtree might contain matches */
+    so->prof_subtrees_checked++;
+    return true;
 }
-/* GCOV_EXCL_STOP */
 
 /*
- * smol_find_end_position - Find the end position for position-based scans
+ * smol_find_probe_leaf - first leaf for an equality probe (so->bound_datum)
  *
- * Returns the (block, offset) of the first tuple that EXCEEDS the upper bound.
- * This is used as the exclusive end position for position-based scans.
- *
- * For upper_bound_strict=true (< operator):  find first tuple >= upper_bound
- * For upper_bound_strict=false (<= operator): find first tuple > upper_bound
+ * When the internal items' zone keys are exact for the probe (int2/int4 in
+ * legacy indexes; integer-like, uuid and short C-collation text keys in v6
+ * indexes), the child chosen at each level is the only subtree that can hold
+ * the probe and its zone map and bloom filter (and the leaf's own bloom, when
+ * the index has per-leaf bloom pages) can rule the probe out without
+ * reading any leaf (*absent_out = true).  Returns InvalidBlockNumber with
+ * *absent_out false when the probe is above every key in the index.  Other
+ * keys use the regular first-leaf search.
  */
-void
-smol_find_end_position(Relation idx, SmolScanOpaque so,
-                       BlockNumber *end_blk_out, OffsetNumber *end_off_out)
+BlockNumber
+smol_find_probe_leaf(Relation idx, SmolScanOpaque so, bool *absent_out)
 {
-    /* If no upper bound, end position is past the rightmost tuple */
-    if (!so->have_upper_bound)
+    SmolMeta meta;
+    BlockNumber cur;
+    uint16 levels;
+    uint16 zkey_len;
+    uint8 pkey[SMOL_ZKEY_MAX];
+    bool exact;
+    bool use_zone_maps;
+    bool use_bloom;
+    uint64 bloom_h = 0;
+
+    *absent_out = false;
+    smol_meta_get(idx, &meta);
+    if (!smol_scan_bound_zkey(so, &meta, false, pkey, &exact) || !exact)
     {
-        *end_blk_out = InvalidBlockNumber;
-        *end_off_out = InvalidOffsetNumber;
-        return;
+        if (so->atttypid == TEXTOID)
+        {
+            /* The generic search returns InvalidBlockNumber only when zone maps rule the probe out */
+            cur = smol_find_first_leaf_generic(idx, so);
+            *absent_out = !BlockNumberIsValid(cur);
+            return cur;
+        }
+        return smol_find_first_leaf(idx, smol_bound_to_int64(so->atttypid, so->bound_datum, PG_INT64_MIN),
+                                    so->atttypid, so->key_len);
     }
 
-    /* Find the leaf containing the upper bound */
-    BlockNumber leaf_blk;
+    cur = meta.root_blkno;
+    levels = meta.height;
+    zkey_len = smol_meta_zkey_len(&meta);
+    use_zone_maps = (smol_zone_maps && meta.zone_maps_enabled);
+    use_bloom = (use_zone_maps && smol_scan_bloom_usable(so, &meta));
+    if (use_bloom)
+        bloom_h = smol_bloom_hash_bound(so->bound_datum, so->atttypid, so->key_len, so->key_byval);
 
-    if (so->atttypid == TEXTOID)
-    {
-        /* For text types, we need to search from leftmost and scan forward
-         * to find the exact position. For now, disable position scan for text. */
-        *end_blk_out = InvalidBlockNumber;
-        *end_off_out = InvalidOffsetNumber;
-        return;
-    }
-    else
+    while (levels > 1)
     {
-        /* Integer types: use fast path to find approximate leaf */
-        int64 ub = 0;
-        if (so->atttypid == INT2OID)
-            ub = (int64) DatumGetInt16(so->upper_bound_datum);
-        else if (so->atttypid == INT4OID)
-            ub = (int64) DatumGetInt32(so->upper_bound_datum);
-        else if (so->atttypid == INT8OID)
-            ub = DatumGetInt64(so->upper_bound_datum);
+        SmolNodeView node;
+        OffsetNumber maxoff = smol_node_open(idx, &meta, cur, &node);
+        OffsetNumber lo = FirstOffsetNumber, hi = maxoff, found = InvalidOffsetNumber;
+        SmolZoneItem item;
 
-        leaf_blk = smol_find_first_leaf(idx, ub, so->atttypid, so->key_len);
-    }
-
-    /* Now binary search within this leaf and potentially subsequent leaves
-     * to find the first tuple that exceeds the upper bound */
-    Buffer buf = ReadBufferExtended(idx, MAIN_FORKNUM, leaf_blk, RBM_NORMAL, so->bstrategy);
-    Page page = BufferGetPage(buf);
-    uint16 nitems = smol_leaf_nitems(page);
+        /* First child whose highkey >= probe */
+        while (lo <= hi)
+        {
+            OffsetNumber mid = (OffsetNumber) (lo + ((hi - lo) >> 1));
+            smol_node_item(&node, mid, &item);
+            if (memcmp(item.highkey, pkey, zkey_len) >= 0)
+            {
+                found = mid;
+                if (mid == FirstOffsetNumber) break;
+                hi = (OffsetNumber) (mid - 1);
+            }
+            else
+                lo = (OffsetNumber) (mid + 1);
+        }
+        if (found == InvalidOffsetNumber)
+        {
+            if (cur == meta.root_blkno)
+            {
+                smol_node_close(&node);
+                return InvalidBlockNumber;  /* above every key */
+            }
+            found = maxoff; /* GCOV_EXCL_LINE - defensive: parent highkey bounds the subtree */
+        }
+        smol_node_item(&node, found, &item);
+        smol_node_close(&node);
+
+        if (use_zone_maps && memcmp(item.minkey, pkey, zkey_len) > 0)
+        {
+            so->prof_subtrees_skipped++;
+            *absent_out = true;
+            return InvalidBlockNumber;
+        }
+        if (use_bloom && item.bloom_filter != 0)
+        {
+            so->prof_bloom_checks++;
+            if (!smol_bloom_test(&item.bloom_filter, 64, bloom_h, meta.bloom_nhash))
+            {
+                so->prof_bloom_skips++;
+                *absent_out = true;
+                return InvalidBlockNumber;
+            }
+        }
+        cur = item.child;
+        levels--;
+    }
+
+    /* The probe can only be in this leaf: its own bloom may rule it out */
+    if (use_bloom && smol_meta_has_leaf_blooms(&meta))
+    {
+        so->prof_bloom_checks++;
+        if (!smol_leaf_bloom_test(idx, &meta, cur, bloom_h))
+        {
+            so->prof_bloom_skips++;
+            *absent_out = true;
+            return InvalidBlockNumber;
+        }
+    }
+    return cur;
+}
+
+/* Generic version of smol_find_first_leaf that supports all key types including text.
+ * Uses SmolScanOpaque's comparison context to correctly handle text/varchar types.
+ *
+ * NOTE: Internal items carry zone-key prefixes of the keys (16 bytes at most in
+ * v6 indexes, a truncated int32 in legacy ones).  Comparing prefixes is
+ * sufficient for navigation - leaf pages have the full keys for exact matching.
+ * Bounds without a usable zone key descend leftmost.
+ */
+BlockNumber
+smol_find_first_leaf_generic(Relation idx, SmolScanOpaque so)
+{
+    SmolMeta meta;
+    smol_meta_get(idx, &meta);
+    BlockNumber cur = meta.root_blkno;
+    uint16 levels = meta.height;
+    uint16 zkey_len = smol_meta_zkey_len(&meta);
+    uint8 bkey[SMOL_ZKEY_MAX];
+    bool exact;
+
+    /* Zone key of our bound for comparison with the items' highkeys */
+    if (!so->have_bound || !smol_scan_bound_zkey(so, &meta, false, bkey, &exact))
+        memset(bkey, 0, sizeof(bkey));
+
+    while (levels > 1)
+    {
+        SmolNodeView node;
+        OffsetNumber maxoff = smol_node_open(idx, &meta, cur, &node);
+        BlockNumber child = InvalidBlockNumber;
+        SmolZoneItem item;
+
+        /* Binary search for first child where highkey >= lower_bound */
+        OffsetNumber lo = FirstOffsetNumber, hi = maxoff;
+        while (lo <= hi)
+        {
+            OffsetNumber mid = (OffsetNumber) (lo + ((hi - lo) >> 1));
+
+            smol_node_item(&node, mid, &item);
+            if (memcmp(item.highkey, bkey, zkey_len) >= 0)
+            {
+                child = item.child;
+                if (mid == FirstOffsetNumber) break;
+                hi = (OffsetNumber) (mid - 1);
+            }
+            else
+                lo = (OffsetNumber) (mid + 1);
+        }
+        if (!BlockNumberIsValid(child)) /* GCOV_EXCL_START - defensive: rightmost child when all keys < lower_bound */
+        {
+            /* choose rightmost child */
+            smol_node_item(&node, maxoff, &item);
+            child = item.child;
+        } /* GCOV_EXCL_STOP */
+
+        /* Zone map filtering: After finding first candidate child, verify it can match */
+        if (BlockNumberIsValid(child) && smol_zone_maps && meta.zone_maps_enabled)
+        {
+            /* Scan forward from the candidate child to find first subtree that can match */
+            OffsetNumber start_off = lo; /* lo points to where we found the child */
+            bool found_match = false;
+
+            for (OffsetNumber off = start_off; off <= maxoff; off++)
+            {
+                smol_node_item(&node, off, &item);
+
+                if (smol_subtree_can_match(&item, so, &meta))
+                {
+                    /* Found a subtree that might contain matches */
+                    child = item.child;
+                    found_match = true;
+                    break;
+                }
+            }
+
+            /* If no subtree can match, this query has no results */
+            if (!found_match)
+            {
+                smol_node_close(&node);
+                return InvalidBlockNumber;
+            }
+        }
+
+        smol_node_close(&node);
+        cur = child;
+        levels--;
+    }
+    SMOL_LOGF("find_first_leaf_generic: leaf=%u height=%u", cur, meta.height);
+    return cur;
+}
+
+/*
+ * smol_find_leaf_for_upper_bound - leaf holding the last key that satisfies
+ * the scan's upper bound (the equality key when there is no upper bound);
+ * the rightmost leaf when the scan has neither.  Each level descends into
+ * the first child whose high key exceeds the bound: every key at or below
+ * the bound lives in that child or to its left.  Exact strict bounds stop
+ * at the first high key >= bound, skipping leaves full of the bound value.
+ * Returns InvalidBlockNumber for an empty index.
+ */
+BlockNumber
+smol_find_leaf_for_upper_bound(Relation idx, SmolScanOpaque so)
+{
+    SmolMeta meta;
+    uint8 ukey[SMOL_ZKEY_MAX];
+    bool exact = false, bounded = false, strict = false;
+    uint16 zkey_len;
+    BlockNumber cur;
+    uint16 levels;
+
+    smol_meta_get(idx, &meta);
+    if (!BlockNumberIsValid(meta.root_blkno))
+        return InvalidBlockNumber;
+    zkey_len = smol_meta_zkey_len(&meta);
+    if (so->have_upper_bound)
+    {
+        bounded = smol_scan_bound_zkey(so, &meta, true, ukey, &exact);
+        strict = so->upper_bound_strict && exact;
+    }
+    else if (so->have_k1_eq)
+        bounded = smol_scan_bound_zkey(so, &meta, false, ukey, &exact);
+    /* Pre-v6 text prefixes do not sort like the keys: take the rightmost path */
+    if (bounded && !exact && !smol_meta_wide_keys(&meta))
+        bounded = false;
+
+    cur = meta.root_blkno;
+    levels = meta.height;
+    while (levels > 1)
+    {
+        SmolNodeView node;
+        OffsetNumber maxoff = smol_node_open(idx, &meta, cur, &node);
+        OffsetNumber off = maxoff;
+        SmolZoneItem item;
+
+        if (bounded)
+        {
+            /* High keys ascend: binary-search the first child past the bound */
+            OffsetNumber lo = FirstOffsetNumber, hi = maxoff;
+
+            while (lo < hi)
+            {
+                OffsetNumber mid = (OffsetNumber) (lo + ((hi - lo) >> 1));
+                int cmp;
+
+                smol_node_item(&node, mid, &item);
+                cmp = memcmp(item.highkey, ukey, zkey_len);
+                if (strict ? (cmp >= 0) : (cmp > 0))
+                    hi = mid;
+                else
+                    lo = (OffsetNumber) (mid + 1);
+            }
+            off = lo;
+        }
+        smol_node_item(&node, off, &item);
+        smol_node_close(&node);
+        cur = item.child;
+        levels--;
+    }
+    SMOL_LOGF("find_leaf_for_upper_bound: leaf=%u height=%u", cur, meta.height);
+    return cur;
+}
+
+/*
+ * smol_find_end_position - Find the end position for position-based scans
+ *
+ * Returns the (block, offset) of the first tuple that EXCEEDS the upper bound.
+ * This is used as the exclusive end position for position-based scans.
+ *
+ * For upper_bound_strict=true (< operator):  find first tuple >= upper_bound
+ * For upper_bound_strict=false (<= operator): find first tuple > upper_bound
+ */
+void
+smol_find_end_position(Relation idx, SmolScanOpaque so,
+                       BlockNumber *end_blk_out, OffsetNumber *end_off_out)
+{
+    /* If no upper bound, end position is past the rightmost tuple */
+    if (!so->have_upper_bound)
+    {
+        *end_blk_out = InvalidBlockNumber;
+        *end_off_out = InvalidOffsetNumber;
+        return;
+    }
+
+    /* Find the leaf containing the upper bound */
+    BlockNumber leaf_blk;
+
+    if (so->atttypid == TEXTOID)
+    {
+        /* For text types, we need to search from leftmost and scan forward
+         * to find the exact position. For now, disable position scan for text. */
+        *end_blk_out = InvalidBlockNumber;
+        *end_off_out = InvalidOffsetNumber;
+        return;
+    }
+    else
+    {
+        /* Integer types: use fast path to find approximate leaf */
+        int64 ub = smol_bound_to_int64(so->atttypid, so->upper_bound_datum, PG_INT64_MIN);
+
+        leaf_blk = smol_find_first_leaf(idx, ub, so->atttypid, so->key_len);
+    }
+
+    /* Now binary search within this leaf and potentially subsequent leaves
+     * to find the first tuple that exceeds the upper bound */
+    Buffer buf = ReadBufferExtended(idx, MAIN_FORKNUM, leaf_blk, RBM_NORMAL, so->bstrategy);
+    Page page = BufferGetPage(buf);
+    uint16 nitems = smol_leaf_nitems(page);
 
     /* Binary search for first tuple that exceeds upper bound */
     uint16 lo = FirstOffsetNumber;
@@ -746,8 +1520,9 @@ smol_leaf_nitems(Page page)
     char *p = (char *) PageGetItem(page, iid);
     uint16 tag;
     memcpy(&tag, p, sizeof(uint16));
-    if (tag == SMOL_TAG_KEY_RLE ||
-        tag == SMOL_TAG_KEY_RLE_V2 || tag == SMOL_TAG_INC_RLE)
+    if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2 ||
+        tag == SMOL_TAG_INC_RLE || tag == SMOL_TAG_KEY_FOR || tag == SMOL_TAG_TEXT_PREFIX ||
+        tag == SMOL_TAG_INC_DICT)
     {
         /* Tagged formats: [u16 tag][u16 nitems][...] */
         uint16 nitems;
@@ -770,6 +1545,51 @@ smol_leaf_keyptr_ex(Page page, uint16 idx, uint16 key_len, const uint16 *inc_len
     uint16 tag;
     memcpy(&tag, p, sizeof(uint16));
 
+    if (tag == SMOL_TAG_KEY_FOR)
+    {
+        /* No key bytes on the page: decode into a small ring so the last few
+         * returned pointers stay valid together (callers compare pairs) */
+        static char ring[SMOL_FOR_KEYRING][sizeof(int64)];
+        static int ring_next = 0;
+        SmolForLeaf f;
+        char *slot;
+        int64 v;
+
+        smol_for_open(p, &f);
+        SMOL_DEFENSIVE_CHECK(idx >= 1 && idx <= f.nitems, ERROR,
+                            (errmsg("smol: FOR keyptr index %u out of range [1,%u]", idx, f.nitems)));
+        slot = ring[ring_next];
+        ring_next = (ring_next + 1) % SMOL_FOR_KEYRING;
+        v = smol_for_value(&f, (uint32) (idx - 1));
+        smol_for_store_key(slot, v, key_len);
+        return slot;
+    }
+    if (tag == SMOL_TAG_TEXT_PREFIX)
+    {
+        /* Keys are split into prefix and suffix: rebuild into the same kind of ring */
+        static char ring[SMOL_FOR_KEYRING][SMOL_TEXT_KEY_MAX];
+        static int ring_next = 0;
+        SmolTextPrefixLeaf t;
+        char *slot;
+
+        smol_tp_open(p, &t);
+        SMOL_DEFENSIVE_CHECK(idx >= 1 && idx <= t.nitems && key_len <= SMOL_TEXT_KEY_MAX, ERROR,
+                            (errmsg("smol: prefix keyptr index %u out of range [1,%u]", idx, t.nitems)));
+        slot = ring[ring_next];
+        ring_next = (ring_next + 1) % SMOL_FOR_KEYRING;
+        smol_tp_key(&t, (uint32) (idx - 1), slot, key_len);
+        return slot;
+    }
+    if (tag == SMOL_TAG_INC_DICT)
+    {
+        /* Keys are stored plain; only the INCLUDE columns are coded */
+        uint16 n;
+
+        memcpy(&n, p + sizeof(uint16), sizeof(uint16));
+        SMOL_DEFENSIVE_CHECK(idx >= 1 && idx <= n, ERROR,
+                            (errmsg("smol: dictionary keyptr index %u out of range [1,%u]", idx, n)));
+        return (char *) smol_incdict_keys(p) + (size_t) (idx - 1) * key_len;
+    }
     if (!(tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2 || tag == SMOL_TAG_INC_RLE))
     {
         /* Plain payload: [u16 n][keys...] (no tag, n is first uint16) */
@@ -860,703 +1680,2367 @@ smol_rightmost_leaf(Relation idx)
 
 /*
  * ========================================================================
- * Zone Map Statistics Collection
+ * Leaf Search Kernels
  * ========================================================================
- */
-
-/*
- * smol_estimate_distinct - Estimate distinct count using run-length encoding
  *
- * For sorted data, we count the number of runs (consecutive equal values).
- * This is exact for sorted data but may underestimate for unsorted data.
+ * Plain single-column leaves store keys as one contiguous fixed-width array
+ * after the u16 item count, so int2/int4/int8-like keys can be compared 16
+ * bytes at a time.  Bound searches binary-search down to a small window and
+ * finish with a vector scan for the first key not below the bound; run-end
+ * detection scans forward for the first key that differs from the run key.
+ * Builds without SSE2/NEON (see port/simd.h) use the scalar loops.
  */
-static uint16
-smol_estimate_distinct(const void *keys, uint32 n, uint16 key_len, Oid typid)
+
+#define SMOL_LEAF_SIMD_WINDOW_BYTES 128 /* stop binary search below this span */
+
+static inline int64
+smol_leaf_int_at(const char *keys, uint16 i, uint16 key_len)
 {
-    uint32 runs = 0;
+    const char *p = keys + (size_t) i * key_len;
 
-    if (n == 0)
-        return 0; /* GCOV_EXCL_LINE (flaky)  */
-    if (n == 1)
-        return 1;
+    if (key_len == 2)
+    { int16 v; memcpy(&v, p, 2); return v; }
+    if (key_len == 4)
+    { int32 v; memcpy(&v, p, 4); return v; }
+    { int64 v; memcpy(&v, p, 8); return v; }
+}
 
-    /* Count runs by comparing consecutive keys */
-    runs = 1; /* First key starts a run */
+#if defined(USE_SSE2) || defined(USE_NEON)
 
-    for (uint32 i = 1; i < n; i++)
-    {
-        const char *prev = (const char *)keys + (i - 1) * key_len;
-        const char *curr = (const char *)keys + i * key_len;
+#define SMOL_VEC_BYTES 16
 
-        if (memcmp(prev, curr, key_len) != 0)
-            runs++;
+#ifdef USE_SSE2
+typedef __m128i SmolVec;
+#define SMOL_VEC_MASK_BITS 1            /* movemask: one bit per byte */
+#define SMOL_VEC_MASK_FULL UINT64CONST(0xFFFF)
+
+static inline SmolVec
+smol_vec_load(const char *p)
+{
+    return _mm_loadu_si128((const __m128i *) p);
+}
+
+static inline SmolVec
+smol_vec_splat(int64 v, uint16 key_len)
+{
+    if (key_len == 2) return _mm_set1_epi16((int16) v);
+    if (key_len == 4) return _mm_set1_epi32((int32) v);
+    return _mm_set1_epi64x(v);
+}
+
+/* Lanes where k < b (signed), as all-ones lanes */
+static inline SmolVec
+smol_vec_lt(SmolVec k, SmolVec b, uint16 key_len)
+{
+    if (key_len == 2) return _mm_cmplt_epi16(k, b);
+    if (key_len == 4) return _mm_cmplt_epi32(k, b);
+    {
+        /*
+         * SSE2 has no 64-bit compare: k < b iff hi(k) < hi(b), or the high
+         * halves are equal and lo(k) < lo(b) unsigned.  Flipping the sign bit
+         * of the low halves turns that unsigned compare into a signed one.
+         */
+        const __m128i flip = _mm_set_epi32(0, (int) 0x80000000, 0, (int) 0x80000000);
+        __m128i kf = _mm_xor_si128(k, flip);
+        __m128i bf = _mm_xor_si128(b, flip);
+        __m128i gt = _mm_cmpgt_epi32(bf, kf);
+        __m128i eq = _mm_cmpeq_epi32(kf, bf);
+        __m128i r = _mm_or_si128(gt, _mm_and_si128(eq, _mm_slli_epi64(gt, 32)));
+
+        return _mm_shuffle_epi32(r, _MM_SHUFFLE(3, 3, 1, 1));
     }
+}
 
-    /* Saturate at UINT16_MAX */
-    if (runs > UINT16_MAX)
-        return UINT16_MAX; /* GCOV_EXCL_LINE */
+static inline SmolVec
+smol_vec_eq(SmolVec k, SmolVec b)
+{
+    return _mm_cmpeq_epi8(k, b);
+}
 
-    return (uint16)runs;
+static inline uint64
+smol_vec_mask(SmolVec m)
+{
+    return (uint64) (uint32) _mm_movemask_epi8(m);
 }
+#else                                   /* USE_NEON */
+typedef int8x16_t SmolVec;
+#define SMOL_VEC_MASK_BITS 4            /* shift-narrow: one nibble per byte */
+#define SMOL_VEC_MASK_FULL (~UINT64CONST(0))
 
-/*
- * smol_collect_leaf_stats - Collect zone map statistics for a leaf page
- *
- * Extracts min/max keys, row count, distinct count estimate, and builds
- * a bloom filter for all keys in the leaf.
- *
- * For keys longer than 4 bytes (e.g., text, UUID), we use the first 4 bytes
- * as an approximation for zone map filtering. This is sufficient for pruning
- * most non-matching subtrees while keeping internal nodes compact.
- */
-void
-smol_collect_leaf_stats(SmolLeafStats *stats, const void *keys, uint32 n,
-                        uint16 key_len, Oid typid, BlockNumber blk)
+static inline SmolVec
+smol_vec_load(const char *p)
 {
-    stats->blk = blk;
-    stats->row_count = n;
+    return vld1q_s8((const int8 *) p);
+}
 
-    if (n == 0) /* GCOV_EXCL_START - Defensive: pages always have >= 1 key */
-    {
-        stats->minkey = 0;
-        stats->maxkey = 0;
-        stats->distinct_count = 0;
-        stats->bloom_filter = 0;
-        stats->padding = 0;
-        return;
-    } /* GCOV_EXCL_STOP */
+static inline SmolVec
+smol_vec_splat(int64 v, uint16 key_len)
+{
+    if (key_len == 2) return vreinterpretq_s8_s16(vdupq_n_s16((int16) v));
+    if (key_len == 4) return vreinterpretq_s8_s32(vdupq_n_s32((int32) v));
+    return vreinterpretq_s8_s64(vdupq_n_s64(v));
+}
 
-    /* Extract min and max keys (assuming sorted data) */
-    const char *first_key = (const char *)keys;
-    const char *last_key = (const char *)keys + (n - 1) * key_len;
+static inline SmolVec
+smol_vec_lt(SmolVec k, SmolVec b, uint16 key_len)
+{
+    if (key_len == 2)
+        return vreinterpretq_s8_u16(vcltq_s16(vreinterpretq_s16_s8(k), vreinterpretq_s16_s8(b)));
+    if (key_len == 4)
+        return vreinterpretq_s8_u32(vcltq_s32(vreinterpretq_s32_s8(k), vreinterpretq_s32_s8(b)));
+    return vreinterpretq_s8_u64(vcltq_s64(vreinterpretq_s64_s8(k), vreinterpretq_s64_s8(b)));
+}
 
-    /* Convert to int32 - truncate or pad as needed */
-    switch (typid)
-    {
-        case INT2OID:
-            {
-                int16 v;
-                memcpy(&v, first_key, sizeof(int16));
-                stats->minkey = (int32)v;
-                memcpy(&v, last_key, sizeof(int16));
-                stats->maxkey = (int32)v;
-                break;
+static inline SmolVec
+smol_vec_eq(SmolVec k, SmolVec b)
+{
+    return vreinterpretq_s8_u8(vceqq_s8(k, b));
+}
+
+static inline uint64
+smol_vec_mask(SmolVec m)
+{
+    uint8x8_t nib = vshrn_n_u16(vreinterpretq_u16_s8(m), 4);
+
+    return vget_lane_u64(vreinterpret_u64_u8(nib), 0);
+}
+#endif                                  /* USE_SSE2 */
+
+/* Lane index of the first lane whose compare lane is not all-ones (lanes if none) */
+static inline uint16
+smol_vec_first_clear(uint64 mask, uint16 key_len)
+{
+    uint64 inv = ~mask & SMOL_VEC_MASK_FULL;
+
+    if (inv == 0)
+        return (uint16) (SMOL_VEC_BYTES / key_len);
+    return (uint16) (pg_rightmost_one_pos64(inv) / (SMOL_VEC_MASK_BITS * key_len));
+}
+#endif                                  /* USE_SSE2 || USE_NEON */
+
+/* First index in [lo, hi) whose key is >= bound (hi if none); keys are sorted */
+static inline uint16
+smol_leaf_scan_not_below(const char *keys, uint16 lo, uint16 hi, uint16 key_len, int64 bound)
+{
+    uint16 i = lo;
+
+#if defined(USE_SSE2) || defined(USE_NEON)
+    {
+        uint16 lanes = (uint16) (SMOL_VEC_BYTES / key_len);
+        SmolVec b = smol_vec_splat(bound, key_len);
+
+        for (; i + lanes <= hi; i += lanes)
+        {
+            SmolVec k = smol_vec_load(keys + (size_t) i * key_len);
+            uint16 f = smol_vec_first_clear(smol_vec_mask(smol_vec_lt(k, b, key_len)), key_len);
+
+            if (f < lanes)
+                return (uint16) (i + f);
+        }
+    }
+#endif
+    for (; i < hi; i++)
+        if (smol_leaf_int_at(keys, i, key_len) >= bound)
+            break;
+    return i;
+}
+
+/*
+ * smol_leaf_search_int - index (0-based) of the first of n sorted integer
+ * keys that is >= bound (> bound when strict), or n when there is none.
+ * The bound is in the key type's range (it comes from a same-type Datum).
+ */
+uint16
+smol_leaf_search_int(const char *keys, uint16 n, uint16 key_len,
+                     int64 bound, bool strict, uint64 *bsteps)
+{
+    uint16 lo = 0, hi = n;
+    uint16 window = (uint16) (SMOL_LEAF_SIMD_WINDOW_BYTES / key_len);
+
+    SMOL_DEFENSIVE_CHECK(key_len == 2 || key_len == 4 || key_len == 8, ERROR,
+                        (errmsg("smol: integer leaf search on key_len=%u", key_len)));
+    if (strict)
+    {
+        /* > bound is >= bound + 1; nothing is above the type's maximum */
+        int64 tmax = key_len == 2 ? PG_INT16_MAX : key_len == 4 ? PG_INT32_MAX : PG_INT64_MAX;
+
+        if (bound >= tmax)
+            return n;
+        bound++;
+    }
+    while (hi - lo > window)
+    {
+        uint16 mid = (uint16) (lo + ((hi - lo) >> 1));
+
+        if (bsteps) (*bsteps)++;
+        if (smol_leaf_int_at(keys, mid, key_len) < bound)
+            lo = (uint16) (mid + 1);
+        else
+            hi = mid;
+    }
+    if (bsteps) (*bsteps)++;
+    return smol_leaf_scan_not_below(keys, lo, hi, key_len, bound);
+}
+
+/*
+ * smol_leaf_run_end_int - index (0-based) of the last key in the run of keys
+ * equal to keys[start], searching up to n keys.
+ */
+uint16
+smol_leaf_run_end_int(const char *keys, uint16 n, uint16 key_len, uint16 start)
+{
+    int64 run = smol_leaf_int_at(keys, start, key_len);
+    uint16 i = (uint16) (start + 1);
+
+    SMOL_DEFENSIVE_CHECK(key_len == 2 || key_len == 4 || key_len == 8, ERROR,
+                        (errmsg("smol: integer run detection on key_len=%u", key_len)));
+#if defined(USE_SSE2) || defined(USE_NEON)
+    {
+        uint16 lanes = (uint16) (SMOL_VEC_BYTES / key_len);
+        SmolVec r = smol_vec_splat(run, key_len);
+
+        for (; i + lanes <= n; i += lanes)
+        {
+            SmolVec k = smol_vec_load(keys + (size_t) i * key_len);
+            uint16 f = smol_vec_first_clear(smol_vec_mask(smol_vec_eq(k, r)), key_len);
+
+            if (f < lanes)
+                return (uint16) (i + f - 1);
+        }
+    }
+#endif
+    for (; i < n; i++)
+        if (smol_leaf_int_at(keys, i, key_len) != run)
+            break;
+    return (uint16) (i - 1);
+}
+
+/* Key array of a plain-format single-column leaf, or of a dictionary-coded
+ * INCLUDE leaf (NULL for the other tagged formats) */
+char *
+smol_leaf_plain_keys(Page page, uint16 *nitems_out)
+{
+    char *p = smol1_payload(page);
+    uint16 tag;
+
+    memcpy(&tag, p, sizeof(uint16));
+    if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2 ||
+        tag == SMOL_TAG_INC_RLE || tag == SMOL_TAG_KEY_FOR || tag == SMOL_TAG_TEXT_PREFIX)
+        return NULL;
+    if (tag == SMOL_TAG_INC_DICT)
+    {
+        /* Keys are stored plain ahead of the coded INCLUDE columns */
+        memcpy(nitems_out, p + sizeof(uint16), sizeof(uint16));
+        return (char *) smol_incdict_keys(p);
+    }
+    *nitems_out = tag;
+    return p + sizeof(uint16);
+}
+
+/*
+ * smol_for_encode - write a SMOL_TAG_KEY_FOR payload for n sorted integer
+ * keys of key_len bytes into dst; returns the payload size.  dst must hold
+ * smol_for_block_bytes() per block plus header and slack.
+ */
+Size
+smol_for_encode(char *dst, const char *keys, uint16 n, uint16 key_len)
+{
+    uint16 tag = SMOL_TAG_KEY_FOR;
+    uint16 nblocks = (uint16) ((n + SMOL_FOR_BLOCK - 1) / SMOL_FOR_BLOCK);
+    uint16 reserved = 0;
+    char *bases = dst + SMOL_FOR_HEADER;
+    char *offs = bases + (size_t) nblocks * sizeof(int64);
+    uint8 *widths = (uint8 *) (offs + (size_t) nblocks * sizeof(uint16));
+    char *data = (char *) widths + nblocks;
+    uint32 pos = 0;
+
+    memcpy(dst, &tag, sizeof(uint16));
+    memcpy(dst + sizeof(uint16), &n, sizeof(uint16));
+    memcpy(dst + sizeof(uint16) * 2, &nblocks, sizeof(uint16));
+    memcpy(dst + sizeof(uint16) * 3, &reserved, sizeof(uint16));
+    for (uint16 b = 0; b < nblocks; b++)
+    {
+        uint32 lo = (uint32) b * SMOL_FOR_BLOCK;
+        uint32 cnt = Min((uint32) SMOL_FOR_BLOCK, (uint32) n - lo);
+        int64 mn = smol_leaf_int_at(keys, (uint16) lo, key_len);
+        int64 mx = mn;
+        uint16 off = (uint16) pos;
+        uint8 width;
+        Size nbytes;
+
+        for (uint32 j = 1; j < cnt; j++)
+        {
+            int64 v = smol_leaf_int_at(keys, (uint16) (lo + j), key_len);
+
+            if (v < mn) mn = v;
+            if (v > mx) mx = v;
+        }
+        width = smol_for_width((uint64) mx - (uint64) mn);
+        nbytes = ((Size) cnt * width + 7) / 8;
+        memcpy(bases + (size_t) b * sizeof(int64), &mn, sizeof(int64));
+        memcpy(offs + (size_t) b * sizeof(uint16), &off, sizeof(uint16));
+        widths[b] = width;
+        memset(data + pos, 0, nbytes + SMOL_FOR_SLACK);
+        if (width > 0)
+        {
+            for (uint32 j = 0; j < cnt; j++)
+            {
+                uint64 d = (uint64) smol_leaf_int_at(keys, (uint16) (lo + j), key_len) - (uint64) mn;
+                uint32 bit = j * width;
+                uint64 w;
+
+                memcpy(&w, data + pos + (bit >> 3), sizeof(uint64));
+#ifdef WORDS_BIGENDIAN
+                w = pg_bswap64(w);
+#endif
+                w |= d << (bit & 7);
+#ifdef WORDS_BIGENDIAN
+                w = pg_bswap64(w);
+#endif
+                memcpy(data + pos + (bit >> 3), &w, sizeof(uint64));
             }
-        case INT4OID:
-            memcpy(&stats->minkey, first_key, sizeof(int32));
-            memcpy(&stats->maxkey, last_key, sizeof(int32));
+        }
+        pos += (uint32) nbytes;
+    }
+    memset(data + pos, 0, SMOL_FOR_SLACK);
+    return (Size) (data - dst) + pos + SMOL_FOR_SLACK;
+}
+
+/*
+ * smol_for_decode - unpack every key of a FOR payload into a plain key array
+ * (key_len bytes per key).  The per-block loop is a fixed shift/mask with no
+ * data-dependent branches, so the compiler can unroll and vectorize it.
+ */
+void
+smol_for_decode(const char *payload, char *out, uint16 key_len)
+{
+    SmolForLeaf f;
+
+    smol_for_open(payload, &f);
+    for (uint16 b = 0; b < f.nblocks; b++)
+    {
+        uint32 lo = (uint32) b * SMOL_FOR_BLOCK;
+        uint32 cnt = Min((uint32) SMOL_FOR_BLOCK, (uint32) f.nitems - lo);
+        int64 base;
+        uint16 off;
+        uint8 width = f.widths[b];
+        const char *data;
+
+        memcpy(&base, f.bases + (size_t) b * sizeof(int64), sizeof(int64));
+        memcpy(&off, f.offs + (size_t) b * sizeof(uint16), sizeof(uint16));
+        data = f.data + off;
+        switch (key_len)
+        {
+            case 2:
+                for (uint32 j = 0; j < cnt; j++)
+                {
+                    int16 v = (int16) ((uint64) base + smol_for_bits(data, j * width, width));
+                    memcpy(out + (size_t) (lo + j) * 2, &v, 2);
+                }
+                break;
+            case 4:
+                for (uint32 j = 0; j < cnt; j++)
+                {
+                    int32 v = (int32) ((uint64) base + smol_for_bits(data, j * width, width));
+                    memcpy(out + (size_t) (lo + j) * 4, &v, 4);
+                }
+                break;
+            default:
+                for (uint32 j = 0; j < cnt; j++)
+                {
+                    int64 v = (int64) ((uint64) base + smol_for_bits(data, j * width, width));
+                    memcpy(out + (size_t) (lo + j) * 8, &v, 8);
+                }
+                break;
+        }
+    }
+}
+
+/* Length of a NUL-padded text key */
+static inline uint16
+smol_tp_keylen(const char *k, uint16 key_len)
+{
+    const char *z = (const char *) memchr(k, '\0', key_len);
+
+    return z ? (uint16) (z - k) : key_len;
+}
+
+/*
+ * smol_tp_fit - number of NUL-padded text keys, starting at keys[0], that fit
+ * a SMOL_TAG_TEXT_PREFIX payload of at most 'avail' bytes.  The prefix is the
+ * common prefix of every key on the page (not just the first and last), so
+ * the layout stays correct for orders other than bytewise.
+ */
+Size
+smol_tp_fit(const char *keys, Size n, uint16 key_len, Size avail)
+{
+    const char *k0 = keys;
+    uint16 plen = smol_tp_keylen(k0, key_len);
+    Size sumlen = 0, rows = 0;
+
+    while (rows < n && rows < PG_UINT16_MAX - 1)
+    {
+        const char *k = keys + rows * key_len;
+        uint16 len = smol_tp_keylen(k, key_len);
+        uint16 p = Min(plen, len);
+        Size used;
+
+        while (p > 0 && memcmp(k0, k, p) != 0)
+            p--;
+        used = SMOL_TP_HEADER + (rows + 2) * sizeof(uint16) + sumlen + len - rows * p;
+        if (used > avail)
+            break;
+        plen = p;
+        sumlen += len;
+        rows++;
+    }
+    return rows;
+}
+
+/*
+ * smol_tp_encode - write a SMOL_TAG_TEXT_PREFIX payload for n NUL-padded
+ * text keys of key_len bytes into dst; returns the payload size.  Callers
+ * size n with smol_tp_fit().
+ */
+Size
+smol_tp_encode(char *dst, const char *keys, uint16 n, uint16 key_len)
+{
+    uint16 tag = SMOL_TAG_TEXT_PREFIX;
+    uint16 reserved = 0;
+    uint16 plen = smol_tp_keylen(keys, key_len);
+    char *offs = dst + SMOL_TP_HEADER;
+    char *out;
+    uint16 pos = 0;
+
+    for (uint16 i = 1; i < n; i++)
+    {
+        const char *k = keys + (size_t) i * key_len;
+        uint16 p = Min(plen, smol_tp_keylen(k, key_len));
+
+        while (p > 0 && memcmp(keys, k, p) != 0)
+            p--;
+        plen = p;
+    }
+    memcpy(dst, &tag, sizeof(uint16));
+    memcpy(dst + sizeof(uint16), &n, sizeof(uint16));
+    memcpy(dst + sizeof(uint16) * 2, &plen, sizeof(uint16));
+    memcpy(dst + sizeof(uint16) * 3, &reserved, sizeof(uint16));
+    out = offs + ((size_t) n + 1) * sizeof(uint16);
+    memcpy(out, keys, plen);
+    out += plen;
+    for (uint16 i = 0; i < n; i++)
+    {
+        const char *k = keys + (size_t) i * key_len;
+        uint16 len = (uint16) (smol_tp_keylen(k, key_len) - plen);
+
+        memcpy(offs + (size_t) i * sizeof(uint16), &pos, sizeof(uint16));
+        memcpy(out + pos, k + plen, len);
+        pos = (uint16) (pos + len);
+    }
+    memcpy(offs + (size_t) n * sizeof(uint16), &pos, sizeof(uint16));
+    return (Size) (out - dst) + pos;
+}
+
+/*
+ * smol_tp_decode - rebuild every key of a SMOL_TAG_TEXT_PREFIX payload as a
+ * plain NUL-padded key array (key_len bytes per key).
+ */
+void
+smol_tp_decode(const char *payload, char *out, uint16 key_len)
+{
+    SmolTextPrefixLeaf t;
+
+    smol_tp_open(payload, &t);
+    for (uint32 i = 0; i < t.nitems; i++)
+        smol_tp_key(&t, i, out + (size_t) i * key_len, key_len);
+}
+
+/* Dictionary being collected for one SMOL_TAG_INC_DICT column */
+typedef struct SmolIncDictBuild
+{
+    uint16      ndict;
+    uint16      last;               /* code of the previous row, tried first */
+    bool        overflow;           /* more than SMOL_INC_DICT_MAX values: stays raw */
+    const char *vals[SMOL_INC_DICT_MAX];
+} SmolIncDictBuild;
+
+/* Code of value v, adding it to the dictionary if new; -1 once overflowed */
+static int
+smol_inc_dict_add(SmolIncDictBuild *d, const char *v, uint16 len)
+{
+    if (d->overflow)
+        return -1;
+    if (d->ndict > 0 && memcmp(d->vals[d->last], v, len) == 0)
+        return d->last;
+    for (uint16 j = 0; j < d->ndict; j++)
+    {
+        if (memcmp(d->vals[j], v, len) == 0)
+        {
+            d->last = j;
+            return j;
+        }
+    }
+    if (d->ndict == SMOL_INC_DICT_MAX)
+    {
+        d->overflow = true;
+        return -1;
+    }
+    d->vals[d->ndict] = v;
+    d->last = d->ndict;
+    return d->ndict++;
+}
+
+/* Coded size of a column, or 0 when raw values are no larger */
+static Size
+smol_inc_dict_coded_bytes(const SmolIncDictBuild *d, Size rows, uint16 len)
+{
+    Size coded;
+
+    if (d->overflow || d->ndict == 0)
+        return 0;
+    coded = (Size) d->ndict * len + (rows * smol_for_width(d->ndict - 1) + 7) / 8 + SMOL_FOR_SLACK;
+    return (coded < rows * len) ? coded : 0;
+}
+
+/*
+ * smol_inc_dict_fit - number of rows, starting at 'start' in the per-column
+ * INCLUDE arrays, that fit a SMOL_TAG_INC_DICT payload of at most 'avail'
+ * bytes.  Each column is charged the smaller of its raw and coded forms.
+ */
+Size
+smol_inc_dict_fit(const char * const *incs, Size start, Size n, uint16 key_len,
+                  int ninc, const uint16 *inc_lens, Size avail)
+{
+    SmolIncDictBuild *d = (SmolIncDictBuild *) palloc(sizeof(SmolIncDictBuild) * ninc);
+    Size rows = 0;
+
+    for (int c = 0; c < ninc; c++)
+    {
+        d[c].ndict = 0;
+        d[c].last = 0;
+        d[c].overflow = false;
+    }
+    while (rows < n && rows < 32000)
+    {
+        Size used = SMOL_INC_DICT_HEADER + (Size) ninc * sizeof(uint16) + (rows + 1) * key_len;
+
+        for (int c = 0; c < ninc; c++)
+        {
+            Size coded;
+
+            smol_inc_dict_add(&d[c], incs[c] + (start + rows) * inc_lens[c], inc_lens[c]);
+            coded = smol_inc_dict_coded_bytes(&d[c], rows + 1, inc_lens[c]);
+            used += SMOL_INC_DICT_COL + (coded ? coded : (rows + 1) * inc_lens[c]);
+        }
+        if (used > avail)
             break;
+        rows++;
+    }
+    pfree(d);
+    return rows;
+}
+
+/*
+ * smol_inc_dict_encode - write a SMOL_TAG_INC_DICT payload for n rows: keys
+ * holds n packed keys of key_len bytes, incs the per-column INCLUDE arrays
+ * read from row 'start'.  Returns the payload size; callers size n with
+ * smol_inc_dict_fit().
+ */
+Size
+smol_inc_dict_encode(char *dst, const char *keys, const char * const *incs, Size start,
+                     uint16 n, uint16 key_len, int ninc, const uint16 *inc_lens)
+{
+    uint16 tag = SMOL_TAG_INC_DICT;
+    uint16 ninc16 = (uint16) ninc;
+    uint16 reserved = 0;
+    SmolIncDictBuild *d = (SmolIncDictBuild *) palloc(sizeof(SmolIncDictBuild));
+    uint8 *codes = (uint8 *) palloc((Size) n);
+    char *p;
+
+    memcpy(dst, &tag, sizeof(uint16));
+    memcpy(dst + sizeof(uint16), &n, sizeof(uint16));
+    memcpy(dst + sizeof(uint16) * 2, &ninc16, sizeof(uint16));
+    memcpy(dst + sizeof(uint16) * 3, &reserved, sizeof(uint16));
+    p = dst + SMOL_INC_DICT_HEADER + (size_t) ninc * sizeof(uint16);
+    memcpy(p, keys, (size_t) n * key_len);
+    p += (size_t) n * key_len;
+    for (int c = 0; c < ninc; c++)
+    {
+        uint16 len = inc_lens[c];
+        const char *col = incs[c] + start * len;
+        uint16 off = (uint16) (p - dst);
+        uint16 ndict;
+        Size coded;
+
+        d->ndict = 0;
+        d->last = 0;
+        d->overflow = false;
+        for (uint16 r = 0; r < n; r++)
+            codes[r] = (uint8) smol_inc_dict_add(d, col + (size_t) r * len, len);
+        coded = smol_inc_dict_coded_bytes(d, n, len);
+        ndict = coded ? d->ndict : 0;
+        memcpy(dst + SMOL_INC_DICT_HEADER + (size_t) c * sizeof(uint16), &off, sizeof(uint16));
+        memcpy(p, &ndict, sizeof(uint16));
+        memcpy(p + sizeof(uint16), &reserved, sizeof(uint16));
+        p += SMOL_INC_DICT_COL;
+        if (ndict == 0)
+        {
+            memcpy(p, col, (size_t) n * len);
+            p += (size_t) n * len;
+            continue;
+        }
+        for (uint16 j = 0; j < ndict; j++)
+            memcpy(p + (size_t) j * len, d->vals[j], len);
+        p += (size_t) ndict * len;
+        {
+            uint8 width = smol_for_width((uint64) (ndict - 1));
+            Size nbytes = ((Size) n * width + 7) / 8;
+
+            memset(p, 0, nbytes + SMOL_FOR_SLACK);
+            for (uint32 r = 0; r < n && width > 0; r++)
+            {
+                uint32 bit = r * width;
+                uint64 w;
+
+                memcpy(&w, p + (bit >> 3), sizeof(uint64));
+#ifdef WORDS_BIGENDIAN
+                w = pg_bswap64(w);
+#endif
+                w |= (uint64) codes[r] << (bit & 7);
+#ifdef WORDS_BIGENDIAN
+                w = pg_bswap64(w);
+#endif
+                memcpy(p + (bit >> 3), &w, sizeof(uint64));
+            }
+            p += nbytes + SMOL_FOR_SLACK;
+        }
+    }
+    pfree(codes);
+    pfree(d);
+    return (Size) (p - dst);
+}
+
+/*
+ * smol_inc_dict_decode - rebuild a SMOL_TAG_INC_DICT payload as the plain
+ * INCLUDE body: n keys followed by one contiguous block per INCLUDE column.
+ */
+void
+smol_inc_dict_decode(const char *payload, char *out, uint16 key_len, const uint16 *inc_lens)
+{
+    uint16 n, ninc;
+
+    memcpy(&n, payload + sizeof(uint16), sizeof(uint16));
+    memcpy(&ninc, payload + sizeof(uint16) * 2, sizeof(uint16));
+    memcpy(out, smol_incdict_keys(payload), (size_t) n * key_len);
+    out += (size_t) n * key_len;
+    for (uint16 c = 0; c < ninc; c++)
+    {
+        uint16 len = inc_lens[c];
+        SmolIncDictCol col;
+
+        smol_incdict_col(payload, c, len, &col);
+        if (col.ndict == 0)
+            memcpy(out, col.vals, (size_t) n * len);
+        else
+        {
+            for (uint32 r = 0; r < n; r++)
+                memcpy(out + (size_t) r * len,
+                       col.vals + (size_t) smol_for_bits(col.codes, r * col.width, col.width) * len, len);
+        }
+        out += (size_t) n * len;
+    }
+}
+
+/*
+ * smol12_group_fit - number of sorted two-column rows, starting at 'start',
+ * that fit a SMOL_TAG_K1_GROUPS payload of at most 'avail' bytes.  'perm'
+ * maps sorted position to buffer slot (NULL when the buffers are already in
+ * order); 'rest' is the per-row k2 plus INCLUDE width.
+ */
+Size
+smol12_group_fit(const char *k1buf, const uint32 *perm, Size start, Size n,
+                 uint16 key_len1, Size rest, Size avail)
+{
+    Size used = SMOL12_GROUP_HEADER, rows = 0;
+    const char *prev = NULL;
+
+    while (start + rows < n)
+    {
+        Size slot = perm ? perm[start + rows] : start + rows;
+        const char *k = k1buf + slot * key_len1;
+        Size need = rest;
+
+        if (prev == NULL || memcmp(k, prev, key_len1) != 0)
+            need += (Size) key_len1 + sizeof(uint16) * 2;
+        if (used + need > avail || rows == PG_UINT16_MAX)
+            break;
+        used += need;
+        prev = k;
+        rows++;
+    }
+    return rows;
+}
+
+/*
+ * smol12_group_encode - write nrows sorted rows as a SMOL_TAG_K1_GROUPS
+ * payload into dst and return its size.  INCLUDE column c of sorted row r is
+ * incs[c] + r * inc_lens[c] (already in sorted order, not permuted).
+ */
+Size
+smol12_group_encode(char *dst, const char *k1buf, const char *k2buf, const uint32 *perm,
+                    Size start, uint16 nrows, uint16 key_len1, uint16 key_len2,
+                    char * const *incs, int inc_count, const uint16 *inc_lens)
+{
+    uint16 tag = SMOL_TAG_K1_GROUPS, ngroups = 0, reserved = 0;
+    uint32 inc_total = 0;
+    char *dirp = dst + SMOL12_GROUP_HEADER;
+    char *k2p, *incp;
+    uint16 first = 0;
+
+    for (int c = 0; c < inc_count; c++)
+        inc_total += inc_lens[c];
+    /* Directory first: its size fixes where the k2 array starts */
+    for (uint16 r = 0; r <= nrows; r++)
+    {
+        const char *k = NULL;
+        const char *pk;
+
+        if (r < nrows)
+            k = k1buf + (perm ? perm[start + r] : start + r) * key_len1;
+        if (r == 0)
+            continue;
+        pk = k1buf + (perm ? perm[start + r - 1] : start + r - 1) * key_len1;
+        if (k == NULL || memcmp(k, pk, key_len1) != 0)
+        {
+            uint16 cnt = (uint16) (r - first);
+
+            memcpy(dirp, pk, key_len1);
+            memcpy(dirp + key_len1, &first, sizeof(uint16));
+            memcpy(dirp + key_len1 + sizeof(uint16), &cnt, sizeof(uint16));
+            dirp += key_len1 + sizeof(uint16) * 2;
+            ngroups++;
+            first = r;
+        }
+    }
+    memcpy(dst, &tag, sizeof(uint16));
+    memcpy(dst + sizeof(uint16), &nrows, sizeof(uint16));
+    memcpy(dst + sizeof(uint16) * 2, &ngroups, sizeof(uint16));
+    memcpy(dst + sizeof(uint16) * 3, &reserved, sizeof(uint16));
+
+    k2p = dirp;
+    incp = k2p + (size_t) nrows * key_len2;
+    for (uint16 r = 0; r < nrows; r++)
+    {
+        Size slot = perm ? perm[start + r] : start + r;
+
+        memcpy(k2p, k2buf + slot * key_len2, key_len2);
+        k2p += key_len2;
+        for (int c = 0; c < inc_count; c++)
+        {
+            memcpy(incp, incs[c] + (start + r) * inc_lens[c], inc_lens[c]);
+            incp += inc_lens[c];
+        }
+    }
+    return (Size) (incp - dst);
+}
+
+/*
+ * smol_for_search_int - first 0-based position whose key is >= bound (> when
+ * strict), or nitems.  Binary-searches the block bases, then one block with
+ * single-value extraction; nothing is decoded in bulk.
+ */
+uint16
+smol_for_search_int(const char *payload, int64 bound, bool strict)
+{
+    SmolForLeaf f;
+    uint16 lo = 0, hi;
+    uint32 start, cnt;
+
+    smol_for_open(payload, &f);
+    if (strict)
+    {
+        if (bound == PG_INT64_MAX)
+            return f.nitems;
+        bound++;
+    }
+    /* First block whose base (= its first key) is >= bound */
+    hi = f.nblocks;
+    while (lo < hi)
+    {
+        uint16 mid = (uint16) (lo + ((hi - lo) >> 1));
+        int64 base;
+
+        memcpy(&base, f.bases + (size_t) mid * sizeof(int64), sizeof(int64));
+        if (base < bound)
+            lo = (uint16) (mid + 1);
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return 0;
+    /* The answer is inside block lo - 1 or at the start of block lo */
+    start = (uint32) (lo - 1) * SMOL_FOR_BLOCK;
+    cnt = Min((uint32) SMOL_FOR_BLOCK, (uint32) f.nitems - start);
+    {
+        uint32 l = 1, h = cnt;     /* key at start is < bound */
+
+        while (l < h)
+        {
+            uint32 mid = l + ((h - l) >> 1);
+
+            if (smol_for_value(&f, start + mid) < bound)
+                l = mid + 1;
+            else
+                h = mid;
+        }
+        return (uint16) (start + l);
+    }
+}
+
+/*
+ * ========================================================================
+ * Zone Map Statistics Collection
+ * ========================================================================
+ */
+
+/*
+ * smol_estimate_distinct - Estimate distinct count using run-length encoding
+ *
+ * For sorted data, we count the number of runs (consecutive equal values).
+ * This is exact for sorted data but may underestimate for unsorted data.
+ */
+static uint16
+smol_estimate_distinct(const void *keys, uint32 n, uint16 key_len, Oid typid)
+{
+    uint32 runs = 0;
+
+    if (n == 0)
+        return 0; /* GCOV_EXCL_LINE (flaky)  */
+    if (n == 1)
+        return 1;
+
+    /* Count runs by comparing consecutive keys */
+    runs = 1; /* First key starts a run */
+
+    for (uint32 i = 1; i < n; i++)
+    {
+        const char *prev = (const char *)keys + (i - 1) * key_len;
+        const char *curr = (const char *)keys + i * key_len;
+
+        if (memcmp(prev, curr, key_len) != 0)
+            runs++;
+    }
+
+    /* Saturate at UINT16_MAX */
+    if (runs > UINT16_MAX)
+        return UINT16_MAX; /* GCOV_EXCL_LINE */
+
+    return (uint16)runs;
+}
+
+/*
+ * smol_collect_leaf_stats - Collect zone map statistics for a leaf page
+ *
+ * Extracts min/max keys, row count, distinct count estimate, and builds
+ * a bloom filter for all keys in the leaf.
+ *
+ * Min/max are stored as full-width zone keys (see smol_zkey_from_keyptr):
+ * exact for keys up to 16 bytes, a 16-byte prefix for longer text.
+ */
+void
+smol_collect_leaf_stats(SmolLeafStats *stats, const void *keys, uint32 n,
+                        uint16 key_len, Oid typid, BlockNumber blk)
+{
+    stats->blk = blk;
+    stats->row_count = n;
+
+    if (n == 0) /* GCOV_EXCL_START - Defensive: pages always have >= 1 key */
+    {
+        memset(stats->minkey, 0, SMOL_ZKEY_MAX);
+        memset(stats->maxkey, 0, SMOL_ZKEY_MAX);
+        stats->distinct_count = 0;
+        stats->bloom_filter = 0;
+        stats->padding = 0;
+        return;
+    } /* GCOV_EXCL_STOP */
+
+    /* Extract min and max keys (assuming sorted data) */
+    const char *first_key = (const char *)keys;
+    const char *last_key = (const char *)keys + (n - 1) * key_len;
+
+    smol_zkey_from_keyptr(stats->minkey, SMOL_ZKEY_MAX, first_key, key_len, typid);
+    smol_zkey_from_keyptr(stats->maxkey, SMOL_ZKEY_MAX, last_key, key_len, typid);
+
+    /* Estimate distinct count */
+    stats->distinct_count = smol_estimate_distinct(keys, n, key_len, typid);
+
+    /* Build bloom filter if enabled */
+    if (smol_build_bloom_filters && smol_bloom_nhash > 0)
+    {
+        stats->bloom_filter = 0;
+
+        for (uint32 i = 0; i < n; i++)
+            smol_bloom_add(&stats->bloom_filter, 64,
+                           smol_bloom_hash_key((const char *) keys + (size_t) i * key_len, key_len, typid),
+                           smol_bloom_nhash);
+    }
+    else  /* GCOV_EXCL_LINE - Bloom disabled (nhash <= 0) - defensive fallback */
+    {
+        stats->bloom_filter = 0;
+    }
+
+    stats->padding = 0;
+}
+
+/*
+ * smol_leaf_stats_highkey_only - Minimal leaf stats when zone maps are disabled
+ *
+ * Internal levels still need each leaf's highkey for navigation.
+ */
+void
+smol_leaf_stats_highkey_only(SmolLeafStats *stats, BlockNumber blk, const char *last_key,
+                             uint16 key_len, Oid typid)
+{
+    memset(stats, 0, sizeof(SmolLeafStats));
+    stats->blk = blk;
+    smol_zkey_from_keyptr(stats->maxkey, SMOL_ZKEY_MAX, last_key, key_len, typid);
+}
+
+/*
+ * ========================================================================
+ * Bloom Filter Functions for Zone Maps
+ * ========================================================================
+ *
+ * Bloom filters over key bytes using FNV-1a + Murmur3 mixing with double
+ * hashing: for k hash functions, h_i(x) = (h1(x) + i * h2(x)) mod nbits.
+ * Internal items carry 64-bit filters; per-leaf bloom pages carry wider ones.
+ *
+ * Keys hash their on-disk bytes (text up to the NUL padding), so probes
+ * hash the same bytes whatever the type.  Integer keys hash their int64
+ * value, which matches the filters of indexes built before v9.
+ */
+
+#define SMOL_FNV_BASIS UINT64_C(14695981039346656037)
+#define SMOL_FNV_PRIME UINT64_C(1099511628211)
+
+/* FNV-1a over a byte string */
+static inline uint64
+smol_bloom_hash_bytes(const char *p, Size len)
+{
+    uint64 h = SMOL_FNV_BASIS;
+
+    for (Size i = 0; i < len; i++)
+    {
+        h ^= (unsigned char) p[i];
+        h *= SMOL_FNV_PRIME;
+    }
+    return h;
+}
+
+/* FNV-1a over the little-endian bytes of an int64 */
+static inline uint64
+smol_bloom_hash_int64(int64 v)
+{
+    uint64 h = SMOL_FNV_BASIS;
+
+    for (int i = 0; i < 8; i++)
+    {
+        h ^= ((uint64) v >> (i * 8)) & 0xFF;
+        h *= SMOL_FNV_PRIME;
+    }
+    return h;
+}
+
+/*
+ * smol_bloom_hash_key - primary bloom hash of an on-disk key
+ */
+uint64
+smol_bloom_hash_key(const char *key, uint16 key_len, Oid typid)
+{
+    switch (typid)
+    {
+        case INT2OID:
+        case INT4OID:
         case INT8OID:
+            return smol_bloom_hash_int64(smol_for_load_key(key, key_len));
+        case TEXTOID:
             {
-                int64 v;
-                memcpy(&v, first_key, sizeof(int64));
-                stats->minkey = (int32)v; /* Low 32 bits (truncated) */
-                memcpy(&v, last_key, sizeof(int64));
-                stats->maxkey = (int32)v;
-                break;
+                const char *z = (const char *) memchr(key, '\0', key_len);
+
+                return smol_bloom_hash_bytes(key, z ? (Size) (z - key) : (Size) key_len);
             }
-        default:
-            /* For text, UUID, and other types: use first 4 bytes */
-            /* This provides approximate filtering - good enough for zone maps */
-            if (key_len >= sizeof(int32))
+        case FLOAT4OID:
+        case FLOAT8OID:
+            /* Hash the normalized image so -0/+0 and all NaNs collide as they compare */
+            if (smol_norm_nwords(typid, key_len) == 1)
             {
-                memcpy(&stats->minkey, first_key, sizeof(int32));
-                memcpy(&stats->maxkey, last_key, sizeof(int32));
+                uint64 w;
+
+                smol_norm_key(key, key_len, typid, &w);
+                return smol_bloom_hash_int64((int64) w);
             }
-            else
+            return smol_bloom_hash_bytes(key, key_len);
+        default:
+            return smol_bloom_hash_bytes(key, key_len);
+    }
+}
+
+/*
+ * smol_bloom_hash_bound - primary bloom hash of a scan bound, equal to
+ * smol_bloom_hash_key() of the stored key it matches
+ */
+uint64
+smol_bloom_hash_bound(Datum bound, Oid typid, uint16 key_len, bool byval)
+{
+    char buf[sizeof(int64)];
+
+    switch (typid)
+    {
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+            return smol_bloom_hash_int64(smol_bound_to_int64(typid, bound, 0));
+        case TEXTOID:
             {
-                /* Pad with zeros if key is shorter than 4 bytes */
-                stats->minkey = 0;
-                stats->maxkey = 0;
-                memcpy(&stats->minkey, first_key, key_len);
-                memcpy(&stats->maxkey, last_key, key_len);
+                text *t = DatumGetTextPP(bound);
+
+                return smol_bloom_hash_bytes(VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t));
             }
+        default:
             break;
     }
+    return smol_bloom_hash_key(smol_datum_key_bytes(bound, key_len, byval, buf),
+                               byval ? Min(key_len, (uint16) sizeof(int64)) : key_len, typid);
+}
+
+/* Secondary hash: Murmur3 64-bit finalizer of the primary one */
+static inline uint64
+smol_bloom_hash2(uint64 h)
+{
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64_C(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+    return h;
+}
+
+/*
+ * smol_bloom_add - Add a key hash to a filter of nbits bits
+ */
+void
+smol_bloom_add(uint64 *bits, uint32 nbits, uint64 h, int nhash)
+{
+    uint64 h2;
+
+    if (nhash <= 0 || nhash > SMOL_BLOOM_MAX_NHASH)
+        return;  /* Invalid nhash */ /* GCOV_EXCL_LINE */
+
+    h2 = smol_bloom_hash2(h);
+    for (int i = 0; i < nhash; i++)
+    {
+        uint64 b = (h + (uint64) i * h2) % nbits;
+
+        bits[b / 64] |= (UINT64_C(1) << (b % 64));
+    }
+}
+
+/*
+ * smol_bloom_test - Test if a key hash might be in a filter of nbits bits
+ *
+ * Returns:
+ *   true  = key might be present (or false positive)
+ *   false = key definitely not present
+ * A zero 64-bit filter was never built and matches everything.
+ */
+bool
+smol_bloom_test(const uint64 *bits, uint32 nbits, uint64 h, int nhash)
+{
+    uint64 h2;
+
+    if (nbits == 64 && bits[0] == 0)
+        return true;  /* Bloom disabled or empty - assume might match */ // GCOV_EXCL_LINE
+
+#ifdef SMOL_TEST_COVERAGE
+    /* Force invalid nhash for coverage testing (lines 919,951) */
+    if (smol_test_force_invalid_nhash)
+        nhash = -1; // GCOV_EXCL_LINE
+#endif
+
+    if (nhash <= 0 || nhash > SMOL_BLOOM_MAX_NHASH)
+        return true;  /* Invalid nhash - assume might match */ // GCOV_EXCL_LINE
+
+    h2 = smol_bloom_hash2(h);
+
+#ifdef SMOL_TEST_COVERAGE
+    /* Force bloom rejection for coverage testing (line 928) */
+    if (smol_test_force_bloom_rejection)
+        return false;
+#endif
+
+    for (int i = 0; i < nhash; i++)
+    {
+        uint64 b = (h + (uint64) i * h2) % nbits;
+
+        if ((bits[b / 64] & (UINT64_C(1) << (b % 64))) == 0)
+            return false;  /* Definitely not present */
+    }
+
+    return true;  /* Might be present */
+}
+
+/*
+ * smol_bloom_fill_page - add every key of a single-column leaf to a filter
+ * of nbits bits.  inc_total is the per-row INCLUDE width (Include-RLE runs
+ * carry one copy of the INCLUDE values).
+ */
+void
+smol_bloom_fill_page(Page page, uint16 key_len, uint32 inc_total, Oid typid, int nhash,
+                     uint64 *bits, uint32 nbits)
+{
+    uint16 nitems;
+    char *p;
+    uint16 tag;
 
-    /* Estimate distinct count */
-    stats->distinct_count = smol_estimate_distinct(keys, n, key_len, typid);
+    nitems = smol_leaf_nitems(page);
+    if (nitems == 0)
+        return;  /* Empty page */ // GCOV_EXCL_LINE
 
-    /* Build bloom filter if enabled */
-    if (smol_build_bloom_filters && smol_bloom_nhash > 0)
+    p = smol1_payload(page);
+    memcpy(&tag, p, sizeof(uint16));
+
+    if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2 || tag == SMOL_TAG_INC_RLE)
     {
-        stats->bloom_filter = 0;
+        /* RLE page: add each distinct run key */
+        uint16 nruns;
+        char *rp = p + sizeof(uint16) * 3 + (tag == SMOL_TAG_KEY_RLE_V2 ? 1 : 0);
+        size_t run_len = (size_t) key_len + sizeof(uint16) + (tag == SMOL_TAG_INC_RLE ? inc_total : 0);
 
-        for (uint32 i = 0; i < n; i++)
-        {
-            const char *key = (const char *)keys + i * key_len;
-            Datum d;
+        memcpy(&nruns, p + sizeof(uint16) * 2, sizeof(uint16));
+        for (uint16 r = 0; r < nruns; r++, rp += run_len)
+            smol_bloom_add(bits, nbits, smol_bloom_hash_key(rp, key_len, typid), nhash);
+    }
+    else if (tag == SMOL_TAG_KEY_FOR)
+    {
+        /* FOR page: integer keys only, extracted one at a time */
+        SmolForLeaf f;
 
-            /* Convert key to Datum */
-            switch (typid)
-            {
-                case INT2OID:
-                    {
-                        int16 v;
-                        memcpy(&v, key, sizeof(int16));
-                        d = Int16GetDatum(v);
-                        break;
-                    }
-                case INT4OID:
-                    {
-                        int32 v;
-                        memcpy(&v, key, sizeof(int32));
-                        d = Int32GetDatum(v);
-                        break;
-                    }
-                case INT8OID:
-                    {
-                        int64 v;
-                        memcpy(&v, key, sizeof(int64));
-                        d = Int64GetDatum(v);
-                        break;
-                    }
-                default:
-                    {
-                        int64 v = 0;
-                        memcpy(&v, key, Min(sizeof(int64), key_len));
-                        d = Int64GetDatum(v);
-                        break;
-                    }
-            }
+        smol_for_open(p, &f);
+        for (uint16 i = 0; i < nitems; i++)
+            smol_bloom_add(bits, nbits, smol_bloom_hash_int64(smol_for_value(&f, i)), nhash);
+    }
+    else if (tag == SMOL_TAG_TEXT_PREFIX)
+    {
+        /* Prefix text page: rebuild each key and hash it like a plain text key */
+        SmolTextPrefixLeaf t;
+        char k[SMOL_TEXT_KEY_MAX];
 
-            smol_bloom_add(&stats->bloom_filter, d, typid, smol_bloom_nhash);
+        smol_tp_open(p, &t);
+        for (uint16 i = 0; i < nitems; i++)
+        {
+            smol_tp_key(&t, i, k, key_len);
+            smol_bloom_add(bits, nbits, smol_bloom_hash_key(k, key_len, typid), nhash);
         }
     }
-    else  /* GCOV_EXCL_LINE - Bloom disabled (nhash <= 0) - defensive fallback */
+    else
     {
-        stats->bloom_filter = 0;
+        /* Plain (or dictionary-coded INCLUDE) page: add all keys */
+        const char *keys = (tag == SMOL_TAG_INC_DICT) ? smol_incdict_keys(p)
+                                                      : p + sizeof(uint16); /* skip nitems header */
+
+        for (uint16 i = 0; i < nitems; i++)
+            smol_bloom_add(bits, nbits, smol_bloom_hash_key(keys + (size_t) i * key_len, key_len, typid), nhash);
     }
+}
 
-    stats->padding = 0;
+/*
+ * smol_bloom_build_page - 64-bit bloom filter of all keys in a leaf
+ */
+uint64
+smol_bloom_build_page(Page page, uint16 key_len, uint32 inc_total, Oid typid, int nhash)
+{
+    uint64 bloom = 0;
+
+#ifdef SMOL_TEST_COVERAGE
+    /* Force invalid nhash for coverage testing (line 951) */
+    if (smol_test_force_invalid_nhash)
+        nhash = -1; // GCOV_EXCL_LINE
+#endif
+
+    if (nhash <= 0 || nhash > SMOL_BLOOM_MAX_NHASH)
+        return 0;  /* Invalid nhash */ // GCOV_EXCL_LINE
+
+    smol_bloom_fill_page(page, key_len, inc_total, typid, nhash, &bloom, 64);
+    return bloom;
 }
 
 /*
- * ========================================================================
- * Bloom Filter Functions for Zone Maps
- * ========================================================================
- *
- * Simple 64-bit bloom filter using FNV-1a + Murmur3 mixing with double hashing.
- * For k hash functions, we use: h_i(x) = (h1(x) + i * h2(x)) mod 64
+ * smol_scan_bloom_usable - true when the scan's equality key may be tested
+ * against the bloom filters of an index with this metapage
  */
+bool
+smol_scan_bloom_usable(SmolScanOpaque so, const SmolMeta *meta)
+{
+    if (!smol_bloom_filters || !meta->bloom_enabled || meta->bloom_nhash == 0)
+        return false;
+    if (so->atttypid == INT2OID || so->atttypid == INT4OID || so->atttypid == INT8OID)
+        return true;
+    /* Earlier indexes hashed by-reference keys as pointers */
+    if (meta->version < SMOL_META_VERSION_TYPED_BLOOM)
+        return false;
+    /* ... and floats by their raw bytes, so -0 missed +0 */
+    if ((so->atttypid == FLOAT4OID || so->atttypid == FLOAT8OID) &&
+        meta->version < SMOL_META_VERSION_NORM_KEYS)
+        return false;
+    /* Non-C collations may call different bytes equal */
+    return !(so->atttypid == TEXTOID && so->use_generic_cmp);
+}
 
 /*
- * smol_bloom_hash1 - Primary hash using FNV-1a
+ * smol_leaf_bloom_test - test a key hash against the bloom of one leaf in
+ * the per-leaf bloom pages; true (might be present) for leaves without one
  */
-static uint64
-smol_bloom_hash1(Datum key, Oid typid)
+bool
+smol_leaf_bloom_test(Relation idx, const SmolMeta *meta, BlockNumber leaf, uint64 h)
 {
-    uint64 h = UINT64_C(14695981039346656037);  /* FNV offset basis */
-    uint64 val;  /* Union approach to avoid uninitialized warnings */
+    uint32 per_page = SMOL_LEAF_BLOOMS_PER_PAGE(meta->leaf_bloom_words);
+    uint32 slot;
+    Buffer buf;
+    SmolLeafBloomPageHeader *hdr;
+    bool maybe;
 
-    /* Convert datum to uint64 for consistent hashing */
-    switch (typid)
+    if (!smol_meta_has_leaf_blooms(meta) || leaf < meta->leaf_bloom_first ||
+        leaf - meta->leaf_bloom_first >= meta->leaf_bloom_nslots)
+        return true;
+    slot = leaf - meta->leaf_bloom_first;
+    buf = ReadBuffer(idx, meta->leaf_bloom_blkno + slot / per_page);
+    hdr = (SmolLeafBloomPageHeader *) PageGetContents(BufferGetPage(buf));
+    SMOL_DEFENSIVE_CHECK(hdr->magic == SMOL_LEAF_BLOOM_MAGIC && hdr->nwords == meta->leaf_bloom_words, ERROR,
+                         (errmsg("smol: bad leaf bloom page for leaf %u", leaf)));
+    maybe = smol_bloom_test((const uint64 *) ((char *) hdr + sizeof(SmolLeafBloomPageHeader)) +
+                            (Size) (slot % per_page) * hdr->nwords,
+                            (uint32) hdr->nwords * 64, h, meta->bloom_nhash);
+    ReleaseBuffer(buf);
+    return maybe;
+}
+
+/*
+ * smol_build_and_write_leaf_blooms - write the per-leaf bloom pages
+ *
+ * Called after the tree (and leaf directory) are complete.  Walks the leaf
+ * chain once, filling one smol.bloom_leaf_bits filter per leaf, and writes
+ * the slots to consecutive new pages as each page fills.  Leaves must come
+ * in increasing block order, as builds write them.  Sets the v9 fields of
+ * *meta (the caller writes the metapage) and returns the first bloom page,
+ * or InvalidBlockNumber when blooms are off or the leaves are out of order.
+ */
+BlockNumber
+smol_build_and_write_leaf_blooms(Relation idx, SmolMeta *meta)
+{
+    Oid typid = TupleDescAttr(RelationGetDescr(idx), 0)->atttypid;
+    uint16 nwords = (uint16) ((smol_bloom_leaf_bits + 63) / 64);
+    uint32 per_page;
+    uint32 inc_total = 0;
+    BufferAccessStrategy strategy;
+    Buffer buf;
+    Page page;
+    BlockNumber leaf;
+    BlockNumber first_leaf;
+    BlockNumber prev_leaf = InvalidBlockNumber;
+    BlockNumber first_page = InvalidBlockNumber;
+    BlockNumber nblocks;
+    uint64 *slots;
+    uint32 page_first = 0;      /* slot of slots[0] */
+    uint32 nslots = 0;
+    BlockNumber npages = 0;
+
+    meta->leaf_bloom_words = 0;
+    meta->leaf_bloom_blkno = InvalidBlockNumber;
+    meta->leaf_bloom_first = InvalidBlockNumber;
+    meta->leaf_bloom_nslots = 0;
+    if (nwords == 0 || !meta->bloom_enabled || meta->bloom_nhash == 0 || meta->nkeyatts != 1 ||
+        meta->height < 1 || !BlockNumberIsValid(meta->root_blkno))
+        return InvalidBlockNumber;
+    for (int c = 0; c < meta->inc_count; c++)
+        inc_total += meta->inc_len[c];
+    per_page = SMOL_LEAF_BLOOMS_PER_PAGE(nwords);
+    nblocks = RelationGetNumberOfBlocks(idx);
+
+    /* Find leftmost leaf by descending from root */
+    leaf = meta->root_blkno;
+    for (int level = meta->height; level > 1; level--)
     {
-        case INT2OID:
-            val = (uint64) DatumGetInt16(key);
-            break;
-        case INT4OID:
-            val = (uint64) DatumGetInt32(key);
-            break;
-        case INT8OID:
-            val = (uint64) DatumGetInt64(key);
-            break;
-        default:
-            /* Fallback: hash the datum itself (works for pass-by-value types) */
-            val = (uint64) key;
-            break;
+        SmolZoneItem item;
+
+        buf = ReadBuffer(idx, leaf);
+        smol_internal_item_read(BufferGetPage(buf), FirstOffsetNumber, meta, &item);
+        leaf = item.child;
+        ReleaseBuffer(buf);
     }
+    first_leaf = leaf;
 
-    /* FNV-1a: h = (h XOR byte) * FNV_prime */
-    for (int i = 0; i < 8; i++)
+    slots = (uint64 *) palloc((Size) per_page * nwords * sizeof(uint64));
+    memset(slots, 0xFF, (Size) per_page * nwords * sizeof(uint64));
+    strategy = GetAccessStrategy(BAS_BULKREAD);
+    for (;;)
     {
-        h ^= (val >> (i * 8)) & 0xFF;
-        h *= UINT64_C(1099511628211);  /* FNV prime */
+        bool done = !BlockNumberIsValid(leaf);
+        uint32 slot = done ? 0 : leaf - first_leaf;
+
+        if (!done && (leaf >= nblocks || (BlockNumberIsValid(prev_leaf) && leaf <= prev_leaf)))
+        { /* GCOV_EXCL_START - builds write leaves in rightlink order */
+            FreeAccessStrategy(strategy);
+            pfree(slots);
+            return InvalidBlockNumber;
+        } /* GCOV_EXCL_STOP */
+
+        /* Flush full pages (and the last one) before placing this leaf */
+        while (done ? nslots > page_first : slot >= page_first + per_page)
+        {
+            SmolLeafBloomPageHeader *hdr;
+            uint32 cnt = done ? Min(per_page, nslots - page_first) : per_page;
+
+            buf = ReadBufferExtended(idx, MAIN_FORKNUM, P_NEW, RBM_NORMAL, NULL);
+            LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+            if (npages == 0)
+                first_page = BufferGetBlockNumber(buf);
+            SMOL_DEFENSIVE_CHECK(BufferGetBlockNumber(buf) == first_page + npages, ERROR,
+                                 (errmsg("smol: leaf bloom pages are not consecutive")));
+            page = BufferGetPage(buf);
+            PageInit(page, BLCKSZ, 0);  /* No special area */
+            hdr = (SmolLeafBloomPageHeader *) PageGetContents(page);
+            hdr->magic = SMOL_LEAF_BLOOM_MAGIC;
+            hdr->first_slot = page_first;
+            hdr->page_slots = (uint16) cnt;
+            hdr->nwords = nwords;
+            hdr->padding = 0;
+            memcpy((char *) hdr + sizeof(SmolLeafBloomPageHeader), slots, (Size) cnt * nwords * sizeof(uint64));
+            MarkBufferDirty(buf);
+            UnlockReleaseBuffer(buf);
+            npages++;
+            page_first += per_page;
+            memset(slots, 0xFF, (Size) per_page * nwords * sizeof(uint64));
+        }
+        if (done)
+            break;
+
+        /* Slots of skipped (internal) blocks stay all ones */
+        buf = ReadBufferExtended(idx, MAIN_FORKNUM, leaf, RBM_NORMAL, strategy);
+        page = BufferGetPage(buf);
+        {
+            uint64 *bits = slots + (Size) (slot - page_first) * nwords;
+
+            memset(bits, 0, (Size) nwords * sizeof(uint64));
+            smol_bloom_fill_page(page, meta->key_len1, inc_total, typid, meta->bloom_nhash, bits, (uint32) nwords * 64);
+        }
+        nslots = slot + 1;
+        prev_leaf = leaf;
+        leaf = smol_page_opaque(page)->rightlink;
+        ReleaseBuffer(buf);
     }
+    FreeAccessStrategy(strategy);
+    pfree(slots);
+
+    meta->leaf_bloom_words = nwords;
+    meta->leaf_bloom_blkno = first_page;
+    meta->leaf_bloom_first = first_leaf;
+    meta->leaf_bloom_nslots = nslots;
+    SMOL_LOGF("wrote %u leaf bloom slots of %u bits over %u pages at block %u",
+              nslots, (unsigned) nwords * 64, npages, first_page);
+    return first_page;
+}
 
-    return h;
+static inline int64
+smol_inc_zone_read_int(const char *p, uint16 len)
+{
+    if (len == 2)
+    { int16 v; memcpy(&v, p, 2); return v; }
+    if (len == 4)
+    { int32 v; memcpy(&v, p, 4); return v; }
+    { int64 v; memcpy(&v, p, 8); return v; }
+}
+
+/* Widen slot z to cover value v of its summarized column zc */
+static inline void
+smol_inc_zone_note(SmolIncZoneSlot *z, int zc, int64 v)
+{
+    if (v < z->bounds[2 * zc])
+        z->bounds[2 * zc] = v;
+    if (v > z->bounds[2 * zc + 1])
+        z->bounds[2 * zc + 1] = v;
 }
 
 /*
- * smol_bloom_hash2 - Secondary hash using Murmur3 finalizer
+ * Fill zone z from the INCLUDE columns of one single-key leaf.  Layouts
+ * without INCLUDE columns (key RLE, FOR, text prefix) keep the full range.
  */
-static uint64
-smol_bloom_hash2(Datum key, Oid typid)
+static void
+smol_inc_zone_fill_page(Page page, const SmolMeta *meta, SmolIncZoneSlot *z)
 {
-    uint64 h = smol_bloom_hash1(key, typid);
+    char *p = smol1_payload(page);
+    uint16 key_len = meta->key_len1;
+    uint32 inc_total = 0;
+    uint32 off[16];
+    uint16 tag;
+    int zc = 0;
 
-    /* Murmur3 64-bit finalizer for additional mixing */
-    h ^= h >> 33;
-    h *= UINT64_C(0xff51afd7ed558ccd);
-    h ^= h >> 33;
-    h *= UINT64_C(0xc4ceb9fe1a85ec53);
-    h ^= h >> 33;
+    for (int c = 0; c < meta->inc_count; c++)
+    {
+        off[c] = inc_total;
+        inc_total += meta->inc_len[c];
+    }
+    memcpy(&tag, p, sizeof(uint16));
+    if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2 ||
+        tag == SMOL_TAG_KEY_FOR || tag == SMOL_TAG_TEXT_PREFIX)
+        return;
 
-    return h;
+    /* Start from an empty range and widen it row by row */
+    if (tag == SMOL_TAG_INC_RLE || tag == SMOL_TAG_INC_DICT)
+    {
+        uint16 nitems;
+
+        memcpy(&nitems, p + sizeof(uint16), sizeof(uint16));
+        z->nrows = nitems;
+    }
+    else
+        z->nrows = tag;
+    for (int c = 0; c < meta->inc_zone_ncols; c++)
+    {
+        z->bounds[2 * c] = PG_INT64_MAX;
+        z->bounds[2 * c + 1] = PG_INT64_MIN;
+    }
+    for (int c = 0; c < meta->inc_count; c++)
+    {
+        uint16 len = meta->inc_len[c];
+
+        if ((meta->inc_zone_mask & (1u << c)) == 0)
+            continue;
+        if (tag == SMOL_TAG_INC_RLE)
+        {
+            /* [tag][nitems][nruns] runs of [key][u16 cnt][inc1][inc2]... */
+            uint16 nruns;
+            char *rp = p + sizeof(uint16) * 3;
+
+            memcpy(&nruns, p + sizeof(uint16) * 2, sizeof(uint16));
+            for (uint16 r = 0; r < nruns; r++)
+            {
+                smol_inc_zone_note(z, zc, smol_inc_zone_read_int(rp + key_len + sizeof(uint16) + off[c], len));
+                rp += key_len + sizeof(uint16) + inc_total;
+            }
+        }
+        else
+        {
+            uint16 n;
+            char *keys = smol_leaf_plain_keys(page, &n);
+
+            if (tag == SMOL_TAG_INC_DICT)
+            {
+                /* Every dictionary entry occurs on the page */
+                SmolIncDictCol col;
+
+                smol_incdict_col(p, (uint16) c, len, &col);
+                if (col.ndict > 0)
+                    for (uint16 d = 0; d < col.ndict; d++)
+                        smol_inc_zone_note(z, zc, smol_inc_zone_read_int(col.vals + (size_t) d * len, len));
+                else
+                    for (uint16 i = 0; i < n; i++)
+                        smol_inc_zone_note(z, zc, smol_inc_zone_read_int(col.vals + (size_t) i * len, len));
+            }
+            else
+            {
+                /* Plain: [u16 n][keys][inc1 block][inc2 block]... */
+                const char *vals = keys + (size_t) n * key_len + (size_t) n * off[c];
+
+                for (uint16 i = 0; i < n; i++)
+                    smol_inc_zone_note(z, zc, smol_inc_zone_read_int(vals + (size_t) i * len, len));
+            }
+        }
+        zc++;
+    }
+}
+
+/* Reset n zones to "no leaf": read it, and match every value */
+static void
+smol_inc_zone_clear(char *slots, uint32 n, Size slot_bytes, int ncols)
+{
+    for (uint32 i = 0; i < n; i++)
+    {
+        SmolIncZoneSlot *z = (SmolIncZoneSlot *) (slots + (Size) i * slot_bytes);
+
+        z->next = InvalidBlockNumber;
+        z->nrows = 0;
+        for (int c = 0; c < ncols; c++)
+        {
+            z->bounds[2 * c] = PG_INT64_MIN;
+            z->bounds[2 * c + 1] = PG_INT64_MAX;
+        }
+    }
 }
 
 /*
- * smol_bloom_add - Add a key to bloom filter
+ * smol_inc_zone_slot - zone of one leaf in the INCLUDE zone pages, or NULL
+ * for leaves without one.  *zbuf keeps the last zone page pinned between
+ * calls (InvalidBuffer at first); the caller releases it.
+ */
+const SmolIncZoneSlot *
+smol_inc_zone_slot(Relation idx, const SmolMeta *meta, BlockNumber leaf, Buffer *zbuf)
+{
+    uint32 per_page = SMOL_INC_ZONES_PER_PAGE(meta->inc_zone_ncols);
+    uint32 slot;
+    BlockNumber zblk;
+    SmolIncZonePageHeader *hdr;
+
+    if (!smol_meta_has_inc_zones(meta) || leaf < meta->inc_zone_first ||
+        leaf - meta->inc_zone_first >= meta->inc_zone_nslots)
+        return NULL;
+    slot = leaf - meta->inc_zone_first;
+    zblk = meta->inc_zone_blkno + slot / per_page;
+    if (!BufferIsValid(*zbuf) || BufferGetBlockNumber(*zbuf) != zblk)
+    {
+        if (BufferIsValid(*zbuf))
+            ReleaseBuffer(*zbuf);
+        *zbuf = ReadBuffer(idx, zblk);
+    }
+    hdr = (SmolIncZonePageHeader *) PageGetContents(BufferGetPage(*zbuf));
+    SMOL_DEFENSIVE_CHECK(hdr->magic == SMOL_INC_ZONE_MAGIC && hdr->ncols == meta->inc_zone_ncols, ERROR,
+                         (errmsg("smol: bad INCLUDE zone page for leaf %u", leaf)));
+    return (const SmolIncZoneSlot *) ((char *) hdr + sizeof(SmolIncZonePageHeader) +
+                                      (Size) (slot % per_page) * SMOL_INC_ZONE_SLOT_BYTES(hdr->ncols));
+}
+
+/*
+ * smol_build_and_write_inc_zones - write the per-leaf INCLUDE zone pages
  *
- * Uses double hashing: h_i(x) = (h1(x) + i * h2(x)) mod 64
+ * Called after the leaf blooms.  Summarizes every int2/int4/int8 INCLUDE
+ * column; walks the leaf chain once like smol_build_and_write_leaf_blooms
+ * and writes the slots to consecutive new pages as each page fills.  Sets
+ * the v10 fields of *meta (the caller writes the metapage) and returns the
+ * first zone page, or InvalidBlockNumber when there is nothing to summarize.
  */
-void
-smol_bloom_add(uint64 *bloom, Datum key, Oid typid, int nhash)
+BlockNumber
+smol_build_and_write_inc_zones(Relation idx, SmolMeta *meta)
 {
-    uint64 h1, h2;
+    TupleDesc desc = RelationGetDescr(idx);
+    uint16 mask = 0;
+    uint16 ncols = 0;
+    Size slot_bytes;
+    uint32 per_page;
+    BufferAccessStrategy strategy;
+    Buffer buf;
+    Page page;
+    BlockNumber leaf;
+    BlockNumber first_leaf;
+    BlockNumber prev_leaf = InvalidBlockNumber;
+    BlockNumber first_page = InvalidBlockNumber;
+    BlockNumber nblocks;
+    char *slots;
+    uint32 page_first = 0;      /* slot of slots[0] */
+    uint32 nslots = 0;
+    BlockNumber npages = 0;
+
+    meta->inc_zone_mask = 0;
+    meta->inc_zone_ncols = 0;
+    meta->inc_zone_blkno = InvalidBlockNumber;
+    meta->inc_zone_first = InvalidBlockNumber;
+    meta->inc_zone_nslots = 0;
+    if (meta->nkeyatts != 1 || meta->height < 1 || !BlockNumberIsValid(meta->root_blkno))
+        return InvalidBlockNumber;
+    for (int c = 0; c < meta->inc_count && c < 16; c++)
+    {
+        Oid typid = TupleDescAttr(desc, 1 + c)->atttypid;
 
-    if (nhash <= 0 || nhash > 4)
-        return;  /* Invalid nhash */ /* GCOV_EXCL_LINE */
+        if (typid == INT2OID || typid == INT4OID || typid == INT8OID)
+        {
+            mask |= (uint16) (1u << c);
+            ncols++;
+        }
+    }
+    if (ncols == 0)
+        return InvalidBlockNumber;
+    meta->inc_zone_mask = mask;
+    meta->inc_zone_ncols = ncols;
+    slot_bytes = SMOL_INC_ZONE_SLOT_BYTES(ncols);
+    per_page = SMOL_INC_ZONES_PER_PAGE(ncols);
+    nblocks = RelationGetNumberOfBlocks(idx);
+
+    /* Find leftmost leaf by descending from root */
+    leaf = meta->root_blkno;
+    for (int level = meta->height; level > 1; level--)
+    {
+        SmolZoneItem item;
 
-    h1 = smol_bloom_hash1(key, typid);
-    h2 = smol_bloom_hash2(key, typid);
+        buf = ReadBuffer(idx, leaf);
+        smol_internal_item_read(BufferGetPage(buf), FirstOffsetNumber, meta, &item);
+        leaf = item.child;
+        ReleaseBuffer(buf);
+    }
+    first_leaf = leaf;
 
-    for (int i = 0; i < nhash; i++)
+    slots = (char *) palloc((Size) per_page * slot_bytes);
+    smol_inc_zone_clear(slots, per_page, slot_bytes, ncols);
+    strategy = GetAccessStrategy(BAS_BULKREAD);
+    for (;;)
     {
-        uint64 h = (h1 + (uint64)i * h2) % 64;
-        *bloom |= (UINT64_C(1) << h);
+        bool done = !BlockNumberIsValid(leaf);
+        uint32 slot = done ? 0 : leaf - first_leaf;
+
+        if (!done && (leaf >= nblocks || (BlockNumberIsValid(prev_leaf) && leaf <= prev_leaf)))
+        { /* GCOV_EXCL_START - builds write leaves in rightlink order */
+            FreeAccessStrategy(strategy);
+            pfree(slots);
+            meta->inc_zone_mask = 0;
+            meta->inc_zone_ncols = 0;
+            return InvalidBlockNumber;
+        } /* GCOV_EXCL_STOP */
+
+        /* Flush full pages (and the last one) before placing this leaf */
+        while (done ? nslots > page_first : slot >= page_first + per_page)
+        {
+            SmolIncZonePageHeader *hdr;
+            uint32 cnt = done ? Min(per_page, nslots - page_first) : per_page;
+
+            buf = ReadBufferExtended(idx, MAIN_FORKNUM, P_NEW, RBM_NORMAL, NULL);
+            LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+            if (npages == 0)
+                first_page = BufferGetBlockNumber(buf);
+            SMOL_DEFENSIVE_CHECK(BufferGetBlockNumber(buf) == first_page + npages, ERROR,
+                                 (errmsg("smol: INCLUDE zone pages are not consecutive")));
+            page = BufferGetPage(buf);
+            PageInit(page, BLCKSZ, 0);  /* No special area */
+            hdr = (SmolIncZonePageHeader *) PageGetContents(page);
+            hdr->magic = SMOL_INC_ZONE_MAGIC;
+            hdr->first_slot = page_first;
+            hdr->page_slots = (uint16) cnt;
+            hdr->ncols = ncols;
+            hdr->padding = 0;
+            memcpy((char *) hdr + sizeof(SmolIncZonePageHeader), slots, (Size) cnt * slot_bytes);
+            MarkBufferDirty(buf);
+            UnlockReleaseBuffer(buf);
+            npages++;
+            page_first += per_page;
+            smol_inc_zone_clear(slots, per_page, slot_bytes, ncols);
+        }
+        if (done)
+            break;
+
+        /* Slots of skipped (internal) blocks keep the full range */
+        buf = ReadBufferExtended(idx, MAIN_FORKNUM, leaf, RBM_NORMAL, strategy);
+        page = BufferGetPage(buf);
+        {
+            SmolIncZoneSlot *z = (SmolIncZoneSlot *) (slots + (Size) (slot - page_first) * slot_bytes);
+
+            smol_inc_zone_fill_page(page, meta, z);
+            /* The last leaf may gain a right sibling through smol_append */
+            z->next = smol_page_opaque(page)->rightlink;
+        }
+        nslots = slot + 1;
+        prev_leaf = leaf;
+        leaf = smol_page_opaque(page)->rightlink;
+        ReleaseBuffer(buf);
     }
+    FreeAccessStrategy(strategy);
+    pfree(slots);
+
+    meta->inc_zone_blkno = first_page;
+    meta->inc_zone_first = first_leaf;
+    meta->inc_zone_nslots = nslots;
+    SMOL_LOGF("wrote %u INCLUDE zone slots of %u columns over %u pages at block %u",
+              nslots, (unsigned) ncols, npages, first_page);
+    return first_page;
 }
 
 /*
- * smol_bloom_test - Test if key might be in bloom filter
+ * Leaf Directory Functions for Parallel Scan Optimization
  *
- * Returns:
- *   true  = key might be present (or false positive)
- *   false = key definitely not present
+ * These will be appended to smol_utils.c
  */
-bool
-smol_bloom_test(uint64 bloom, Datum key, Oid typid, int nhash)
+
+/*
+ * smol_build_and_write_directory - Build leaf directory after index construction
+ *
+ * Called AFTER the index is completely built (all leaves written, tree complete).
+ * Walks the rightlinks twice: once to count leaves and rows, then to cut
+ * entries every ~total_rows/entries rows, so partitions carry equal work even
+ * when leaves hold very different row counts (RLE vs plain).  Entries are
+ * written to consecutive new pages.
+ * Returns the first directory block, or InvalidBlockNumber when the index
+ * has fewer than SMOL_DIR_MIN_LEAVES leaves or its leaf block numbers do not
+ * increase along the rightlinks (parallel scans detect the end of a directory
+ * entry by comparing block numbers).
+ */
+BlockNumber
+smol_build_and_write_directory(Relation idx)
 {
-    uint64 h1, h2;
+    SmolMeta meta;
+    Oid typid = TupleDescAttr(RelationGetDescr(idx), 0)->atttypid;
+    BufferAccessStrategy strategy;
+    SmolDirEntry *entries;
+    Buffer buf;
+    Page page;
+    BlockNumber dir_blk = InvalidBlockNumber;
+    BlockNumber first_leaf;
+    BlockNumber leaf;
+    BlockNumber prev_leaf = InvalidBlockNumber;
+    BlockNumber nblocks;
+    uint32 total_leaves = 0;
+    uint64 total_rows = 0;
+    uint32 target;
+    uint64 rows_per_entry;
+    uint64 acc = 0;
+    uint32 nentries = 0;
+    uint16 zkey_len;
+    uint16 npages;
 
-    if (bloom == 0)
-        return true;  /* Bloom disabled or empty - assume might match */ // GCOV_EXCL_LINE
+    smol_meta_read(idx, &meta);
+    if (meta.height < 1)
+        return InvalidBlockNumber;
+    zkey_len = smol_meta_zkey_len(&meta);
+    nblocks = RelationGetNumberOfBlocks(idx);
 
-#ifdef SMOL_TEST_COVERAGE
-    /* Force invalid nhash for coverage testing (lines 919,951) */
-    if (smol_test_force_invalid_nhash)
-        nhash = -1; // GCOV_EXCL_LINE
-#endif
+    /* Find leftmost leaf by descending from root */
+    leaf = meta.root_blkno;
+    for (int level = meta.height; level > 1; level--)
+    {
+        SmolZoneItem item;
 
-    if (nhash <= 0 || nhash > 4)
-        return true;  /* Invalid nhash - assume might match */ // GCOV_EXCL_LINE
+        buf = ReadBuffer(idx, leaf);
+        page = BufferGetPage(buf);
+        smol_internal_item_read(page, FirstOffsetNumber, &meta, &item);
+        leaf = item.child;
+        ReleaseBuffer(buf);
+    }
+    if (!BlockNumberIsValid(leaf))
+        return InvalidBlockNumber; /* GCOV_EXCL_LINE - defensive */
+    first_leaf = leaf;
+
+    /* Pass 1: count leaves and rows, check block order */
+    strategy = GetAccessStrategy(BAS_BULKREAD);
+    while (BlockNumberIsValid(leaf))
+    {
+        if (leaf >= nblocks || (BlockNumberIsValid(prev_leaf) && leaf <= prev_leaf))
+        { /* GCOV_EXCL_START - builds write leaves in rightlink order */
+            FreeAccessStrategy(strategy);
+            return InvalidBlockNumber;
+        } /* GCOV_EXCL_STOP */
+        prev_leaf = leaf;
+        buf = ReadBufferExtended(idx, MAIN_FORKNUM, leaf, RBM_NORMAL, strategy);
+        page = BufferGetPage(buf);
+        total_leaves++;
+        total_rows += smol_leaf_nitems(page);
+        leaf = smol_page_opaque(page)->rightlink;
+        ReleaseBuffer(buf);
+    }
+    if (total_leaves < SMOL_DIR_MIN_LEAVES)
+    {
+        FreeAccessStrategy(strategy);
+        return InvalidBlockNumber;
+    }
 
-    h1 = smol_bloom_hash1(key, typid);
-    h2 = smol_bloom_hash2(key, typid);
+    target = Min(total_leaves, (uint32) SMOL_DIR_MAX_ENTRIES);
+    rows_per_entry = Max((total_rows + target - 1) / target, (uint64) 1);
+    entries = (SmolDirEntry *) palloc0(sizeof(SmolDirEntry) * target);
 
-#ifdef SMOL_TEST_COVERAGE
-    /* Force bloom rejection for coverage testing (line 928) */
-    if (smol_test_force_bloom_rejection)
+    /* Pass 2: start a new entry once the current one holds rows_per_entry rows */
+    leaf = first_leaf;
+    while (BlockNumberIsValid(leaf))
     {
-        /* Clear the first bit that would be checked to force rejection */
-        uint64 h = (h1 + 0 * h2) % 64;
-        bloom &= ~(UINT64_C(1) << h);
+        uint16 n;
+
+        buf = ReadBufferExtended(idx, MAIN_FORKNUM, leaf, RBM_NORMAL, strategy);
+        page = BufferGetPage(buf);
+        n = smol_leaf_nitems(page);
+        if (nentries == 0 || (acc >= rows_per_entry && nentries < target))
+        {
+            SmolDirEntry *e = &entries[nentries++];
+
+            e->leaf_blkno = leaf;
+            if (n > 0)
+                smol_zkey_from_keyptr(e->minkey, zkey_len,
+                                      smol_leaf_keyptr_ex(page, 1, meta.key_len1, NULL, 0, NULL),
+                                      meta.key_len1, typid);
+            acc = 0;
+        }
+        entries[nentries - 1].row_count += n;
+        acc += n;
+        leaf = smol_page_opaque(page)->rightlink;
+        ReleaseBuffer(buf);
     }
-#endif
+    FreeAccessStrategy(strategy);
 
-    for (int i = 0; i < nhash; i++)
+    /* Write entries to consecutive pages; the first page header owns the totals */
+    npages = (uint16) ((nentries + SMOL_DIR_ENTRIES_PER_PAGE - 1) / SMOL_DIR_ENTRIES_PER_PAGE);
+    for (uint16 pg = 0; pg < npages; pg++)
     {
-        uint64 h = (h1 + (uint64)i * h2) % 64;
-        if ((bloom & (UINT64_C(1) << h)) == 0)
-            return false;  /* Definitely not present */
+        uint32 first = (uint32) pg * SMOL_DIR_ENTRIES_PER_PAGE;
+        uint16 cnt = (uint16) Min((uint32) SMOL_DIR_ENTRIES_PER_PAGE, nentries - first);
+        SmolDirPageHeader *hdr;
+
+        buf = ReadBufferExtended(idx, MAIN_FORKNUM, P_NEW, RBM_NORMAL, NULL);
+        LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+        if (pg == 0)
+            dir_blk = BufferGetBlockNumber(buf);
+        SMOL_DEFENSIVE_CHECK(BufferGetBlockNumber(buf) == dir_blk + pg, ERROR,
+                             (errmsg("smol: directory pages are not consecutive")));
+        page = BufferGetPage(buf);
+        PageInit(page, BLCKSZ, 0);  /* No special area */
+        hdr = (SmolDirPageHeader *) PageGetContents(page);
+        hdr->magic = SMOL_DIR_MAGIC;
+        hdr->num_entries = nentries;
+        hdr->npages = npages;
+        hdr->zkey_len = zkey_len;
+        hdr->page_entries = cnt;
+        hdr->padding = 0;
+        memcpy((char *) hdr + sizeof(SmolDirPageHeader), &entries[first], cnt * sizeof(SmolDirEntry));
+        MarkBufferDirty(buf);
+        UnlockReleaseBuffer(buf);
     }
 
-    return true;  /* Might be present */
+    SMOL_LOGF("built leaf directory with %u entries over %u pages (%u leaves, %lu rows, ~%lu rows/entry) at block %u",
+              nentries, npages, total_leaves, (unsigned long) total_rows,
+              (unsigned long) rows_per_entry, dir_blk);
+    pfree(entries);
+
+    return dir_blk;
 }
 
 /*
- * smol_bloom_build_page - Build bloom filter for all keys in a page
+ * smol_leaf_count_distinct - count the leading-key changes on one leaf
  *
- * This is a placeholder for now - will be implemented when we integrate
- * with the build path. For single-column plain pages, we'll scan the
- * key array and add each key to the bloom filter.
+ * 'prev' holds the last key of the previous leaf (valid when *have_prev) and
+ * is updated to this leaf's last key, so a value spanning leaves counts once.
  */
-uint64
-smol_bloom_build_page(Page page, uint16 key_len, Oid typid, int nhash)
+static double
+smol_leaf_count_distinct(Page page, const SmolMeta *meta, uint32 inc_total, char *prev, bool *have_prev)
 {
-    uint64 bloom = 0;
-    uint16 nitems;
-    ItemId iid;
-    char *p;
+    char *p = (char *) PageGetItem(page, PageGetItemId(page, FirstOffsetNumber));
+    uint16 key_len = meta->key_len1;
+    double distinct = 0;
     uint16 tag;
 
-#ifdef SMOL_TEST_COVERAGE
-    /* Force invalid nhash for coverage testing (line 951) */
-    if (smol_test_force_invalid_nhash)
-        nhash = -1; // GCOV_EXCL_LINE
-#endif
+    if (meta->nkeyatts == 2 && smol12_is_grouped(p))
+    {
+        /* One directory entry per k1 run; only the first may continue the previous leaf */
+        uint16 ng = smol12_ngroups(p);
+
+        for (uint16 g = 0; g < ng; g++)
+        {
+            char *k = smol12_group_k1(p, g, key_len);
 
-    if (nhash <= 0 || nhash > 4)
-        return 0;  /* Invalid nhash */ // GCOV_EXCL_LINE
+            if (g > 0 || !*have_prev || !smol_key_eq_len(k, prev, key_len))
+                distinct++;
+            if (g == ng - 1)
+                memcpy(prev, k, key_len);
+        }
+        *have_prev = true;
+        return distinct;
+    }
+    if (meta->nkeyatts == 2)
+    {
+        uint16 n = smol12_leaf_nrows(page);
 
-    /* Get number of items in page */
-    nitems = smol_leaf_nitems(page);
-    if (nitems == 0)
-        return 0;  /* Empty page */ // GCOV_EXCL_LINE
+        for (uint16 r = 1; r <= n; r++)
+        {
+            char *k = smol12_row_k1_ptr(page, r, key_len, meta->key_len2, inc_total);
 
-    /* Get pointer to page data */
-    iid = PageGetItemId(page, FirstOffsetNumber);
-    p = (char *) PageGetItem(page, iid);
+            if (!*have_prev || !smol_key_eq_len(k, prev, key_len))
+                distinct++;
+            memcpy(prev, k, key_len);
+            *have_prev = true;
+        }
+        return distinct;
+    }
 
-    /* Check if this is an RLE page or plain page */
     memcpy(&tag, p, sizeof(uint16));
+    if (tag == SMOL_TAG_KEY_FOR)
+    {
+        SmolForLeaf f;
+        char k[sizeof(int64)];
+
+        smol_for_open(p, &f);
+        for (uint32 i = 0; i < f.nitems; i++)
+        {
+            smol_for_store_key(k, smol_for_value(&f, i), key_len);
+            if (!*have_prev || !smol_key_eq_len(k, prev, key_len))
+                distinct++;
+            memcpy(prev, k, key_len);
+            *have_prev = true;
+        }
+    }
+    else if (tag == SMOL_TAG_TEXT_PREFIX)
+    {
+        SmolTextPrefixLeaf t;
+        char k[SMOL_TEXT_KEY_MAX];
 
-    if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2)
+        smol_tp_open(p, &t);
+        for (uint32 i = 0; i < t.nitems; i++)
+        {
+            smol_tp_key(&t, i, k, key_len);
+            if (!*have_prev || !smol_key_eq_len(k, prev, key_len))
+                distinct++;
+            memcpy(prev, k, key_len);
+            *have_prev = true;
+        }
+    }
+    else if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2 || tag == SMOL_TAG_INC_RLE)
     {
-        /* RLE page: decode runs and add distinct keys to bloom filter */
         uint16 nruns;
-        p += sizeof(uint16); /* skip tag */
-        p += sizeof(uint16); /* skip nitems */
-        memcpy(&nruns, p, sizeof(uint16)); p += sizeof(uint16);
+        char *rp = p + sizeof(uint16) * 3;
+        size_t run_len = (size_t) key_len + sizeof(uint16) + (tag == SMOL_TAG_INC_RLE ? inc_total : 0);
 
+        memcpy(&nruns, p + sizeof(uint16) * 2, sizeof(uint16));
         if (tag == SMOL_TAG_KEY_RLE_V2)
-            p++; /* skip continues_byte */
-
-        /* Add each distinct run key to bloom filter */
-        for (uint16 r = 0; r < nruns; r++)
+            rp++;  /* continues byte */
+        for (uint16 r = 0; r < nruns; r++, rp += run_len)
         {
-            Datum d;
-            char *run_key = p;
-
-            /* Extract datum based on key type */
-            switch (typid)
-            {
-                case INT2OID:
-                    {
-                        int16 v;
-                        memcpy(&v, run_key, sizeof(int16));
-                        d = Int16GetDatum(v);
-                        break;
-                    }
-                case INT4OID:
-                    {
-                        int32 v;
-                        memcpy(&v, run_key, sizeof(int32));
-                        d = Int32GetDatum(v);
-                        break;
-                    }
-                case INT8OID:
-                    {
-                        int64 v;
-                        memcpy(&v, run_key, sizeof(int64));
-                        d = Int64GetDatum(v);
-                        break;
-                    }
-                /* GCOV_EXCL_START */
-                default:
-                    /* For other types, treat as int64 for now */
-                    {
-                        int64 v;
-                        memcpy(&v, run_key, Min(sizeof(int64), key_len));
-                        d = Int64GetDatum(v);
-                        break;
-                    }
-                /* GCOV_EXCL_STOP */
-            }
-
-            smol_bloom_add(&bloom, d, typid, nhash);
-
-            /* Move to next run: skip key + count */
-            p += key_len + sizeof(uint16);
+            if (!*have_prev || !smol_key_eq_len(rp, prev, key_len))
+                distinct++;
+            memcpy(prev, rp, key_len);
+            *have_prev = true;
         }
     }
     else
     {
-        /* Plain page: add all keys to bloom filter */
-        const char *keys = p + sizeof(uint16); /* skip nitems header */
+        uint16 n = tag;
+        char *k = p + sizeof(uint16);
 
-        for (uint16 i = 0; i < nitems; i++)
+        if (tag == SMOL_TAG_INC_DICT)
         {
-            Datum d;
-
-            /* Extract datum based on key type */
-            switch (typid)
-            {
-                case INT2OID: // GCOV_EXCL_LINE
-                    { // GCOV_EXCL_LINE
-                        int16 v; // GCOV_EXCL_LINE
-                        memcpy(&v, keys + i * key_len, sizeof(int16)); // GCOV_EXCL_LINE
-                        d = Int16GetDatum(v); // GCOV_EXCL_LINE
-                        break; // GCOV_EXCL_LINE
-                    } // GCOV_EXCL_LINE
-                case INT4OID:
-                    {
-                        int32 v;
-                        memcpy(&v, keys + i * key_len, sizeof(int32));
-                        d = Int32GetDatum(v);
-                        break;
-                    }
-                case INT8OID:
-                    {
-                        int64 v;
-                        memcpy(&v, keys + i * key_len, sizeof(int64));
-                        d = Int64GetDatum(v);
-                        break;
-                    }
-                default: // GCOV_EXCL_LINE
-                    /* For other types, treat as int64 for now */ // GCOV_EXCL_LINE
-                    { // GCOV_EXCL_LINE
-                        int64 v; // GCOV_EXCL_LINE
-                        memcpy(&v, keys + i * key_len, Min(sizeof(int64), key_len)); // GCOV_EXCL_LINE
-                        d = Int64GetDatum(v); // GCOV_EXCL_LINE
-                        break; // GCOV_EXCL_LINE
-                    } // GCOV_EXCL_LINE
-            }
-
-            smol_bloom_add(&bloom, d, typid, nhash);
+            memcpy(&n, p + sizeof(uint16), sizeof(uint16));
+            k = (char *) smol_incdict_keys(p);
+        }
+        for (uint16 i = 0; i < n; i++, k += key_len)
+        {
+            if (!*have_prev || !smol_key_eq_len(k, prev, key_len))
+                distinct++;
+            memcpy(prev, k, key_len);
+            *have_prev = true;
         }
     }
-
-    return bloom;
+    return distinct;
 }
-/*
- * Leaf Directory Functions for Parallel Scan Optimization
- *
- * These will be appended to smol_utils.c
- */
 
 /*
- * smol_build_and_write_directory - Build leaf directory after index construction
+ * smol_collect_meta_stats - record build statistics for the cost estimator
  *
- * Called AFTER the index is completely built (all leaves written, tree complete).
- * Enumerates leaves by walking rightlinks and samples them into a fixed-size directory.
- * Returns block number of directory page.
+ * Called after the index is complete.  Counts the nodes of each internal
+ * level along the rightlinks (giving the average fanout per level), then
+ * walks the leaves once for rows, leaves in a packed (RLE or FOR) layout
+ * and distinct leading-key values, and stores the totals in the metapage.
  */
-/* GCOV_EXCL_START - directory feature disabled due to bug */
-BlockNumber
-smol_build_and_write_directory(Relation idx)
+void
+smol_collect_meta_stats(Relation idx)
 {
     SmolMeta meta;
-    SmolDirectory *dir;
+    BufferAccessStrategy strategy;
     Buffer buf;
     Page page;
-    BlockNumber dir_blk;
-    BlockNumber leaf;
+    SmolMeta *mp;
+    BlockNumber level_first;
+    BlockNumber blk;
     BlockNumber nblocks;
-    uint32 leaf_count = 0;
-    uint32 sample_every;
-    uint32 next_sample_at;
+    double level_nodes[SMOL_STAT_LEVELS + 1];
+    int nlevels = 0;
+    double rows = 0, distinct = 0;
+    BlockNumber leaves = 0, packed = 0;
+    uint32 inc_total = 0;
+    char *prev;
+    bool have_prev = false;
 
-    /* Read metadata */
     smol_meta_read(idx, &meta);
-
-    /* Need at least height 1 (has leaves) */
-    if (meta.height < 1)
-        return InvalidBlockNumber;
-
-    /* Get total blocks for safety checks */
+    if (meta.height < 1 || !BlockNumberIsValid(meta.root_blkno))
+        return;
+    for (uint16 i = 0; i < meta.inc_count; i++)
+        inc_total += meta.inc_len[i];
     nblocks = RelationGetNumberOfBlocks(idx);
 
-    /* For height 1, root is the only leaf */
-    if (meta.height == 1)
-    {
-        leaf = meta.root_blkno;
-    }
-    else
+    /* Internal levels, root first: count nodes and step down the leftmost child */
+    level_first = meta.root_blkno;
+    for (int level = meta.height; level > 1; level--)
     {
-        /* Find leftmost leaf by descending from root */
-        BlockNumber cur = meta.root_blkno;
-        for (int level = meta.height; level > 1; level--)
+        SmolZoneItem item;
+        double nodes = 0;
+
+        item.child = InvalidBlockNumber;
+        blk = level_first;
+        while (BlockNumberIsValid(blk) && blk < nblocks)
         {
-            buf = ReadBuffer(idx, cur);
+            buf = ReadBuffer(idx, blk);
             page = BufferGetPage(buf);
-            /* First child is at offset 1 */
-            SmolInternalItem *item = (SmolInternalItem *) PageGetItem(page, PageGetItemId(page, 1));
-            cur = item->child;
+            if (blk == level_first)
+                smol_internal_item_read(page, FirstOffsetNumber, &meta, &item);
+            nodes++;
+            blk = smol_page_opaque(page)->rightlink;
             ReleaseBuffer(buf);
         }
-        leaf = cur;
+        if (nlevels < SMOL_STAT_LEVELS + 1)
+            level_nodes[nlevels++] = nodes;
+        level_first = item.child;
     }
 
-    if (!BlockNumberIsValid(leaf))
-        return InvalidBlockNumber;
-
-    /* Allocate directory in memory */
-    dir = (SmolDirectory *) palloc0(sizeof(SmolDirectory));
-    dir->magic = SMOL_DIR_MAGIC;
-    dir->num_entries = 0;
-
-    /* Count total leaves first (walk once) */
-    BlockNumber temp_leaf = leaf;
-    uint32 total_leaves = 0;
-
-    while (BlockNumberIsValid(temp_leaf) && total_leaves < 1000000)
+    /* Leaves */
+    prev = palloc(Max(meta.key_len1, (uint16) sizeof(int64)));
+    strategy = GetAccessStrategy(BAS_BULKREAD);
+    blk = level_first;
+    while (BlockNumberIsValid(blk) && blk < nblocks)
     {
-        if (temp_leaf >= nblocks)
-        {
-            elog(WARNING, "smol: invalid leaf block %u during count (index has %u blocks)",
-                 temp_leaf, nblocks);
-            break;
-        }
-
-        total_leaves++;
+        uint16 tag;
 
-        /* Get rightlink */
-        buf = ReadBuffer(idx, temp_leaf);
+        CHECK_FOR_INTERRUPTS();
+        buf = ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, strategy);
         page = BufferGetPage(buf);
-        SmolOpaque op = smol_page_opaque(page);
-        temp_leaf = op->rightlink;
+        leaves++;
+        if (meta.nkeyatts == 2)
+        {
+            if (smol12_is_grouped(smol12_payload(page)))
+                packed++;
+            rows += smol12_leaf_nrows(page);
+        }
+        else
+        {
+            memcpy(&tag, PageGetItem(page, PageGetItemId(page, FirstOffsetNumber)), sizeof(uint16));
+            if (tag == SMOL_TAG_KEY_RLE || tag == SMOL_TAG_KEY_RLE_V2 ||
+                tag == SMOL_TAG_INC_RLE || tag == SMOL_TAG_KEY_FOR || tag == SMOL_TAG_TEXT_PREFIX ||
+                tag == SMOL_TAG_INC_DICT)
+                packed++;
+            rows += smol_leaf_nitems(page);
+        }
+        distinct += smol_leaf_count_distinct(page, &meta, inc_total, prev, &have_prev);
+        blk = smol_page_opaque(page)->rightlink;
         ReleaseBuffer(buf);
     }
+    FreeAccessStrategy(strategy);
+    pfree(prev);
 
-    if (total_leaves == 0)
+    buf = ReadBuffer(idx, 0);
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    mp = smol_meta_ptr(BufferGetPage(buf));
+    mp->stat_rows = rows;
+    mp->stat_distinct = distinct;
+    mp->stat_leaves = leaves;
+    mp->stat_packed_leaves = packed;
+    memset(mp->stat_fanout, 0, sizeof(mp->stat_fanout));
+    /* level_nodes[] runs root first; fanout of level i is its children per node */
+    for (int i = nlevels - 1, f = 0; i >= 0 && f < SMOL_STAT_LEVELS; i--, f++)
     {
-        pfree(dir);
-        return InvalidBlockNumber;
-    }
+        double children = (i == nlevels - 1) ? (double) leaves : level_nodes[i + 1];
 
-    /* Calculate sampling rate to fit in directory */
-    if (total_leaves <= SMOL_DIR_MAX_ENTRIES)
-    {
-        sample_every = 1;  /* Sample every leaf */
-    }
-    else
-    {
-        sample_every = (total_leaves + SMOL_DIR_MAX_ENTRIES - 1) / SMOL_DIR_MAX_ENTRIES;
+        mp->stat_fanout[f] = (float4) (children / Max(level_nodes[i], 1.0));
     }
+    MarkBufferDirty(buf);
+    UnlockReleaseBuffer(buf);
 
-    next_sample_at = 0;
-    leaf_count = 0;
+    SMOL_LOGF("build stats: rows=%.0f distinct=%.0f leaves=%u packed=%u levels=%d",
+              rows, distinct, leaves, packed, nlevels);
+}
 
-    /* Now sample leaves */
-    while (BlockNumberIsValid(leaf) && dir->num_entries < SMOL_DIR_MAX_ENTRIES)
-    {
-        if (leaf >= nblocks)
-        {
-            elog(WARNING, "smol: invalid leaf block %u during sampling (index has %u blocks)",
-                 leaf, nblocks);
-            break;
-        }
+/*
+ * smol_heap_append_mark - the last heap tuple slot in use: the final block
+ * and its highest line pointer.  An empty heap gives block 0, offset 0.
+ */
+void
+smol_heap_append_mark(Relation heap, BlockNumber *blk, OffsetNumber *off)
+{
+    BlockNumber nblocks = RelationGetNumberOfBlocks(heap);
+    Buffer buf;
+    Page page;
 
-        /* Sample this leaf? */
-        if (leaf_count == next_sample_at)
-        {
-            buf = ReadBuffer(idx, leaf);
-            page = BufferGetPage(buf);
+    *blk = 0;
+    *off = InvalidOffsetNumber;
+    if (nblocks == 0)
+        return;
+    buf = ReadBuffer(heap, nblocks - 1);
+    LockBuffer(buf, BUFFER_LOCK_SHARE);
+    page = BufferGetPage(buf);
+    *blk = nblocks - 1;
+    if (!PageIsNew(page))
+        *off = PageGetMaxOffsetNumber(page);
+    UnlockReleaseBuffer(buf);
+}
 
-            /* Read first key as key_prefix */
-            int32 key_prefix = 0;
-            if (meta.key_len1 <= 4 && smol_leaf_nitems(page) > 0)
-            {
-                char *keyptr = smol_leaf_keyptr_ex(page, 1, meta.key_len1, NULL, 0, NULL);
-                if (keyptr)
-                {
-                    memcpy(&key_prefix, keyptr, meta.key_len1);
-                }
-            }
+/*
+ * smol_heap_new_rows_check - inspect the heap tuples after (from_blk,
+ * from_off) and up to (to_blk, to_off).  *current_xact is set when one was
+ * inserted by this transaction or one of its subtransactions, *updated when
+ * one is the new version left by a non-HOT UPDATE that did not abort.
+ */
+void
+smol_heap_new_rows_check(Relation heap, BlockNumber from_blk, OffsetNumber from_off,
+                         BlockNumber to_blk, OffsetNumber to_off,
+                         bool *current_xact, bool *updated)
+{
+    BufferAccessStrategy strategy = GetAccessStrategy(BAS_BULKREAD);
+    bool        found = false;
 
-            /* Add to directory */
-            dir->entries[dir->num_entries].key_prefix = key_prefix;
-            dir->entries[dir->num_entries].leaf_blkno = leaf;
-            dir->num_entries++;
+    *current_xact = *updated = false;
 
-            /* Get rightlink */
-            SmolOpaque op = smol_page_opaque(page);
-            BlockNumber next = op->rightlink;
-            ReleaseBuffer(buf);
+    for (BlockNumber blk = from_blk; blk <= to_blk && !found; blk++)
+    {
+        Buffer buf = ReadBufferExtended(heap, MAIN_FORKNUM, blk, RBM_NORMAL, strategy);
+        Page page;
+        OffsetNumber maxoff;
 
-            leaf = next;
-            next_sample_at += sample_every;
-        }
-        else
+        LockBuffer(buf, BUFFER_LOCK_SHARE);
+        page = BufferGetPage(buf);
+        maxoff = PageIsNew(page) ? InvalidOffsetNumber : PageGetMaxOffsetNumber(page);
+        if (blk == to_blk)
+            maxoff = Min(maxoff, to_off);
+        for (OffsetNumber off = (blk == from_blk) ? OffsetNumberNext(from_off) : FirstOffsetNumber;
+             off <= maxoff && !found; off++)
         {
-            /* Skip this leaf, just get its rightlink */
-            buf = ReadBuffer(idx, leaf);
-            page = BufferGetPage(buf);
-            SmolOpaque op = smol_page_opaque(page);
-            leaf = op->rightlink;
-            ReleaseBuffer(buf);
+            ItemId iid = PageGetItemId(page, off);
+            HeapTupleHeader htup;
+            TransactionId xmin;
+
+            if (!ItemIdIsNormal(iid))
+                continue;
+            htup = (HeapTupleHeader) PageGetItem(page, iid);
+            xmin = HeapTupleHeaderGetXmin(htup);
+            if (TransactionIdIsCurrentTransactionId(xmin))
+                *current_xact = true;
+            else if ((htup->t_infomask & HEAP_UPDATED) && !HeapTupleHeaderIsHeapOnly(htup) &&
+                     !HeapTupleHeaderXminInvalid(htup) && !TransactionIdDidAbort(xmin))
+                *updated = true;    /* a HOT version keeps its root's place and indexed values */
+            found = *current_xact || *updated;
         }
-
-        leaf_count++;
+        UnlockReleaseBuffer(buf);
     }
+    FreeAccessStrategy(strategy);
+}
+
+/* Record the heap rows a fresh build covered; smol_append resumes after them */
+void
+smol_meta_set_append_mark(Relation idx, Relation heap)
+{
+    BlockNumber blk;
+    OffsetNumber off;
+    Buffer buf;
+    SmolMeta *mp;
+
+    smol_heap_append_mark(heap, &blk, &off);
+    buf = ReadBuffer(idx, 0);
+    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    mp = smol_meta_ptr(BufferGetPage(buf));
+    mp->append_heap_blk = blk;
+    mp->append_heap_off = off;
+    mp->nsegments = 0;
+    mp->append_stale = false;
+    MarkBufferDirty(buf);
+    UnlockReleaseBuffer(buf);
+}
 
-    if (dir->num_entries == 0)
+/*
+ * smol_root_zone_fraction - share of rows whose root subtree can match
+ *
+ * Probes the root's zone maps (and bloom filters, for equality) with the
+ * bounds in 'so' and returns the row-weighted fraction of children that may
+ * hold matches; 1.0 when the root is a leaf or zone maps are off.  Used by
+ * smol_costestimate to cap the leaf fraction a scan touches.
+ */
+double
+smol_root_zone_fraction(Relation idx, SmolScanOpaque so, SmolMeta *meta)
+{
+    SmolNodeView node;
+    OffsetNumber maxoff;
+    double all = 0, hit = 0;
+
+    if (meta->height < 2 || !meta->zone_maps_enabled || !smol_zone_maps)
+        return 1.0;
+
+    maxoff = smol_node_open(idx, meta, meta->root_blkno, &node);
+    for (OffsetNumber off = FirstOffsetNumber; off <= maxoff; off++)
     {
-        pfree(dir);
-        return InvalidBlockNumber;
+        SmolZoneItem item;
+        double w;
+
+        smol_node_item(&node, off, &item);
+        w = Max((double) item.row_count, 1.0);
+        all += w;
+        if (smol_subtree_can_match(&item, so, meta))
+            hit += w;
     }
+    smol_node_close(&node);
 
-    /* Allocate a new page for directory */
-    buf = ReadBufferExtended(idx, MAIN_FORKNUM, P_NEW, RBM_NORMAL, NULL);
-    dir_blk = BufferGetBlockNumber(buf);
-    LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+    if (all <= 0)
+        return 1.0; /* GCOV_EXCL_LINE - defensive: internal pages are never empty */
+    return hit / all;
+}
 
-    page = BufferGetPage(buf);
-    PageInit(page, BLCKSZ, 0);  /* No special area */
+/*
+ * smol_prewarm_upper - read the metapage, the leaf directory and every
+ * internal level into shared buffers, root first
+ *
+ * These are the pages each scan's descent and parallel partitioning touch
+ * before any leaf; returns the number of blocks read.
+ */
+uint64
+smol_prewarm_upper(Relation idx, const SmolMeta *meta)
+{
+    BlockNumber nblocks = RelationGetNumberOfBlocks(idx);
+    BlockNumber level_first;
+    uint64 nread = 0;
+    Buffer buf;
+    Page page;
 
-    /* Write directory to page */
-    Size dir_size = offsetof(SmolDirectory, entries) +
-                    dir->num_entries * sizeof(SmolDirEntry);
+    if (nblocks == 0)
+        return 0; /* GCOV_EXCL_LINE - defensive: built indexes have a metapage */
+    ReleaseBuffer(ReadBuffer(idx, 0));
+    nread++;
 
-    if (dir_size > BLCKSZ - SizeOfPageHeaderData)
+    if (BlockNumberIsValid(meta->directory_blkno) && meta->directory_blkno < nblocks)
     {
-        elog(ERROR, "smol: directory too large (%zu bytes)", dir_size);
+        uint16 npages;
+
+        buf = ReadBuffer(idx, meta->directory_blkno);
+        page = BufferGetPage(buf);
+        npages = ((SmolDirPageHeader *) PageGetContents(page))->npages;
+        ReleaseBuffer(buf);
+        nread += smol_prewarm_blocks(idx, meta->directory_blkno + 1,
+                                     Min(meta->directory_blkno + npages, nblocks)) + 1;
     }
 
-    memcpy(PageGetContents(page), dir, dir_size);
+    if (meta->height < 2 || !BlockNumberIsValid(meta->root_blkno))
+        return nread;
 
-    MarkBufferDirty(buf);
-    UnlockReleaseBuffer(buf);
+    level_first = meta->root_blkno;
+    for (int level = meta->height; level > 1; level--)
+    {
+        BlockNumber blk = level_first;
+        SmolZoneItem item;
+
+        item.child = InvalidBlockNumber;
+        while (BlockNumberIsValid(blk) && blk < nblocks)
+        {
+            CHECK_FOR_INTERRUPTS();
+            buf = ReadBuffer(idx, blk);
+            page = BufferGetPage(buf);
+            if (blk == level_first)
+                smol_internal_item_read(page, FirstOffsetNumber, meta, &item);
+            blk = smol_page_opaque(page)->rightlink;
+            ReleaseBuffer(buf);
+            nread++;
+        }
+        level_first = item.child;
+    }
+    return nread;
+}
 
-    pfree(dir);
+/*
+ * smol_prewarm_blocks - load blocks [start, end) into shared buffers
+ *
+ * Reads go through the default strategy (a bulk-read ring would recycle the
+ * buffers it just loaded) with SMOL_PREWARM_DISTANCE blocks prefetched ahead.
+ */
+uint64
+smol_prewarm_blocks(Relation idx, BlockNumber start, BlockNumber end)
+{
+    BlockNumber pf = start;
+    uint64 nread = 0;
+
+    for (BlockNumber blk = start; blk < end; blk++)
+    {
+        CHECK_FOR_INTERRUPTS();
+        while (pf < end && pf < blk + SMOL_PREWARM_DISTANCE)
+            PrefetchBuffer(idx, MAIN_FORKNUM, pf++);
+        ReleaseBuffer(ReadBufferExtended(idx, MAIN_FORKNUM, blk, RBM_NORMAL, NULL));
+        nread++;
+    }
+    return nread;
+}
 
-    elog(LOG, "smol: built leaf directory with %u entries (sampled %u of %u leaves) at block %u",
-         dir->num_entries, dir->num_entries, total_leaves, dir_blk);
+/*
+ * smol_resident_warm - warm a resident index's upper levels once per backend
+ *
+ * Shared buffers cannot stay pinned across transactions, so `resident`
+ * indexes instead have their metapage, directory and internal levels read by
+ * the first scan in each backend (and so loaded after a restart by the first
+ * query that uses them); every later descent keeps their usage counts high.
+ * Keyed by relfilenumber, so a REINDEX warms the new tree.
+ */
+void
+smol_resident_warm(Relation idx, const SmolMeta *meta)
+{
+    static List *warmed = NIL;
+    Oid relnumber = (Oid) idx->rd_locator.relNumber;
+    MemoryContext old;
 
-    return dir_blk;
-} /* GCOV_EXCL_STOP */
+    if (list_member_oid(warmed, relnumber))
+        return;
+    (void) smol_prewarm_upper(idx, meta);
+    old = MemoryContextSwitchTo(TopMemoryContext);
+    warmed = lappend_oid(warmed, relnumber);
+    MemoryContextSwitchTo(old);
+}
 
 /*
  * smol_read_directory - Read leaf directory from index
  *
- * Returns palloc'd directory structure. Caller must pfree().
+ * Returns palloc'd directory (entries plus cumulative row offsets), or NULL
+ * when the pages do not hold a current-format directory.  Caller must pfree()
+ * both dir->row_start and dir.
  */
-/* GCOV_EXCL_START - directory feature disabled due to bug */
 SmolDirectory *
 smol_read_directory(Relation idx, BlockNumber dir_blk)
 {
     Buffer buf;
     Page page;
     SmolDirectory *dir;
-    SmolDirectory *page_dir;
-    Size dir_size;
+    SmolDirPageHeader hdr;
+    uint32 got = 0;
 
     if (!BlockNumberIsValid(dir_blk))
         return NULL;
 
     buf = ReadBuffer(idx, dir_blk);
     page = BufferGetPage(buf);
-    page_dir = (SmolDirectory *) PageGetContents(page);
+    memcpy(&hdr, PageGetContents(page), sizeof(hdr));
+    ReleaseBuffer(buf);
 
-    /* Validate magic */
-    if (page_dir->magic != SMOL_DIR_MAGIC)
-    {
-        ReleaseBuffer(buf);
-        elog(WARNING, "smol: invalid directory magic at block %u", dir_blk);
+    /* Single-page directories of older builds are ignored, not reported */
+    if (hdr.magic == SMOL_DIR_MAGIC_V1)
+        return NULL; /* GCOV_EXCL_LINE - no current build writes them */
+    if (hdr.magic != SMOL_DIR_MAGIC || hdr.num_entries == 0 || hdr.num_entries > SMOL_DIR_MAX_ENTRIES ||
+        (uint32) hdr.npages * SMOL_DIR_ENTRIES_PER_PAGE < hdr.num_entries)
+    { /* GCOV_EXCL_START - defensive: corrupted directory page */
+        elog(WARNING, "smol: invalid leaf directory at block %u", dir_blk);
         return NULL;
-    }
+    } /* GCOV_EXCL_STOP */
 
-    /* Validate num_entries */
-    if (page_dir->num_entries > SMOL_DIR_MAX_ENTRIES)
+    dir = (SmolDirectory *) palloc(offsetof(SmolDirectory, entries) + hdr.num_entries * sizeof(SmolDirEntry));
+    dir->num_entries = hdr.num_entries;
+    dir->zkey_len = hdr.zkey_len;
+    for (uint16 pg = 0; pg < hdr.npages; pg++)
     {
+        const SmolDirPageHeader *ph;
+
+        buf = ReadBuffer(idx, dir_blk + pg);
+        page = BufferGetPage(buf);
+        ph = (const SmolDirPageHeader *) PageGetContents(page);
+        if (ph->magic != SMOL_DIR_MAGIC || got + ph->page_entries > dir->num_entries)
+        { /* GCOV_EXCL_START - defensive: corrupted directory page */
+            ReleaseBuffer(buf);
+            pfree(dir);
+            elog(WARNING, "smol: invalid leaf directory page %u", dir_blk + pg);
+            return NULL;
+        } /* GCOV_EXCL_STOP */
+        memcpy(&dir->entries[got], (const char *) ph + sizeof(SmolDirPageHeader),
+               ph->page_entries * sizeof(SmolDirEntry));
+        got += ph->page_entries;
         ReleaseBuffer(buf);
-        elog(WARNING, "smol: invalid directory entry count %u at block %u",
-             page_dir->num_entries, dir_blk);
-        return NULL;
     }
+    if (got != dir->num_entries)
+    { /* GCOV_EXCL_START - defensive: corrupted directory page */
+        pfree(dir);
+        elog(WARNING, "smol: leaf directory at block %u holds %u of %u entries", dir_blk, got, hdr.num_entries);
+        return NULL;
+    } /* GCOV_EXCL_STOP */
 
-    /* Copy directory to palloc'd memory */
-    dir_size = offsetof(SmolDirectory, entries) +
-               page_dir->num_entries * sizeof(SmolDirEntry);
-    dir = (SmolDirectory *) palloc(dir_size);
-    memcpy(dir, page_dir, dir_size);
-
-    ReleaseBuffer(buf);
+    dir->row_start = (uint64 *) palloc((dir->num_entries + 1) * sizeof(uint64));
+    dir->row_start[0] = 0;
+    for (uint32 i = 0; i < dir->num_entries; i++)
+        dir->row_start[i + 1] = dir->row_start[i] + dir->entries[i].row_count;
 
     return dir;
-} /* GCOV_EXCL_STOP */
+}
 
 /* ----------------------------------------------------------------
  * NUMERIC Support Functions
@@ -1697,3 +4181,168 @@ smol_int64_to_numeric(int64 value, int scale)
 
     return result;
 }
+
+/*
+ * ========================================================================
+ * Shared Scan Statistics (pg_stat_smol)
+ * ========================================================================
+ */
+
+static SmolStatsShared *smol_stats_shared = NULL;
+
+static void
+smol_stats_init_shmem(void *ptr)
+{
+    SmolStatsShared *sh = (SmolStatsShared *) ptr;
+
+    for (int i = 0; i < SMOL_STATS_SLOTS; i++)
+    {
+        pg_atomic_init_u64(&sh->entries[i].key, 0);
+        for (int c = 0; c < SMOL_STAT_NCOUNTERS; c++)
+            pg_atomic_init_u64(&sh->entries[i].counters[c], 0);
+    }
+}
+
+/* Attach to (creating on first use) the statistics segment */
+static SmolStatsShared *
+smol_stats_attach(void)
+{
+    if (smol_stats_shared == NULL)
+    {
+        bool found;
+
+        smol_stats_shared = (SmolStatsShared *) GetNamedDSMSegment("smol_scan_stats", sizeof(SmolStatsShared),
+                                                                   smol_stats_init_shmem, &found);
+    }
+    return smol_stats_shared;
+}
+
+/*
+ * Slot of index 'indexoid' in the current database, claiming a free one.  A
+ * full table gives up the slot of an index of this database that has been
+ * dropped (other databases' catalogs are out of reach); NULL when there is none.
+ */
+static SmolStatsEntry *
+smol_stats_entry(SmolStatsShared *sh, Oid indexoid)
+{
+    uint64 key = ((uint64) MyDatabaseId << 32) | (uint64) indexoid;
+    uint32 start = murmurhash32((uint32) indexoid ^ (uint32) MyDatabaseId) % SMOL_STATS_SLOTS;
+
+    for (uint32 i = 0; i < SMOL_STATS_SLOTS; i++)
+    {
+        SmolStatsEntry *e = &sh->entries[(start + i) % SMOL_STATS_SLOTS];
+        uint64 cur = pg_atomic_read_u64(&e->key);
+
+        if (cur == key)
+            return e;
+        if (cur == 0)
+        {
+            if (pg_atomic_compare_exchange_u64(&e->key, &cur, key) || cur == key)
+                return e;
+        }
+    }
+
+    for (uint32 i = 0; i < SMOL_STATS_SLOTS; i++)
+    {
+        SmolStatsEntry *e = &sh->entries[(start + i) % SMOL_STATS_SLOTS];
+        uint64 cur = pg_atomic_read_u64(&e->key);
+
+        if (cur == 0 || (Oid) (cur >> 32) != MyDatabaseId ||
+            SearchSysCacheExists1(RELOID, ObjectIdGetDatum((Oid) (cur & 0xFFFFFFFF))))
+            continue;
+        if (pg_atomic_compare_exchange_u64(&e->key, &cur, key))
+        {
+            /* a scan of the dropped index can't still be flushing into it */
+            for (int c = 0; c < SMOL_STAT_NCOUNTERS; c++)
+                pg_atomic_write_u64(&e->counters[c], 0);
+            return e;
+        }
+        if (cur == key)
+            return e;
+    }
+    return NULL;
+}
+
+/*
+ * smol_stats_flush - add a finished scan's counters to its index's slot;
+ * one atomic add per non-zero counter
+ */
+void
+smol_stats_flush(IndexScanDesc scan, SmolScanOpaque so)
+{
+    SmolStatsShared *sh;
+    SmolStatsEntry *e;
+    uint64 v[SMOL_STAT_NCOUNTERS];
+
+    if (!smol_track_scan_stats || so->stat_scans == 0)
+        return;
+    v[SMOL_STAT_SCANS] = so->stat_scans;
+    v[SMOL_STAT_LEAVES] = so->stat_leaves;
+    v[SMOL_STAT_ZONE_PRUNED] = so->prof_subtrees_skipped;
+    v[SMOL_STAT_BLOOM_CHECKS] = so->prof_bloom_checks;
+    v[SMOL_STAT_BLOOM_PRUNED] = so->prof_bloom_skips;
+    v[SMOL_STAT_RUNS] = so->stat_runs;
+    v[SMOL_STAT_PREFETCHES] = so->stat_prefetches;
+    v[SMOL_STAT_PARALLEL_SCANS] = scan->parallel_scan ? 1 : 0;
+    v[SMOL_STAT_DIR_CLAIMS] = so->prof_dir_claims;
+    v[SMOL_STAT_DIR_STEALS] = so->prof_dir_steals;
+
+    sh = smol_stats_attach();
+    e = smol_stats_entry(sh, RelationGetRelid(scan->indexRelation));
+    if (e == NULL)
+        return; /* GCOV_EXCL_LINE - needs SMOL_STATS_SLOTS scanned indexes */
+    for (int c = 0; c < SMOL_STAT_NCOUNTERS; c++)
+        if (v[c] != 0)
+            pg_atomic_fetch_add_u64(&e->counters[c], v[c]);
+}
+
+/*
+ * smol_stat_indexes() - counters of the current database's indexes, one row
+ * per index scanned since the last reset (backs the pg_stat_smol view)
+ */
+PG_FUNCTION_INFO_V1(smol_stat_indexes);
+
+Datum
+smol_stat_indexes(PG_FUNCTION_ARGS)
+{
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    SmolStatsShared *sh;
+
+    InitMaterializedSRF(fcinfo, 0);
+    sh = smol_stats_attach();
+    for (int i = 0; i < SMOL_STATS_SLOTS; i++)
+    {
+        SmolStatsEntry *e = &sh->entries[i];
+        uint64 key = pg_atomic_read_u64(&e->key);
+        Datum values[SMOL_STAT_NCOUNTERS + 1];
+        bool nulls[SMOL_STAT_NCOUNTERS + 1] = {0};
+
+        if (key == 0 || (Oid) (key >> 32) != MyDatabaseId)
+            continue;
+        values[0] = ObjectIdGetDatum((Oid) (key & 0xFFFFFFFF));
+        for (int c = 0; c < SMOL_STAT_NCOUNTERS; c++)
+            values[c + 1] = Int64GetDatum((int64) pg_atomic_read_u64(&e->counters[c]));
+        tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc, values, nulls);
+    }
+    return (Datum) 0;
+}
+
+/*
+ * smol_stat_reset() - zero every counter and free all slots.  Scans that
+ * finish concurrently may land in a slot as it is cleared.
+ */
+PG_FUNCTION_INFO_V1(smol_stat_reset);
+
+Datum
+smol_stat_reset(PG_FUNCTION_ARGS)
+{
+    SmolStatsShared *sh = smol_stats_attach();
+
+    for (int i = 0; i < SMOL_STATS_SLOTS; i++)
+    {
+        for (int c = 0; c < SMOL_STAT_NCOUNTERS; c++)
+            pg_atomic_write_u64(&sh->entries[i].counters[c], 0);
+        pg_atomic_write_u64(&sh->entries[i].key, 0);
+    }
+    PG_RETURN_VOID();
+}
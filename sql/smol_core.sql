@@ -847,3 +847,288 @@ RESET enable_seqscan;
 
 -- Cleanup
 DROP TABLE t_macaddr8_inc CASCADE;
+
+-- ============================================================================
+-- Parallel INCLUDE and two-column builds
+-- ============================================================================
+SET max_parallel_maintenance_workers = 4;
+SET min_parallel_table_scan_size = 0;
+SET enable_seqscan = off;
+-- INCLUDE and two-column builds consume the merged worker runs
+DROP TABLE IF EXISTS t_parallel_build_inc CASCADE;
+CREATE TABLE t_parallel_build_inc (k int4, v int4, t text);
+INSERT INTO t_parallel_build_inc SELECT i % 5000, i, 'v' || (i % 7) FROM generate_series(1, 30000) i;
+CREATE INDEX t_parallel_build_inc_k ON t_parallel_build_inc USING smol(k) INCLUDE (v, t);
+CREATE INDEX t_parallel_build_inc_kv ON t_parallel_build_inc USING smol(k, v);
+CREATE INDEX t_parallel_build_inc_kvt ON t_parallel_build_inc USING smol(k, v) INCLUDE (t);
+SELECT count(*), sum(v) FROM t_parallel_build_inc WHERE k BETWEEN 100 AND 199;
+SELECT count(*) FROM t_parallel_build_inc WHERE k = 42 AND v > 20000;
+SELECT count(DISTINCT t) FROM t_parallel_build_inc WHERE k = 0;
+DROP TABLE IF EXISTS t_parallel_build_txt CASCADE;
+CREATE TABLE t_parallel_build_txt (k text COLLATE "C", v int4);
+INSERT INTO t_parallel_build_txt SELECT 'k' || lpad((i % 1000)::text, 4, '0'), i FROM generate_series(1, 30000) i;
+CREATE INDEX t_parallel_build_txt_idx ON t_parallel_build_txt USING smol(k) INCLUDE (v);
+SELECT count(*), sum(v) FROM t_parallel_build_txt WHERE k >= 'k0990';
+RESET max_parallel_maintenance_workers;
+RESET min_parallel_table_scan_size;
+RESET enable_seqscan;
+DROP TABLE t_parallel_build_inc CASCADE;
+DROP TABLE t_parallel_build_txt CASCADE;
+
+-- ============================================================================
+-- External-sort INCLUDE build (heap larger than maintenance_work_mem)
+-- ============================================================================
+SET maintenance_work_mem = '1MB';
+DROP TABLE IF EXISTS t_spill_inc CASCADE;
+CREATE TABLE t_spill_inc (k int4, v int4, t text);
+INSERT INTO t_spill_inc SELECT i % 5000, i, 'row' || (i % 97) FROM generate_series(1, 100000) i;
+CREATE INDEX t_spill_inc_idx ON t_spill_inc USING smol(k) INCLUDE (v, t);
+DROP TABLE IF EXISTS t_spill_txt CASCADE;
+CREATE TABLE t_spill_txt (k text COLLATE "C", v int4);
+INSERT INTO t_spill_txt SELECT lpad((i % 3000)::text, 6, '0'), i FROM generate_series(1, 100000) i;
+CREATE INDEX t_spill_txt_idx ON t_spill_txt USING smol(k) INCLUDE (v);
+
+RESET maintenance_work_mem;
+
+SET enable_seqscan = off;
+SET max_parallel_workers_per_gather = 0;
+SELECT count(*), sum(v::int8), count(DISTINCT t) FROM t_spill_inc WHERE k >= 1000 AND k < 2000;
+SELECT count(*), max(v) FROM t_spill_inc WHERE k = 4999;
+SELECT count(*), sum(v::int8) FROM t_spill_txt WHERE k >= '001000' AND k < '001100';
+RESET enable_seqscan;
+RESET max_parallel_workers_per_gather;
+DROP TABLE t_spill_inc CASCADE;
+DROP TABLE t_spill_txt CASCADE;
+
+-- ============================================================================
+-- smol_append segments and smol_compact
+-- ============================================================================
+DROP TABLE IF EXISTS t_app CASCADE;
+CREATE UNLOGGED TABLE t_app (k int4, v int4);
+INSERT INTO t_app SELECT i, i % 100 FROM generate_series(1, 100000) i;
+CREATE INDEX t_app_idx ON t_app USING smol(k) INCLUDE (v) WITH (append = true);
+SELECT smol_append('t_app_idx');
+INSERT INTO t_app SELECT i, i % 100 FROM generate_series(100001, 150000) i;
+SELECT smol_append('t_app_idx');
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET max_parallel_workers_per_gather = 0;
+SELECT count(*), sum(k), sum(v) FROM t_app WHERE k > 0;
+SELECT count(*) FROM t_app WHERE k BETWEEN 99990 AND 100010;
+SELECT k FROM t_app WHERE k > 0 ORDER BY k DESC LIMIT 3;
+SELECT k, v FROM t_app WHERE k = 120007;
+INSERT INTO t_app SELECT i, 1 FROM generate_series(150001, 150003) i;
+-- Until smol_append runs, scans miss the new rows
+SELECT count(*) FROM t_app WHERE k >= 149999;
+SELECT smol_append('t_app_idx');
+SELECT count(*) FROM t_app WHERE k >= 149999;
+SELECT smol_compact('t_app_idx') >= 2 AS compacted;
+SELECT count(*), sum(k) FROM t_app WHERE k > 0;
+SELECT k FROM t_app WHERE k > 0 ORDER BY k DESC LIMIT 3;
+-- Rows of the current transaction are refused: a segment is not rolled back
+BEGIN;
+INSERT INTO t_app SELECT i, 1 FROM generate_series(150004, 150010) i;
+SELECT smol_append('t_app_idx');
+ROLLBACK;
+-- The aborted rows are dead, so nothing is appended
+SELECT smol_append('t_app_idx');
+SELECT count(*), max(k) FROM t_app WHERE k > 0;
+-- Two key columns: the segment continues the last leading-key run
+DROP TABLE IF EXISTS t_app2 CASCADE;
+CREATE UNLOGGED TABLE t_app2 (a int4, b int4);
+INSERT INTO t_app2 SELECT i / 100, i FROM generate_series(1, 20000) i;
+CREATE INDEX t_app2_idx ON t_app2 USING smol(a, b) WITH (append = true);
+INSERT INTO t_app2 SELECT i / 100, i FROM generate_series(20001, 40000) i;
+SELECT smol_append('t_app2_idx');
+SELECT count(*) FROM t_app2 WHERE a = 200;
+SELECT count(*), sum(b) FROM t_app2 WHERE a >= 0;
+SELECT a, b FROM t_app2 WHERE a = 200 ORDER BY a DESC, b DESC OFFSET 99 LIMIT 1;
+-- Rows sorting below the last key need a REINDEX; the index is left as it was
+DROP TABLE IF EXISTS t_app_bad CASCADE;
+CREATE UNLOGGED TABLE t_app_bad (k int4);
+INSERT INTO t_app_bad SELECT generate_series(1, 1000);
+CREATE INDEX t_app_bad_idx ON t_app_bad USING smol(k) WITH (append = true);
+INSERT INTO t_app_bad VALUES (5);
+SELECT smol_append('t_app_bad_idx');
+SELECT count(*) FROM t_app_bad WHERE k > 0;
+-- An UPDATE's new version on its old page lands below the mark: REINDEX instead
+DROP TABLE IF EXISTS t_app_upd CASCADE;
+CREATE UNLOGGED TABLE t_app_upd (k int4, v int4) WITH (fillfactor = 50);
+INSERT INTO t_app_upd SELECT i, 0 FROM generate_series(1, 1000) i;
+CREATE INDEX t_app_upd_idx ON t_app_upd USING smol(k) INCLUDE (v) WITH (append = true);
+-- Plain index scans are refused, so the updates run as sequential scans
+RESET enable_seqscan;
+SET enable_indexscan = off;
+UPDATE t_app_upd SET v = 1 WHERE k = 10;
+SELECT smol_append('t_app_upd_idx');
+REINDEX INDEX t_app_upd_idx;
+-- Past the mark an UPDATE is refused too: the new version is not heap-only
+INSERT INTO t_app_upd SELECT i, 0 FROM generate_series(1001, 1010) i;
+UPDATE t_app_upd SET v = 1 WHERE k = 1005;
+SELECT smol_append('t_app_upd_idx');
+RESET enable_indexscan;
+DROP TABLE t_app CASCADE;
+DROP TABLE t_app2 CASCADE;
+DROP TABLE t_app_bad CASCADE;
+DROP TABLE t_app_upd CASCADE;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+RESET max_parallel_workers_per_gather;
+
+-- ============================================================================
+-- Bulk leaf writes during build (smol.build_bulk_write)
+-- ============================================================================
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET max_parallel_workers_per_gather = 0;
+DROP TABLE IF EXISTS t_bulk CASCADE;
+CREATE UNLOGGED TABLE t_bulk (k int4, v int4, w int4, t text COLLATE "C");
+INSERT INTO t_bulk SELECT i * 3, i % 100, i % 7, 'row-' || lpad(i::text, 6, '0') FROM generate_series(1, 50000) i;
+SET smol.build_bulk_write = off;
+CREATE INDEX t_bulk_buf_idx ON t_bulk USING smol(k);
+RESET smol.build_bulk_write;
+CREATE INDEX t_bulk_idx ON t_bulk USING smol(k);
+-- Same layout either way
+SELECT pg_relation_size('t_bulk_idx') = pg_relation_size('t_bulk_buf_idx') AS same_size,
+       pg_relation_size('t_bulk_idx') > 8 * current_setting('block_size')::int AS multi_leaf;
+DROP INDEX t_bulk_buf_idx;
+SELECT count(*), sum(k) FROM t_bulk WHERE k > 1000;
+-- Backward scans follow the leftlinks set before each leaf was written
+SELECT count(*), sum(k) FROM (SELECT k FROM t_bulk WHERE k < 140000 ORDER BY k DESC) s;
+SELECT array_agg(k) FROM (SELECT k FROM t_bulk ORDER BY k DESC LIMIT 3) s;
+DROP INDEX t_bulk_idx;
+CREATE INDEX t_bulk_inc_idx ON t_bulk USING smol(k) INCLUDE (v);
+SELECT count(*), sum(v) FROM (SELECT k, v FROM t_bulk WHERE k >= 30000 ORDER BY k DESC) s;
+DROP INDEX t_bulk_inc_idx;
+CREATE INDEX t_bulk_txt_idx ON t_bulk USING smol(t);
+SELECT count(*), min(t), max(t) FROM t_bulk WHERE t >= 'row-040000';
+SELECT array_agg(t) FROM (SELECT t FROM t_bulk WHERE t < 'row-000100' ORDER BY t DESC LIMIT 2) s;
+DROP INDEX t_bulk_txt_idx;
+CREATE INDEX t_bulk_two_idx ON t_bulk USING smol(v, k);
+SELECT count(*), sum(k) FROM t_bulk WHERE v = 7 AND k > 75000;
+SELECT array_agg(v * 1000000 + k) FROM (SELECT v, k FROM t_bulk WHERE v <= 99 ORDER BY v DESC, k DESC LIMIT 3) s;
+DROP INDEX t_bulk_two_idx;
+CREATE INDEX t_bulk_twoinc_idx ON t_bulk USING smol(v, k) INCLUDE (w);
+SELECT count(*), sum(w) FROM t_bulk WHERE v = 42;
+DROP TABLE t_bulk CASCADE;
+-- Temporary indexes take the bulk path too
+CREATE TEMP TABLE t_bulk_tmp AS SELECT i AS k FROM generate_series(1, 20000) i;
+CREATE INDEX t_bulk_tmp_idx ON t_bulk_tmp USING smol(k);
+SELECT count(*), sum(k) FROM t_bulk_tmp WHERE k > 100;
+DROP TABLE t_bulk_tmp;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+RESET max_parallel_workers_per_gather;
+
+-- ============================================================================
+-- smol_build_many: several indexes from one heap scan
+-- ============================================================================
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET max_parallel_workers_per_gather = 0;
+DROP TABLE IF EXISTS t_bm CASCADE;
+CREATE UNLOGGED TABLE t_bm (a int4, b int8, c text COLLATE "C", v int4);
+INSERT INTO t_bm SELECT i % 1000, i::int8 * 3, 'r' || lpad((i % 5000)::text, 5, '0'), i % 7 FROM generate_series(1, 30000) i;
+CREATE INDEX t_bm_a_idx ON t_bm USING smol(a) INCLUDE (v);
+CREATE INDEX t_bm_b_idx ON t_bm USING smol(b, a);
+CREATE INDEX t_bm_c_idx ON t_bm USING smol(c);
+CREATE INDEX t_bm_btree ON t_bm (v);
+ANALYZE t_bm;
+-- An empty list rebuilds every SMOL index of the table; the btree is left alone
+SELECT smol_build_many('t_bm');
+SELECT count(*), sum(v) FROM t_bm WHERE a = 17;
+SELECT count(*), min(a), max(a) FROM t_bm WHERE b >= 89000 AND b < 89100;
+SELECT count(*) FROM t_bm WHERE c = 'r00042';
+-- Listed indexes only; repeats are rebuilt once
+RESET enable_seqscan;
+DELETE FROM t_bm WHERE a >= 500;
+SET enable_seqscan = off;
+SELECT smol_build_many('t_bm', ARRAY['t_bm_a_idx', 't_bm_c_idx', 't_bm_a_idx']::regclass[]);
+SELECT count(*), sum(v) FROM t_bm WHERE a = 17;
+SELECT count(*) FROM t_bm WHERE a >= 0;
+SELECT count(*) FROM t_bm WHERE c = 'r00042';
+SELECT count(*) FROM t_bm WHERE c = 'r00600';
+-- Only SMOL indexes of the named table
+SELECT smol_build_many('t_bm', ARRAY['t_bm_btree']::regclass[]);
+CREATE UNLOGGED TABLE t_bm2 (a int4);
+CREATE INDEX t_bm2_idx ON t_bm2 USING smol(a);
+SELECT smol_build_many('t_bm', ARRAY['t_bm2_idx']::regclass[]);
+DROP TABLE t_bm CASCADE;
+DROP TABLE t_bm2 CASCADE;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+RESET max_parallel_workers_per_gather;
+
+-- ============================================================================
+-- Normalized-key radix builds (smol.build_radix_sort)
+-- ============================================================================
+SET max_parallel_workers_per_gather = 0;
+DROP TABLE IF EXISTS t_nk CASCADE;
+CREATE UNLOGGED TABLE t_nk (f8 float8, ts timestamp, u uuid, o oid, d date, f4 float4);
+INSERT INTO t_nk SELECT ((i * 7919) % 20001 - 10000) / 4.0,
+    '2020-01-01'::timestamp + ((i * 7919) % 20001) * interval '1 minute',
+    md5(i::text)::uuid, ((i * 7919) % 20001 + 3000000000::int8)::oid,
+    date '2024-01-01' + i % 50, ((i * 31) % 1001 - 500) / 2.0
+  FROM generate_series(1, 20000) i;
+INSERT INTO t_nk VALUES ('-0', '2020-01-01', md5('x')::uuid, 1, '2024-01-07', '-0'),
+    ('NaN', '2020-01-01', md5('y')::uuid, 2, '2024-01-07', 'NaN'),
+    ('Infinity', '2020-01-01', md5('z')::uuid, 3, '2024-01-07', '-Infinity'),
+    ('-Infinity', '2020-01-01', md5('w')::uuid, 4, '2024-01-07', '-1.5');
+CREATE INDEX t_nk_f8 ON t_nk USING smol(f8);
+CREATE INDEX t_nk_ts ON t_nk USING smol(ts);
+CREATE INDEX t_nk_u ON t_nk USING smol(u);
+CREATE INDEX t_nk_o ON t_nk USING smol(o);
+CREATE INDEX t_nk_df ON t_nk USING smol(d, f4);
+CREATE UNLOGGED TABLE t_nk3 (s text COLLATE "C", f float8, v int4);
+INSERT INTO t_nk3 SELECT md5(i::text), ((i * 7919) % 20001 - 10000) / 4.0, i % 100 FROM generate_series(1, 20000) i;
+CREATE INDEX t_nk3_s ON t_nk3 USING smol(s) INCLUDE (v);
+CREATE INDEX t_nk3_f ON t_nk3 USING smol(f) INCLUDE (v);
+ANALYZE t_nk;
+ANALYZE t_nk3;
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET enable_sort = off;
+-- Radix-sorted builds: key order, ranges, and -0/+0 under zone keys and blooms
+SELECT count(*) FROM (SELECT f8, lag(f8) OVER () AS p FROM (SELECT f8 FROM t_nk ORDER BY f8) s) w WHERE p > f8;
+SELECT count(*), min(f8), max(f8) FROM t_nk WHERE f8 BETWEEN -10.5 AND 3.25;
+SELECT count(*) FROM t_nk WHERE f8 = 0;
+SELECT count(*) FROM t_nk WHERE f8 = '-0';
+SELECT count(*) FROM t_nk WHERE f8 > 2400;
+SELECT count(*) FROM (SELECT ts, lag(ts) OVER () AS p FROM (SELECT ts FROM t_nk ORDER BY ts) s) w WHERE p > ts;
+SELECT count(*), min(ts) = '2020-01-05' AS lo_ok FROM t_nk WHERE ts >= '2020-01-05' AND ts < '2020-01-06';
+SELECT count(*) FROM (SELECT u, lag(u) OVER () AS p FROM (SELECT u FROM t_nk ORDER BY u) s) w WHERE p > u;
+SELECT count(*) FROM t_nk WHERE u >= '80000000-0000-0000-0000-000000000000';
+SELECT count(*), sum(o::int8) FROM t_nk WHERE o BETWEEN 3000010000 AND 3000010100;
+SELECT count(*) FROM (SELECT d, f4, lag(d) OVER () AS pd, lag(f4) OVER () AS pf FROM (SELECT d, f4 FROM t_nk ORDER BY d, f4) s) w WHERE (pd, pf) > (d, f4);
+SELECT count(*), sum(f4) FROM t_nk WHERE d = date '2024-01-07' AND f4 < 0;
+SELECT count(*), sum(v) FROM t_nk3 WHERE f < -100;
+SELECT count(*) FROM (SELECT f, lag(f) OVER () AS p FROM (SELECT f, v FROM t_nk3 ORDER BY f) s) w WHERE p > f;
+SELECT count(*), sum(v) FROM t_nk3 WHERE s >= 'f';
+SELECT count(*) FROM (SELECT s, lag(s) OVER () AS p FROM (SELECT s, v FROM t_nk3 ORDER BY s) q) w WHERE p > s;
+-- Comparator and tuplesort builds give the same answers
+SET smol.build_radix_sort = off;
+REINDEX TABLE t_nk;
+REINDEX TABLE t_nk3;
+SELECT count(*) FROM (SELECT f8, lag(f8) OVER () AS p FROM (SELECT f8 FROM t_nk ORDER BY f8) s) w WHERE p > f8;
+SELECT count(*), min(f8), max(f8) FROM t_nk WHERE f8 BETWEEN -10.5 AND 3.25;
+SELECT count(*) FROM t_nk WHERE f8 = 0;
+SELECT count(*) FROM t_nk WHERE f8 = '-0';
+SELECT count(*) FROM t_nk WHERE f8 > 2400;
+SELECT count(*) FROM (SELECT ts, lag(ts) OVER () AS p FROM (SELECT ts FROM t_nk ORDER BY ts) s) w WHERE p > ts;
+SELECT count(*), min(ts) = '2020-01-05' AS lo_ok FROM t_nk WHERE ts >= '2020-01-05' AND ts < '2020-01-06';
+SELECT count(*) FROM (SELECT u, lag(u) OVER () AS p FROM (SELECT u FROM t_nk ORDER BY u) s) w WHERE p > u;
+SELECT count(*) FROM t_nk WHERE u >= '80000000-0000-0000-0000-000000000000';
+SELECT count(*), sum(o::int8) FROM t_nk WHERE o BETWEEN 3000010000 AND 3000010100;
+SELECT count(*) FROM (SELECT d, f4, lag(d) OVER () AS pd, lag(f4) OVER () AS pf FROM (SELECT d, f4 FROM t_nk ORDER BY d, f4) s) w WHERE (pd, pf) > (d, f4);
+SELECT count(*), sum(f4) FROM t_nk WHERE d = date '2024-01-07' AND f4 < 0;
+SELECT count(*), sum(v) FROM t_nk3 WHERE f < -100;
+SELECT count(*) FROM (SELECT f, lag(f) OVER () AS p FROM (SELECT f, v FROM t_nk3 ORDER BY f) s) w WHERE p > f;
+SELECT count(*), sum(v) FROM t_nk3 WHERE s >= 'f';
+SELECT count(*) FROM (SELECT s, lag(s) OVER () AS p FROM (SELECT s, v FROM t_nk3 ORDER BY s) q) w WHERE p > s;
+RESET smol.build_radix_sort;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+RESET enable_sort;
+DROP TABLE t_nk CASCADE;
+DROP TABLE t_nk3 CASCADE;
+RESET max_parallel_workers_per_gather;
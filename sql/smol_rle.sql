@@ -714,3 +714,81 @@ DROP TABLE t_large_growth CASCADE;
 DROP TABLE t_progress CASCADE;
 DROP TABLE t_mixed_byte CASCADE;
 
+-- ============================================================================
+-- Aggregate pushdown: smol_group_agg() folds runs without emitting rows
+-- ============================================================================
+
+-- Include-RLE leaves: one run per key, folded as count * value
+DROP TABLE IF EXISTS t_agg_rle CASCADE;
+CREATE UNLOGGED TABLE t_agg_rle (k int4, v int8);
+INSERT INTO t_agg_rle SELECT i / 1000, (i / 1000) * 7 FROM generate_series(0, 99999) i;
+CREATE INDEX t_agg_rle_idx ON t_agg_rle USING smol(k) INCLUDE (v);
+SELECT * FROM smol_group_agg('t_agg_rle_idx', 1, 10, 12) ORDER BY k;
+SELECT count(*) FROM (
+  (SELECT * FROM smol_group_agg('t_agg_rle_idx')
+   EXCEPT ALL SELECT k, count(*), sum(v), min(v), max(v) FROM t_agg_rle GROUP BY k)
+  UNION ALL
+  (SELECT k, count(*), sum(v), min(v), max(v) FROM t_agg_rle GROUP BY k
+   EXCEPT ALL SELECT * FROM smol_group_agg('t_agg_rle_idx'))) d;
+
+-- Plain leaves with duplicate keys and a second INCLUDE column
+DROP TABLE IF EXISTS t_agg_plain CASCADE;
+CREATE UNLOGGED TABLE t_agg_plain (k int8, w int2, v int4);
+INSERT INTO t_agg_plain SELECT i / 3, (i % 5)::int2, i FROM generate_series(0, 29999) i;
+CREATE INDEX t_agg_plain_idx ON t_agg_plain USING smol(k) INCLUDE (w, v);
+SELECT * FROM smol_group_agg('t_agg_plain_idx', 2, 5, 6) ORDER BY k;
+SELECT count(*) FROM (
+  (SELECT * FROM smol_group_agg('t_agg_plain_idx', 2, 1000)
+   EXCEPT ALL SELECT k, count(*), sum(v), min(v), max(v) FROM t_agg_plain WHERE k >= 1000 GROUP BY k)
+  UNION ALL
+  (SELECT k, count(*), sum(v), min(v), max(v) FROM t_agg_plain WHERE k >= 1000 GROUP BY k
+   EXCEPT ALL SELECT * FROM smol_group_agg('t_agg_plain_idx', 2, 1000))) d;
+SELECT count(*), sum(count), sum(sum) FROM smol_group_agg('t_agg_plain_idx', 1);
+
+-- Key-RLE leaves (no INCLUDE): counts only
+DROP TABLE IF EXISTS t_agg_keys CASCADE;
+CREATE UNLOGGED TABLE t_agg_keys (k int2);
+INSERT INTO t_agg_keys SELECT (i % 50)::int2 FROM generate_series(1, 10000) i;
+CREATE INDEX t_agg_keys_idx ON t_agg_keys USING smol(k);
+SELECT * FROM smol_group_agg('t_agg_keys_idx', lower_key => 48) ORDER BY k;
+SELECT count(*), sum(count) FROM smol_group_agg('t_agg_keys_idx');
+SELECT * FROM smol_group_agg('t_agg_keys_idx', 1);
+
+-- Sums past the int64 range switch to an exact numeric carry
+DROP TABLE IF EXISTS t_agg_big CASCADE;
+CREATE UNLOGGED TABLE t_agg_big (k int4, v int8);
+INSERT INTO t_agg_big SELECT 1, 9000000000000000000 FROM generate_series(1, 4);
+CREATE INDEX t_agg_big_idx ON t_agg_big USING smol(k) INCLUDE (v);
+SELECT * FROM smol_group_agg('t_agg_big_idx');
+
+-- Bounds outside the int2 key range are clamped, not truncated
+DROP TABLE IF EXISTS t_agg_i2 CASCADE;
+CREATE UNLOGGED TABLE t_agg_i2 (k int2, v int4);
+INSERT INTO t_agg_i2 SELECT i, i FROM generate_series(-30000, 30000) i;
+CREATE INDEX t_agg_i2_idx ON t_agg_i2 USING smol(k) INCLUDE (v);
+SELECT count(*), sum(count), min(k), max(k) FROM smol_group_agg('t_agg_i2_idx', 1, -70000);
+SELECT count(*) FROM smol_group_agg('t_agg_i2_idx', 1, 70000);
+SELECT count(*), min(k) FROM smol_group_agg('t_agg_i2_idx', 1, 29998, 70000);
+
+-- Leaf readers need SELECT on the table and no row-level security
+CREATE ROLE regress_smol_agg;
+SET ROLE regress_smol_agg;
+SELECT count(*) FROM smol_group_agg('t_agg_rle_idx');
+RESET ROLE;
+GRANT SELECT ON t_agg_rle TO regress_smol_agg;
+ALTER TABLE t_agg_rle ENABLE ROW LEVEL SECURITY;
+SET ROLE regress_smol_agg;
+SELECT count(*) FROM smol_group_agg('t_agg_rle_idx');
+RESET ROLE;
+ALTER TABLE t_agg_rle DISABLE ROW LEVEL SECURITY;
+SET ROLE regress_smol_agg;
+SELECT count(*) FROM smol_group_agg('t_agg_rle_idx');
+RESET ROLE;
+REVOKE SELECT ON t_agg_rle FROM regress_smol_agg;
+DROP ROLE regress_smol_agg;
+
+DROP TABLE t_agg_rle CASCADE;
+DROP TABLE t_agg_plain CASCADE;
+DROP TABLE t_agg_keys CASCADE;
+DROP TABLE t_agg_big CASCADE;
+DROP TABLE t_agg_i2 CASCADE;
@@ -206,6 +206,63 @@ DROP TABLE t_parallel_seq CASCADE;
 DROP TABLE t_parallel_idx CASCADE;
 DROP TABLE t_parallel_build CASCADE;
 
+-- ============================================================================
+-- Frame-of-reference bit-packed integer leaves (smol.key_bitpack)
+-- ============================================================================
+DROP TABLE IF EXISTS t_for CASCADE;
+CREATE TABLE t_for (k int8);
+INSERT INTO t_for SELECT i * 3 FROM generate_series(1, 100000) i;
+CREATE INDEX t_for_plain ON t_for USING smol(k);
+SET smol.key_bitpack = on;
+CREATE INDEX t_for_bp ON t_for USING smol(k);
+DROP TABLE IF EXISTS t_for4 CASCADE;
+CREATE TABLE t_for4 (k int4);
+INSERT INTO t_for4 SELECT i / 2 FROM generate_series(1, 100000) i;
+CREATE INDEX t_for4_bp ON t_for4 USING smol(k);
+RESET smol.key_bitpack;
+SELECT pg_relation_size('t_for_bp') < pg_relation_size('t_for_plain') AS smaller;
+DROP INDEX t_for_plain;
+
+SET enable_seqscan = off;
+SET max_parallel_workers_per_gather = 0;
+SELECT count(*), sum(k) FROM t_for WHERE k >= 30000 AND k < 60000;
+SELECT count(*) FROM t_for WHERE k = 29997;
+SELECT k FROM t_for WHERE k > 299990 ORDER BY k DESC LIMIT 3;
+SELECT count(*), sum(k) FROM t_for4 WHERE k BETWEEN 100 AND 199;
+SELECT count(*) FROM t_for4 WHERE k = 777;
+RESET enable_seqscan;
+RESET max_parallel_workers_per_gather;
+DROP TABLE t_for CASCADE;
+DROP TABLE t_for4 CASCADE;
+
+-- ============================================================================
+-- Bounded backward scans (descend to the upper bound, walk leftlinks)
+-- ============================================================================
+DROP TABLE IF EXISTS t_bwd CASCADE;
+CREATE TABLE t_bwd (k int4);
+INSERT INTO t_bwd SELECT i / 3 FROM generate_series(1, 60000) i;
+CREATE INDEX t_bwd_idx ON t_bwd USING smol(k);
+DROP TABLE IF EXISTS t_bwd2 CASCADE;
+CREATE TABLE t_bwd2 (a int4, b int4);
+INSERT INTO t_bwd2 SELECT i / 4, i FROM generate_series(1, 40000) i;
+CREATE INDEX t_bwd2_idx ON t_bwd2 USING smol(a, b);
+
+SET enable_seqscan = off;
+SET max_parallel_workers_per_gather = 0;
+SELECT k FROM t_bwd WHERE k < 10000 ORDER BY k DESC LIMIT 4;
+SELECT k FROM t_bwd WHERE k <= 10000 ORDER BY k DESC LIMIT 4;
+SELECT min(k), max(k), count(*) FROM (SELECT k FROM t_bwd WHERE k BETWEEN 500 AND 700 ORDER BY k DESC LIMIT 1000) s;
+SELECT k FROM t_bwd WHERE k < 1 ORDER BY k DESC LIMIT 5;
+SELECT k FROM t_bwd WHERE k < 0 ORDER BY k DESC LIMIT 5;
+SELECT k FROM t_bwd WHERE k <= 50000 ORDER BY k DESC LIMIT 2;
+SELECT a, b FROM t_bwd2 WHERE a <= 5000 ORDER BY a DESC LIMIT 3;
+SELECT a, b FROM t_bwd2 WHERE a >= 9990 ORDER BY a DESC LIMIT 2;
+SELECT count(*), min(b), max(b) FROM (SELECT a, b FROM t_bwd2 WHERE a BETWEEN 100 AND 199 ORDER BY a DESC LIMIT 1000) s;
+RESET enable_seqscan;
+RESET max_parallel_workers_per_gather;
+DROP TABLE t_bwd CASCADE;
+DROP TABLE t_bwd2 CASCADE;
+
 -- ============================================================================
 -- smol_options_coverage
 -- ============================================================================
@@ -220,6 +277,35 @@ CREATE INDEX t_opt_idx ON t_opt USING smol(k) WITH (fillfactor=90);
 -- Cleanup
 DROP TABLE t_opt CASCADE;
 
+-- ============================================================================
+-- smol_prewarm and resident indexes
+-- ============================================================================
+DROP TABLE IF EXISTS t_pw CASCADE;
+CREATE UNLOGGED TABLE t_pw (k int4);
+INSERT INTO t_pw SELECT i FROM generate_series(1, 600000) i;
+-- Enough leaves for a directory, so chunks follow its entries
+CREATE INDEX t_pw_idx ON t_pw USING smol(k) WITH (resident = true);
+SELECT reloptions FROM pg_class WHERE relname = 't_pw_idx';
+-- Every block is read at least once, by the caller alone or with workers
+SELECT smol_prewarm('t_pw_idx') >= (SELECT total_pages FROM smol_inspect('t_pw_idx'));
+SELECT smol_prewarm('t_pw_idx', 2) >= (SELECT total_pages FROM smol_inspect('t_pw_idx'));
+SELECT smol_prewarm('t_pw_idx', -1);
+CREATE INDEX t_pw_btree ON t_pw (k);
+SELECT smol_prewarm('t_pw_btree');
+DROP INDEX t_pw_btree;
+SELECT smol_prewarm('t_pw');
+CREATE ROLE regress_smol_prewarm;
+SET ROLE regress_smol_prewarm;
+SELECT smol_prewarm('t_pw_idx');
+RESET ROLE;
+DROP ROLE regress_smol_prewarm;
+-- The first scan of a resident index warms its upper levels
+SET enable_seqscan = off;
+SELECT count(*), min(k), max(k) FROM t_pw WHERE k > 599000;
+RESET enable_seqscan;
+CREATE INDEX t_pw_bad ON t_pw USING smol(k) WITH (resident = 'maybe');
+DROP TABLE t_pw CASCADE;
+
 -- ============================================================================
 -- Position-based scan optimization tests
 -- ============================================================================
@@ -308,11 +394,793 @@ CREATE INDEX t_multi_include_idx ON t_multi_include USING smol(k) INCLUDE (v1, v
 
 SELECT count(*), sum(v1), sum(v2), sum(v3) FROM t_multi_include WHERE k >= 50 AND k <= 450;
 
+-- Buffering on RLE, include-RLE, text and two-column leaves, both directions;
+-- a small buffer makes batches end inside runs and at bounds
+SET smol.tuple_buffer_size = 7;
+DROP TABLE IF EXISTS t_tb_rle CASCADE;
+CREATE UNLOGGED TABLE t_tb_rle(k int4);
+INSERT INTO t_tb_rle SELECT i / 10 FROM generate_series(1, 20000) i;
+CREATE INDEX t_tb_rle_idx ON t_tb_rle USING smol(k);
+SELECT count(*), sum(k) FROM t_tb_rle WHERE k >= 1500;
+SELECT count(*) FROM t_tb_rle WHERE k = 1234;
+SELECT count(*), sum(k) FROM (SELECT k FROM t_tb_rle WHERE k BETWEEN 700 AND 899 ORDER BY k DESC) s;
+SELECT array_agg(k) FROM (SELECT k FROM t_tb_rle WHERE k <= 1203 ORDER BY k DESC LIMIT 25) s;
+-- Rescans must not return rows buffered for the previous key
+SELECT sum(s.k) FROM generate_series(100, 104) g, LATERAL (SELECT k FROM t_tb_rle WHERE k >= g ORDER BY k LIMIT 12) s;
+DROP TABLE IF EXISTS t_tb_incrle CASCADE;
+CREATE UNLOGGED TABLE t_tb_incrle(k int4, v int4);
+INSERT INTO t_tb_incrle SELECT i / 10, (i / 10) % 7 FROM generate_series(1, 20000) i;
+CREATE INDEX t_tb_incrle_idx ON t_tb_incrle USING smol(k) INCLUDE (v);
+SELECT count(*), sum(k), sum(v) FROM t_tb_incrle WHERE k >= 1500;
+SELECT count(*), sum(v) FROM (SELECT k, v FROM t_tb_incrle WHERE k < 900 ORDER BY k DESC) s;
+SELECT array_agg(k * 10 + v) FROM (SELECT k, v FROM t_tb_incrle WHERE k <= 1203 ORDER BY k DESC LIMIT 12) s;
+DROP TABLE IF EXISTS t_tb_txt CASCADE;
+CREATE UNLOGGED TABLE t_tb_txt(k text COLLATE "C", v text);
+INSERT INTO t_tb_txt SELECT 'key-' || lpad((i / 4)::text, 5, '0'), 'v' || (i % 3) FROM generate_series(1, 8000) i;
+CREATE INDEX t_tb_txt_idx ON t_tb_txt USING smol(k) INCLUDE (v);
+SELECT count(*), count(DISTINCT k), min(v), max(v) FROM t_tb_txt WHERE k >= 'key-01500';
+SELECT count(*), count(DISTINCT k) FROM (SELECT k FROM t_tb_txt WHERE k < 'key-00500' ORDER BY k DESC) s;
+SELECT array_agg(k || ':' || v ORDER BY k, v) FROM (SELECT k, v FROM t_tb_txt WHERE k <= 'key-00101' ORDER BY k DESC LIMIT 8) s;
+DROP TABLE IF EXISTS t_tb2 CASCADE;
+CREATE UNLOGGED TABLE t_tb2(a int4, b int4);
+INSERT INTO t_tb2 SELECT i / 20, i % 20 FROM generate_series(1, 10000) i;
+CREATE INDEX t_tb2_idx ON t_tb2 USING smol(a, b);
+SELECT count(*), sum(a), sum(b) FROM t_tb2 WHERE a >= 400;
+SELECT count(*), sum(a) FROM t_tb2 WHERE a >= 400 AND b = 3;
+SELECT count(*), sum(b) FROM (SELECT a, b FROM t_tb2 WHERE a BETWEEN 100 AND 199 ORDER BY a DESC, b DESC) s;
+SELECT array_agg(a * 100 + b) FROM (SELECT a, b FROM t_tb2 WHERE a <= 250 ORDER BY a DESC, b DESC LIMIT 25) s;
+SELECT array_agg(a) FROM (SELECT a FROM t_tb2 WHERE a < 250 AND b = 7 ORDER BY a DESC LIMIT 10) s;
+RESET smol.tuple_buffer_size;
+DROP TABLE t_tb_rle CASCADE;
+DROP TABLE t_tb_incrle CASCADE;
+DROP TABLE t_tb_txt CASCADE;
+DROP TABLE t_tb2 CASCADE;
+
 -- Cleanup tuple buffering tests
 DROP TABLE t_tuple_buffer CASCADE;
 DROP TABLE t_multi_include CASCADE;
 RESET smol.use_tuple_buffering;
 
+-- ============================================================================
+-- ScalarArrayOp (IN / = ANY) with sorted multi-probe descent
+-- ============================================================================
+DROP TABLE IF EXISTS t_saop CASCADE;
+CREATE UNLOGGED TABLE t_saop(k int4, v int4);
+INSERT INTO t_saop SELECT i % 5000, i FROM generate_series(1, 20000) i;
+CREATE INDEX t_saop_idx ON t_saop USING smol(k);
+DROP TABLE IF EXISTS t_saop2 CASCADE;
+CREATE UNLOGGED TABLE t_saop2(a int4, b int4);
+INSERT INTO t_saop2 SELECT i % 100, i % 7 FROM generate_series(1, 7000) i;
+CREATE INDEX t_saop2_idx ON t_saop2 USING smol(a, b);
+DROP TABLE IF EXISTS t_saop_text CASCADE;
+CREATE UNLOGGED TABLE t_saop_text(k text COLLATE "C");
+INSERT INTO t_saop_text SELECT 'key' || (i % 300) FROM generate_series(1, 3000) i;
+CREATE INDEX t_saop_text_idx ON t_saop_text USING smol(k);
+
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SET enable_indexonlyscan = on;
+
+-- Unsorted probes with duplicates, NULL and missing values
+SELECT k, count(*) FROM t_saop WHERE k = ANY('{7, 3, 4999, 3, NULL, 12345, -1}') GROUP BY k ORDER BY k;
+-- Scalar quals on the same column filter the probe list
+SELECT count(*) FROM t_saop WHERE k IN (10, 20, 30) AND k > 15;
+-- Empty array and cross-type probes (out-of-range elements never match)
+SELECT count(*) FROM t_saop WHERE k = ANY('{}'::int4[]);
+SELECT count(*) FROM t_saop WHERE k = ANY(ARRAY[1, 5000000000]::int8[]);
+-- Backward scan uses the probe range plus a membership filter
+SELECT k FROM t_saop WHERE k IN (5, 100, 2500) ORDER BY k DESC LIMIT 5;
+-- Inequality arrays reduce to a single bound
+SELECT count(*) FROM t_saop WHERE k < ANY('{3, 10}');
+SELECT count(*) FROM t_saop WHERE k >= ANY('{4990, 4995}');
+-- Many probes across leaves
+SELECT count(*), sum(k) FROM t_saop WHERE k = ANY(ARRAY(SELECT g * 50 FROM generate_series(0, 99) g));
+-- Two-column index: arrays on both keys
+SELECT count(*) FROM t_saop2 WHERE a IN (1, 50, 99) AND b = ANY('{0, 3}');
+SELECT count(*), sum(b) FROM t_saop2 WHERE a = ANY('{4, 2}');
+-- Text keys
+SELECT count(*) FROM t_saop_text WHERE k IN ('key1', 'key299', 'nokey');
+
+DROP TABLE t_saop CASCADE;
+DROP TABLE t_saop2 CASCADE;
+DROP TABLE t_saop_text CASCADE;
+
+-- ============================================================================
+-- Full-width zone keys (int8, timestamptz, uuid, long text)
+-- ============================================================================
+DROP TABLE IF EXISTS t_zk8 CASCADE;
+CREATE UNLOGGED TABLE t_zk8(k int8);
+INSERT INTO t_zk8 SELECT i * 10000000000::int8 FROM generate_series(-25000, 25000) i;
+CREATE INDEX t_zk8_idx ON t_zk8 USING smol(k);
+DROP TABLE IF EXISTS t_zkts CASCADE;
+CREATE UNLOGGED TABLE t_zkts(ts timestamptz);
+INSERT INTO t_zkts SELECT '2020-01-01 00:00+00'::timestamptz + i * interval '1 minute' FROM generate_series(1, 50000) i;
+CREATE INDEX t_zkts_idx ON t_zkts USING smol(ts);
+DROP TABLE IF EXISTS t_zkuuid CASCADE;
+CREATE UNLOGGED TABLE t_zkuuid(u uuid);
+INSERT INTO t_zkuuid SELECT md5(i::text)::uuid FROM generate_series(1, 20000) i;
+CREATE INDEX t_zkuuid_idx ON t_zkuuid USING smol(u);
+DROP TABLE IF EXISTS t_zktext CASCADE;
+CREATE UNLOGGED TABLE t_zktext(k text COLLATE "C");
+INSERT INTO t_zktext SELECT 'prefix_' || lpad(i::text, 10, '0') FROM generate_series(1, 30000) i;
+CREATE INDEX t_zktext_idx ON t_zktext USING smol(k);
+
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SET enable_indexonlyscan = on;
+
+-- int8 bounds beyond the int32 range
+SELECT count(*) FROM t_zk8 WHERE k >= 24990 * 10000000000::int8;
+SELECT count(*) FROM t_zk8 WHERE k < -24990 * 10000000000::int8;
+SELECT count(*) FROM t_zk8 WHERE k > 12345 * 10000000000::int8 AND k <= 12355 * 10000000000::int8;
+SELECT count(*) FROM t_zk8 WHERE k = 7777 * 10000000000::int8;
+SELECT count(*) FROM t_zk8 WHERE k = 7777 * 10000000000::int8 + 1;
+-- timestamptz range and equality
+SELECT count(*) FROM t_zkts WHERE ts >= '2020-01-01 00:00+00'::timestamptz + interval '49990 minutes';
+SELECT count(*) FROM t_zkts WHERE ts > '2020-01-01 00:00+00'::timestamptz + interval '100 minutes'
+  AND ts <= '2020-01-01 00:00+00'::timestamptz + interval '200 minutes';
+SELECT count(*) FROM t_zkts WHERE ts = '2020-01-01 00:00+00'::timestamptz + interval '31415 minutes';
+-- uuid keys compare on all 16 bytes
+SELECT count(*) FROM t_zkuuid WHERE u >= 'f0000000-0000-0000-0000-000000000000';
+SELECT count(*) FROM t_zkuuid WHERE u BETWEEN '40000000-0000-0000-0000-000000000000' AND '4fffffff-ffff-ffff-ffff-ffffffffffff';
+SELECT count(*) FROM t_zkuuid WHERE u > '827ccb0e-ea8a-706c-4c34-a16891f84e7b';
+SELECT count(*) FROM t_zkuuid WHERE u = '827ccb0e-ea8a-706c-4c34-a16891f84e7b';
+-- text keys longer than the 16-byte zone key prefix
+SELECT count(*) FROM t_zktext WHERE k >= 'prefix_0000029990';
+SELECT count(*) FROM t_zktext WHERE k > 'prefix_00000299';
+SELECT count(*) FROM t_zktext WHERE k >= 'prefix_0000010000' AND k < 'prefix_0000010100';
+SELECT count(*) FROM t_zktext WHERE k = 'prefix_0000012345';
+-- Internal levels still carry full-width highkeys when zone maps are not built
+SET smol.build_zone_maps = off;
+DROP INDEX t_zk8_idx;
+CREATE INDEX t_zk8_idx ON t_zk8 USING smol(k);
+RESET smol.build_zone_maps;
+SELECT count(*) FROM t_zk8 WHERE k >= 24990 * 10000000000::int8;
+SELECT count(*) FROM t_zk8 WHERE k > 12345 * 10000000000::int8 AND k <= 12355 * 10000000000::int8;
+
+DROP TABLE t_zk8 CASCADE;
+DROP TABLE t_zkts CASCADE;
+DROP TABLE t_zkuuid CASCADE;
+DROP TABLE t_zktext CASCADE;
+
+-- ============================================================================
+-- Vectorized in-leaf search on plain int2/int4/int8 leaves
+-- ============================================================================
+DROP TABLE IF EXISTS t_vec2 CASCADE;
+CREATE UNLOGGED TABLE t_vec2(k int2);
+INSERT INTO t_vec2 SELECT i FROM generate_series(-32000, 32000) i;
+CREATE INDEX t_vec2_idx ON t_vec2 USING smol(k);
+DROP TABLE IF EXISTS t_vec4 CASCADE;
+CREATE UNLOGGED TABLE t_vec4(k int4);
+INSERT INTO t_vec4 SELECT i * 3 FROM generate_series(-100000, 100000) i;
+CREATE INDEX t_vec4_idx ON t_vec4 USING smol(k);
+DROP TABLE IF EXISTS t_vec8 CASCADE;
+CREATE UNLOGGED TABLE t_vec8(k int8, v int4);
+INSERT INTO t_vec8 SELECT (i / 2) * 10000000000::int8, i FROM generate_series(0, 39999) i;
+CREATE INDEX t_vec8_idx ON t_vec8 USING smol(k) INCLUDE (v);
+
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SET enable_indexonlyscan = on;
+
+-- int2: inclusive/strict bounds, negative keys, strict bound at the type maximum
+SELECT count(*) FROM t_vec2 WHERE k >= 31990::int2;
+SELECT count(*) FROM t_vec2 WHERE k > 31990::int2;
+SELECT count(*) FROM t_vec2 WHERE k > -32000::int2 AND k < -31990::int2;
+SELECT count(*) FROM t_vec2 WHERE k = 32000::int2;
+SELECT count(*) FROM t_vec2 WHERE k > 32767::int2;
+-- int4: bounds between stored keys
+SELECT count(*) FROM t_vec4 WHERE k >= 299990;
+SELECT count(*) FROM t_vec4 WHERE k > 300 AND k <= 600;
+SELECT count(*) FROM t_vec4 WHERE k > -7;
+SELECT count(*) FROM t_vec4 WHERE k = 3001;
+SELECT count(*) FROM t_vec4 WHERE k >= -2147483648;
+-- int8 + INCLUDE: duplicate-key runs on plain leaves
+SELECT count(*), sum(v) FROM t_vec8 WHERE k >= 19990 * 10000000000::int8;
+SELECT count(*), sum(v) FROM t_vec8 WHERE k > 100 * 10000000000::int8 AND k <= 110 * 10000000000::int8;
+SELECT count(*), sum(v) FROM t_vec8 WHERE k = 12345 * 10000000000::int8;
+SELECT count(*) FROM t_vec8 WHERE k > 9223372036854775807;
+
+DROP TABLE t_vec2 CASCADE;
+DROP TABLE t_vec4 CASCADE;
+DROP TABLE t_vec8 CASCADE;
+
+-- ============================================================================
+-- Parallel scan over the leaf directory (work-stealing entry ranges)
+-- ============================================================================
+DROP TABLE IF EXISTS t_pdir CASCADE;
+CREATE UNLOGGED TABLE t_pdir(k int4);
+INSERT INTO t_pdir SELECT i FROM generate_series(1, 600000) i;
+CREATE INDEX t_pdir_idx ON t_pdir USING smol(k);
+ANALYZE t_pdir;
+
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SET enable_indexonlyscan = on;
+SET max_parallel_workers_per_gather = 4;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_index_scan_size = 0;
+
+-- Every claimed entry seeks to the lower bound; upper bounds stop the claims
+SELECT count(*) FROM t_pdir WHERE k >= 1;
+SELECT count(*) FROM t_pdir WHERE k > 123456;
+SELECT count(*), sum(k::int8) FROM t_pdir WHERE k BETWEEN 200000 AND 400000;
+SELECT count(*) FROM t_pdir WHERE k = 345678;
+SELECT count(*) FROM t_pdir WHERE k >= 599990;
+SELECT count(*) FROM t_pdir WHERE k < 100;
+-- one heavy key: a few RLE leaves carry most of the rows, and entries split by rows
+DROP TABLE IF EXISTS t_pdirw CASCADE;
+CREATE UNLOGGED TABLE t_pdirw(k int4);
+INSERT INTO t_pdirw SELECT i FROM generate_series(1, 600000) i;
+INSERT INTO t_pdirw SELECT 300000 FROM generate_series(1, 200000);
+CREATE INDEX t_pdirw_idx ON t_pdirw USING smol(k);
+ANALYZE t_pdirw;
+SELECT count(*) FROM t_pdirw WHERE k >= 1;
+SELECT count(*) FROM t_pdirw WHERE k > 123456;
+SELECT count(*), sum(k::int8) FROM t_pdirw WHERE k BETWEEN 200000 AND 400000;
+SELECT count(*) FROM t_pdirw WHERE k = 300000;
+-- text keys: entry ranges come from the directory's zone keys
+DROP TABLE IF EXISTS t_pdirt CASCADE;
+CREATE UNLOGGED TABLE t_pdirt(k text COLLATE "C");
+INSERT INTO t_pdirt SELECT lpad(i::text, 8, '0') FROM generate_series(1, 300000) i;
+CREATE INDEX t_pdirt_idx ON t_pdirt USING smol(k);
+ANALYZE t_pdirt;
+SELECT count(*) FROM t_pdirt WHERE k >= '00100000' AND k < '00200000';
+SELECT count(*) FROM t_pdirt WHERE k = '00123456';
+SELECT count(*) FROM t_pdirt WHERE k > '00299990';
+
+RESET max_parallel_workers_per_gather;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_index_scan_size;
+DROP TABLE t_pdir CASCADE;
+DROP TABLE t_pdirw CASCADE;
+DROP TABLE t_pdirt CASCADE;
+
+-- ============================================================================
+-- Bitmap Heap Scan (lossy heap block ranges per leaf)
+-- ============================================================================
+DROP TABLE IF EXISTS t_bitmap CASCADE;
+CREATE UNLOGGED TABLE t_bitmap(k int4, v int4);
+INSERT INTO t_bitmap SELECT i, i % 7 FROM generate_series(1, 20000) i;
+CREATE INDEX t_bitmap_k ON t_bitmap USING smol(k);
+-- INCLUDE build records no heap ranges: bitmap falls back to the whole heap
+CREATE INDEX t_bitmap_v ON t_bitmap USING smol(v) INCLUDE (k);
+ANALYZE t_bitmap;
+
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+SET enable_indexonlyscan = off;
+SET enable_bitmapscan = on;
+
+-- Non-IOS queries now run as bitmap heap scans instead of erroring
+SELECT count(*), sum(v) FROM t_bitmap WHERE k BETWEEN 1000 AND 1500;
+SELECT count(*) FROM t_bitmap WHERE k = 4242;
+SELECT count(*), sum(k) FROM t_bitmap WHERE k > 19990;
+SELECT count(*), sum(k) FROM t_bitmap WHERE v = 3 AND k < 200;
+
+-- Plans go through the SMOL index; the INCLUDE index would read the whole heap
+EXPLAIN (COSTS OFF) SELECT count(*), sum(v) FROM t_bitmap WHERE k BETWEEN 1000 AND 1500;
+EXPLAIN (COSTS OFF) SELECT count(*), sum(k) FROM t_bitmap WHERE v = 3 AND k < 200;
+-- Two SMOL bitmaps are intersected before the heap is visited
+DROP TABLE IF EXISTS t_bitmap_and CASCADE;
+CREATE UNLOGGED TABLE t_bitmap_and(k int4, w int4);
+INSERT INTO t_bitmap_and SELECT i, (i * 7) % 200000 FROM generate_series(1, 200000) i;
+CREATE INDEX t_bitmap_and_k ON t_bitmap_and USING smol(k);
+CREATE INDEX t_bitmap_and_w ON t_bitmap_and USING smol(w);
+ANALYZE t_bitmap_and;
+EXPLAIN (COSTS OFF) SELECT count(*), sum(k) FROM t_bitmap_and WHERE k < 40000 AND w < 80000;
+SELECT count(*), sum(k) FROM t_bitmap_and WHERE k < 40000 AND w < 80000;
+DROP TABLE t_bitmap_and CASCADE;
+DROP TABLE t_bitmap CASCADE;
+
+-- ============================================================================
+-- Statistics-driven cost estimates
+-- ============================================================================
+DROP TABLE IF EXISTS t_cstat CASCADE;
+CREATE UNLOGGED TABLE t_cstat(k int4);
+INSERT INTO t_cstat SELECT i / 10 FROM generate_series(1, 200000) i;
+CREATE INDEX t_cstat_bt ON t_cstat USING btree(k);
+CREATE INDEX t_cstat_smol ON t_cstat USING smol(k);
+VACUUM ANALYZE t_cstat;
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET enable_indexscan = off;
+SET enable_indexonlyscan = on;
+SET max_parallel_workers_per_gather = 0;
+
+-- A wide range costs the few RLE leaves it reads, well below the btree pages
+EXPLAIN (COSTS OFF) SELECT count(*) FROM t_cstat WHERE k BETWEEN 1000 AND 15000;
+SELECT count(*) FROM t_cstat WHERE k BETWEEN 1000 AND 15000;
+-- Bounds past every root zone map still plan and return nothing
+SELECT count(*) FROM t_cstat WHERE k > 30000;
+SELECT count(*) FROM t_cstat WHERE k = 777;
+
+DROP TABLE t_cstat CASCADE;
+
+-- ============================================================================
+-- Leaf read stream
+-- ============================================================================
+DROP TABLE IF EXISTS t_rs CASCADE;
+CREATE UNLOGGED TABLE t_rs (k int4);
+INSERT INTO t_rs SELECT i FROM generate_series(1, 200000) i;
+CREATE INDEX t_rs_idx ON t_rs USING smol(k);
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET max_parallel_workers_per_gather = 0;
+
+-- Forward and backward walks return the same rows through the stream ...
+SELECT count(*), sum(k::int8) FROM t_rs WHERE k > 1000;
+SELECT count(*), sum(k::int8) FROM t_rs WHERE k BETWEEN 5000 AND 150000;
+SELECT k FROM t_rs WHERE k < 120000 ORDER BY k DESC LIMIT 3;
+SELECT count(*), sum(k::int8) FROM (SELECT k FROM t_rs WHERE k > 100 ORDER BY k DESC) s;
+-- ... and with per-block prefetch
+SET smol.read_stream = off;
+SELECT count(*), sum(k::int8) FROM t_rs WHERE k > 1000;
+SELECT count(*), sum(k::int8) FROM t_rs WHERE k BETWEEN 5000 AND 150000;
+SELECT k FROM t_rs WHERE k < 120000 ORDER BY k DESC LIMIT 3;
+SELECT count(*), sum(k::int8) FROM (SELECT k FROM t_rs WHERE k > 100 ORDER BY k DESC) s;
+RESET smol.read_stream;
+DROP TABLE t_rs CASCADE;
+
+-- ============================================================================
+-- k1-grouped two-column leaves
+-- ============================================================================
+DROP TABLE IF EXISTS t_grp CASCADE;
+DROP TABLE IF EXISTS t_grp_rm CASCADE;
+CREATE UNLOGGED TABLE t_grp (tenant int4, ts int8);
+INSERT INTO t_grp SELECT t, s * 2 FROM generate_series(0, 49) t, generate_series(1, 4000) s;
+INSERT INTO t_grp SELECT 7, 100 FROM generate_series(1, 3);
+CREATE UNLOGGED TABLE t_grp_rm AS SELECT * FROM t_grp;
+CREATE INDEX t_grp_rm_idx ON t_grp_rm USING smol(tenant, ts);
+SET smol.two_col_groups = on;
+CREATE INDEX t_grp_idx ON t_grp USING smol(tenant, ts);
+-- Each tenant is stored once per leaf, so the grouped index is smaller
+SELECT pg_relation_size('t_grp_idx') < pg_relation_size('t_grp_rm_idx') AS smaller;
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET max_parallel_workers_per_gather = 0;
+SELECT count(*), sum(ts) FROM t_grp WHERE tenant >= 0;
+SELECT count(*), sum(ts) FROM t_grp WHERE tenant = 7 AND ts BETWEEN 1000 AND 2000;
+-- Second-key equality binary-searches each group and skips groups on k2 min/max
+SELECT count(*) FROM t_grp WHERE tenant = 7 AND ts = 100;
+SELECT count(*) FROM t_grp WHERE tenant = 7 AND ts = 101;
+SELECT count(*) FROM t_grp WHERE tenant BETWEEN 10 AND 12 AND ts = 8000;
+SELECT count(*) FROM t_grp WHERE ts = 100;
+SELECT count(*) FROM t_grp WHERE ts = 8002;
+SELECT tenant, ts FROM t_grp WHERE tenant <= 3 AND ts = 2 ORDER BY tenant DESC, ts DESC;
+SELECT count(*) FROM (SELECT ts FROM t_grp WHERE tenant = 7 AND ts = 100 ORDER BY tenant DESC, ts DESC) s;
+-- INCLUDE columns follow the packed k2 array
+DROP TABLE IF EXISTS t_grpi CASCADE;
+CREATE UNLOGGED TABLE t_grpi (g int4, v int4, w int4);
+INSERT INTO t_grpi SELECT g, s, g * 10000 + s FROM generate_series(0, 4) g, generate_series(1, 2000) s;
+CREATE INDEX t_grpi_idx ON t_grpi USING smol(g, v) INCLUDE (w);
+SELECT w FROM t_grpi WHERE g = 3 AND v = 1500;
+SELECT count(*), sum(w) FROM t_grpi WHERE g = 2 AND v BETWEEN 100 AND 199;
+RESET smol.two_col_groups;
+DROP TABLE t_grp CASCADE;
+DROP TABLE t_grp_rm CASCADE;
+DROP TABLE t_grpi CASCADE;
+
+-- ============================================================================
+-- Scan kernels specialized on key width and INCLUDE shape
+-- ============================================================================
+DROP TABLE IF EXISTS t_kern CASCADE;
+DROP TABLE IF EXISTS t_kern8 CASCADE;
+DROP TABLE IF EXISTS t_kern_ko CASCADE;
+DROP TABLE IF EXISTS t_kern_mix CASCADE;
+CREATE UNLOGGED TABLE t_kern (k int4, a int4, b int4);
+INSERT INTO t_kern SELECT i, i * 2, i % 7 FROM generate_series(1, 50000) i;
+CREATE INDEX t_kern_idx ON t_kern USING smol(k) INCLUDE (a, b);
+CREATE UNLOGGED TABLE t_kern8 (k int8, x int8);
+INSERT INTO t_kern8 SELECT i * 3, -i FROM generate_series(1, 40000) i;
+CREATE INDEX t_kern8_idx ON t_kern8 USING smol(k) INCLUDE (x);
+CREATE UNLOGGED TABLE t_kern_ko (k int8);
+INSERT INTO t_kern_ko SELECT i * 10 FROM generate_series(1, 30000) i;
+CREATE INDEX t_kern_ko_idx ON t_kern_ko USING smol(k);
+-- Mixed INCLUDE widths have no kernel and take the generic refill
+CREATE UNLOGGED TABLE t_kern_mix (k int4, x int8, y int4);
+INSERT INTO t_kern_mix SELECT i, i * 1000, i % 3 FROM generate_series(1, 20000) i;
+CREATE INDEX t_kern_mix_idx ON t_kern_mix USING smol(k) INCLUDE (x, y);
+-- An odd buffer size makes refills stop mid-page
+SET smol.tuple_buffer_size = 7;
+SELECT count(*), sum(a), sum(b) FROM t_kern WHERE k BETWEEN 1000 AND 30000;
+SELECT k, a, b FROM t_kern WHERE k = 777;
+SELECT k, a FROM t_kern WHERE k > 49990 ORDER BY k LIMIT 3;
+SELECT count(*), sum(b) FROM t_kern WHERE k < 20;
+SELECT count(*), sum(x) FROM t_kern8 WHERE k >= 60000 AND k < 90000;
+SELECT count(*), sum(k) FROM t_kern_ko WHERE k > 100 AND k <= 250000;
+SELECT count(*) FROM t_kern_ko WHERE k = 12340;
+SELECT count(*), sum(x), sum(y) FROM t_kern_mix WHERE k > 5000;
+-- Same answers from the generic refill
+SET smol.scan_kernels = off;
+SELECT count(*), sum(a), sum(b) FROM t_kern WHERE k BETWEEN 1000 AND 30000;
+SELECT count(*), sum(k) FROM t_kern_ko WHERE k > 100 AND k <= 250000;
+RESET smol.scan_kernels;
+RESET smol.tuple_buffer_size;
+DROP TABLE t_kern CASCADE;
+DROP TABLE t_kern8 CASCADE;
+DROP TABLE t_kern_ko CASCADE;
+DROP TABLE t_kern_mix CASCADE;
+
+-- ============================================================================
+-- Prefix-truncated text leaves (smol.text_prefix)
+-- ============================================================================
+DROP TABLE IF EXISTS t_tp CASCADE;
+DROP TABLE IF EXISTS t_tp_long CASCADE;
+CREATE UNLOGGED TABLE t_tp (k text COLLATE "C");
+INSERT INTO t_tp SELECT 'SKU-' || lpad(i::text, 6, '0') FROM generate_series(1, 20000) i;
+CREATE INDEX t_tp_pad_idx ON t_tp USING smol(k);
+SET smol.text_prefix = on;
+CREATE INDEX t_tp_idx ON t_tp USING smol(k);
+-- Each leaf stores its shared prefix once instead of padding every key to 16 bytes
+SELECT pg_relation_size('t_tp_idx') * 2 < pg_relation_size('t_tp_pad_idx') AS smaller;
+DROP INDEX t_tp_pad_idx;
+SELECT count(*) FROM t_tp WHERE k >= 'SKU-005000' AND k < 'SKU-006000';
+SELECT k FROM t_tp WHERE k = 'SKU-012345';
+SELECT k FROM t_tp WHERE k > 'SKU-019997' ORDER BY k;
+SELECT k FROM t_tp WHERE k < 'SKU-000004' ORDER BY k DESC;
+SELECT count(*), min(k), max(k) FROM t_tp WHERE k BETWEEN 'SKU-0' AND 'SKU-1';
+-- Keys longer than 32 bytes
+CREATE UNLOGGED TABLE t_tp_long (k text COLLATE "C");
+INSERT INTO t_tp_long SELECT 'https://example.com/catalog/items/' || lpad(i::text, 8, '0') FROM generate_series(1, 5000) i;
+CREATE INDEX t_tp_long_idx ON t_tp_long USING smol(k);
+SELECT count(*) FROM t_tp_long WHERE k >= 'https://example.com/catalog/items/00001000' AND k < 'https://example.com/catalog/items/00002000';
+SELECT k FROM t_tp_long WHERE k = 'https://example.com/catalog/items/00004321';
+SELECT length(k) FROM t_tp_long WHERE k > 'https://example.com/catalog/items/00004998' ORDER BY k;
+-- The padded layout still stops at 32 bytes
+SET smol.text_prefix = off;
+CREATE INDEX t_tp_long_pad_idx ON t_tp_long USING smol(k);
+RESET smol.text_prefix;
+DROP TABLE t_tp CASCADE;
+DROP TABLE t_tp_long CASCADE;
+
+-- ============================================================================
+-- Dictionary-coded INCLUDE columns (smol.include_dict)
+-- ============================================================================
+DROP TABLE IF EXISTS t_idict CASCADE;
+DROP TABLE IF EXISTS t_idict_txt CASCADE;
+DROP TABLE IF EXISTS t_idict_fw CASCADE;
+CREATE UNLOGGED TABLE t_idict (k int4, status int2, region text COLLATE "C", amount int8);
+INSERT INTO t_idict SELECT i, (i % 5)::int2, (ARRAY['north','south','east','west'])[1 + i % 4], i * 10 FROM generate_series(1, 50000) i;
+CREATE INDEX t_idict_plain_idx ON t_idict USING smol(k) INCLUDE (status, region, amount);
+SET smol.include_dict = on;
+CREATE INDEX t_idict_idx ON t_idict USING smol(k) INCLUDE (status, region, amount);
+-- status and region become a few bits per row; amount stays raw
+SELECT pg_relation_size('t_idict_idx') < pg_relation_size('t_idict_plain_idx') AS smaller;
+DROP INDEX t_idict_plain_idx;
+SELECT count(*), sum(status), count(DISTINCT region), sum(amount) FROM t_idict WHERE k BETWEEN 1000 AND 20000;
+SELECT k, status, region, amount FROM t_idict WHERE k > 49996 ORDER BY k;
+SELECT k, status, region FROM t_idict WHERE k < 4 ORDER BY k DESC;
+SELECT region, count(*), sum(status) FROM t_idict WHERE k <= 30000 GROUP BY region ORDER BY region;
+SELECT * FROM smol_group_agg('t_idict_idx', 1, 100, 104) ORDER BY k;
+-- Text keys
+CREATE UNLOGGED TABLE t_idict_txt (name text COLLATE "C", grade int4);
+INSERT INTO t_idict_txt SELECT 'user-' || lpad(i::text, 5, '0'), i % 3 FROM generate_series(1, 20000) i;
+CREATE INDEX t_idict_txt_idx ON t_idict_txt USING smol(name) INCLUDE (grade);
+SELECT name, grade FROM t_idict_txt WHERE name >= 'user-12340' AND name < 'user-12344' ORDER BY name;
+SELECT grade, count(*) FROM t_idict_txt WHERE name < 'user-03000' GROUP BY grade ORDER BY grade;
+-- Fixed-width INCLUDEs with no generated refill kernel read the decoded leaf image
+CREATE UNLOGGED TABLE t_idict_fw (k int4, status int2, amount int8);
+INSERT INTO t_idict_fw SELECT i, (i % 5)::int2, (i % 7) * 100 FROM generate_series(1, 50000) i;
+CREATE INDEX t_idict_fw_idx ON t_idict_fw USING smol(k) INCLUDE (status, amount);
+SELECT count(*), sum(status), sum(amount) FROM t_idict_fw WHERE k BETWEEN 1000 AND 20000;
+SELECT k, status, amount FROM t_idict_fw WHERE k > 49996 ORDER BY k;
+SELECT k, status, amount FROM t_idict_fw WHERE k < 4 ORDER BY k DESC;
+SELECT status, count(*), sum(amount) FROM t_idict_fw WHERE k <= 30000 GROUP BY status ORDER BY status;
+RESET smol.include_dict;
+DROP TABLE t_idict CASCADE;
+DROP TABLE t_idict_txt CASCADE;
+DROP TABLE t_idict_fw CASCADE;
+
+-- ============================================================================
+-- Per-leaf bloom pages and byte-hashed blooms (smol.bloom_leaf_bits)
+-- ============================================================================
+DROP TABLE IF EXISTS t_lbloom CASCADE;
+DROP TABLE IF EXISTS t_lbloom_txt CASCADE;
+CREATE UNLOGGED TABLE t_lbloom (u uuid);
+INSERT INTO t_lbloom SELECT md5((i % 20000)::text)::uuid FROM generate_series(1, 40000) i;
+CREATE INDEX t_lbloom_plain_idx ON t_lbloom USING smol(u);
+SET smol.bloom_leaf_bits = 1024;
+SET smol.bloom_nhash = 6;
+CREATE INDEX t_lbloom_idx ON t_lbloom USING smol(u);
+-- the bloom pages follow the tree
+SELECT pg_relation_size('t_lbloom_idx') > pg_relation_size('t_lbloom_plain_idx') AS has_bloom_pages;
+DROP INDEX t_lbloom_plain_idx;
+SELECT u FROM t_lbloom WHERE u = md5('777')::uuid;
+SELECT count(*) FROM t_lbloom WHERE u = md5('0')::uuid;
+SELECT count(*) FROM t_lbloom WHERE u = md5('absent')::uuid;
+SELECT count(*) FROM t_lbloom WHERE u = ANY (ARRAY[md5('5')::uuid, md5('nope')::uuid, md5('19999')::uuid]);
+RESET smol.bloom_leaf_bits;
+RESET smol.bloom_nhash;
+-- Text keys without bloom pages test the leaf's key bytes on the fly
+CREATE UNLOGGED TABLE t_lbloom_txt (name text COLLATE "C");
+INSERT INTO t_lbloom_txt SELECT 'name-' || (i % 15000) FROM generate_series(1, 30000) i;
+CREATE INDEX t_lbloom_txt_idx ON t_lbloom_txt USING smol(name);
+SELECT name, count(*) FROM t_lbloom_txt WHERE name = 'name-4321' GROUP BY name;
+SELECT count(*) FROM t_lbloom_txt WHERE name = 'name-43210';
+SELECT count(*) FROM t_lbloom_txt WHERE name = ANY (ARRAY['name-1', 'name-x', 'name-14999']);
+DROP TABLE t_lbloom CASCADE;
+DROP TABLE t_lbloom_txt CASCADE;
+
+-- ============================================================================
+-- Shared scan statistics (pg_stat_smol, EXPLAIN (ANALYZE, SMOL))
+-- ============================================================================
+DROP TABLE IF EXISTS t_pgstat CASCADE;
+CREATE UNLOGGED TABLE t_pgstat (k int4);
+INSERT INTO t_pgstat SELECT i FROM generate_series(1, 50000) i;
+INSERT INTO t_pgstat SELECT 1000000 + i FROM generate_series(1, 50000) i;
+CREATE INDEX t_pgstat_idx ON t_pgstat USING smol(k);
+SELECT smol_stat_reset();
+CREATE ROLE regress_smol_stat;
+SET ROLE regress_smol_stat;
+SELECT smol_stat_reset();
+RESET ROLE;
+DROP ROLE regress_smol_stat;
+SELECT count(*) FROM pg_stat_smol WHERE indexrelname = 't_pgstat_idx';
+SELECT count(*) FROM t_pgstat WHERE k BETWEEN 1000 AND 60000;
+-- falls in the gap between the two key ranges
+SELECT count(*) FROM t_pgstat WHERE k = 500000;
+SELECT relname, scans >= 2 AS scanned, leaves_read > 1 AS read_leaves, bloom_pruned <= bloom_checks AS consistent
+FROM pg_stat_smol WHERE indexrelname = 't_pgstat_idx';
+SET smol.track_scan_stats = off;
+SELECT count(*) FROM t_pgstat WHERE k < 100;
+RESET smol.track_scan_stats;
+SELECT scans < 3 AS untracked FROM pg_stat_smol WHERE indexrelname = 't_pgstat_idx';
+-- the option is accepted without ANALYZE and prints nothing extra
+EXPLAIN (COSTS OFF, SMOL) SELECT count(*) FROM t_pgstat WHERE k = 7;
+DROP TABLE t_pgstat CASCADE;
+-- A full table hands the slots of dropped indexes to new ones
+DROP TABLE IF EXISTS t_pgstat_slot CASCADE;
+CREATE UNLOGGED TABLE t_pgstat_slot (k int4);
+INSERT INTO t_pgstat_slot SELECT i FROM generate_series(1, 100) i;
+SELECT smol_stat_reset();
+SET enable_seqscan = off;
+DO $$
+BEGIN
+    FOR i IN 1..1100 LOOP
+        EXECUTE 'CREATE INDEX t_pgstat_slot_tmp ON t_pgstat_slot USING smol(k)';
+        PERFORM count(*) FROM t_pgstat_slot WHERE k = 7;
+        EXECUTE 'DROP INDEX t_pgstat_slot_tmp';
+    END LOOP;
+END $$;
+CREATE INDEX t_pgstat_slot_idx ON t_pgstat_slot USING smol(k);
+SELECT count(*) FROM t_pgstat_slot WHERE k = 7;
+SELECT scans FROM pg_stat_smol WHERE indexrelname = 't_pgstat_slot_idx';
+RESET enable_seqscan;
+DROP TABLE t_pgstat_slot CASCADE;
+
+-- ============================================================================
+-- Microbenchmark functions (smol_bench_scan, smol_bench_build_profile)
+-- ============================================================================
+DROP TABLE IF EXISTS t_bench CASCADE;
+CREATE UNLOGGED TABLE t_bench (k int4, v int4);
+INSERT INTO t_bench SELECT i, i % 10 FROM generate_series(1, 5000) i;
+CREATE INDEX t_bench_idx ON t_bench USING smol(k);
+SELECT indexrelid = 't_bench_idx'::regclass AS same_index, tuples, sort_ms <= total_ms AS phases_ordered, index_mb > 0 AS sized
+FROM smol_bench_build_profile();
+CREATE INDEX t_bench_inc_idx ON t_bench USING smol(k) INCLUDE (v);
+SELECT tuples, ns_per_tuple > 0 AS timed, mb_per_sec > 0 AS rated FROM smol_bench_scan('t_bench_idx', 3);
+SELECT tuples FROM smol_bench_scan('t_bench_inc_idx', 2, true);
+-- The timed scan reads every row: it needs SELECT and no row-level security
+CREATE ROLE regress_smol_bench;
+SET ROLE regress_smol_bench;
+SELECT tuples FROM smol_bench_scan('t_bench_idx', 1);
+RESET ROLE;
+GRANT SELECT ON t_bench TO regress_smol_bench;
+ALTER TABLE t_bench ENABLE ROW LEVEL SECURITY;
+SET ROLE regress_smol_bench;
+SELECT tuples FROM smol_bench_scan('t_bench_idx', 1);
+RESET ROLE;
+ALTER TABLE t_bench DISABLE ROW LEVEL SECURITY;
+REVOKE SELECT ON t_bench FROM regress_smol_bench;
+DROP ROLE regress_smol_bench;
+TRUNCATE t_bench;
+CREATE INDEX t_bench_empty_idx ON t_bench USING smol(k);
+SELECT tuples, ns_per_tuple IS NULL AS untimed FROM smol_bench_scan('t_bench_empty_idx');
+CREATE INDEX t_bench_bt ON t_bench USING btree(k);
+SELECT * FROM smol_bench_scan('t_bench_bt');
+SELECT * FROM smol_bench_scan('t_bench_idx', 0);
+DROP TABLE t_bench CASCADE;
+
+-- ============================================================================
+-- Skip scan over leading-key groups (smol.skip_scan, smol_distinct)
+-- ============================================================================
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+DROP TABLE IF EXISTS t_skip CASCADE;
+CREATE UNLOGGED TABLE t_skip (tenant int4, ts int8);
+INSERT INTO t_skip SELECT i % 6, i FROM generate_series(1, 60000) i;
+CREATE INDEX t_skip_idx ON t_skip USING smol(tenant, ts);
+SELECT tenant, count(*), min(ts), max(ts) FROM t_skip WHERE ts BETWEEN 30000 AND 30100 GROUP BY tenant ORDER BY tenant;
+SELECT count(*), sum(ts) FROM t_skip WHERE ts <= 500;
+SELECT tenant, ts FROM t_skip WHERE ts = 777;
+SELECT count(*), sum(ts) FROM t_skip WHERE ts > 59990 AND tenant >= 2;
+SELECT count(*) FROM t_skip WHERE tenant BETWEEN 2 AND 3 AND ts >= 1000 AND ts < 1012;
+SELECT count(*) FROM t_skip WHERE ts > 100 AND ts < 50;
+-- Groups above the bound are jumped over, not read
+SELECT smol_stat_reset();
+SELECT count(*) FROM t_skip WHERE ts <= 500;
+SELECT leaves_read < 20 AS skipped FROM pg_stat_smol WHERE indexrelname = 't_skip_idx';
+SET smol.skip_scan = off;
+SELECT smol_stat_reset();
+SELECT count(*) FROM t_skip WHERE ts <= 500;
+SELECT leaves_read > 60 AS full_walk FROM pg_stat_smol WHERE indexrelname = 't_skip_idx';
+RESET smol.skip_scan;
+-- Backward scans keep walking leaf by leaf
+SELECT array_agg(tenant * 100000 + ts) FROM (SELECT tenant, ts FROM t_skip WHERE ts <= 20 ORDER BY tenant DESC, ts DESC LIMIT 5) s;
+DROP INDEX t_skip_idx;
+SET smol.two_col_groups = on;
+CREATE INDEX t_skip_grp_idx ON t_skip USING smol(tenant, ts);
+RESET smol.two_col_groups;
+SELECT count(*), sum(ts) FROM t_skip WHERE ts >= 59000;
+SELECT array_agg(tenant * 100000 + ts) FROM (SELECT tenant, ts FROM t_skip WHERE ts < 13 ORDER BY tenant, ts) s;
+-- smol_distinct: one row per leading key
+SELECT * FROM smol_distinct('t_skip_grp_idx');
+SELECT * FROM smol_distinct('t_skip_grp_idx', 2, 4);
+DROP INDEX t_skip_grp_idx;
+CREATE INDEX t_skip_rle_idx ON t_skip USING smol(tenant);
+SELECT k FROM smol_distinct('t_skip_rle_idx');
+SELECT k FROM smol_distinct('t_skip_rle_idx', 5, 100);
+DROP INDEX t_skip_rle_idx;
+CREATE INDEX t_skip_ts_idx ON t_skip USING smol(ts);
+SELECT count(*), min(k), max(k) FROM smol_distinct('t_skip_ts_idx', 1000);
+SELECT k FROM smol_distinct('t_skip_ts_idx', NULL, 3);
+CREATE ROLE regress_smol_distinct;
+SET ROLE regress_smol_distinct;
+SELECT k FROM smol_distinct('t_skip_ts_idx', NULL, 3);
+RESET ROLE;
+GRANT SELECT ON t_skip TO regress_smol_distinct;
+ALTER TABLE t_skip ENABLE ROW LEVEL SECURITY;
+SET ROLE regress_smol_distinct;
+SELECT k FROM smol_distinct('t_skip_ts_idx', NULL, 3);
+RESET ROLE;
+ALTER TABLE t_skip DISABLE ROW LEVEL SECURITY;
+SET ROLE regress_smol_distinct;
+SELECT k FROM smol_distinct('t_skip_ts_idx', NULL, 3);
+RESET ROLE;
+REVOKE SELECT ON t_skip FROM regress_smol_distinct;
+DROP ROLE regress_smol_distinct;
+DROP INDEX t_skip_ts_idx;
+SET smol.key_bitpack = on;
+CREATE INDEX t_skip_for_idx ON t_skip USING smol(ts);
+RESET smol.key_bitpack;
+SELECT count(*), sum(k) FROM smol_distinct('t_skip_for_idx', 59995, 70000);
+DROP TABLE t_skip CASCADE;
+CREATE UNLOGGED TABLE t_skip_txt (name text COLLATE "C");
+INSERT INTO t_skip_txt VALUES ('a'), ('b');
+CREATE INDEX t_skip_txt_idx ON t_skip_txt USING smol(name);
+SELECT * FROM smol_distinct('t_skip_txt_idx');
+DROP TABLE t_skip_txt CASCADE;
+
+-- ============================================================================
+-- Backend-local tree cache (smol.tree_cache_pages)
+-- ============================================================================
+DROP TABLE IF EXISTS t_tc CASCADE;
+CREATE UNLOGGED TABLE t_tc (k int4, v int4);
+INSERT INTO t_tc SELECT i, i % 10 FROM generate_series(1, 200000) i;
+CREATE INDEX t_tc_idx ON t_tc USING smol(k) INCLUDE (v) WITH (append = true);
+CREATE UNLOGGED TABLE t_tc_probe (p int4);
+INSERT INTO t_tc_probe SELECT i * 997 FROM generate_series(1, 300) i;
+ANALYZE t_tc;
+ANALYZE t_tc_probe;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+-- Nested-loop descents read the cached upper levels
+SELECT count(*), sum(t.v) FROM t_tc_probe p JOIN t_tc t ON t.k = p.p;
+SELECT count(*), sum(t.k) FROM t_tc_probe p JOIN t_tc t ON t.k BETWEEN p.p AND p.p + 5;
+-- A cache smaller than the tree reads the other pages through shared buffers
+SET smol.tree_cache_pages = 1;
+SELECT count(*), sum(t.v) FROM t_tc_probe p JOIN t_tc t ON t.k = p.p;
+SET smol.tree_cache_pages = 0;
+SELECT count(*), sum(t.k) FROM t_tc_probe p JOIN t_tc t ON t.k BETWEEN p.p AND p.p + 5;
+RESET smol.tree_cache_pages;
+RESET enable_hashjoin;
+RESET enable_mergejoin;
+-- Appends and compaction rewrite the upper levels: the cached tree is dropped
+SELECT count(*) FROM t_tc WHERE k > 199990;
+INSERT INTO t_tc SELECT i, i % 10 FROM generate_series(200001, 260000) i;
+SELECT smol_append('t_tc_idx');
+SELECT count(*), max(k) FROM t_tc WHERE k > 199990;
+SELECT k, v FROM t_tc WHERE k = 250003;
+SELECT smol_compact('t_tc_idx') >= 2 AS compacted;
+SELECT count(*), max(k) FROM t_tc WHERE k > 199990;
+-- The rewrite survives ROLLBACK, and so must the cache drop
+INSERT INTO t_tc SELECT i, i % 10 FROM generate_series(260001, 270000) i;
+BEGIN;
+SELECT smol_append('t_tc_idx');
+ROLLBACK;
+SELECT count(*), max(k) FROM t_tc WHERE k > 199990;
+-- A REINDEX reads the new tree
+DELETE FROM t_tc WHERE k > 100000;
+REINDEX INDEX t_tc_idx;
+SELECT count(*), max(k) FROM t_tc WHERE k > 99990;
+DROP TABLE t_tc CASCADE;
+DROP TABLE t_tc_probe CASCADE;
+
+-- ============================================================================
+-- Rescan repositioning (smol.rescan_reposition)
+-- ============================================================================
+DROP TABLE IF EXISTS t_rp CASCADE;
+CREATE UNLOGGED TABLE t_rp (k int4, v int4);
+INSERT INTO t_rp SELECT i * 2, i % 7 FROM generate_series(1, 100000) i;
+CREATE INDEX t_rp_idx ON t_rp USING smol(k) INCLUDE (v);
+CREATE UNLOGGED TABLE t_rp_outer (p int4);
+INSERT INTO t_rp_outer SELECT i * 37 FROM generate_series(1, 3000) i;
+CREATE UNLOGGED TABLE t_rp_shuf (p int4);
+INSERT INTO t_rp_shuf SELECT (i * 7919) % 200003 FROM generate_series(1, 3000) i;
+ANALYZE t_rp;
+ANALYZE t_rp_outer;
+ANALYZE t_rp_shuf;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+-- A sorted outer side starts most probes on the previous start leaf or its sibling
+SELECT count(*), sum(t.v) FROM t_rp_outer o JOIN t_rp t ON t.k = o.p;
+SELECT count(*), sum(t.k) FROM t_rp_outer o JOIN t_rp t ON t.k BETWEEN o.p AND o.p + 10;
+SELECT count(*), sum(t.k) FROM t_rp_outer o JOIN t_rp t ON t.k > o.p AND t.k < o.p + 7;
+-- Unsorted probes fall back to a descent whenever the bound is elsewhere
+SELECT count(*), sum(t.v) FROM t_rp_shuf o JOIN t_rp t ON t.k = o.p;
+SELECT count(*), sum(t.k) FROM t_rp_shuf o JOIN t_rp t ON t.k >= o.p AND t.k <= o.p + 3;
+SET smol.rescan_reposition = off;
+SELECT count(*), sum(t.v) FROM t_rp_outer o JOIN t_rp t ON t.k = o.p;
+SELECT count(*), sum(t.k) FROM t_rp_shuf o JOIN t_rp t ON t.k >= o.p AND t.k <= o.p + 3;
+RESET smol.rescan_reposition;
+-- Two key columns and text keys
+CREATE UNLOGGED TABLE t_rp2 (a int4, b int4);
+INSERT INTO t_rp2 SELECT i / 10, i FROM generate_series(1, 200000) i;
+CREATE INDEX t_rp2_idx ON t_rp2 USING smol(a, b);
+ANALYZE t_rp2;
+SELECT count(*), sum(t.b) FROM t_rp_outer o JOIN t_rp2 t ON t.a = o.p AND t.b > 0;
+CREATE UNLOGGED TABLE t_rp_txt (s text COLLATE "C");
+INSERT INTO t_rp_txt SELECT 'key-' || lpad(i::text, 6, '0') FROM generate_series(1, 50000) i;
+CREATE INDEX t_rp_txt_idx ON t_rp_txt USING smol(s);
+CREATE UNLOGGED TABLE t_rp_touter (s text COLLATE "C");
+INSERT INTO t_rp_touter SELECT 'key-' || lpad((i * 13)::text, 6, '0') FROM generate_series(1, 5000) i;
+ANALYZE t_rp_txt;
+ANALYZE t_rp_touter;
+SELECT count(*), min(t.s), max(t.s) FROM t_rp_touter o JOIN t_rp_txt t ON t.s = o.s;
+RESET enable_hashjoin;
+RESET enable_mergejoin;
+DROP TABLE t_rp CASCADE;
+DROP TABLE t_rp_outer CASCADE;
+DROP TABLE t_rp_shuf CASCADE;
+DROP TABLE t_rp2 CASCADE;
+DROP TABLE t_rp_txt CASCADE;
+DROP TABLE t_rp_touter CASCADE;
+
+-- ============================================================================
+-- INCLUDE zone pages and smol_group_agg filters (smol.build_include_zones)
+-- ============================================================================
+DROP TABLE IF EXISTS t_iz CASCADE;
+CREATE UNLOGGED TABLE t_iz (k int4, status int4, amt int8);
+INSERT INTO t_iz SELECT i / 10, (i / 5000) % 4, i % 100 FROM generate_series(1, 200000) i;
+SET smol.build_include_zones = on;
+CREATE INDEX t_iz_idx ON t_iz USING smol(k) INCLUDE (status, amt) WITH (append = true);
+RESET smol.build_include_zones;
+CREATE INDEX t_iz_nz ON t_iz USING smol(k) INCLUDE (status, amt);
+ANALYZE t_iz;
+SELECT pg_relation_size('t_iz_idx') > pg_relation_size('t_iz_nz') AS has_zone_pages;
+-- Leaves whose status range misses the filter are skipped unread
+SELECT count(*), sum(count), sum(sum) FROM smol_group_agg('t_iz_idx', 2, filter_col => 1, filter_lower => 3, filter_upper => 3);
+SELECT count(*), sum(count), sum(sum) FROM smol_group_agg('t_iz_nz', 2, filter_col => 1, filter_lower => 3, filter_upper => 3);
+SELECT count(*) FROM ((SELECT * FROM smol_group_agg('t_iz_idx', 2, 100, 15000, 1, 1, 2) EXCEPT ALL SELECT k, count(*), sum(amt), min(amt), max(amt) FROM t_iz WHERE k BETWEEN 100 AND 15000 AND status BETWEEN 1 AND 2 GROUP BY k) UNION ALL (SELECT k, count(*), sum(amt), min(amt), max(amt) FROM t_iz WHERE k BETWEEN 100 AND 15000 AND status BETWEEN 1 AND 2 GROUP BY k EXCEPT ALL SELECT * FROM smol_group_agg('t_iz_idx', 2, 100, 15000, 1, 1, 2))) d;
+SELECT count(*) FROM ((SELECT * FROM smol_group_agg('t_iz_nz', 2, 100, 15000, 1, 1, 2) EXCEPT ALL SELECT k, count(*), sum(amt), min(amt), max(amt) FROM t_iz WHERE k BETWEEN 100 AND 15000 AND status BETWEEN 1 AND 2 GROUP BY k) UNION ALL (SELECT k, count(*), sum(amt), min(amt), max(amt) FROM t_iz WHERE k BETWEEN 100 AND 15000 AND status BETWEEN 1 AND 2 GROUP BY k EXCEPT ALL SELECT * FROM smol_group_agg('t_iz_nz', 2, 100, 15000, 1, 1, 2))) d;
+SELECT count(*) FROM smol_group_agg('t_iz_idx', filter_col => 1, filter_lower => 9);
+-- Rows appended after the build have no zone and are always read
+DROP INDEX t_iz_nz;
+INSERT INTO t_iz SELECT i / 10, 3, i % 100 FROM generate_series(200001, 210000) i;
+SELECT smol_append('t_iz_idx');
+SELECT count(*), sum(count), sum(sum) FROM smol_group_agg('t_iz_idx', 2, filter_col => 1, filter_lower => 3, filter_upper => 3);
+SELECT smol_group_agg('t_iz_idx', filter_col => 3);
+DROP TABLE t_iz CASCADE;
+
 -- Reset all scan settings
 RESET enable_seqscan;
 RESET enable_indexscan;